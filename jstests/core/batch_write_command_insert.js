@@ -368,6 +368,75 @@ try {
     assert(coll.count() == 50, "Unexpected number inserted by bulk write: " + coll.count());
 }
 
+//
+// Documents are inserted in groups, and a group with a duplicate key is inserted again one document
+// at a time. Only the duplicate gets an error, and n counts every other document inserted.
+function insertIds(ids, ordered) {
+    var docs = ids.map(function(id) {
+        return {_id: id};
+    });
+    return coll.runCommand({insert: coll.getName(), documents: docs, ordered: ordered});
+}
+
+function idRange(start, end) {
+    var ids = [];
+    for (var i = start; i < end; i++) {
+        ids.push(i);
+    }
+    return ids;
+}
+
+function assertDuplicateKeyErrors(result, indexes) {
+    assert(result.ok, tojson(result));
+    assert.eq(indexes.length, result.writeErrors.length, tojson(result));
+    for (var i = 0; i < indexes.length; i++) {
+        assert.eq(indexes[i], result.writeErrors[i].index, tojson(result));
+        assert.eq(ErrorCodes.DuplicateKey, result.writeErrors[i].code, tojson(result));
+    }
+}
+
+// Ordered, with the duplicate in the middle of the group
+coll.drop();
+coll.insert({_id: 5});
+result = insertIds(idRange(0, 10), true);
+assertDuplicateKeyErrors(result, [5]);
+assert.eq(5, result.n);
+assert.eq(idRange(0, 6), coll.find().sort({_id: 1}).toArray().map(function(doc) {
+    return doc._id;
+}));
+
+// Unordered, with two duplicates in the middle of the group
+coll.drop();
+coll.insert({_id: 3});
+coll.insert({_id: 7});
+result = insertIds(idRange(0, 10), false);
+assertDuplicateKeyErrors(result, [3, 7]);
+assert.eq(8, result.n);
+assert.eq(10, coll.count());
+
+// Duplicates in the batch itself, within a group
+coll.drop();
+result = insertIds([0, 1, 0, 2, 1, 3], false);
+assertDuplicateKeyErrors(result, [2, 4]);
+assert.eq(4, result.n);
+assert.eq(4, coll.count());
+
+// The groups after the one with the duplicate are inserted as groups again
+coll.drop();
+coll.insert({_id: 100});
+result = insertIds(idRange(0, 300), false);
+assertDuplicateKeyErrors(result, [100]);
+assert.eq(299, result.n);
+assert.eq(300, coll.count());
+
+coll.drop();
+coll.insert({_id: 100});
+result = insertIds(idRange(0, 300), true);
+assertDuplicateKeyErrors(result, [100]);
+assert.eq(100, result.n);
+assert.eq(101, coll.count());
+assert.eq(0, coll.count({_id: {$gt: 100}}));
+
 //
 // Background index creation
 // Note: due to SERVER-13304 this test is at the end of this file, and we don't drop
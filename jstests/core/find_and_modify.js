@@ -113,6 +113,52 @@ cmdRes = db.runCommand({
 });
 assert.commandFailed(cmdRes);
 
+//
+// A $meta textScore projection needs a $text query, also when the query is by _id only.
+//
+
+t.drop();
+t.insert({_id: "found", y: 1});
+
+cmdRes = db.runCommand({
+    findAndModify: t.getName(),
+    query: {_id: "found"},
+    update: {$inc: {y: 1}},
+    fields: {score: {$meta: "textScore"}}
+});
+assert.commandFailed(cmdRes);
+
+cmdRes = db.runCommand({
+    findAndModify: t.getName(),
+    query: {_id: "found"},
+    update: {$inc: {y: 1}},
+    fields: {score: {$meta: "textScore"}},
+    new: true
+});
+assert.commandFailed(cmdRes);
+
+cmdRes = db.runCommand({
+    findAndModify: t.getName(),
+    query: {_id: "found"},
+    remove: true,
+    fields: {score: {$meta: "textScore"}}
+});
+assert.commandFailed(cmdRes);
+
+// The document was neither updated nor removed.
+assert.eq({_id: "found", y: 1}, t.findOne());
+
+// Other projections of a query by _id still work.
+cmdRes = db.runCommand({
+    findAndModify: t.getName(),
+    query: {_id: "found"},
+    update: {$inc: {y: 1}},
+    fields: {y: 1},
+    new: true
+});
+assert.commandWorked(cmdRes);
+assert.eq({_id: "found", y: 2}, cmdRes.value);
+
 //
 // SERVER-17372
 //
@@ -0,0 +1,72 @@
+// Test that replaying a journal which spans several files with several recovery threads gives the
+// same data as replaying it with a single one.
+
+var testname = "dur_parallel_recovery";
+var path = MongoRunner.dataPath + testname;
+var serialPath = path + "_serial";
+var parallelPath = path + "_parallel";
+
+// Random, so that the journal does not compress well and the writes fill more than one journal
+// file. Snappy only finds repeats within blocks of 64KB, so using it in every document is fine.
+var chars = "abcdefghijklmnopqrstuvwxyz0123456789";
+var parts = [];
+for (var i = 0; i < 1024 * 1024; i++) {
+    parts.push(chars[Math.floor(Math.random() * chars.length)]);
+}
+var randomString = parts.join("");
+
+jsTest.log("Writing the journal");
+
+// No periodic flush of the data files, so that no journal file gets removed
+var conn = MongoRunner.runMongod({dbpath: path, journal: "", smallfiles: "", syncdelay: 0});
+var testDB = conn.getDB("test");
+
+for (var i = 0; i < 150; i++) {
+    testDB.foo.insert({_id: i, s: randomString.substr(i, 1000 * 1000), n: 0});
+    testDB.bar.insert({_id: i, x: i});
+}
+testDB.foo.update({_id: {$lt: 50}}, {$inc: {n: 1}}, {multi: true});
+testDB.foo.remove({_id: {$gte: 140}});
+testDB.bar.ensureIndex({x: 1});
+testDB.bar.update({}, {$set: {y: "grown past its padding"}}, {multi: true});
+assert.commandWorked(testDB.runCommand({getlasterror: 1, j: 1}));
+
+MongoRunner.stopMongod(conn.port, /*signal*/ 9);
+
+var journalFiles = listFiles(path + "/journal").filter(function(f) {
+    return f.baseName.indexOf("j._") == 0;
+});
+assert.gt(journalFiles.length, 1, "the journal should span several files: " + tojson(journalFiles));
+
+copyDbpath(path, serialPath);
+copyDbpath(path, parallelPath);
+
+function recover(dbpath, threadCount) {
+    jsTest.log("Recovering " + dbpath + " with " + threadCount + " threads");
+
+    var conn = MongoRunner.runMongod({
+        restart: true,
+        cleanData: false,
+        dbpath: dbpath,
+        journal: "",
+        smallfiles: "",
+        setParameter: "journalRecoveryThreadCount=" + threadCount
+    });
+    var testDB = conn.getDB("test");
+
+    assert.eq(140, testDB.foo.count());
+    assert.eq(50, testDB.foo.count({n: 1}));
+    assert.eq(150, testDB.bar.count({y: {$exists: true}}));
+    assert(testDB.foo.validate(true).valid);
+    assert(testDB.bar.validate(true).valid);
+
+    var res = assert.commandWorked(testDB.runCommand({dbHash: 1}));
+    MongoRunner.stopMongod(conn);
+    return res.collections;
+}
+
+var serialHashes = recover(serialPath, 1);
+var parallelHashes = recover(parallelPath, 8);
+assert.eq(serialHashes, parallelHashes);
+
+jsTest.log(testname + " SUCCESS");
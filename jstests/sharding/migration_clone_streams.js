@@ -0,0 +1,79 @@
+//
+// Tests that chunk migrations whose initial clone is fetched on several streams copy every
+// document exactly once, and that the failure of one stream fails the migration.
+//
+(function() {
+    'use strict';
+
+    var st = new ShardingTest({shards: 2, mongos: 1});
+    st.stopBalancer();
+
+    var mongos = st.s0;
+    var admin = mongos.getDB("admin");
+    var shards = mongos.getCollection("config.shards").find().toArray();
+    var coll = mongos.getCollection("foo.bar");
+
+    assert.commandWorked(admin.runCommand({enableSharding: coll.getDB() + ""}));
+    printjson(admin.runCommand({movePrimary: coll.getDB() + "", to: shards[0]._id}));
+    assert.commandWorked(admin.runCommand({shardCollection: coll + "", key: {_id: 1}}));
+
+    assert.commandWorked(
+        st.shard1.getDB("admin").runCommand({setParameter: 1, migrateCloneStreams: 4}));
+
+    // Documents of about 1MB, so that the donor hands them out in several _migrateClone batches
+    var numDocs = 40;
+    var bigString = new Array(1024 * 1024).join("x");
+
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < numDocs; i++) {
+        bulk.insert({_id: i, s: bigString});
+    }
+    assert.writeOK(bulk.execute());
+
+    var donorColl = st.shard0.getCollection(coll + "");
+    var recipientColl = st.shard1.getCollection(coll + "");
+
+    jsTest.log("Failing one of the clone streams after the first batch...");
+
+    assert.commandWorked(st.shard1.getDB("admin").runCommand(
+        {configureFailPoint: "failMigrateCloneFetch", mode: {skip: 1}}));
+
+    assert.commandFailed(admin.runCommand(
+        {moveChunk: coll + "", find: {_id: 0}, to: shards[1]._id, _waitForDelete: true}));
+
+    assert.commandWorked(st.shard1.getDB("admin").runCommand(
+        {configureFailPoint: "failMigrateCloneFetch", mode: "off"}));
+
+    // The donor still owns every document
+    assert.eq(numDocs, donorColl.count());
+    assert.eq(numDocs, coll.find().itcount());
+
+    jsTest.log("Migrating with all the clone streams...");
+
+    // The documents cloned by the failed migration may still be getting deleted
+    assert.soon(function() {
+        var res = admin.runCommand(
+            {moveChunk: coll + "", find: {_id: 0}, to: shards[1]._id, _waitForDelete: true});
+        if (!res.ok) {
+            printjson(res);
+        }
+        return res.ok;
+    });
+
+    assert.eq(0, donorColl.count());
+    assert.eq(numDocs, recipientColl.count());
+
+    var ids = [];
+    recipientColl.find().sort({_id: 1}).forEach(function(doc) {
+        assert.eq(bigString, doc.s, "document " + doc._id + " was not cloned intact");
+        ids.push(doc._id);
+    });
+
+    for (var i = 0; i < numDocs; i++) {
+        assert.eq(i, ids[i]);
+    }
+
+    jsTest.log("DONE!");
+
+    st.stop();
+})();
@@ -0,0 +1,118 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bson_field_index.h"
+
+namespace mongo {
+
+const int BSONFieldIndex::kLookupsBeforeIndexing;
+const int BSONFieldIndex::kMinFieldsToIndex;
+
+BSONFieldIndex::BSONFieldIndex(const BSONObj& obj) : _obj(obj) {}
+
+void BSONFieldIndex::reset(const BSONObj& obj) {
+    _obj = obj;
+    _lookups = 0;
+    _triedIndexing = false;
+    _slots.clear();
+}
+
+uint32_t BSONFieldIndex::_hash(StringData name) {
+    // 32 bit FNV-1a.
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0; i < name.size(); ++i) {
+        hash ^= static_cast<unsigned char>(name[i]);
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+void BSONFieldIndex::_build() const {
+    _triedIndexing = true;
+
+    const int nFields = _obj.nFields();
+    if (nFields < kMinFieldsToIndex)
+        return;
+
+    size_t capacity = 1;
+    while (capacity < static_cast<size_t>(nFields) * 2) {
+        capacity <<= 1;
+    }
+    _slots.assign(capacity, Slot{0, 0});
+    const size_t mask = capacity - 1;
+
+    const char* const base = _obj.objdata();
+    BSONObjIterator it(_obj);
+    while (it.more()) {
+        const BSONElement e = it.next();
+        const StringData name = e.fieldNameStringData();
+        const uint32_t hash = _hash(name);
+
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            Slot& slot = _slots[i];
+            if (!slot.offset) {
+                slot.hash = hash;
+                slot.offset = e.rawdata() - base;
+                break;
+            }
+            // Keep the first of several fields with the same name, like BSONObj::getField.
+            if (slot.hash == hash && BSONElement(base + slot.offset).fieldNameStringData() == name)
+                break;
+        }
+    }
+}
+
+BSONElement BSONFieldIndex::getField(StringData name) const {
+    if (!_triedIndexing) {
+        if (++_lookups < kLookupsBeforeIndexing)
+            return _obj.getField(name);
+        _build();
+    }
+
+    if (_slots.empty())
+        return _obj.getField(name);
+
+    const char* const base = _obj.objdata();
+    const uint32_t hash = _hash(name);
+    const size_t mask = _slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        const Slot& slot = _slots[i];
+        if (!slot.offset)
+            return BSONElement();
+
+        if (slot.hash == hash) {
+            BSONElement e(base + slot.offset);
+            if (e.fieldNameStringData() == name)
+                return e;
+        }
+    }
+}
+
+}  // namespace mongo
@@ -0,0 +1,100 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonobj.h"
+
+namespace mongo {
+
+/**
+ * Lookup structure for the top-level fields of a single BSONObj, for callers which look up many
+ * fields of the same document. getField() returns exactly what BSONObj::getField() would, but
+ * once the index is built each lookup costs one hash probe instead of a scan over the elements
+ * preceding the field.
+ *
+ * The index is built lazily: the first kLookupsBeforeIndexing - 1 lookups scan the object, so
+ * that documents which are only consulted once or twice never pay for the table, and objects with
+ * fewer than kMinFieldsToIndex fields are never indexed.
+ *
+ * The object must not be modified while the index is in use. Not thread safe.
+ */
+class BSONFieldIndex {
+    MONGO_DISALLOW_COPYING(BSONFieldIndex);
+
+public:
+    static const int kLookupsBeforeIndexing = 4;
+    static const int kMinFieldsToIndex = 16;
+
+    BSONFieldIndex() = default;
+    explicit BSONFieldIndex(const BSONObj& obj);
+
+    /**
+     * Starts indexing 'obj', discarding the index of any previous object.
+     */
+    void reset(const BSONObj& obj);
+
+    /**
+     * Returns the first field of the object named 'name', or an EOO element if there is none.
+     */
+    BSONElement getField(StringData name) const;
+
+    /**
+     * Returns true if the hash table has been built for the current object.
+     */
+    bool isIndexed() const {
+        return !_slots.empty();
+    }
+
+private:
+    struct Slot {
+        uint32_t hash;
+        // Offset of the element from the start of the object. Zero marks an empty slot, since
+        // no element can start inside the object's length prefix.
+        uint32_t offset;
+    };
+
+    static uint32_t _hash(StringData name);
+
+    void _build() const;
+
+    BSONObj _obj;
+
+    mutable int _lookups = 0;
+    mutable bool _triedIndexing = false;
+
+    // Open addressing hash table with linear probing, sized to a power of two.
+    mutable std::vector<Slot> _slots;
+};
+
+}  // namespace mongo
@@ -0,0 +1,117 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bson_field_index.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace {
+
+std::string fieldName(int i) {
+    return str::stream() << "field" << i;
+}
+
+BSONObj makeWideObj(int nFields) {
+    BSONObjBuilder bob;
+    for (int i = 0; i < nFields; ++i) {
+        bob.append(fieldName(i), i);
+    }
+    return bob.obj();
+}
+
+TEST(BSONFieldIndex, FindsAllFieldsOfWideObject) {
+    const int nFields = 150;
+    BSONObj obj = makeWideObj(nFields);
+    BSONFieldIndex index(obj);
+
+    for (int i = 0; i < nFields; ++i) {
+        BSONElement e = index.getField(fieldName(i));
+        ASSERT_EQUALS(i, e.numberInt());
+        ASSERT_EQUALS(obj.getField(fieldName(i)).rawdata(), e.rawdata());
+    }
+    ASSERT(index.isIndexed());
+}
+
+TEST(BSONFieldIndex, MissingFieldIsEOO) {
+    BSONObj obj = makeWideObj(50);
+    BSONFieldIndex index(obj);
+
+    for (int i = 0; i < BSONFieldIndex::kLookupsBeforeIndexing; ++i) {
+        ASSERT(index.getField("missing").eoo());
+    }
+    ASSERT(index.isIndexed());
+    ASSERT(index.getField("missing").eoo());
+    ASSERT(index.getField("").eoo());
+    ASSERT(index.getField("field").eoo());
+}
+
+TEST(BSONFieldIndex, FirstDuplicateFieldWins) {
+    BSONObjBuilder bob;
+    bob.appendElements(makeWideObj(BSONFieldIndex::kMinFieldsToIndex));
+    bob.append("dup", 1);
+    bob.append("dup", 2);
+    BSONObj obj = bob.obj();
+    BSONFieldIndex index(obj);
+
+    for (int i = 0; i < BSONFieldIndex::kLookupsBeforeIndexing; ++i) {
+        ASSERT_EQUALS(1, index.getField("dup").numberInt());
+    }
+    ASSERT(index.isIndexed());
+}
+
+TEST(BSONFieldIndex, SmallObjectIsNotIndexed) {
+    BSONObj obj = BSON("a" << 1 << "b" << 2);
+    BSONFieldIndex index(obj);
+
+    for (int i = 0; i < BSONFieldIndex::kLookupsBeforeIndexing * 2; ++i) {
+        ASSERT_EQUALS(2, index.getField("b").numberInt());
+    }
+    ASSERT_FALSE(index.isIndexed());
+}
+
+TEST(BSONFieldIndex, ResetDiscardsPreviousObject) {
+    BSONObj first = makeWideObj(100);
+    BSONFieldIndex index(first);
+    for (int i = 0; i < BSONFieldIndex::kLookupsBeforeIndexing; ++i) {
+        index.getField("field1");
+    }
+    ASSERT(index.isIndexed());
+
+    BSONObj second = BSON("field1" << "x");
+    index.reset(second);
+    ASSERT_FALSE(index.isIndexed());
+    ASSERT_EQUALS("x", index.getField("field1").str());
+    ASSERT(index.getField("field2").eoo());
+}
+
+}  // namespace
+}  // namespace mongo
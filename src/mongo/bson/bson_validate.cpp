@@ -27,9 +27,10 @@
  *    then also delete it in the license file.
  */
 
+#include <algorithm>
 #include <cstring>
-#include <deque>
 #include <limits>
+#include <vector>
 
 #include "mongo/base/data_view.h"
 #include "mongo/bson/bson_validate.h"
@@ -169,6 +170,82 @@ private:
     int _startPosition;
 };
 
+/**
+ * Stack of the objects enclosing the current position. The outermost kInlineFrames levels are
+ * kept inline, so that validating a document which is not deeply nested does not allocate.
+ */
+class ValidationFrameStack {
+public:
+    static const size_t kInlineFrames = 32;
+
+    ValidationObjectFrame* push() {
+        ++_size;
+        if (_size <= kInlineFrames) {
+            _inline[_size - 1] = ValidationObjectFrame();
+            return &_inline[_size - 1];
+        }
+        _overflow.emplace_back();
+        return &_overflow.back();
+    }
+
+    void pop() {
+        if (_size > kInlineFrames)
+            _overflow.pop_back();
+        --_size;
+    }
+
+    ValidationObjectFrame* back() {
+        return _size <= kInlineFrames ? &_inline[_size - 1] : &_overflow.back();
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+
+private:
+    size_t _size = 0;
+    ValidationObjectFrame _inline[kInlineFrames];
+    std::vector<ValidationObjectFrame> _overflow;
+};
+
+/**
+ * Size of the value of each BSON type whose value has a fixed size and needs no checking beyond
+ * being within the buffer, indexed by type byte. Other types are marked with -1.
+ */
+class FixedValueSizes {
+public:
+    FixedValueSizes() {
+        std::fill(_sizes, _sizes + 256, -1);
+        set(MinKey, 0);
+        set(MaxKey, 0);
+        set(jstNULL, 0);
+        set(Undefined, 0);
+        set(jstOID, OID::kOIDSize);
+        set(NumberInt, sizeof(int32_t));
+        set(NumberDouble, sizeof(int64_t));
+        set(NumberLong, sizeof(int64_t));
+        set(bsonTimestamp, sizeof(int64_t));
+        set(Date, sizeof(int64_t));
+    }
+
+    int operator[](signed char type) const {
+        return _sizes[static_cast<unsigned char>(type)];
+    }
+
+private:
+    void set(BSONType type, int size) {
+        _sizes[static_cast<unsigned char>(type)] = size;
+    }
+
+    int _sizes[256];
+};
+
+const FixedValueSizes kFixedValueSizes;
+
 /**
  * WARNING: only pass in a non-EOO idElem if it has been fully validated already!
  */
@@ -184,28 +261,21 @@ Status validateElementInfo(Buffer* buffer, ValidationState::State* nextState, BS
         return Status::OK();
     }
 
-    StringData name;
-    status = buffer->readCString(&name);
+    status = buffer->readCString(NULL);
     if (!status.isOK())
         return status;
 
-    switch (type) {
-        case MinKey:
-        case MaxKey:
-        case jstNULL:
-        case Undefined:
-            return Status::OK();
-
-        case jstOID:
-            if (!buffer->skip(OID::kOIDSize))
-                return makeError("invalid bson", idElem);
-            return Status::OK();
-
-        case NumberInt:
-            if (!buffer->skip(sizeof(int32_t)))
-                return makeError("invalid bson", idElem);
-            return Status::OK();
+    // Most elements are of a fixed size type, which only needs a bounds check.
+    const int fixedValueSize = kFixedValueSizes[type];
+    if (fixedValueSize > 0) {
+        if (!buffer->skip(fixedValueSize))
+            return makeError("invalid bson", idElem);
+        return Status::OK();
+    } else if (fixedValueSize == 0) {
+        return Status::OK();
+    }
 
+    switch (type) {
         case Bool:
             uint8_t val;
             if (!buffer->readNumber(&val))
@@ -214,14 +284,6 @@ Status validateElementInfo(Buffer* buffer, ValidationState::State* nextState, BS
                 return makeError("invalid boolean value", idElem);
             return Status::OK();
 
-        case NumberDouble:
-        case NumberLong:
-        case bsonTimestamp:
-        case Date:
-            if (!buffer->skip(sizeof(int64_t)))
-                return makeError("invalid bson", idElem);
-            return Status::OK();
-
         case NumberDecimal:
             if (Decimal128::enabled) {
                 if (!buffer->skip(sizeof(Decimal128::Value)))
@@ -282,7 +344,7 @@ Status validateElementInfo(Buffer* buffer, ValidationState::State* nextState, BS
 }
 
 Status validateBSONIterative(Buffer* buffer) {
-    std::deque<ValidationObjectFrame> frames;
+    ValidationFrameStack frames;
     ValidationObjectFrame* curr = NULL;
     ValidationState::State state = ValidationState::BeginObj;
 
@@ -292,8 +354,7 @@ Status validateBSONIterative(Buffer* buffer) {
     while (state != ValidationState::Done) {
         switch (state) {
             case ValidationState::BeginObj:
-                frames.push_back(ValidationObjectFrame());
-                curr = &frames.back();
+                curr = frames.push();
                 curr->setStartPosition(buffer->position());
                 curr->setIsCodeWithScope(false);
                 if (!buffer->readNumber<int>(&curr->expectedSize)) {
@@ -332,11 +393,11 @@ Status validateBSONIterative(Buffer* buffer) {
                 if (actualLength != curr->expectedSize) {
                     return makeError("bson length doesn't match what we found", idElem);
                 }
-                frames.pop_back();
+                frames.pop();
                 if (frames.empty()) {
                     state = ValidationState::Done;
                 } else {
-                    curr = &frames.back();
+                    curr = frames.back();
                     if (curr->isCodeWithScope())
                         state = ValidationState::EndCodeWScope;
                     else
@@ -345,8 +406,7 @@ Status validateBSONIterative(Buffer* buffer) {
                 break;
             }
             case ValidationState::BeginCodeWScope: {
-                frames.push_back(ValidationObjectFrame());
-                curr = &frames.back();
+                curr = frames.push();
                 curr->setStartPosition(buffer->position());
                 curr->setIsCodeWithScope(true);
                 if (!buffer->readNumber<int>(&curr->expectedSize))
@@ -363,10 +423,10 @@ Status validateBSONIterative(Buffer* buffer) {
                     return makeError("bson length for CodeWScope doesn't match what we found",
                                      idElem);
                 }
-                frames.pop_back();
+                frames.pop();
                 if (frames.empty())
                     return makeError("unnested CodeWScope", idElem);
-                curr = &frames.back();
+                curr = frames.back();
                 state = ValidationState::WithinObj;
                 break;
             }
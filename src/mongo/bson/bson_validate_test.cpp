@@ -236,6 +236,27 @@ TEST(BSONValidateFast, NestedObject) {
     ASSERT_NOT_OK(validateBSON(x.objdata(), x.objsize() / 2));
 }
 
+TEST(BSONValidateFast, DeeplyNestedObject) {
+    BSONObj x = BSON("a" << 1);
+    for (int i = 0; i < 100; ++i) {
+        x = BSON("a" << x << "b" << BSON_ARRAY(i));
+    }
+    ASSERT_OK(validateBSON(x.objdata(), x.objsize()));
+
+    // Corrupt the size of the innermost object.
+    BSONObj inner = x;
+    while (inner.firstElement().type() == Object) {
+        inner = inner.firstElement().Obj();
+    }
+    std::unique_ptr<char[]> buffer(new char[x.objsize()]);
+    memcpy(buffer.get(), x.objdata(), x.objsize());
+    DataView(buffer.get() + (inner.objdata() - x.objdata())).write<LittleEndian<int>>(99);
+    const Status status = validateBSON(buffer.get(), x.objsize());
+    ASSERT_NOT_OK(status);
+    ASSERT_EQUALS(status.reason(),
+                  "bson length doesn't match what we found in object with unknown _id");
+}
+
 TEST(BSONValidateFast, ErrorWithId) {
     BufBuilder bb;
     BSONObjBuilder ob(bb);
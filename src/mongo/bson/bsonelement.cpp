@@ -47,18 +47,29 @@
 namespace mongo {
 namespace str = mongoutils::str;
 
-using std::dec;
-using std::hex;
 using std::string;
 
 string BSONElement::jsonString(JsonStringFormat format, bool includeFieldNames, int pretty) const {
-    std::stringstream s;
-    if (includeFieldNames)
-        s << '"' << escape(fieldName()) << "\" : ";
+    StringBuilder s;
+    jsonStringBuffer(format, includeFieldNames, pretty, s);
+    return s.str();
+}
+
+void BSONElement::jsonStringBuffer(JsonStringFormat format,
+                                   bool includeFieldNames,
+                                   int pretty,
+                                   StringBuilder& s) const {
+    if (includeFieldNames) {
+        s << '"';
+        appendEscaped(fieldNameStringData(), false, s);
+        s << "\" : ";
+    }
     switch (type()) {
         case mongo::String:
         case Symbol:
-            s << '"' << escape(string(valuestr(), valuestrsize() - 1)) << '"';
+            s << '"';
+            appendEscaped(StringData(valuestr(), valuestrsize() - 1), false, s);
+            s << '"';
             break;
         case NumberLong:
             if (format == TenGen) {
@@ -75,8 +86,11 @@ string BSONElement::jsonString(JsonStringFormat format, bool includeFieldNames,
         case NumberDouble:
             if (number() >= -std::numeric_limits<double>::max() &&
                 number() <= std::numeric_limits<double>::max()) {
-                s.precision(16);
-                s << number();
+                // Same as streaming with a precision of 16.
+                char buf[32];
+                const int len = snprintf(buf, sizeof(buf), "%.16g", number());
+                invariant(len > 0 && len < static_cast<int>(sizeof(buf)));
+                s << StringData(buf, len);
             }
             // This is not valid JSON, but according to RFC-4627, "Numeric values that cannot be
             // represented as sequences of digits (such as Infinity and NaN) are not permitted." so
@@ -125,7 +139,7 @@ string BSONElement::jsonString(JsonStringFormat format, bool includeFieldNames,
             }
             break;
         case Object:
-            s << embeddedObject().jsonString(format, pretty);
+            embeddedObject().jsonStringBuffer(format, pretty, false, s);
             break;
         case mongo::Array: {
             if (embeddedObject().isEmpty()) {
@@ -147,7 +161,7 @@ string BSONElement::jsonString(JsonStringFormat format, bool includeFieldNames,
                     if (strtol(e.fieldName(), 0, 10) > count) {
                         s << "undefined";
                     } else {
-                        s << e.jsonString(format, false, pretty ? pretty + 1 : 0);
+                        e.jsonStringBuffer(format, false, pretty ? pretty + 1 : 0, s);
                         e = i.next();
                     }
                     count++;
@@ -167,7 +181,7 @@ string BSONElement::jsonString(JsonStringFormat format, bool includeFieldNames,
             s << '"' << valuestr() << "\", ";
             if (format != TenGen)
                 s << "\"$id\" : ";
-            s << '"' << mongo::OID::from(valuestr() + valuestrsize()) << "\" ";
+            s << '"' << mongo::OID::from(valuestr() + valuestrsize()).toString() << "\" ";
             if (format == TenGen)
                 s << ')';
             else
@@ -180,7 +194,7 @@ string BSONElement::jsonString(JsonStringFormat format, bool includeFieldNames,
             } else {
                 s << "{ \"$oid\" : ";
             }
-            s << '"' << __oid() << '"';
+            s << '"' << __oid().toString() << '"';
             if (format == TenGen) {
                 s << " )";
             } else {
@@ -190,15 +204,11 @@ string BSONElement::jsonString(JsonStringFormat format, bool includeFieldNames,
         case BinData: {
             ConstDataCursor reader(value());
             const int len = reader.readAndAdvance<LittleEndian<int>>();
-            BinDataType type = static_cast<BinDataType>(reader.readAndAdvance<uint8_t>());
+            const uint8_t type = reader.readAndAdvance<uint8_t>();
 
             s << "{ \"$binary\" : \"";
             base64::encode(s, reader.view(), len);
-            s << "\", \"$type\" : \"" << hex;
-            s.width(2);
-            s.fill('0');
-            s << type << dec;
-            s << "\" }";
+            s << "\", \"$type\" : \"" << toHexLower(&type, 1) << "\" }";
             break;
         }
         case mongo::Date:
@@ -242,10 +252,13 @@ string BSONElement::jsonString(JsonStringFormat format, bool includeFieldNames,
             break;
         case RegEx:
             if (format == Strict) {
-                s << "{ \"$regex\" : \"" << escape(regex());
+                s << "{ \"$regex\" : \"";
+                appendEscaped(regex(), false, s);
                 s << "\", \"$options\" : \"" << regexFlags() << "\" }";
             } else {
-                s << "/" << escape(regex(), true) << "/";
+                s << "/";
+                appendEscaped(regex(), true, s);
+                s << "/";
                 // FIXME Worry about alpha order?
                 for (const char* f = regexFlags(); *f; ++f) {
                     switch (*f) {
@@ -263,14 +276,20 @@ string BSONElement::jsonString(JsonStringFormat format, bool includeFieldNames,
         case CodeWScope: {
             BSONObj scope = codeWScopeObject();
             if (!scope.isEmpty()) {
-                s << "{ \"$code\" : \"" << escape(_asCode()) << "\" , "
-                  << "\"$scope\" : " << scope.jsonString() << " }";
+                s << "{ \"$code\" : \"";
+                appendEscaped(_asCode(), false, s);
+                s << "\" , "
+                  << "\"$scope\" : ";
+                scope.jsonStringBuffer(Strict, 0, false, s);
+                s << " }";
                 break;
             }
         }
 
         case Code:
-            s << "\"" << escape(_asCode()) << "\"";
+            s << "\"";
+            appendEscaped(_asCode(), false, s);
+            s << "\"";
             break;
 
         case bsonTimestamp:
@@ -299,7 +318,6 @@ string BSONElement::jsonString(JsonStringFormat format, bool includeFieldNames,
             string message = ss.str();
             massert(10312, message.c_str(), false);
     }
-    return s.str();
 }
 
 namespace {
@@ -830,9 +848,8 @@ bool BSONObj::coerceVector(std::vector<T>* out) const {
 }
 
 // used by jsonString()
-std::string escape(const std::string& s, bool escape_slash) {
-    StringBuilder ret;
-    for (std::string::const_iterator i = s.begin(); i != s.end(); ++i) {
+void appendEscaped(StringData s, bool escape_slash, StringBuilder& ret) {
+    for (StringData::const_iterator i = s.begin(); i != s.end(); ++i) {
         switch (*i) {
             case '"':
                 ret << "\\\"";
@@ -868,6 +885,11 @@ std::string escape(const std::string& s, bool escape_slash) {
                 }
         }
     }
+}
+
+std::string escape(const std::string& s, bool escape_slash) {
+    StringBuilder ret;
+    appendEscaped(s, escape_slash, ret);
     return ret.str();
 }
 
@@ -182,6 +182,14 @@ public:
     std::string jsonString(JsonStringFormat format,
                            bool includeFieldNames = true,
                            int pretty = 0) const;
+
+    /**
+     * Appends the JSON representation of this element to 's', same as jsonString().
+     */
+    void jsonStringBuffer(JsonStringFormat format,
+                          bool includeFieldNames,
+                          int pretty,
+                          StringBuilder& s) const;
     operator std::string() const {
         return toString();
     }
@@ -819,4 +827,9 @@ inline BSONElement::BSONElement() {
 
 // TODO(SERVER-14596): move to a better place; take a StringData.
 std::string escape(const std::string& s, bool escape_slash = false);
+
+/**
+ * Appends the escaped form of 's' to 'out', same as escape().
+ */
+void appendEscaped(StringData s, bool escape_slash, StringBuilder& out);
 }
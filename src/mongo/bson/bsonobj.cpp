@@ -92,12 +92,25 @@ string BSONObj::jsonString(JsonStringFormat format, int pretty, bool isArray) co
         return isArray ? "[]" : "{}";
 
     StringBuilder s;
+    jsonStringBuffer(format, pretty, isArray, s);
+    return s.str();
+}
+
+void BSONObj::jsonStringBuffer(JsonStringFormat format,
+                               int pretty,
+                               bool isArray,
+                               StringBuilder& s) const {
+    if (isEmpty()) {
+        s << (isArray ? "[]" : "{}");
+        return;
+    }
+
     s << (isArray ? "[ " : "{ ");
     BSONObjIterator i(*this);
     BSONElement e = i.next();
     if (!e.eoo())
         while (1) {
-            s << e.jsonString(format, !isArray, pretty ? pretty + 1 : 0);
+            e.jsonStringBuffer(format, !isArray, pretty ? pretty + 1 : 0, s);
             e = i.next();
             if (e.eoo())
                 break;
@@ -111,7 +124,6 @@ string BSONObj::jsonString(JsonStringFormat format, int pretty, bool isArray) co
             }
         }
     s << (isArray ? " ]" : " }");
-    return s.str();
 }
 
 bool BSONObj::valid() const {
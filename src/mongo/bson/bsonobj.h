@@ -177,6 +177,30 @@ public:
         return _ownedBuffer.get() != 0;
     }
 
+    /**
+     * Makes this object share ownership of the buffer of 'other', which must be owned and contain
+     * this object's data, typically because this object was retrieved from a subobject or an
+     * array element of 'other'. This keeps the data alive for as long as this object is, without
+     * copying it like getOwned() would.
+     */
+    BSONObj& shareOwnershipWith(const BSONObj& other) {
+        invariant(other.isOwned());
+        dassert(other.objdata() <= objdata() &&
+                objdata() + objsize() <= other.objdata() + other.objsize());
+        _ownedBuffer = other._ownedBuffer;
+        return *this;
+    }
+
+    /**
+     * Makes this object share ownership of 'buffer', which must contain this object's data, for
+     * example because this object was received into it over the network.
+     */
+    BSONObj& shareOwnershipWith(const SharedBuffer& buffer) {
+        invariant(buffer.get());
+        _ownedBuffer = buffer;
+        return *this;
+    }
+
     /** assure the data buffer is under the control of this BSONObj and not a remote buffer
         @see isOwned()
     */
@@ -200,6 +224,15 @@ public:
                            int pretty = 0,
                            bool isArray = false) const;
 
+    /**
+     * Appends the JSON representation of this object to 's', same as jsonString(). Serializing
+     * into a single buffer avoids building a separate string for every nested element.
+     */
+    void jsonStringBuffer(JsonStringFormat format,
+                          int pretty,
+                          bool isArray,
+                          StringBuilder& s) const;
+
     /** note: addFields always adds _id even if not specified */
     int addFields(BSONObj& from, std::set<std::string>& fields); /* returns n added */
 
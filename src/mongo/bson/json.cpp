@@ -95,6 +95,16 @@ Status JParse::parseError(StringData msg) {
 
 Status JParse::value(StringData fieldName, BSONObjBuilder& builder) {
     MONGO_JSON_DEBUG("fieldName: " << fieldName);
+    // Go straight to number() for the common case of a plain number, rather than trying each
+    // of the tokens below first.
+    const char* first = _input;
+    while (first < _input_end && isspace(*reinterpret_cast<const unsigned char*>(first))) {
+        ++first;
+    }
+    if (first < _input_end && isdigit(*reinterpret_cast<const unsigned char*>(first))) {
+        return number(fieldName, builder);
+    }
+
     if (peekToken(LBRACE)) {
         Status ret = object(fieldName, builder);
         if (ret != Status::OK()) {
@@ -1175,6 +1185,17 @@ Status JParse::chars(std::string* result, const char* terminalSet, const char* a
                     // TODO: check for escaped control characters
             }
             ++q;
+        } else if (allowedSet == NULL && terminalSet[0] != '\0' && terminalSet[1] == '\0') {
+            // Copy the whole run of ordinary characters up to the next terminal, escape or
+            // control character at once.
+            const char terminal = terminalSet[0];
+            const char* runEnd = q + 1;
+            while (runEnd < _input_end && *runEnd != terminal && *runEnd != '\\' &&
+                   static_cast<unsigned char>(*runEnd) > 0x1F) {
+                ++runEnd;
+            }
+            result->append(q, runEnd - q);
+            q = runEnd;
         } else {
             result->push_back(*q++);
         }
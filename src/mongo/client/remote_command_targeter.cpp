@@ -29,7 +29,11 @@
 #include "mongo/platform/basic.h"
 
 #include "mongo/client/remote_command_targeter.h"
+#include "mongo/base/status_with.h"
+#include "mongo/client/read_preference.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/net/hostandport.h"
 
 namespace mongo {
 namespace {
@@ -46,6 +50,14 @@ const Seconds kFindHostTimeoutPad(1);
 
 }  // namespace
 
+StatusWith<HostAndPort> RemoteCommandTargeter::findAlternateHost(
+    const ReadPreferenceSetting& readPref, const HostAndPort& excluded) {
+    return Status(ErrorCodes::FailedToSatisfyReadPreference,
+                  str::stream() << "no host other than " << excluded.toString()
+                                << " is available to satisfy read preference "
+                                << readPref.toString());
+}
+
 Milliseconds RemoteCommandTargeter::selectFindHostMaxWaitTime(OperationContext* txn) {
     // TODO: Get remaining max time from 'txn'.
     Milliseconds remainingMaxTime(0);
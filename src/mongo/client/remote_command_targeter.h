@@ -72,6 +72,17 @@ public:
     virtual StatusWith<HostAndPort> findHost(const ReadPreferenceSetting& readPref,
                                              Milliseconds maxWait = Milliseconds(0)) = 0;
 
+    /**
+     * Obtains a host other than 'excluded', which matches the read preferences specified by
+     * readPref, without blocking. Used to select a second host to which a read can be sent in
+     * parallel with the one sent to 'excluded'.
+     *
+     * The default implementation returns FailedToSatisfyReadPreference, since targeters which
+     * represent a single host have no other host to offer.
+     */
+    virtual StatusWith<HostAndPort> findAlternateHost(const ReadPreferenceSetting& readPref,
+                                                      const HostAndPort& excluded);
+
     /**
      * Reports to the targeter that a NotMaster response was received when communicating with
      * "host', and so it should update its bookkeeping to avoid giving out the host again on a
@@ -36,7 +36,9 @@
 namespace mongo {
 
 RemoteCommandTargeterMock::RemoteCommandTargeterMock()
-    : _findHostReturnValue(Status(ErrorCodes::InternalError, "No return value set")) {}
+    : _findHostReturnValue(Status(ErrorCodes::InternalError, "No return value set")),
+      _findAlternateHostReturnValue(
+          Status(ErrorCodes::FailedToSatisfyReadPreference, "No return value set")) {}
 
 RemoteCommandTargeterMock::~RemoteCommandTargeterMock() = default;
 
@@ -57,6 +59,11 @@ StatusWith<HostAndPort> RemoteCommandTargeterMock::findHost(const ReadPreference
     return _findHostReturnValue;
 }
 
+StatusWith<HostAndPort> RemoteCommandTargeterMock::findAlternateHost(
+    const ReadPreferenceSetting& readPref, const HostAndPort& excluded) {
+    return _findAlternateHostReturnValue;
+}
+
 void RemoteCommandTargeterMock::markHostNotMaster(const HostAndPort& host) {}
 
 void RemoteCommandTargeterMock::markHostUnreachable(const HostAndPort& host) {}
@@ -69,4 +76,9 @@ void RemoteCommandTargeterMock::setFindHostReturnValue(StatusWith<HostAndPort> r
     _findHostReturnValue = std::move(returnValue);
 }
 
+void RemoteCommandTargeterMock::setFindAlternateHostReturnValue(
+    StatusWith<HostAndPort> returnValue) {
+    _findAlternateHostReturnValue = std::move(returnValue);
+}
+
 }  // namespace mongo
@@ -57,6 +57,13 @@ public:
     StatusWith<HostAndPort> findHost(const ReadPreferenceSetting& readPref,
                                      Milliseconds maxWait) override;
 
+    /**
+     * Returns the return value last set by setFindAlternateHostReturnValue.
+     * Returns ErrorCodes::FailedToSatisfyReadPreference if it was never called.
+     */
+    StatusWith<HostAndPort> findAlternateHost(const ReadPreferenceSetting& readPref,
+                                              const HostAndPort& excluded) override;
+
     /**
      * No-op for the mock.
      */
@@ -77,9 +84,15 @@ public:
      */
     void setFindHostReturnValue(StatusWith<HostAndPort> returnValue);
 
+    /**
+     * Sets the return value for the next call to findAlternateHost.
+     */
+    void setFindAlternateHostReturnValue(StatusWith<HostAndPort> returnValue);
+
 private:
     ConnectionString _connectionStringReturnValue;
     StatusWith<HostAndPort> _findHostReturnValue;
+    StatusWith<HostAndPort> _findAlternateHostReturnValue;
 };
 
 }  // namespace mongo
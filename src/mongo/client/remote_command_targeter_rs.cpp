@@ -63,6 +63,11 @@ StatusWith<HostAndPort> RemoteCommandTargeterRS::findHost(const ReadPreferenceSe
     return _rsMonitor->getHostOrRefresh(readPref, maxWait);
 }
 
+StatusWith<HostAndPort> RemoteCommandTargeterRS::findAlternateHost(
+    const ReadPreferenceSetting& readPref, const HostAndPort& excluded) {
+    return _rsMonitor->getAlternateHost(readPref, excluded);
+}
+
 void RemoteCommandTargeterRS::markHostNotMaster(const HostAndPort& host) {
     invariant(_rsMonitor);
 
@@ -80,6 +80,16 @@ public:
     StatusWith<HostAndPort> getHostOrRefresh(const ReadPreferenceSetting& readPref,
                                              Milliseconds maxWait = kDefaultFindHostTimeout);
 
+    /**
+     * Returns a host other than 'excluded' matching the given read preference, based only on the
+     * current view of the set. Never refreshes or waits, so it is cheap enough to call on the
+     * critical path of a request. Used to pick a second host to send a hedged read to.
+     *
+     * Returns FailedToSatisfyReadPreference if no other known host matches.
+     */
+    StatusWith<HostAndPort> getAlternateHost(const ReadPreferenceSetting& readPref,
+                                             const HostAndPort& excluded);
+
     /**
      * Returns the host we think is the current master or uasserts.
      *
@@ -133,11 +133,13 @@ public:
     bool isUsable() const;
 
     /**
-     * Returns a host matching criteria or an empty host if no known host matches.
+     * Returns a host matching criteria or an empty host if no known host matches. Never returns
+     * 'excluded', if it is set.
      *
      * Note: Uses only local data and does not go over the network.
      */
-    HostAndPort getMatchingHost(const ReadPreferenceSetting& criteria) const;
+    HostAndPort getMatchingHost(const ReadPreferenceSetting& criteria,
+                                const HostAndPort& excluded = HostAndPort()) const;
 
     /**
      * Returns the Node with the given host, or NULL if no Node has that host.
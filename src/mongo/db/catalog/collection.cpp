@@ -45,6 +45,7 @@
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/curop.h"
+#include "mongo/db/field_ref_set.h"
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/keypattern.h"
 #include "mongo/db/matcher/expression_parser.h"
@@ -85,6 +86,24 @@ Status checkValidatorForBannedExpressions(const BSONObj& validator) {
 
     return Status::OK();
 }
+
+/**
+ * Returns true if updating the paths in 'updatedFields' may change the keys of an index over
+ * 'indexedPaths'. A NULL 'indexedPaths' stands for an index whose paths are unknown.
+ */
+bool mayChangeIndexKeys(const UpdateIndexData* indexedPaths, const FieldRefSet& updatedFields) {
+    if (!indexedPaths) {
+        return true;
+    }
+
+    for (FieldRefSet::const_iterator it = updatedFields.begin(); it != updatedFields.end(); ++it) {
+        if (indexedPaths->mightBeIndexed((*it)->dottedField())) {
+            return true;
+        }
+    }
+
+    return false;
+}
 }
 
 using std::unique_ptr;
@@ -270,6 +289,7 @@ Status Collection::checkValidation(OperationContext* txn, const BSONObj& documen
     if (documentValidationDisabled(txn))
         return Status::OK();
 
+    WritePhaseTimer timer(txn, WritePhase::kValidation);
     if (_validator->matchesBSON(document))
         return Status::OK();
 
@@ -510,6 +530,7 @@ StatusWith<RecordId> Collection::updateDocument(OperationContext* txn,
                                                 const BSONObj& newDoc,
                                                 bool enforceQuota,
                                                 bool indexesAffected,
+                                                const FieldRefSet* updatedFields,
                                                 OpDebug* debug,
                                                 oplogUpdateEntryArgs& args) {
     {
@@ -566,6 +587,13 @@ StatusWith<RecordId> Collection::updateDocument(OperationContext* txn,
         IndexCatalog::IndexIterator ii = _indexCatalog.getIndexIterator(txn, true);
         while (ii.more()) {
             IndexDescriptor* descriptor = ii.next();
+
+            // Leave alone the indexes over none of the updated paths, their keys can't change.
+            if (updatedFields && !updatedFields->empty() &&
+                !mayChangeIndexKeys(infoCache()->getIndexKeys(txn, descriptor), *updatedFields)) {
+                continue;
+            }
+
             IndexCatalogEntry* entry = ii.catalogEntry(descriptor);
             IndexAccessMethod* iam = ii.accessMethod(descriptor);
 
@@ -630,10 +658,15 @@ StatusWith<RecordId> Collection::updateDocument(OperationContext* txn,
         IndexCatalog::IndexIterator ii = _indexCatalog.getIndexIterator(txn, true);
         while (ii.more()) {
             IndexDescriptor* descriptor = ii.next();
+            auto ticket = updateTickets.mutableMap().find(descriptor);
+            if (ticket == updateTickets.mutableMap().end()) {
+                continue;
+            }
+
             IndexAccessMethod* iam = ii.accessMethod(descriptor);
 
             int64_t updatedKeys;
-            Status ret = iam->update(txn, *updateTickets.mutableMap()[descriptor], &updatedKeys);
+            Status ret = iam->update(txn, *ticket->second, &updatedKeys);
             if (!ret.isOK())
                 return StatusWith<RecordId>(ret);
             if (debug)
@@ -56,6 +56,7 @@ namespace mongo {
 class CollectionCatalogEntry;
 class DatabaseCatalogEntry;
 class ExtentManager;
+class FieldRefSet;
 class IndexCatalog;
 class MatchExpression;
 class MultiIndexBlock;
@@ -72,6 +73,9 @@ struct CompactOptions {
         validateDocuments = true;
         paddingFactor = 1;
         paddingBytes = 0;
+        maxRecordsPerStep = 100;
+        maxDeletedRecordsPerStep = 1000;
+        minFreeFraction = 0.5;
     }
 
     // padding
@@ -89,15 +93,26 @@ struct CompactOptions {
     // other
     bool validateDocuments;
 
+    // only used by online compaction
+    int maxRecordsPerStep;         // how many records one step may move before yielding
+    int maxDeletedRecordsPerStep;  // how many freelist entries one step may walk
+    double minFreeFraction;        // extents with a smaller fraction of free space are left alone
+
     std::string toString() const;
 };
 
 struct CompactStats {
     CompactStats() {
         corruptDocuments = 0;
+        recordsMoved = 0;
+        extentsFreed = 0;
     }
 
     long long corruptDocuments;
+
+    // only filled in by online compaction
+    long long recordsMoved;
+    long long extentsFreed;
 };
 
 /**
@@ -296,6 +311,8 @@ public:
      * updates the document @ oldLocation with newDoc
      * if the document fits in the old space, it is put there
      * if not, it is moved
+     * if indexesAffected, the indexes are updated. When updatedFields is not NULL nor empty, it
+     * lists the paths which may have changed, and only the indexes over those paths are updated.
      * @return the post update location of the doc (may or may not be the same as oldLocation)
      */
     StatusWith<RecordId> updateDocument(OperationContext* txn,
@@ -304,6 +321,7 @@ public:
                                         const BSONObj& newDoc,
                                         bool enforceQuota,
                                         bool indexesAffected,
+                                        const FieldRefSet* updatedFields,
                                         OpDebug* debug,
                                         oplogUpdateEntryArgs& args);
 
@@ -325,6 +343,20 @@ public:
 
     StatusWith<CompactStats> compact(OperationContext* txn, const CompactOptions* options);
 
+    /**
+     * Does one bounded step of compacting this collection without taking it offline. Only needs
+     * the collection locked in MODE_IX; callers should release their locks between steps.
+     * Moved documents are unindexed and reindexed the same way as documents moved by an update.
+     *
+     * Returns true if there is more to do. Call compactOnlineDone() once no more steps will
+     * follow, whether or not the last step returned false.
+     */
+    StatusWith<bool> compactOnlineStep(OperationContext* txn,
+                                       const CompactOptions* options,
+                                       CompactStats* stats);
+
+    void compactOnlineDone(OperationContext* txn);
+
     /**
      * removes all documents as fast as possible
      * indexes before and after will be the same
@@ -95,6 +95,36 @@ private:
 
     MultiIndexBlock* _multiIndexBlock;
 };
+
+/**
+ * Used by online compaction, where the indexes stay in place: moved records are indexed at
+ * their new location as soon as they are written.
+ */
+class OnlineCompactAdaptor : public RecordStoreCompactAdaptor {
+public:
+    OnlineCompactAdaptor(OperationContext* txn, IndexCatalog* indexCatalog)
+        : _txn(txn), _indexCatalog(indexCatalog) {}
+
+    virtual bool isDataValid(const RecordData& recData) {
+        return recData.toBson().valid();
+    }
+
+    virtual size_t dataSize(const RecordData& recData) {
+        return recData.toBson().objsize();
+    }
+
+    virtual void inserted(const RecordData& recData, const RecordId& newLocation) {
+        const BSONObj doc = recData.toBson();
+        std::vector<BsonRecord> bsonRecords;
+        BsonRecord bsonRecord = {newLocation, &doc};
+        bsonRecords.push_back(bsonRecord);
+        uassertStatusOK(_indexCatalog->indexRecords(_txn, bsonRecords));
+    }
+
+private:
+    OperationContext* const _txn;
+    IndexCatalog* const _indexCatalog;
+};
 }
 
 
@@ -190,4 +220,32 @@ StatusWith<CompactStats> Collection::compact(OperationContext* txn,
     return StatusWith<CompactStats>(stats);
 }
 
+StatusWith<bool> Collection::compactOnlineStep(OperationContext* txn,
+                                               const CompactOptions* compactOptions,
+                                               CompactStats* stats) {
+    dassert(txn->lockState()->isCollectionLockedForMode(ns().toString(), MODE_IX));
+
+    if (!_recordStore->compactOnlineSupported())
+        return StatusWith<bool>(ErrorCodes::CommandNotSupported,
+                                str::stream()
+                                    << "cannot compact online collection with record store: "
+                                    << _recordStore->name());
+
+    if (_indexCatalog.numIndexesInProgress(txn))
+        return StatusWith<bool>(ErrorCodes::BadValue, "cannot compact when indexes in progress");
+
+    // Records are moved with their contents unchanged, so there is nothing to validate and
+    // nothing to replicate: RecordIds are local to each node.
+    DisableDocumentValidation validationDisabler(txn);
+
+    OnlineCompactAdaptor adaptor(txn, &_indexCatalog);
+    return _recordStore->compactOnline(txn, &adaptor, this, compactOptions, stats);
+}
+
+void Collection::compactOnlineDone(OperationContext* txn) {
+    dassert(txn->lockState()->isCollectionLockedForMode(ns().toString(), MODE_IX));
+
+    _recordStore->compactOnlineDone(txn);
+}
+
 }  // namespace mongo
@@ -63,54 +63,79 @@ const UpdateIndexData& CollectionInfoCache::getIndexKeys(OperationContext* txn)
     return _indexedPaths;
 }
 
-void CollectionInfoCache::computeIndexKeys(OperationContext* txn) {
-    _indexedPaths.clear();
+const UpdateIndexData* CollectionInfoCache::getIndexKeys(OperationContext* txn,
+                                                         const IndexDescriptor* desc) const {
+    // This requires "some" lock, and MODE_IS is an expression for that, for now.
+    dassert(txn->lockState()->isCollectionLockedForMode(_collection->ns().ns(), MODE_IS));
+    invariant(_keysComputed);
+    auto it = _indexedPathsByIndex.find(desc);
+    return it == _indexedPathsByIndex.end() ? NULL : &it->second;
+}
 
-    IndexCatalog::IndexIterator i = _collection->getIndexCatalog()->getIndexIterator(txn, true);
-    while (i.more()) {
-        IndexDescriptor* descriptor = i.next();
+namespace {
 
-        if (descriptor->getAccessMethodName() != IndexNames::TEXT) {
-            BSONObj key = descriptor->keyPattern();
-            BSONObjIterator j(key);
-            while (j.more()) {
-                BSONElement e = j.next();
-                _indexedPaths.addPath(e.fieldName());
-            }
+/**
+ * Adds to 'indexedPaths' the paths which take part in the keys of the index 'descriptor', or in
+ * its partial filter.
+ */
+void addIndexedPaths(const IndexDescriptor* descriptor,
+                     const IndexCatalogEntry* entry,
+                     UpdateIndexData* indexedPaths) {
+    if (descriptor->getAccessMethodName() != IndexNames::TEXT) {
+        BSONObj key = descriptor->keyPattern();
+        BSONObjIterator j(key);
+        while (j.more()) {
+            BSONElement e = j.next();
+            indexedPaths->addPath(e.fieldName());
+        }
+    } else {
+        fts::FTSSpec ftsSpec(descriptor->infoObj());
+
+        if (ftsSpec.wildcard()) {
+            indexedPaths->allPathsIndexed();
         } else {
-            fts::FTSSpec ftsSpec(descriptor->infoObj());
-
-            if (ftsSpec.wildcard()) {
-                _indexedPaths.allPathsIndexed();
-            } else {
-                for (size_t i = 0; i < ftsSpec.numExtraBefore(); ++i) {
-                    _indexedPaths.addPath(ftsSpec.extraBefore(i));
-                }
-                for (fts::Weights::const_iterator it = ftsSpec.weights().begin();
-                     it != ftsSpec.weights().end();
-                     ++it) {
-                    _indexedPaths.addPath(it->first);
-                }
-                for (size_t i = 0; i < ftsSpec.numExtraAfter(); ++i) {
-                    _indexedPaths.addPath(ftsSpec.extraAfter(i));
-                }
-                // Any update to a path containing "language" as a component could change the
-                // language of a subdocument.  Add the override field as a path component.
-                _indexedPaths.addPathComponent(ftsSpec.languageOverrideField());
+            for (size_t i = 0; i < ftsSpec.numExtraBefore(); ++i) {
+                indexedPaths->addPath(ftsSpec.extraBefore(i));
+            }
+            for (fts::Weights::const_iterator it = ftsSpec.weights().begin();
+                 it != ftsSpec.weights().end();
+                 ++it) {
+                indexedPaths->addPath(it->first);
+            }
+            for (size_t i = 0; i < ftsSpec.numExtraAfter(); ++i) {
+                indexedPaths->addPath(ftsSpec.extraAfter(i));
             }
+            // Any update to a path containing "language" as a component could change the
+            // language of a subdocument.  Add the override field as a path component.
+            indexedPaths->addPathComponent(ftsSpec.languageOverrideField());
         }
+    }
 
-        // handle partial indexes
-        const IndexCatalogEntry* entry = i.catalogEntry(descriptor);
-        const MatchExpression* filter = entry->getFilterExpression();
-        if (filter) {
-            unordered_set<std::string> paths;
-            QueryPlannerIXSelect::getFields(filter, "", &paths);
-            for (auto it = paths.begin(); it != paths.end(); ++it) {
-                _indexedPaths.addPath(*it);
-            }
+    // handle partial indexes
+    const MatchExpression* filter = entry->getFilterExpression();
+    if (filter) {
+        unordered_set<std::string> paths;
+        QueryPlannerIXSelect::getFields(filter, "", &paths);
+        for (auto it = paths.begin(); it != paths.end(); ++it) {
+            indexedPaths->addPath(*it);
         }
     }
+}
+
+}  // namespace
+
+void CollectionInfoCache::computeIndexKeys(OperationContext* txn) {
+    _indexedPaths.clear();
+    _indexedPathsByIndex.clear();
+
+    IndexCatalog::IndexIterator i = _collection->getIndexCatalog()->getIndexIterator(txn, true);
+    while (i.more()) {
+        IndexDescriptor* descriptor = i.next();
+        const IndexCatalogEntry* entry = i.catalogEntry(descriptor);
+
+        addIndexedPaths(descriptor, entry, &_indexedPaths);
+        addIndexedPaths(descriptor, entry, &_indexedPathsByIndex[descriptor]);
+    }
 
     _keysComputed = true;
 }
@@ -30,6 +30,8 @@
 
 #pragma once
 
+#include <map>
+
 #include "mongo/db/collection_index_usage_tracker.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/query_settings.h"
@@ -64,6 +66,12 @@ public:
     */
     const UpdateIndexData& getIndexKeys(OperationContext* txn) const;
 
+    /**
+     * Same as above, restricted to the paths indexed by the index 'desc'. Returns NULL if the
+     * cache does not know about 'desc'.
+     */
+    const UpdateIndexData* getIndexKeys(OperationContext* txn, const IndexDescriptor* desc) const;
+
     /**
      * Returns cached index usage statistics for this collection.  The map returned will contain
      * entry for each index in the collection along with both a usage counter and a timestamp
@@ -112,6 +120,9 @@ private:
     bool _keysComputed;
     UpdateIndexData _indexedPaths;
 
+    // The paths indexed by each index, '_indexedPaths' being their union.
+    std::map<const IndexDescriptor*, UpdateIndexData> _indexedPathsByIndex;
+
     // A cache for query plans.
     std::unique_ptr<PlanCache> _planCache;
 
@@ -48,12 +48,45 @@
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
 using std::string;
 using std::stringstream;
 
+namespace {
+/**
+ * Parses the padding options shared by compact and compactOnline.
+ */
+bool parsePaddingOptions(const BSONObj& cmdObj, CompactOptions* compactOptions, string& errmsg) {
+    if (cmdObj["preservePadding"].trueValue()) {
+        compactOptions->paddingMode = CompactOptions::PRESERVE;
+        if (cmdObj.hasElement("paddingFactor") || cmdObj.hasElement("paddingBytes")) {
+            errmsg = "cannot mix preservePadding and paddingFactor|paddingBytes";
+            return false;
+        }
+    } else if (cmdObj.hasElement("paddingFactor") || cmdObj.hasElement("paddingBytes")) {
+        compactOptions->paddingMode = CompactOptions::MANUAL;
+        if (cmdObj.hasElement("paddingFactor")) {
+            compactOptions->paddingFactor = cmdObj["paddingFactor"].Number();
+            if (compactOptions->paddingFactor < 1 || compactOptions->paddingFactor > 4) {
+                errmsg = "invalid padding factor";
+                return false;
+            }
+        }
+        if (cmdObj.hasElement("paddingBytes")) {
+            compactOptions->paddingBytes = cmdObj["paddingBytes"].numberInt();
+            if (compactOptions->paddingBytes < 0 || compactOptions->paddingBytes > (1024 * 1024)) {
+                errmsg = "invalid padding bytes";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+}  // namespace
+
 class CompactCmd : public Command {
 public:
     virtual bool isWriteCommandForConfigServer() const {
@@ -117,31 +150,8 @@ public:
         }
 
         CompactOptions compactOptions;
-
-        if (cmdObj["preservePadding"].trueValue()) {
-            compactOptions.paddingMode = CompactOptions::PRESERVE;
-            if (cmdObj.hasElement("paddingFactor") || cmdObj.hasElement("paddingBytes")) {
-                errmsg = "cannot mix preservePadding and paddingFactor|paddingBytes";
-                return false;
-            }
-        } else if (cmdObj.hasElement("paddingFactor") || cmdObj.hasElement("paddingBytes")) {
-            compactOptions.paddingMode = CompactOptions::MANUAL;
-            if (cmdObj.hasElement("paddingFactor")) {
-                compactOptions.paddingFactor = cmdObj["paddingFactor"].Number();
-                if (compactOptions.paddingFactor < 1 || compactOptions.paddingFactor > 4) {
-                    errmsg = "invalid padding factor";
-                    return false;
-                }
-            }
-            if (cmdObj.hasElement("paddingBytes")) {
-                compactOptions.paddingBytes = cmdObj["paddingBytes"].numberInt();
-                if (compactOptions.paddingBytes < 0 ||
-                    compactOptions.paddingBytes > (1024 * 1024)) {
-                    errmsg = "invalid padding bytes";
-                    return false;
-                }
-            }
-        }
+        if (!parsePaddingOptions(cmdObj, &compactOptions, errmsg))
+            return false;
 
         if (cmdObj.hasElement("validate"))
             compactOptions.validateDocuments = cmdObj["validate"].trueValue();
@@ -176,4 +186,133 @@ public:
     }
 };
 static CompactCmd compactCmd;
+
+/**
+ * Compacts a collection a few records at a time, releasing its locks between steps so that the
+ * collection stays available. Documents in the sparsest extents are moved into free space in
+ * other extents and each extent is returned to the storage engine once it is empty.
+ */
+class CompactOnlineCmd : public Command {
+public:
+    virtual bool isWriteCommandForConfigServer() const {
+        return false;
+    }
+    virtual bool adminOnly() const {
+        return false;
+    }
+    virtual bool slaveOk() const {
+        return true;
+    }
+    virtual void addRequiredPrivileges(const std::string& dbname,
+                                       const BSONObj& cmdObj,
+                                       std::vector<Privilege>* out) {
+        ActionSet actions;
+        actions.addAction(ActionType::compact);
+        out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
+    }
+    virtual void help(stringstream& help) const {
+        help << "compact collection without taking it offline (mmapv1 only)\n"
+                "you can cancel with killOp()\n"
+                "{ compactOnline : <collection_name>, [batchSize:<num>], [minFreeFraction:<num>],\n"
+                "  [preservePadding:<bool>], [paddingFactor:<num>], [paddingBytes:<num>] }\n"
+                "  batchSize - documents moved before the locks are released (default 100)\n"
+                "  minFreeFraction - only empty extents with at least this fraction of free "
+                "space (default 0.5)\n";
+    }
+    CompactOnlineCmd() : Command("compactOnline") {}
+
+    virtual bool run(OperationContext* txn,
+                     const string& db,
+                     BSONObj& cmdObj,
+                     int,
+                     string& errmsg,
+                     BSONObjBuilder& result) {
+        const NamespaceString nss(parseNsCollectionRequired(db, cmdObj));
+        if (!nss.isNormal()) {
+            errmsg = "bad namespace name";
+            return false;
+        }
+
+        if (nss.isSystem()) {
+            errmsg = "can't compact a system namespace";
+            return false;
+        }
+
+        CompactOptions compactOptions;
+        if (!parsePaddingOptions(cmdObj, &compactOptions, errmsg))
+            return false;
+
+        if (cmdObj.hasElement("batchSize")) {
+            compactOptions.maxRecordsPerStep = cmdObj["batchSize"].numberInt();
+            if (compactOptions.maxRecordsPerStep < 1 ||
+                compactOptions.maxRecordsPerStep > 10000) {
+                errmsg = "invalid batchSize";
+                return false;
+            }
+        }
+
+        if (cmdObj.hasElement("minFreeFraction")) {
+            compactOptions.minFreeFraction = cmdObj["minFreeFraction"].numberDouble();
+            if (!(compactOptions.minFreeFraction > 0 && compactOptions.minFreeFraction <= 1)) {
+                errmsg = "invalid minFreeFraction";
+                return false;
+            }
+        }
+
+        // Keeps drops and other compactions of this collection out until we are done.
+        std::unique_ptr<BackgroundOperation> backgroundOp;
+        {
+            ScopedTransaction transaction(txn, MODE_IX);
+            AutoGetCollection autoColl(txn, nss, MODE_IX);
+            if (!autoColl.getCollection()) {
+                errmsg = "namespace does not exist";
+                return false;
+            }
+
+            BackgroundOperation::assertNoBgOpInProgForNs(nss.ns());
+            backgroundOp.reset(new BackgroundOperation(nss.ns()));
+        }
+
+        // However we leave the loop below, let the record store forget the compaction state.
+        ON_BLOCK_EXIT([&] {
+            ScopedTransaction transaction(txn, MODE_IX);
+            AutoGetCollection autoColl(txn, nss, MODE_IX);
+            if (autoColl.getCollection())
+                autoColl.getCollection()->compactOnlineDone(txn);
+        });
+
+        log() << "compactOnline " << nss.ns() << " begin, options: " << compactOptions.toString()
+              << " batchSize: " << compactOptions.maxRecordsPerStep
+              << " minFreeFraction: " << compactOptions.minFreeFraction;
+
+        CompactStats stats;
+        bool more = true;
+        while (more) {
+            txn->checkForInterrupt();
+
+            // Locks are only held for one step at a time.
+            ScopedTransaction transaction(txn, MODE_IX);
+            AutoGetCollection autoColl(txn, nss, MODE_IX);
+            Collection* const collection = autoColl.getCollection();
+            if (!collection) {
+                errmsg = "collection dropped during compactOnline";
+                return false;
+            }
+
+            StatusWith<bool> status = collection->compactOnlineStep(txn, &compactOptions, &stats);
+            if (!status.isOK())
+                return appendCommandStatus(result, status.getStatus());
+            more = status.getValue();
+        }
+
+        result.append("recordsMoved", stats.recordsMoved);
+        result.append("extentsFreed", stats.extentsFreed);
+
+        log() << "compactOnline " << nss.ns() << " end, moved " << stats.recordsMoved
+              << " documents and freed " << stats.extentsFreed << " extents";
+
+        return true;
+    }
+};
+static CompactOnlineCmd compactOnlineCmd;
 }
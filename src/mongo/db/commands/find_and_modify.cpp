@@ -416,7 +416,7 @@ public:
                 // Fill out OpDebug with the number of deleted docs.
                 CurOp::get(txn)->debug().ndeleted = getDeleteStats(exec.get())->docsDeleted;
 
-                boost::optional<BSONObj> value = advanceStatus.getValue();
+                const boost::optional<BSONObj>& value = advanceStatus.getValue();
                 appendCommandResponse(exec.get(), args.isRemove(), value, result);
             } else {
                 UpdateRequest request(nsString);
@@ -500,7 +500,7 @@ public:
                 }
                 UpdateStage::fillOutOpDebug(getUpdateStats(exec.get()), &summaryStats, opDebug);
 
-                boost::optional<BSONObj> value = advanceStatus.getValue();
+                const boost::optional<BSONObj>& value = advanceStatus.getValue();
                 appendCommandResponse(exec.get(), args.isRemove(), value, result);
             }
         }
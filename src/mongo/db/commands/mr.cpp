@@ -1724,10 +1724,7 @@ public:
             // Fetch result from other shards 1 chunk at a time. It would be better to do
             // just one big $or query, but then the sorting would not be efficient.
             const string shardName = ShardingState::get(txn)->getShardName();
-            const ChunkMap& chunkMap = cm->getChunkMap();
-
-            for (ChunkMap::const_iterator it = chunkMap.begin(); it != chunkMap.end(); ++it) {
-                ChunkPtr chunk = it->second;
+            for (const ChunkPtr& chunk : cm->getChunks()) {
                 if (chunk->getShardId() == shardName) {
                     chunks.push_back(chunk);
                 }
@@ -762,6 +762,9 @@ bool WriteBatchExecutor::insertMany(WriteBatchExecutor::ExecInsertsState* state,
                                     CurOp* currentOp,
                                     std::vector<WriteErrorDetail*>* errors,
                                     bool ordered) {
+    if (endIndex - startIndex > 1 && insertGroup(state, startIndex, endIndex, currentOp))
+        return false;
+
     for (state->currIndex = startIndex; state->currIndex < endIndex; ++state->currIndex) {
         WriteOpResult result;
         BatchItemRef currInsertItem(state->request, state->currIndex);
@@ -801,6 +804,70 @@ bool WriteBatchExecutor::insertMany(WriteBatchExecutor::ExecInsertsState* state,
     return false;
 }
 
+// Inserts the specified subset of the batch in one unit of work, so that the whole subset costs a
+// single storage engine commit. Any failure rolls the unit of work back and leaves it to
+// insertMany to insert the documents one at a time, which produces the per-document errors.
+bool WriteBatchExecutor::insertGroup(WriteBatchExecutor::ExecInsertsState* state,
+                                     size_t startIndex,
+                                     size_t endIndex,
+                                     CurOp* currentOp) {
+    if (state->request->isInsertIndexRequest())
+        return false;
+
+    std::vector<BSONObj> docs;
+    docs.reserve(endIndex - startIndex);
+    for (size_t i = startIndex; i < endIndex; ++i) {
+        if (i >= state->normalizedInserts.size() || !state->normalizedInserts[i].isOK())
+            return false;
+
+        const BSONObj& normalizedInsert = state->normalizedInserts[i].getValue();
+        docs.push_back(normalizedInsert.isEmpty()
+                           ? state->request->getInsertRequest()->getDocumentsAt(i)
+                           : normalizedInsert);
+    }
+
+    OperationContext* txn = state->txn;
+    invariant(!txn->lockState()->inAWriteUnitOfWork());
+
+    try {
+        WriteOpResult result;
+        if (!state->lockAndCheck(&result))
+            return false;
+
+        {
+            stdx::lock_guard<Client> lk(*txn->getClient());
+            currentOp->setQuery_inlock(docs.front());
+            currentOp->debug().query = docs.front();
+        }
+
+        WriteUnitOfWork wunit(txn);
+        if (!state->getCollection()->insertDocuments(txn, docs.begin(), docs.end(), true).isOK()) {
+            return false;
+        }
+        wunit.commit();
+    } catch (const WriteConflictException&) {
+        currentOp->debug().writeConflicts++;
+        txn->recoveryUnit()->abandonSnapshot();
+        WriteConflictException::logAndBackoff(0, "insert", state->request->getNS().ns());
+        return false;
+    } catch (const StaleConfigException&) {
+        return false;
+    } catch (const DBException& ex) {
+        if (ErrorCodes::isInterruption(ex.toStatus().code()))
+            throw;
+        return false;
+    }
+
+    const int nInserted = docs.size();
+    _opCounters->incInsertInWriteLock(nInserted);
+    _stats->numInserted += nInserted;
+    currentOp->debug().ninserted += nInserted;
+    // Leave the LastError as inserting the final document one at a time would have.
+    _le->recordInsert(1);
+    state->currIndex = endIndex;
+    return true;
+}
+
 // Instantiates an ExecInsertsState, which represents all of the state for the batch.
 // Breaks out into manageably sized chunks for insertMany, between which we can yield.
 // Encapsulates the lock state.
@@ -94,6 +94,17 @@ private:
                     std::vector<WriteErrorDetail*>* errors,
                     bool ordered);
 
+    /**
+     * Inserts a subset of an insert batch inside a single WriteUnitOfWork.
+     * Returns true if all of the documents were inserted. Returns false, without having inserted
+     * anything, if the subset must instead be inserted one document at a time, e.g. because one
+     * of the documents is invalid, a duplicate key was found, or a write conflict occurred.
+     */
+    bool insertGroup(WriteBatchExecutor::ExecInsertsState* state,
+                     size_t startIndex,
+                     size_t endIndex,
+                     CurOp* currentOp);
+
     /**
      * Executes the inserts of an insert batch and returns the write errors.
      *
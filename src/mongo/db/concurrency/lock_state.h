@@ -296,7 +296,8 @@ private:
  * Once the S lock is granted, the flush thread writes the journal entries to disk (it is
  * guaranteed that there will not be any modifications) and applies them to the shared view.
  *
- * After that, it upgrades the S lock to X and remaps the private view.
+ * After that, it remaps the private view. On platforms where the remap is not atomic, it first
+ * upgrades the S lock to X so that readers do not access the view while it is being replaced.
  *
  * NOTE: There should be only one usage of this class and this should be in dur.cpp
  */
@@ -306,7 +307,7 @@ public:
     ~AutoAcquireFlushLockForMMAPV1Commit();
 
     /**
-     * We need the exclusive lock in order to do the shared view remap.
+     * We need the exclusive lock in order to do the shared view remap where it is not atomic.
      */
     void upgradeFlushLockToExclusive();
 
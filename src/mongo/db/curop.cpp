@@ -273,6 +273,7 @@ ProgressMeter& CurOp::setMessage_inlock(const char* msg,
 }
 
 CurOp::~CurOp() {
+    _debug.recordWritePhaseStats();
     invariant(this == _stack->pop());
 }
 
@@ -457,6 +458,22 @@ StringData getProtoString(int op) {
 }
 }  // namespace
 
+void OpDebug::recordWritePhaseStats() const {
+    for (int i = 0; i < kNumWritePhases; ++i) {
+        if (writePhaseMicros[i] >= 0) {
+            globalWritePhaseStats.record(WritePhase(i), writePhaseMicros[i]);
+        }
+    }
+}
+
+void OpDebug::appendWritePhaseMicros(BSONObjBuilder* builder) const {
+    for (int i = 0; i < kNumWritePhases; ++i) {
+        if (writePhaseMicros[i] >= 0) {
+            builder->appendNumber(writePhaseName(WritePhase(i)), writePhaseMicros[i]);
+        }
+    }
+}
+
 #define OPDEBUG_TOSTRING_HELP(x) \
     if (x >= 0)                  \
     s << " " #x ":" << (x)
@@ -523,6 +540,14 @@ string OpDebug::report(const CurOp& curop, const SingleThreadedLockStats& lockSt
     OPDEBUG_TOSTRING_HELP(keyUpdates);
     OPDEBUG_TOSTRING_HELP(writeConflicts);
 
+    {
+        BSONObjBuilder phases;
+        appendWritePhaseMicros(&phases);
+        if (!phases.asTempObj().isEmpty()) {
+            s << " writePhaseMicros:" << phases.obj().toString();
+        }
+    }
+
     if (!exceptionInfo.empty()) {
         s << " exception: " << exceptionInfo.msg;
         if (exceptionInfo.code)
@@ -641,6 +666,13 @@ void OpDebug::append(const CurOp& curop,
     OPDEBUG_APPEND_BOOL(cursorExhausted);
     OPDEBUG_APPEND_NUMBER(keyUpdates);
     OPDEBUG_APPEND_NUMBER(writeConflicts);
+    {
+        BSONObjBuilder phases;
+        appendWritePhaseMicros(&phases);
+        if (!phases.asTempObj().isEmpty()) {
+            b.append("writePhaseMicros", phases.obj());
+        }
+    }
     b.appendNumber("numYield", curop.numYields());
 
     {
@@ -34,11 +34,13 @@
 #include "mongo/base/disallow_copying.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/server_options.h"
+#include "mongo/db/stats/write_phase_stats.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/util/concurrency/spin_lock.h"
 #include "mongo/util/progress_meter.h"
 #include "mongo/util/thread_safe_string.h"
 #include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
 #include "mongo/util/net/message.h"
 
 namespace mongo {
@@ -191,6 +193,23 @@ public:
     int keyUpdates{0};
     long long writeConflicts{0};
 
+    // Time spent in each WritePhase, indexed by the phase. -1 if the phase never ran.
+    static_assert(kNumWritePhases == 6, "writePhaseMicros needs an initializer per phase");
+    long long writePhaseMicros[kNumWritePhases]{-1, -1, -1, -1, -1, -1};
+
+    /**
+     * Adds 'micros' to the time this operation spent in 'phase'.
+     */
+    void recordWritePhase(WritePhase phase, long long micros) {
+        long long& total = writePhaseMicros[static_cast<int>(phase)];
+        total = (total < 0 ? 0 : total) + micros;
+    }
+
+    /**
+     * Adds each phase that ran to the server-wide WritePhaseStats. Called once per operation.
+     */
+    void recordWritePhaseStats() const;
+
     // New Query Framework debugging/profiling info
     // TODO: should this really be an opaque BSONObj?  Not sure.
     CachedBSONObj<4096> execStats;
@@ -204,6 +223,11 @@ public:
     int responseLength{-1};
 
 private:
+    /**
+     * Appends {<phase name>: micros} for each WritePhase that ran.
+     */
+    void appendWritePhaseMicros(BSONObjBuilder* builder) const;
+
     /**
      * Returns true if this OpDebug instance was generated by a find command. Returns false for
      * OP_QUERY find and all other operations.
@@ -576,4 +600,25 @@ private:
         int64_t _approxTargetServerMillis{0};
     } _maxTimeTracker;
 };
+
+/**
+ * Adds the time between its construction and destruction to 'phase' of the current operation's
+ * OpDebug.
+ */
+class WritePhaseTimer {
+    MONGO_DISALLOW_COPYING(WritePhaseTimer);
+
+public:
+    WritePhaseTimer(OperationContext* txn, WritePhase phase)
+        : _debug(CurOp::get(txn)->debug()), _phase(phase) {}
+
+    ~WritePhaseTimer() {
+        _debug.recordWritePhase(_phase, _timer.micros());
+    }
+
+private:
+    OpDebug& _debug;
+    const WritePhase _phase;
+    const Timer _timer;
+};
 }
@@ -30,6 +30,7 @@
 
 #include "mongo/base/init.h"
 #include "mongo/db/client.h"
+#include "mongo/db/concurrency/lock_stats.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/operation_context_noop.h"
 #include "mongo/db/service_context.h"
@@ -98,6 +99,32 @@ TEST(TimeHasExpired, NegSimple) {
     ASSERT_FALSE(curOp.maxTimeHasExpired());
 }
 
+TEST(WritePhaseTimer, RecordsIntoCurrentOp) {
+    auto service = stdx::make_unique<ServiceContextNoop>();
+    auto client = service->makeClient("CurOpTest");
+    OperationContextNoop txn(client.get(), 100);
+    CurOp curOp(&txn);
+    {
+        WritePhaseTimer timer(&txn, WritePhase::kIndexWrite);
+        sleepmicros(intervalShort);
+    }
+    curOp.debug().recordWritePhase(WritePhase::kOplog, 5);
+    curOp.debug().recordWritePhase(WritePhase::kOplog, 7);
+
+    const OpDebug& debug = curOp.debug();
+    ASSERT_GREATER_THAN_OR_EQUALS(debug.writePhaseMicros[int(WritePhase::kIndexWrite)],
+                                  intervalShort);
+    ASSERT_EQUALS(12, debug.writePhaseMicros[int(WritePhase::kOplog)]);
+    ASSERT_EQUALS(-1, debug.writePhaseMicros[int(WritePhase::kValidation)]);
+
+    SingleThreadedLockStats lockStats;
+    BSONObjBuilder builder;
+    debug.append(curOp, lockStats, builder);
+    BSONObj phases = builder.obj()["writePhaseMicros"].Obj();
+    ASSERT_EQUALS(2, phases.nFields());
+    ASSERT_EQUALS(12, phases["oplog"].numberLong());
+}
+
 }  // namespace
 
 }  // namespace mongo
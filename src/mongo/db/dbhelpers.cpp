@@ -34,9 +34,12 @@
 
 #include <boost/filesystem/operations.hpp>
 #include <fstream>
+#include <map>
 
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/index_create.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/curop.h"
 #include "mongo/db/db.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/exec/working_set_common.h"
@@ -57,6 +60,7 @@
 #include "mongo/db/range_arithmetic.h"
 #include "mongo/db/repl/repl_client_info.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/data_protector.h"
 #include "mongo/db/storage/storage_options.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_customization_hooks.h"
@@ -81,6 +85,31 @@ using std::stringstream;
 
 using logger::LogComponent;
 
+namespace {
+
+// Maximum number of documents removeRange deletes in a single write unit of work, between which
+// it releases its locks and waits for replication. Configurable with server parameter
+// "removeRangeBatchSize".
+std::atomic<int> removeRangeBatchSize(128);  // NOLINT
+
+class RemoveRangeBatchSize
+    : public ExportedServerParameter<int, ServerParameterType::kStartupAndRuntime> {
+public:
+    RemoveRangeBatchSize()
+        : ExportedServerParameter<int, ServerParameterType::kStartupAndRuntime>(
+              ServerParameterSet::getGlobal(), "removeRangeBatchSize", &removeRangeBatchSize) {}
+
+    virtual Status validate(const int& potentialNewValue) {
+        if (potentialNewValue < 1 || potentialNewValue > 10000) {
+            return Status(ErrorCodes::BadValue, "removeRangeBatchSize has to be >= 1 and <= 10000");
+        }
+
+        return Status::OK();
+    }
+} removeRangeBatchSizeConfig;
+
+}  // namespace
+
 void Helpers::ensureIndex(OperationContext* txn,
                           Collection* collection,
                           BSONObj keyPattern,
@@ -340,8 +369,19 @@ long long Helpers::removeRange(OperationContext* txn,
 
     Milliseconds millisWaitingForReplication{0};
 
-    while (1) {
-        // Scoping for write lock.
+    const size_t batchSize = static_cast<size_t>(removeRangeBatchSize.load());
+    int writeConflictAttempts = 0;
+    bool done = false;
+
+    // Documents of the current batch which were already handed to 'callback'. A batch which hits a
+    // write conflict is scanned and deleted again, and its documents must not be saved twice.
+    std::map<RecordId, BSONObj> savedInBatch;
+
+    while (!done) {
+        long long numDeletedInBatch = 0;
+
+        // Scoping for write lock. The lock is held for one batch of deletes at a time and released
+        // in between, which is when other operations get to run.
         {
             OldClientWriteContext ctx(txn, ns);
             Collection* collection = ctx.getCollection();
@@ -351,92 +391,131 @@ long long Helpers::removeRange(OperationContext* txn,
             IndexDescriptor* desc =
                 collection->getIndexCatalog()->findIndexByKeyPattern(txn, indexKeyPattern.toBSON());
 
-            unique_ptr<PlanExecutor> exec(
-                InternalPlanner::indexScan(txn,
-                                           collection,
-                                           desc,
-                                           min,
-                                           max,
-                                           maxInclusive,
-                                           PlanExecutor::YIELD_MANUAL,
-                                           InternalPlanner::FORWARD,
-                                           InternalPlanner::IXSCAN_FETCH));
-            exec->setYieldPolicy(PlanExecutor::YIELD_AUTO);
-
-            RecordId rloc;
-            BSONObj obj;
-            PlanExecutor::ExecState state;
-            // This may yield so we cannot touch nsd after this.
-            state = exec->getNext(&obj, &rloc);
-            if (PlanExecutor::IS_EOF == state) {
-                break;
-            }
-
-            if (PlanExecutor::FAILURE == state || PlanExecutor::DEAD == state) {
-                warning(LogComponent::kSharding)
-                    << PlanExecutor::statestr(state) << " - cursor error while trying to delete "
-                    << min << " to " << max << " in " << ns << ": "
-                    << WorkingSetCommon::toStatusString(obj)
-                    << ", stats: " << Explain::getWinningPlanStats(exec.get()) << endl;
-                break;
-            }
-
-            verify(PlanExecutor::ADVANCED == state);
-
-            WriteUnitOfWork wuow(txn);
+            try {
+                // The scan must not yield, so that the record ids of the batch stay valid until the
+                // documents are deleted under the same lock. Without yielding, a NEED_YIELD
+                // surfaces as a WriteConflictException, so the scan is retried along with the
+                // deletes.
+                unique_ptr<PlanExecutor> exec(
+                    InternalPlanner::indexScan(txn,
+                                               collection,
+                                               desc,
+                                               min,
+                                               max,
+                                               maxInclusive,
+                                               PlanExecutor::YIELD_MANUAL,
+                                               InternalPlanner::FORWARD,
+                                               InternalPlanner::IXSCAN_FETCH));
+
+                std::vector<std::pair<RecordId, BSONObj>> batch;
+                while (batch.size() < batchSize) {
+                    RecordId rloc;
+                    BSONObj obj;
+                    PlanExecutor::ExecState state = exec->getNext(&obj, &rloc);
+                    if (PlanExecutor::IS_EOF == state) {
+                        done = true;
+                        break;
+                    }
+
+                    if (PlanExecutor::FAILURE == state || PlanExecutor::DEAD == state) {
+                        warning(LogComponent::kSharding)
+                            << PlanExecutor::statestr(state)
+                            << " - cursor error while trying to delete " << min << " to " << max
+                            << " in " << ns << ": "
+                            << WorkingSetCommon::toStatusString(obj)
+                            << ", stats: " << Explain::getWinningPlanStats(exec.get()) << endl;
+                        done = true;
+                        break;
+                    }
+
+                    verify(PlanExecutor::ADVANCED == state);
+                    batch.emplace_back(rloc, obj.getOwned());
+                }
 
-            if (onlyRemoveOrphanedDocs) {
-                // Do a final check in the write lock to make absolutely sure that our
-                // collection hasn't been modified in a way that invalidates our migration
-                // cleanup.
+                exec.reset();
 
-                // We should never be able to turn off the sharding state once enabled, but
-                // in the future we might want to.
-                verify(ShardingState::get(txn)->enabled());
+                if (batch.empty()) {
+                    break;
+                }
 
-                bool docIsOrphan;
+                NamespaceString nss(ns);
+                if (!repl::getGlobalReplicationCoordinator()->canAcceptWritesFor(nss)) {
+                    warning() << "stepped down from primary while deleting chunk; "
+                              << "orphaning data in " << ns << " in range [" << min << ", " << max
+                              << ")";
+                    return numDeleted;
+                }
 
                 // In write lock, so will be the most up-to-date version
-                std::shared_ptr<CollectionMetadata> metadataNow =
-                    ShardingState::get(txn)->getCollectionMetadata(ns);
-                if (metadataNow) {
-                    ShardKeyPattern kp(metadataNow->getKeyPattern());
-                    BSONObj key = kp.extractShardKeyFromDoc(obj);
-                    docIsOrphan =
-                        !metadataNow->keyBelongsToMe(key) && !metadataNow->keyIsPending(key);
-                } else {
-                    docIsOrphan = false;
+                std::shared_ptr<CollectionMetadata> metadataNow;
+                if (onlyRemoveOrphanedDocs) {
+                    // We should never be able to turn off the sharding state once enabled, but
+                    // in the future we might want to.
+                    verify(ShardingState::get(txn)->enabled());
+                    metadataNow = ShardingState::get(txn)->getCollectionMetadata(ns);
                 }
 
-                if (!docIsOrphan) {
-                    warning(LogComponent::kSharding)
-                        << "aborting migration cleanup for chunk " << min << " to " << max
-                        << (metadataNow ? (string) " at document " + obj.toString() : "")
-                        << ", collection " << ns << " has changed " << endl;
-                    break;
+                WriteUnitOfWork wuow(txn);
+
+                for (const auto& entry : batch) {
+                    const BSONObj& obj = entry.second;
+
+                    if (onlyRemoveOrphanedDocs) {
+                        // Do a final check in the write lock to make absolutely sure that our
+                        // collection hasn't been modified in a way that invalidates our
+                        // migration cleanup.
+                        bool docIsOrphan;
+                        if (metadataNow) {
+                            ShardKeyPattern kp(metadataNow->getKeyPattern());
+                            BSONObj key = kp.extractShardKeyFromDoc(obj);
+                            docIsOrphan = !metadataNow->keyBelongsToMe(key) &&
+                                !metadataNow->keyIsPending(key);
+                        } else {
+                            docIsOrphan = false;
+                        }
+
+                        if (!docIsOrphan) {
+                            warning(LogComponent::kSharding)
+                                << "aborting migration cleanup for chunk " << min << " to " << max
+                                << (metadataNow ? (string) " at document " + obj.toString() : "")
+                                << ", collection " << ns << " has changed " << endl;
+                            done = true;
+                            break;
+                        }
+                    }
+
+                    if (callback) {
+                        auto saved = savedInBatch.find(entry.first);
+                        if (saved == savedInBatch.end() || !saved->second.binaryEqual(obj)) {
+                            callback->goingToDelete(obj);
+                            savedInBatch[entry.first] = obj;
+                        }
+                    }
+
+                    collection->deleteDocument(txn, entry.first, fromMigrate);
+                    numDeletedInBatch++;
                 }
-            }
 
-            NamespaceString nss(ns);
-            if (!repl::getGlobalReplicationCoordinator()->canAcceptWritesFor(nss)) {
-                warning() << "stepped down from primary while deleting chunk; "
-                          << "orphaning data in " << ns << " in range [" << min << ", " << max
-                          << ")";
-                return numDeleted;
+                wuow.commit();
+            } catch (const WriteConflictException& wce) {
+                // Nothing from this batch was deleted, so just scan it again, on a new snapshot as
+                // MONGO_WRITE_CONFLICT_RETRY_LOOP_END does
+                ++CurOp::get(txn)->debug().writeConflicts;
+                wce.logAndBackoff(writeConflictAttempts++, "removeRange", ns);
+                txn->recoveryUnit()->abandonSnapshot();
+                done = false;
+                continue;
             }
 
-            if (callback)
-                callback->goingToDelete(obj);
-
-            collection->deleteDocument(txn, rloc, fromMigrate);
-            wuow.commit();
-            numDeleted++;
+            writeConflictAttempts = 0;
+            savedInBatch.clear();
+            numDeleted += numDeletedInBatch;
         }
 
         // TODO remove once the yielding below that references this timer has been removed
         Timer secondaryThrottleTime;
 
-        if (writeConcern.shouldWaitForOtherNodes() && numDeleted > 0) {
+        if (writeConcern.shouldWaitForOtherNodes() && numDeletedInBatch > 0) {
             repl::ReplicationCoordinator::StatusAndDuration replStatus =
                 repl::getGlobalReplicationCoordinator()->awaitReplication(
                     txn,
@@ -166,6 +166,9 @@ struct Helpers {
      *
      * Returns -1 when no usable index exists
      *
+     * Documents are deleted in batches of up to removeRangeBatchSize, each in a single write unit
+     * of work. Locks are released and replication is waited for between batches.
+     *
      * Does oplog the individual document deletions.
      * // TODO: Refactor this mechanism, it is growing too large
      */
@@ -445,87 +445,100 @@ BSONObj UpdateStage::transformAndUpdate(const Snapshotted<BSONObj>& oldObj, Reco
     // If asked to return new doc, default to the oldObj, in case nothing changes.
     BSONObj newObj = oldObj.value();
 
-    // Ask the driver to apply the mods. It may be that the driver can apply those "in
-    // place", that is, some values of the old document just get adjusted without any
-    // change to the binary layout on the bson layer. It may be that a whole new document
-    // is needed to accomodate the new bson layout of the resulting document. In any event,
-    // only enable in-place mutations if the underlying storage engine offers support for
-    // writing damage events.
-    _doc.reset(oldObj.value(),
-               (_collection->updateWithDamagesSupported()
-                    ? mutablebson::Document::kInPlaceEnabled
-                    : mutablebson::Document::kInPlaceDisabled));
+    const std::vector<FieldRef*>* immutableFields = NULL;
+    if (lifecycle)
+        immutableFields = lifecycle->getImmutableFields();
 
     BSONObj logObj;
 
     FieldRefSet updatedFields;
+    bool addedIdField = false;
     bool docWasModified = false;
 
-    Status status = Status::OK();
-    if (!driver->needMatchDetails()) {
-        // If we don't need match details, avoid doing the rematch
-        status = driver->update(StringData(), &_doc, &logObj, &updatedFields, &docWasModified);
-    } else {
-        // If there was a matched field, obtain it.
-        MatchDetails matchDetails;
-        matchDetails.requestElemMatchKey();
-
-        dassert(cq);
-        verify(cq->root()->matchesBSON(oldObj.value(), &matchDetails));
+    // Simple updates which only overwrite existing values with ones of the same size can be
+    // turned into damages straight from the old document. The driver only does so for fields
+    // which are neither indexed nor immutable, and for values which need no validation, so
+    // that there is nothing left to check afterwards.
+    const char* source = NULL;
+    const bool appliedInPlace = _collection->updateWithDamagesSupported() &&
+        driver->updateInPlace(
+            oldObj.value(), immutableFields, &_damages, &source, &logObj, &docWasModified);
+    bool inPlace = appliedInPlace;
+
+    if (!appliedInPlace) {
+        // Ask the driver to apply the mods. It may be that the driver can apply those "in
+        // place", that is, some values of the old document just get adjusted without any
+        // change to the binary layout on the bson layer. It may be that a whole new document
+        // is needed to accomodate the new bson layout of the resulting document. In any event,
+        // only enable in-place mutations if the underlying storage engine offers support for
+        // writing damage events.
+        _doc.reset(oldObj.value(),
+                   (_collection->updateWithDamagesSupported()
+                        ? mutablebson::Document::kInPlaceEnabled
+                        : mutablebson::Document::kInPlaceDisabled));
+
+        Status status = Status::OK();
+        if (!driver->needMatchDetails()) {
+            // If we don't need match details, avoid doing the rematch
+            status = driver->update(StringData(), &_doc, &logObj, &updatedFields, &docWasModified);
+        } else {
+            // If there was a matched field, obtain it.
+            MatchDetails matchDetails;
+            matchDetails.requestElemMatchKey();
 
-        string matchedField;
-        if (matchDetails.hasElemMatchKey())
-            matchedField = matchDetails.elemMatchKey();
+            dassert(cq);
+            verify(cq->root()->matchesBSON(oldObj.value(), &matchDetails));
 
-        // TODO: Right now, each mod checks in 'prepare' that if it needs positional
-        // data, that a non-empty StringData() was provided. In principle, we could do
-        // that check here in an else clause to the above conditional and remove the
-        // checks from the mods.
+            string matchedField;
+            if (matchDetails.hasElemMatchKey())
+                matchedField = matchDetails.elemMatchKey();
 
-        status = driver->update(matchedField, &_doc, &logObj, &updatedFields, &docWasModified);
-    }
+            // TODO: Right now, each mod checks in 'prepare' that if it needs positional
+            // data, that a non-empty StringData() was provided. In principle, we could do
+            // that check here in an else clause to the above conditional and remove the
+            // checks from the mods.
 
-    if (!status.isOK()) {
-        uasserted(16837, status.reason());
-    }
-
-    // Skip adding _id field if the collection is capped (since capped collection documents can
-    // neither grow nor shrink).
-    const auto createIdField = !_collection->isCapped();
+            status = driver->update(matchedField, &_doc, &logObj, &updatedFields, &docWasModified);
+        }
 
-    // Ensure if _id exists it is first
-    status = ensureIdFieldIsFirst(&_doc);
-    if (status.code() == ErrorCodes::InvalidIdField) {
-        // Create ObjectId _id field if we are doing that
-        if (createIdField) {
-            uassertStatusOK(addObjectIDIdField(&_doc));
+        if (!status.isOK()) {
+            uasserted(16837, status.reason());
         }
-    } else {
-        uassertStatusOK(status);
-    }
 
-    // See if the changes were applied in place
-    const char* source = NULL;
-    const bool inPlace = _doc.getInPlaceUpdates(&_damages, &source);
+        // Skip adding _id field if the collection is capped (since capped collection documents
+        // can neither grow nor shrink).
+        const auto createIdField = !_collection->isCapped();
+
+        // Ensure if _id exists it is first
+        status = ensureIdFieldIsFirst(&_doc);
+        if (status.code() == ErrorCodes::InvalidIdField) {
+            // Create ObjectId _id field if we are doing that
+            if (createIdField) {
+                uassertStatusOK(addObjectIDIdField(&_doc));
+                addedIdField = true;
+            }
+        } else {
+            uassertStatusOK(status);
+        }
 
-    if (inPlace && _damages.empty()) {
-        // An interesting edge case. A modifier didn't notice that it was really a no-op
-        // during its 'prepare' phase. That represents a missed optimization, but we still
-        // shouldn't do any real work. Toggle 'docWasModified' to 'false'.
-        //
-        // Currently, an example of this is '{ $pushAll : { x : [] } }' when the 'x' array
-        // exists.
-        docWasModified = false;
+        // See if the changes were applied in place
+        inPlace = _doc.getInPlaceUpdates(&_damages, &source);
+
+        if (inPlace && _damages.empty()) {
+            // An interesting edge case. A modifier didn't notice that it was really a no-op
+            // during its 'prepare' phase. That represents a missed optimization, but we still
+            // shouldn't do any real work. Toggle 'docWasModified' to 'false'.
+            //
+            // Currently, an example of this is '{ $pushAll : { x : [] } }' when the 'x' array
+            // exists.
+            docWasModified = false;
+        }
     }
 
     if (docWasModified) {
         // Verify that no immutable fields were changed and data is valid for storage.
 
-        if (!(!getOpCtx()->writesAreReplicated() || request->isFromMigration())) {
-            const std::vector<FieldRef*>* immutableFields = NULL;
-            if (lifecycle)
-                immutableFields = lifecycle->getImmutableFields();
-
+        if (!appliedInPlace && getOpCtx()->writesAreReplicated() && !request->isFromMigration()) {
             uassertStatusOK(validate(
                 oldObj.value(), updatedFields, _doc, immutableFields, driver->modOptions()));
         }
@@ -575,12 +588,16 @@ BSONObj UpdateStage::transformAndUpdate(const Snapshotted<BSONObj>& oldObj, Reco
                 args.update = logObj;
                 args.criteria = idQuery;
                 args.fromMigrate = request->isFromMigration();
+                // Only the indexes over the updated fields need new keys, unless an _id was
+                // generated, which is not among them.
+                const FieldRefSet* changedFields = addedIdField ? NULL : &updatedFields;
                 StatusWith<RecordId> res = _collection->updateDocument(getOpCtx(),
                                                                        loc,
                                                                        oldObj,
                                                                        newObj,
                                                                        true,
                                                                        driver->modsAffectIndices(),
+                                                                       changedFields,
                                                                        _params.opDebug,
                                                                        args);
                 uassertStatusOK(res.getStatus());
@@ -213,11 +213,14 @@ BtreeKeyGeneratorV1::BtreeKeyGeneratorV1(std::vector<const char*> fieldNames,
     : BtreeKeyGenerator(fieldNames, fixed, isSparse), _emptyPositionalInfo(fieldNames.size()) {}
 
 BSONElement BtreeKeyGeneratorV1::extractNextElement(const BSONObj& obj,
+                                                    const BSONFieldIndex& objFieldIndex,
                                                     const PositionalPathInfo& positionalInfo,
                                                     const char** field,
                                                     bool* arrayNestedArray) const {
-    std::string firstField = mongoutils::str::before(*field, '.');
-    bool haveObjField = !obj.getField(firstField).eoo();
+    const char* dot = strchr(*field, '.');
+    StringData firstField = dot ? StringData(*field, dot - *field) : StringData(*field);
+    BSONElement firstElt = objFieldIndex.getField(firstField);
+    bool haveObjField = !firstElt.eoo();
     BSONElement arrField = positionalInfo.positionallyIndexedElt;
 
     // An index component field name cannot exist in both a document
@@ -231,7 +234,13 @@ BSONElement BtreeKeyGeneratorV1::extractNextElement(const BSONObj& obj,
 
     *arrayNestedArray = false;
     if (haveObjField) {
-        return obj.getFieldDottedOrArray(*field);
+        // Same as obj.getFieldDottedOrArray(*field), without looking up the first field again.
+        *field = dot ? dot + 1 : *field + firstField.size();
+        if (firstElt.type() == Array || **field == '\0')
+            return firstElt;
+        if (firstElt.type() == Object)
+            return firstElt.embeddedObject().getFieldDottedOrArray(*field);
+        return BSONElement();
     } else if (positionalInfo.hasPositionallyIndexedElt()) {
         if (arrField.type() == Array) {
             *arrayNestedArray = true;
@@ -286,6 +295,7 @@ void BtreeKeyGeneratorV1::getKeysImplWithArray(
     BSONElement arrElt;
     std::set<unsigned> arrIdxs;
     bool mayExpandArrayUnembedded = true;
+    BSONFieldIndex objFieldIndex(obj);
     for (unsigned i = 0; i < fieldNames.size(); ++i) {
         if (*fieldNames[i] == '\0') {
             continue;
@@ -293,8 +303,8 @@ void BtreeKeyGeneratorV1::getKeysImplWithArray(
 
         bool arrayNestedArray;
         // Extract element matching fieldName[ i ] from object xor array.
-        BSONElement e =
-            extractNextElement(obj, positionalInfo[i], &fieldNames[i], &arrayNestedArray);
+        BSONElement e = extractNextElement(
+            obj, objFieldIndex, positionalInfo[i], &fieldNames[i], &arrayNestedArray);
 
         if (e.eoo()) {
             // if field not present, set to null
@@ -30,6 +30,7 @@
 
 #include <vector>
 #include <set>
+#include "mongo/bson/bson_field_index.h"
 #include "mongo/db/jsobj.h"
 
 namespace mongo {
@@ -176,6 +177,9 @@ private:
      * The 'positionalInfo' arg is used for handling a field path where 'obj' has an
      * array indexed by position. See the comments for PositionalPathInfo for more detail.
      *
+     * 'objFieldIndex' indexes 'obj' and is shared by the calls for all fields of the key
+     * pattern, so that compound keys over wide documents do not rescan 'obj' for every field.
+     *
      * Returns the element extracted as a result of traversing the path, or an indexed array
      * if we encounter one during the path traversal.
      *
@@ -202,6 +206,7 @@ private:
      *   the second array element.
      */
     BSONElement extractNextElement(const BSONObj& obj,
+                                   const BSONFieldIndex& objFieldIndex,
                                    const PositionalPathInfo& positionalInfo,
                                    const char** field,
                                    bool* arrayNestedArray) const;
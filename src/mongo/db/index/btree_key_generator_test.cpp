@@ -32,6 +32,7 @@
 
 #include "mongo/db/json.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/mongoutils/str.h"
 
 using namespace mongo;
 using std::unique_ptr;
@@ -827,4 +828,25 @@ TEST(BtreeKeyGeneratorTest, PositionalKeyPatternNestedArrays7) {
     ASSERT(testKeygen(keyPattern, genKeysFrom, expectedKeys));
 }
 
+// Key patterns with enough fields look up the fields of wide documents through a field index.
+TEST(BtreeKeyGeneratorTest, GetKeysFromWideObjectCompound) {
+    BSONObj keyPattern = fromjson("{f25: 1, 'f3.x': 1, f10: 1, f0: 1, missing: 1, f24: 1}");
+    BSONObjBuilder bob;
+    for (int i = 0; i < 26; ++i) {
+        std::string fieldName = mongoutils::str::stream() << "f" << i;
+        if (i == 3) {
+            bob.append(fieldName, BSON("x" << 30));
+        } else if (i == 10) {
+            bob.append(fieldName, BSON_ARRAY(1 << 2));
+        } else {
+            bob.append(fieldName, i);
+        }
+    }
+    BSONObj genKeysFrom = bob.obj();
+    BSONObjSet expectedKeys;
+    expectedKeys.insert(fromjson("{'': 25, '': 30, '': 1, '': 0, '': null, '': 24}"));
+    expectedKeys.insert(fromjson("{'': 25, '': 30, '': 2, '': 0, '': null, '': 24}"));
+    ASSERT(testKeygen(keyPattern, genKeysFrom, expectedKeys));
+}
+
 }  // namespace
@@ -107,9 +107,13 @@ Status IndexAccessMethod::insert(OperationContext* txn,
     *numInserted = 0;
 
     BSONObjSet keys;
-    // Delegate to the subclass.
-    getKeys(obj, &keys);
+    {
+        WritePhaseTimer timer(txn, WritePhase::kKeyGeneration);
+        // Delegate to the subclass.
+        getKeys(obj, &keys);
+    }
 
+    WritePhaseTimer timer(txn, WritePhase::kIndexWrite);
     Status ret = Status::OK();
     for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
         Status status = _newInterface->insert(txn, *i, loc, options.dupsAllowed);
@@ -182,9 +186,13 @@ Status IndexAccessMethod::remove(OperationContext* txn,
                                  const InsertDeleteOptions& options,
                                  int64_t* numDeleted) {
     BSONObjSet keys;
-    getKeys(obj, &keys);
+    {
+        WritePhaseTimer timer(txn, WritePhase::kKeyGeneration);
+        getKeys(obj, &keys);
+    }
     *numDeleted = 0;
 
+    WritePhaseTimer timer(txn, WritePhase::kIndexWrite);
     for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
         removeOneKey(txn, *i, loc, options.dupsAllowed);
         ++*numDeleted;
@@ -293,6 +301,7 @@ Status IndexAccessMethod::validateUpdate(OperationContext* txn,
                                          const InsertDeleteOptions& options,
                                          UpdateTicket* ticket,
                                          const MatchExpression* indexFilter) {
+    WritePhaseTimer timer(txn, WritePhase::kKeyGeneration);
     if (indexFilter == NULL || indexFilter->matchesBSON(from))
         getKeys(from, &ticket->oldKeys);
     if (indexFilter == NULL || indexFilter->matchesBSON(to))
@@ -314,6 +323,7 @@ Status IndexAccessMethod::update(OperationContext* txn,
         return Status(ErrorCodes::InternalError, "Invalid UpdateTicket in update");
     }
 
+    WritePhaseTimer timer(txn, WritePhase::kIndexWrite);
     if (ticket.oldKeys.size() + ticket.added.size() - ticket.removed.size() > 1) {
         _btreeState->setMultikey(txn);
     }
@@ -30,6 +30,7 @@
 
 #pragma once
 
+#include "mongo/bson/bson_field_index.h"
 #include "mongo/bson/bsonobj.h"
 #include "mongo/db/field_ref.h"
 #include "mongo/db/matcher/path.h"
@@ -85,9 +86,9 @@ public:
 
     virtual ElementIterator* allocateIterator(const ElementPath* path) const {
         if (_iteratorUsed)
-            return new BSONElementIterator(path, _obj);
+            return new BSONElementIterator(path, _obj, &_fieldIndex);
         _iteratorUsed = true;
-        _iterator.reset(path, _obj);
+        _iterator.reset(path, _obj, &_fieldIndex);
         return &_iterator;
     }
 
@@ -101,6 +102,8 @@ public:
 
 private:
     BSONObj _obj;
+    // Shared by all the predicates evaluated against this document.
+    BSONFieldIndex _fieldIndex;
     mutable BSONElementIterator _iterator;
     mutable bool _iteratorUsed;
 };
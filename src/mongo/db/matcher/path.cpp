@@ -87,17 +87,22 @@ BSONElementIterator::BSONElementIterator() {
     _path = NULL;
 }
 
-BSONElementIterator::BSONElementIterator(const ElementPath* path, const BSONObj& context)
-    : _path(path), _context(context) {
+BSONElementIterator::BSONElementIterator(const ElementPath* path,
+                                         const BSONObj& context,
+                                         const BSONFieldIndex* contextFieldIndex)
+    : _path(path), _context(context), _contextFieldIndex(contextFieldIndex) {
     _state = BEGIN;
     // log() << "path: " << path.fieldRef().dottedField() << " context: " << context << endl;
 }
 
 BSONElementIterator::~BSONElementIterator() {}
 
-void BSONElementIterator::reset(const ElementPath* path, const BSONObj& context) {
+void BSONElementIterator::reset(const ElementPath* path,
+                                const BSONObj& context,
+                                const BSONFieldIndex* contextFieldIndex) {
     _path = path;
     _context = context;
+    _contextFieldIndex = contextFieldIndex;
     _state = BEGIN;
     _next.reset();
 
@@ -192,7 +197,8 @@ bool BSONElementIterator::more() {
 
     if (_state == BEGIN) {
         size_t idxPath = 0;
-        BSONElement e = getFieldDottedOrArray(_context, _path->fieldRef(), &idxPath);
+        BSONElement e =
+            getFieldDottedOrArray(_context, _path->fieldRef(), &idxPath, _contextFieldIndex);
 
         if (e.type() != Array) {
             _next.reset(e, BSONElement(), false);
@@ -38,6 +38,8 @@
 
 namespace mongo {
 
+class BSONFieldIndex;
+
 class ElementPath {
 public:
     Status init(StringData path);
@@ -137,11 +139,18 @@ private:
 class BSONElementIterator : public ElementIterator {
 public:
     BSONElementIterator();
-    BSONElementIterator(const ElementPath* path, const BSONObj& context);
+    /**
+     * If 'contextFieldIndex' is set, it must index 'context' and must outlive the iterator.
+     */
+    BSONElementIterator(const ElementPath* path,
+                        const BSONObj& context,
+                        const BSONFieldIndex* contextFieldIndex = nullptr);
 
     virtual ~BSONElementIterator();
 
-    void reset(const ElementPath* path, const BSONObj& context);
+    void reset(const ElementPath* path,
+               const BSONObj& context,
+               const BSONFieldIndex* contextFieldIndex = nullptr);
 
     bool more();
     Context next();
@@ -155,6 +164,7 @@ private:
 
     const ElementPath* _path;
     BSONObj _context;
+    const BSONFieldIndex* _contextFieldIndex = nullptr;
 
     enum State { BEGIN, IN_ARRAY, DONE } _state;
     Context _next;
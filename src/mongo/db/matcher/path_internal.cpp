@@ -40,7 +40,10 @@ bool isAllDigits(StringData str) {
     return true;
 }
 
-BSONElement getFieldDottedOrArray(const BSONObj& doc, const FieldRef& path, size_t* idxPath) {
+BSONElement getFieldDottedOrArray(const BSONObj& doc,
+                                  const FieldRef& path,
+                                  size_t* idxPath,
+                                  const BSONFieldIndex* docFieldIndex) {
     if (path.numParts() == 0)
         return doc.getField("");
 
@@ -50,7 +53,11 @@ BSONElement getFieldDottedOrArray(const BSONObj& doc, const FieldRef& path, size
     bool stop = false;
     size_t partNum = 0;
     while (partNum < path.numParts() && !stop) {
-        res = curr.getField(path.getPart(partNum));
+        if (partNum == 0 && docFieldIndex) {
+            res = docFieldIndex->getField(path.getPart(partNum));
+        } else {
+            res = curr.getField(path.getPart(partNum));
+        }
 
         switch (res.type()) {
             case EOO:
@@ -33,6 +33,7 @@
 #include <cstdint>
 
 #include "mongo/base/string_data.h"
+#include "mongo/bson/bson_field_index.h"
 #include "mongo/db/field_ref.h"
 #include "mongo/db/jsobj.h"
 
@@ -42,6 +43,10 @@ bool isAllDigits(StringData str);
 
 // XXX document me
 // Replaces getFieldDottedOrArray without recursion nor std::string manipulation
-BSONElement getFieldDottedOrArray(const BSONObj& doc, const FieldRef& path, size_t* idxPath);
+// If 'docFieldIndex' is set, it must index 'doc' and is used to look up the first part of 'path'.
+BSONElement getFieldDottedOrArray(const BSONObj& doc,
+                                  const FieldRef& path,
+                                  size_t* idxPath,
+                                  const BSONFieldIndex* docFieldIndex = nullptr);
 
 }  // namespace mongo
@@ -33,6 +33,7 @@
 #include "mongo/db/auth/authorization_manager_global.h"
 #include "mongo/db/catalog/collection_options.h"
 #include "mongo/db/commands/dbhash.h"
+#include "mongo/db/curop.h"
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/namespace_string.h"
@@ -62,7 +63,10 @@ void OpObserver::onInserts(OperationContext* txn,
                            vector<BSONObj>::const_iterator begin,
                            vector<BSONObj>::const_iterator end,
                            bool fromMigrate) {
-    repl::logOps(txn, "i", nss, begin, end, fromMigrate);
+    {
+        WritePhaseTimer timer(txn, WritePhase::kOplog);
+        repl::logOps(txn, "i", nss, begin, end, fromMigrate);
+    }
 
     const char* ns = nss.ns().c_str();
     for (auto it = begin; it != end; it++) {
@@ -82,7 +86,10 @@ void OpObserver::onUpdate(OperationContext* txn, oplogUpdateEntryArgs args) {
         return;
     }
 
-    repl::logOp(txn, "u", args.ns.c_str(), args.update, &args.criteria, args.fromMigrate);
+    {
+        WritePhaseTimer timer(txn, WritePhase::kOplog);
+        repl::logOp(txn, "u", args.ns.c_str(), args.update, &args.criteria, args.fromMigrate);
+    }
 
     getGlobalAuthorizationManager()->logOp(txn, "u", args.ns.c_str(), args.update, &args.criteria);
     logOpForSharding(txn, "u", args.ns.c_str(), args.update, &args.criteria, args.fromMigrate);
@@ -111,7 +118,10 @@ void OpObserver::onDelete(OperationContext* txn,
     if (deleteState.idDoc.isEmpty())
         return;
 
-    repl::logOp(txn, "d", ns.ns().c_str(), deleteState.idDoc, nullptr, fromMigrate);
+    {
+        WritePhaseTimer timer(txn, WritePhase::kOplog);
+        repl::logOp(txn, "d", ns.ns().c_str(), deleteState.idDoc, nullptr, fromMigrate);
+    }
 
     AuthorizationManager::get(txn->getServiceContext())
         ->logOp(txn, "d", ns.ns().c_str(), deleteState.idDoc, nullptr);
@@ -42,6 +42,7 @@
 #include "mongo/db/ops/path_support.h"
 #include "mongo/util/embedded_builder.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/safe_num.h"
 
 namespace mongo {
 
@@ -138,9 +139,66 @@ Status UpdateDriver::parse(const BSONObj& updateExpr, const bool multi) {
     // replacement.
     _replacementMode = false;
 
+    parseInPlaceMods(updateExpr);
+
     return Status::OK();
 }
 
+void UpdateDriver::parseInPlaceMods(const BSONObj& updateExpr) {
+    if (_positional) {
+        return;
+    }
+
+    std::vector<InPlaceMod> mods;
+    OwnedPointerVector<FieldRef> paths;
+    FieldRefSet pathSet;
+
+    BSONObjIterator outerIter(updateExpr);
+    while (outerIter.more()) {
+        BSONElement outerModElem = outerIter.next();
+
+        modifiertable::ModifierType modType = modifiertable::getType(outerModElem.fieldName());
+        if (modType != modifiertable::MOD_SET && modType != modifiertable::MOD_INC) {
+            return;
+        }
+
+        BSONObjIterator innerIter(outerModElem.embeddedObject());
+        while (innerIter.more()) {
+            BSONElement innerModElem = innerIter.next();
+
+            // Setting a whole document or array would require validating its contents for
+            // storage, leave that to the regular path.
+            if (innerModElem.type() == Object || innerModElem.type() == Array) {
+                return;
+            }
+
+            unique_ptr<FieldRef> path(new FieldRef(innerModElem.fieldNameStringData()));
+            if (path->getPart(0) == "_id") {
+                return;
+            }
+            for (size_t i = 0; i < path->numParts(); ++i) {
+                if (path->getPart(i)[0] == '$') {
+                    return;
+                }
+            }
+
+            const FieldRef* other;
+            if (!pathSet.insert(path.get(), &other)) {
+                return;
+            }
+
+            InPlaceMod mod;
+            mod.type = modType;
+            mod.elem = innerModElem;
+            mods.push_back(mod);
+            paths.push_back(path.release());
+        }
+    }
+
+    _inPlaceMods.swap(mods);
+    _inPlacePaths.mutableVector().swap(paths.mutableVector());
+}
+
 inline Status UpdateDriver::addAndParse(const modifiertable::ModifierType type,
                                         const BSONElement& elem) {
     if (elem.eoo()) {
@@ -316,6 +374,120 @@ Status UpdateDriver::update(StringData matchedField,
     return Status::OK();
 }
 
+bool UpdateDriver::updateInPlace(const BSONObj& original,
+                                 const std::vector<FieldRef*>* immutablePaths,
+                                 mutablebson::DamageVector* damages,
+                                 const char** damageSource,
+                                 BSONObj* logOpRec,
+                                 bool* docWasModified) {
+    if (_inPlaceMods.empty()) {
+        return false;
+    }
+
+    // A missing or misplaced '_id' would have to be created or moved to the front.
+    if (original.firstElement().fieldNameStringData() != "_id") {
+        return false;
+    }
+
+    damages->clear();
+
+    // The new values are collected in the order of the mods, as the $set entries of the oplog
+    // entry, and then serve as the source of the damages.
+    BSONObjBuilder setBuilder;
+
+    for (size_t i = 0; i < _inPlaceMods.size(); ++i) {
+        const InPlaceMod& mod = _inPlaceMods[i];
+        const FieldRef& path = *_inPlacePaths[i];
+
+        if (_indexedFields && _indexedFields->mightBeIndexed(path.dottedField())) {
+            return false;
+        }
+
+        if (immutablePaths) {
+            for (const FieldRef* immutablePath : *immutablePaths) {
+                if (path == *immutablePath || path.isPrefixOf(*immutablePath) ||
+                    immutablePath->isPrefixOf(path)) {
+                    return false;
+                }
+            }
+        }
+
+        // Find the current value, which must exist and must not be within an array.
+        BSONElement current = original.getField(path.getPart(0));
+        for (size_t part = 1; part < path.numParts(); ++part) {
+            if (current.type() != Object) {
+                return false;
+            }
+            current = current.embeddedObject().getField(path.getPart(part));
+        }
+
+        if (current.eoo()) {
+            return false;
+        }
+
+        // Same no-op rules as ModifierSet and ModifierInc.
+        if (mod.type == modifiertable::MOD_SET) {
+            if (current.binaryEqualValues(mod.elem)) {
+                continue;
+            }
+
+            if (current.type() != mod.elem.type() || current.valuesize() != mod.elem.valuesize()) {
+                return false;
+            }
+
+            setBuilder.appendAs(mod.elem, path.dottedField());
+        } else {
+            const SafeNum currentValue(current);
+            SafeNum newValue(mod.elem);
+            newValue += currentValue;
+
+            // Let update() report non-numeric values and overflows.
+            if (!newValue.isValid()) {
+                return false;
+            }
+
+            if (newValue.isIdentical(currentValue)) {
+                continue;
+            }
+
+            if (newValue.type() != current.type()) {
+                return false;
+            }
+
+            newValue.toBSON(path.dottedField(), &setBuilder);
+        }
+
+        mutablebson::DamageEvent damage;
+        damage.sourceOffset = 0;
+        damage.targetOffset = current.value() - original.objdata();
+        damage.size = current.valuesize();
+        damages->push_back(damage);
+    }
+
+    BSONObjBuilder logBuilder;
+    if (!damages->empty()) {
+        logBuilder.append("$set", setBuilder.done());
+    }
+    _inPlaceLog = logBuilder.obj();
+
+    if (!damages->empty()) {
+        BSONObjIterator setIter(_inPlaceLog.firstElement().embeddedObject());
+        for (mutablebson::DamageEvent& damage : *damages) {
+            damage.sourceOffset = setIter.next().value() - _inPlaceLog.objdata();
+        }
+    }
+
+    _affectIndices = false;
+
+    *damageSource = _inPlaceLog.objdata();
+    *docWasModified = !damages->empty();
+    if (_logOp && logOpRec) {
+        *logOpRec = _inPlaceLog;
+    }
+
+    return true;
+}
+
 size_t UpdateDriver::numMods() const {
     return _mods.size();
 }
@@ -379,6 +551,8 @@ void UpdateDriver::clear() {
         delete *it;
     }
     _mods.clear();
+    _inPlaceMods.clear();
+    _inPlacePaths.clear();
     _indexedFields = NULL;
     _replacementMode = false;
     _positional = false;
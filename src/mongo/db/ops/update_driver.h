@@ -33,6 +33,7 @@
 
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/base/status.h"
+#include "mongo/bson/mutable/damage_vector.h"
 #include "mongo/bson/mutable/document.h"
 #include "mongo/db/field_ref_set.h"
 #include "mongo/db/jsobj.h"
@@ -100,6 +101,27 @@ public:
                   FieldRefSet* updatedFields = NULL,
                   bool* docWasModified = NULL);
 
+    /**
+     * Applies the update directly over the binary representation of 'original', without
+     * loading it in a mutable document, if possible. That is the case when the update is
+     * only made of $set and $inc mods over non-positional paths which all exist in
+     * 'original', cross no arrays, are neither indexed nor overlapping 'immutablePaths' or
+     * '_id', and whose new values have the same type and size as the current ones.
+     *
+     * Returns true if the update was applied, in which case 'damages' and 'damageSource'
+     * describe the changes to make to 'original', 'docWasModified' tells whether any of the
+     * mods was not a no-op and, as in update(), 'logOpRec' is filled in if it is not NULL
+     * and '_logOp' is on. 'damageSource' remains valid until the next call to this method.
+     * Returns false otherwise, including when applying the update would fail, and the
+     * caller must then use update().
+     */
+    bool updateInPlace(const BSONObj& original,
+                       const std::vector<FieldRef*>* immutablePaths,
+                       mutablebson::DamageVector* damages,
+                       const char** damageSource,
+                       BSONObj* logOpRec,
+                       bool* docWasModified);
+
     //
     // Accessors
     //
@@ -139,6 +161,16 @@ private:
     /** Create the modifier and add it to the back of the modifiers vector */
     inline Status addAndParse(const modifiertable::ModifierType type, const BSONElement& elem);
 
+    /** Fills in '_inPlaceMods' if the parsed 'updateExpr' qualifies for updateInPlace */
+    void parseInPlaceMods(const BSONObj& updateExpr);
+
+    struct InPlaceMod {
+        modifiertable::ModifierType type;
+
+        // The {<path>: <value>} element of the mod, pointing into the update expression.
+        BSONElement elem;
+    };
+
     //
     // immutable properties after parsing
     //
@@ -149,6 +181,11 @@ private:
     // Collection of update mod instances. Owned here.
     std::vector<ModifierInterface*> _mods;
 
+    // The same mods as '_mods', in the same order, if they can be applied by updateInPlace.
+    // Empty otherwise. '_inPlacePaths' holds the parsed path of each of them.
+    std::vector<InPlaceMod> _inPlaceMods;
+    OwnedPointerVector<FieldRef> _inPlacePaths;
+
     // What are the list of fields in the collection over which the update is going to be
     // applied that participate in indices?
     //
@@ -180,6 +217,9 @@ private:
 
     // The document used to build the oplog entry for the update.
     mutablebson::Document _logDoc;
+
+    // The oplog entry built by updateInPlace, which also holds the new values it writes.
+    BSONObj _inPlaceLog;
 };
 
 struct UpdateDriver::Options {
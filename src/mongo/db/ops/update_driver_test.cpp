@@ -29,10 +29,12 @@
 #include "mongo/db/ops/update_driver.h"
 
 
+#include <cstring>
 #include <map>
 
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/base/string_data.h"
+#include "mongo/bson/mutable/damage_vector.h"
 #include "mongo/bson/mutable/document.h"
 #include "mongo/bson/mutable/mutable_bson_test_utils.h"
 #include "mongo/db/field_ref.h"
@@ -49,6 +51,7 @@ using mongo::FieldRef;
 using mongo::fromjson;
 using mongo::OwnedPointerVector;
 using mongo::UpdateIndexData;
+using mongo::mutablebson::DamageVector;
 using mongo::mutablebson::Document;
 using mongo::StringData;
 using mongo::UpdateDriver;
@@ -125,6 +128,140 @@ TEST(Parse, SetOnInsert) {
     ASSERT_FALSE(driver.isDocReplacement());
 }
 
+//
+// Tests of applying simple updates directly over the original document
+//
+
+/**
+ * Applies 'updateExpr' to 'original' with updateInPlace and checks that it yields the same
+ * document and oplog entry as the regular update path.
+ */
+void assertSameAsUpdate(const BSONObj& original, const BSONObj& updateExpr) {
+    UpdateDriver::Options opts;
+    opts.logOp = true;
+    UpdateDriver driver(opts);
+    ASSERT_OK(driver.parse(updateExpr));
+
+    DamageVector damages;
+    const char* source = NULL;
+    BSONObj inPlaceLog;
+    bool inPlaceModified = false;
+    ASSERT_TRUE(driver.updateInPlace(
+        original, NULL, &damages, &source, &inPlaceLog, &inPlaceModified));
+
+    mongo::BufBuilder updated;
+    updated.appendBuf(original.objdata(), original.objsize());
+    for (size_t i = 0; i < damages.size(); ++i) {
+        std::memcpy(updated.buf() + damages[i].targetOffset,
+                    source + damages[i].sourceOffset,
+                    damages[i].size);
+    }
+
+    Document doc(original);
+    BSONObj log;
+    bool modified = false;
+    ASSERT_OK(driver.update(StringData(), &doc, &log, NULL, &modified));
+
+    ASSERT_EQUALS(modified, inPlaceModified);
+    ASSERT_EQUALS(doc.getObject(), BSONObj(updated.buf()));
+    ASSERT_EQUALS(log, inPlaceLog);
+}
+
+/** Returns true if updateInPlace agrees to apply 'updateExpr' to 'original'. */
+bool appliesInPlace(const BSONObj& original,
+                    const BSONObj& updateExpr,
+                    const UpdateIndexData* indexedFields = NULL,
+                    const std::vector<FieldRef*>* immutablePaths = NULL) {
+    UpdateDriver::Options opts;
+    UpdateDriver driver(opts);
+    ASSERT_OK(driver.parse(updateExpr));
+    driver.refreshIndexKeys(indexedFields);
+
+    DamageVector damages;
+    const char* source = NULL;
+    bool modified = false;
+    return driver.updateInPlace(original, immutablePaths, &damages, &source, NULL, &modified);
+}
+
+TEST(InPlace, SetAndInc) {
+    assertSameAsUpdate(fromjson("{_id:1, a:1, b:{c:'xy', d:2.5}}"),
+                       fromjson("{$inc:{a:2, 'b.d':1}, $set:{'b.c':'zw'}}"));
+}
+
+TEST(InPlace, IncLong) {
+    assertSameAsUpdate(BSON("_id" << 1 << "a" << 5LL), fromjson("{$inc:{a:-7}}"));
+}
+
+TEST(InPlace, SetNoOp) {
+    assertSameAsUpdate(fromjson("{_id:1, a:1, b:'x'}"), fromjson("{$set:{a:1, b:'x'}}"));
+}
+
+TEST(InPlace, IncNoOp) {
+    assertSameAsUpdate(fromjson("{_id:1, a:1}"), fromjson("{$inc:{a:0}}"));
+}
+
+TEST(InPlace, PartialNoOp) {
+    assertSameAsUpdate(fromjson("{_id:1, a:1, b:2}"), fromjson("{$set:{a:1}, $inc:{b:1}}"));
+}
+
+TEST(InPlace, MissingField) {
+    ASSERT_FALSE(appliesInPlace(fromjson("{_id:1, a:1}"), fromjson("{$inc:{b:1}}")));
+    ASSERT_FALSE(appliesInPlace(fromjson("{_id:1, a:1}"), fromjson("{$set:{'a.b':1}}")));
+}
+
+TEST(InPlace, ValueChangesSize) {
+    ASSERT_FALSE(appliesInPlace(fromjson("{_id:1, a:'x'}"), fromjson("{$set:{a:'xy'}}")));
+    ASSERT_FALSE(appliesInPlace(fromjson("{_id:1, a:1}"), fromjson("{$set:{a:1.5}}")));
+    ASSERT_FALSE(appliesInPlace(fromjson("{_id:1, a:1}"), fromjson("{$inc:{a:0.5}}")));
+    ASSERT_FALSE(appliesInPlace(fromjson("{_id:1, a:2147483647}"), fromjson("{$inc:{a:1}}")));
+}
+
+TEST(InPlace, NotNumeric) {
+    ASSERT_FALSE(appliesInPlace(fromjson("{_id:1, a:'x'}"), fromjson("{$inc:{a:1}}")));
+}
+
+TEST(InPlace, ArrayOnPath) {
+    ASSERT_FALSE(appliesInPlace(fromjson("{_id:1, a:[1, 2]}"), fromjson("{$set:{'a.0':3}}")));
+    ASSERT_FALSE(appliesInPlace(fromjson("{_id:1, a:[{b:1}]}"), fromjson("{$inc:{'a.b':1}}")));
+}
+
+TEST(InPlace, UnsupportedMods) {
+    const BSONObj original = fromjson("{_id:1, a:1, b:{c:1}, d:[1]}");
+    ASSERT_FALSE(appliesInPlace(original, fromjson("{$set:{a:2}, $unset:{e:1}}")));
+    ASSERT_FALSE(appliesInPlace(original, fromjson("{$mul:{a:2}}")));
+    ASSERT_FALSE(appliesInPlace(original, fromjson("{$set:{b:{c:2}}}")));
+    ASSERT_FALSE(appliesInPlace(original, fromjson("{$set:{'d.$':2}}")));
+    ASSERT_FALSE(appliesInPlace(original, fromjson("{$set:{_id:2}}")));
+}
+
+TEST(InPlace, IdNotFirst) {
+    ASSERT_FALSE(appliesInPlace(fromjson("{a:1, _id:1}"), fromjson("{$inc:{a:1}}")));
+    ASSERT_FALSE(appliesInPlace(fromjson("{a:1}"), fromjson("{$inc:{a:1}}")));
+}
+
+TEST(InPlace, IndexedField) {
+    UpdateIndexData indexedFields;
+    indexedFields.addPath("b");
+    ASSERT_TRUE(appliesInPlace(fromjson("{_id:1, a:1}"), fromjson("{$inc:{a:1}}"), &indexedFields));
+    ASSERT_FALSE(
+        appliesInPlace(fromjson("{_id:1, b:{c:1}}"), fromjson("{$inc:{'b.c':1}}"), &indexedFields));
+}
+
+TEST(InPlace, ImmutableField) {
+    OwnedPointerVector<FieldRef> immutablePaths;
+    immutablePaths.push_back(new FieldRef("a.b"));
+    const BSONObj original = fromjson("{_id:1, a:{b:1, c:1}, d:1}");
+    ASSERT_TRUE(
+        appliesInPlace(original, fromjson("{$inc:{d:1}}"), NULL, &immutablePaths.vector()));
+    ASSERT_FALSE(
+        appliesInPlace(original, fromjson("{$inc:{'a.b':1}}"), NULL, &immutablePaths.vector()));
+
+    OwnedPointerVector<FieldRef> immutableParent;
+    immutableParent.push_back(new FieldRef("a"));
+    ASSERT_FALSE(
+        appliesInPlace(original, fromjson("{$inc:{'a.c':1}}"), NULL, &immutableParent.vector()));
+}
+
 //
 // Tests of creating a base for an upsert from a query document
 // $or, $and, $all get special handling, as does the _id field
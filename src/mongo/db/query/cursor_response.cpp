@@ -180,7 +180,11 @@ StatusWith<CursorResponse> CursorResponse::parseFromBSON(const BSONObj& cmdRespo
                 str::stream() << "getMore response batch contains a non-object element: " << elt};
         }
 
-        batch.push_back(elt.Obj().getOwned());
+        if (cmdResponse.isOwned()) {
+            batch.push_back(elt.Obj().shareOwnershipWith(cmdResponse));
+        } else {
+            batch.push_back(elt.Obj().getOwned());
+        }
     }
 
     return {{NamespaceString(fullns), cursorId, batch}};
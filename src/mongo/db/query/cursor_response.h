@@ -166,6 +166,9 @@ public:
 
     /**
      * Constructs a CursorResponse from the command BSON response.
+     *
+     * If 'cmdResponse' is owned, the documents of the batch share ownership of its buffer instead
+     * of being copied one by one. Otherwise each of them gets its own copy.
      */
     static StatusWith<CursorResponse> parseFromBSON(const BSONObj& cmdResponse);
 
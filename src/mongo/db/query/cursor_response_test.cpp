@@ -84,6 +84,50 @@ TEST(CursorResponseTest, parseFromBSONCursorIdZero) {
     ASSERT_EQ(response.getBatch()[1], BSON("_id" << 2));
 }
 
+TEST(CursorResponseTest, parseFromBSONOwnedResponseSharesBuffer) {
+    BSONObj cmdResponse = BSON(
+        "cursor" << BSON("id" << CursorId(123) << "ns"
+                              << "db.coll"
+                              << "nextBatch" << BSON_ARRAY(BSON("_id" << 1) << BSON("_id" << 2)))
+                 << "ok" << 1);
+    StatusWith<CursorResponse> result = CursorResponse::parseFromBSON(cmdResponse);
+    ASSERT_OK(result.getStatus());
+
+    // The documents point into the response instead of being copied, and keep it alive
+    CursorResponse response = std::move(result.getValue());
+    const char* const responseStart = cmdResponse.objdata();
+    const char* const responseEnd = responseStart + cmdResponse.objsize();
+    cmdResponse = BSONObj();
+
+    ASSERT_EQ(response.getBatch().size(), 2U);
+    for (const BSONObj& doc : response.getBatch()) {
+        ASSERT(doc.isOwned());
+        ASSERT(doc.objdata() > responseStart && doc.objdata() < responseEnd);
+    }
+    ASSERT_EQ(response.getBatch()[0], BSON("_id" << 1));
+    ASSERT_EQ(response.getBatch()[1], BSON("_id" << 2));
+}
+
+TEST(CursorResponseTest, parseFromBSONUnownedResponseCopiesDocuments) {
+    BSONObj owner = BSON("response" << BSON(
+                             "cursor" << BSON("id" << CursorId(123) << "ns"
+                                                   << "db.coll"
+                                                   << "nextBatch" << BSON_ARRAY(BSON("_id" << 1)))
+                                      << "ok" << 1));
+    BSONObj cmdResponse = owner["response"].Obj();
+    ASSERT_FALSE(cmdResponse.isOwned());
+
+    StatusWith<CursorResponse> result = CursorResponse::parseFromBSON(cmdResponse);
+    ASSERT_OK(result.getStatus());
+
+    CursorResponse response = std::move(result.getValue());
+    ASSERT_EQ(response.getBatch().size(), 1U);
+    const BSONObj& doc = response.getBatch()[0];
+    ASSERT(doc.isOwned());
+    ASSERT(doc.objdata() < owner.objdata() || doc.objdata() >= owner.objdata() + owner.objsize());
+    ASSERT_EQ(doc, BSON("_id" << 1));
+}
+
 TEST(CursorResponseTest, parseFromBSONEmptyBatch) {
     StatusWith<CursorResponse> result = CursorResponse::parseFromBSON(
         BSON("cursor" << BSON("id" << CursorId(123) << "ns"
@@ -176,6 +176,11 @@ void fillOutPlannerParams(OperationContext* txn,
             ShardingState::get(txn)->getCollectionMetadata(canonicalQuery->ns());
         if (collMetadata) {
             plannerParams->shardKey = collMetadata->getKeyPattern();
+
+            // Shares ownership of the metadata, so that the ranges stay valid for as long as the
+            // planner needs them.
+            plannerParams->ownedShardKeyRanges =
+                std::shared_ptr<const RangeMap>(collMetadata, &collMetadata->getOwnedRanges());
         } else {
             // If there's no metadata don't bother w/the shard filter since we won't know what
             // the key pattern is anyway...
@@ -588,12 +593,15 @@ namespace {
  * Wrap the specified 'root' plan stage in a ProjectionStage. Does not take ownership of any
  * arguments other than root.
  *
+ * 'query' is the expression the documents flowing out of 'root' matched. It may be NULL for the
+ * idhack paths, which only use this for projections without a positional or $meta operator.
+ *
  * If the projection was valid, then return Status::OK() with a pointer to the newly created
  * ProjectionStage. Otherwise, return a status indicating the error reason.
  */
 StatusWith<unique_ptr<PlanStage>> applyProjection(OperationContext* txn,
                                                   const NamespaceString& nsString,
-                                                  CanonicalQuery* cq,
+                                                  const MatchExpression* query,
                                                   const BSONObj& proj,
                                                   bool allowPositional,
                                                   WorkingSet* ws,
@@ -601,7 +609,7 @@ StatusWith<unique_ptr<PlanStage>> applyProjection(OperationContext* txn,
     invariant(!proj.isEmpty());
 
     ParsedProjection* rawParsedProj;
-    Status ppStatus = ParsedProjection::make(proj.getOwned(), cq->root(), &rawParsedProj);
+    Status ppStatus = ParsedProjection::make(proj.getOwned(), query, &rawParsedProj);
     if (!ppStatus.isOK()) {
         return ppStatus;
     }
@@ -623,7 +631,7 @@ StatusWith<unique_ptr<PlanStage>> applyProjection(OperationContext* txn,
 
     ProjectionStageParams params(ExtensionsCallbackReal(txn, &nsString));
     params.projObj = proj;
-    params.fullExpression = cq->root();
+    params.fullExpression = query;
     return {make_unique<ProjectionStage>(txn, params, ws, root.release())};
 }
 
@@ -691,14 +699,30 @@ StatusWith<unique_ptr<PlanExecutor>> getExecutorDelete(OperationContext* txn,
 
         const IndexDescriptor* descriptor = collection->getIndexCatalog()->findIdIndex(txn);
 
+        // A projection is fine here as long as it does not depend on the query. Positional
+        // projections need its match details, and $meta projections are validated against it.
         if (descriptor && CanonicalQuery::isSimpleIdQuery(unparsedQuery) &&
-            request->getProj().isEmpty()) {
+            !ParsedProjection::hasPositionalOperator(request->getProj()) &&
+            !ParsedProjection::hasMetaOperator(request->getProj())) {
             LOG(2) << "Using idhack: " << unparsedQuery.toString();
 
             PlanStage* idHackStage =
                 new IDHackStage(txn, collection, unparsedQuery["_id"].wrap(), ws.get(), descriptor);
-            unique_ptr<DeleteStage> root =
+            unique_ptr<PlanStage> root =
                 make_unique<DeleteStage>(txn, deleteStageParams, ws.get(), collection, idHackStage);
+
+            if (!request->getProj().isEmpty()) {
+                invariant(request->shouldReturnDeleted());
+
+                const bool allowPositional = true;
+                StatusWith<unique_ptr<PlanStage>> projStatus = applyProjection(
+                    txn, nss, NULL, request->getProj(), allowPositional, ws.get(), std::move(root));
+                if (!projStatus.isOK()) {
+                    return projStatus.getStatus();
+                }
+                root = std::move(projStatus.getValue());
+            }
+
             return PlanExecutor::make(txn, std::move(ws), std::move(root), collection, policy);
         }
 
@@ -733,7 +757,7 @@ StatusWith<unique_ptr<PlanExecutor>> getExecutorDelete(OperationContext* txn,
 
         const bool allowPositional = true;
         StatusWith<unique_ptr<PlanStage>> projStatus = applyProjection(
-            txn, nss, cq.get(), request->getProj(), allowPositional, ws.get(), std::move(root));
+            txn, nss, cq->root(), request->getProj(), allowPositional, ws.get(), std::move(root));
         if (!projStatus.isOK()) {
             return projStatus.getStatus();
         }
@@ -835,14 +859,35 @@ StatusWith<unique_ptr<PlanExecutor>> getExecutorUpdate(OperationContext* txn,
 
         const IndexDescriptor* descriptor = collection->getIndexCatalog()->findIdIndex(txn);
 
+        // A projection is fine here as long as it does not depend on the query. Positional
+        // projections need its match details, and $meta projections are validated against it.
         if (descriptor && CanonicalQuery::isSimpleIdQuery(unparsedQuery) &&
-            request->getProj().isEmpty()) {
+            !ParsedProjection::hasPositionalOperator(request->getProj()) &&
+            !ParsedProjection::hasMetaOperator(request->getProj())) {
             LOG(2) << "Using idhack: " << unparsedQuery.toString();
 
             PlanStage* idHackStage =
                 new IDHackStage(txn, collection, unparsedQuery["_id"].wrap(), ws.get(), descriptor);
-            unique_ptr<UpdateStage> root =
+            unique_ptr<PlanStage> root =
                 make_unique<UpdateStage>(txn, updateStageParams, ws.get(), collection, idHackStage);
+
+            if (!request->getProj().isEmpty()) {
+                invariant(request->shouldReturnAnyDocs());
+
+                const bool allowPositional = false;
+                StatusWith<unique_ptr<PlanStage>> projStatus = applyProjection(txn,
+                                                                               nsString,
+                                                                               NULL,
+                                                                               request->getProj(),
+                                                                               allowPositional,
+                                                                               ws.get(),
+                                                                               std::move(root));
+                if (!projStatus.isOK()) {
+                    return projStatus.getStatus();
+                }
+                root = std::move(projStatus.getValue());
+            }
+
             return PlanExecutor::make(txn, std::move(ws), std::move(root), collection, policy);
         }
 
@@ -881,7 +926,7 @@ StatusWith<unique_ptr<PlanExecutor>> getExecutorUpdate(OperationContext* txn,
         const bool allowPositional = request->shouldReturnOldDocs();
         StatusWith<unique_ptr<PlanStage>> projStatus = applyProjection(txn,
                                                                        nsString,
-                                                                       cq.get(),
+                                                                       cq->root(),
                                                                        request->getProj(),
                                                                        allowPositional,
                                                                        ws.get(),
@@ -217,6 +217,7 @@ Status ParsedProjection::make(const BSONObj& spec,
                 return Status(ErrorCodes::BadValue, ss);
             }
 
+            invariant(query);
             std::string matchfield = mongoutils::str::before(e.fieldName(), '.');
             if (!_hasPositionalOperatorMatch(query, matchfield)) {
                 mongoutils::str::stream ss;
@@ -293,6 +294,29 @@ Status ParsedProjection::make(const BSONObj& spec,
     return Status::OK();
 }
 
+// static
+bool ParsedProjection::hasPositionalOperator(const BSONObj& spec) {
+    BSONObjIterator it(spec);
+    while (it.more()) {
+        if (_isPositionalOperator(it.next().fieldName())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// static
+bool ParsedProjection::hasMetaOperator(const BSONObj& spec) {
+    BSONObjIterator it(spec);
+    while (it.more()) {
+        BSONElement e = it.next();
+        if (e.type() == Object && e.embeddedObject().hasField("$meta")) {
+            return true;
+        }
+    }
+    return false;
+}
+
 // static
 bool ParsedProjection::_isPositionalOperator(const char* fieldName) {
     return mongoutils::str::contains(fieldName, ".$") &&
@@ -42,6 +42,8 @@ public:
      * Parses the projection 'spec' and checks its validity with respect to the query 'query'.
      * Puts covering information into 'out'.
      *
+     * 'query' may be NULL only if the spec has no positional operator.
+     *
      * Returns Status::OK() if it's a valid spec.
      * Returns a Status indicating how it's invalid otherwise.
      */
@@ -50,6 +52,18 @@ public:
                        ParsedProjection** out,
                        const ExtensionsCallback& extensionsCallback = ExtensionsCallback());
 
+    /**
+     * Returns true if any top-level field of the projection 'spec' uses the positional
+     * operator, i.e. if parsing 'spec' would need the query it is applied to.
+     */
+    static bool hasPositionalOperator(const BSONObj& spec);
+
+    /**
+     * Returns true if any top-level field of the projection 'spec' is a $meta projection. Whether
+     * those are valid depends on the query, e.g. a textScore needs a $text query.
+     */
+    static bool hasMetaOperator(const BSONObj& spec);
+
     /**
      * Returns true if the projection requires match details from the query,
      * and false otherwise.
@@ -291,4 +291,33 @@ TEST(ParsedProjectionTest, DBRefProjections) {
     // so these fields cannot be arrays.
     createParsedProjection("{'a.$id': {$elemMatch: {x: 1}}}", "{'a.$id.$': 1}");
 }
+
+//
+// Detecting positional projections without a query
+//
+
+TEST(ParsedProjectionTest, HasPositionalOperator) {
+    ASSERT_FALSE(ParsedProjection::hasPositionalOperator(BSONObj()));
+    ASSERT_FALSE(ParsedProjection::hasPositionalOperator(fromjson("{a: 1, b: 0}")));
+    ASSERT_FALSE(ParsedProjection::hasPositionalOperator(fromjson("{a: {$elemMatch: {b: 1}}}")));
+    ASSERT_FALSE(ParsedProjection::hasPositionalOperator(fromjson("{'a.$ref': 1, 'a.$id': 1}")));
+    ASSERT_TRUE(ParsedProjection::hasPositionalOperator(fromjson("{a: 1, 'b.$': 1}")));
+    ASSERT_TRUE(ParsedProjection::hasPositionalOperator(fromjson("{'a.$id.$': 1}")));
+}
+
+TEST(ParsedProjectionTest, HasMetaOperator) {
+    ASSERT_FALSE(ParsedProjection::hasMetaOperator(BSONObj()));
+    ASSERT_FALSE(ParsedProjection::hasMetaOperator(fromjson("{a: 1, b: {$slice: 2}}")));
+    ASSERT_FALSE(ParsedProjection::hasMetaOperator(fromjson("{a: {$elemMatch: {$meta: 1}}}")));
+    ASSERT_TRUE(ParsedProjection::hasMetaOperator(fromjson("{a: 1, b: {$meta: 'textScore'}}")));
+    ASSERT_TRUE(ParsedProjection::hasMetaOperator(fromjson("{a: {$meta: 'recordId'}}")));
+}
+
+TEST(ParsedProjectionTest, NullQueryWithoutPositionalOperator) {
+    ParsedProjection* out = NULL;
+    Status status = ParsedProjection::make(fromjson("{a: 1, b: {$slice: 2}}"), NULL, &out);
+    ASSERT_OK(status);
+    unique_ptr<ParsedProjection> destroy(out);
+    ASSERT_FALSE(out->requiresMatchDetails());
+}
 }  // unnamed namespace
@@ -30,6 +30,7 @@
 
 #include "mongo/db/query/planner_analysis.h"
 
+#include <algorithm>
 #include <set>
 #include <vector>
 
@@ -281,6 +282,151 @@ void geoSkipValidationOn(const std::set<StringData>& twoDSphereFields,
     }
 }
 
+// Maximum number of intervals the bounds on the shard key are allowed to grow to when they are
+// restricted to the ranges owned by the shard. Past that, the scan keeps its original bounds.
+const size_t kMaxOwnedRangeIntervals = 1000;
+
+/**
+ * Appends to 'out' the intersections of the ascending interval 'interval' with the ranges of
+ * 'ownedRanges', in ascending order. Returns false if that would make 'out' exceed
+ * kMaxOwnedRangeIntervals.
+ */
+bool intersectWithOwnedRanges(const Interval& interval,
+                              const RangeMap& ownedRanges,
+                              StringData shardKeyField,
+                              std::vector<Interval>* out) {
+    BSONObjBuilder startKey;
+    startKey.appendAs(interval.start, shardKeyField);
+
+    // Start from the range which contains the start of the interval, if any
+    auto it = ownedRanges.upper_bound(startKey.obj());
+    if (it != ownedRanges.begin()) {
+        --it;
+    }
+
+    for (; it != ownedRanges.end(); ++it) {
+        BSONObjBuilder rangeBuilder;
+        rangeBuilder.appendAs(it->first.firstElement(), "");
+        rangeBuilder.appendAs(it->second.firstElement(), "");
+        const Interval owned(rangeBuilder.obj(), true, false);
+
+        const Interval::IntervalComparison cmp = interval.compare(owned);
+        if (cmp == Interval::INTERVAL_PRECEDES || cmp == Interval::INTERVAL_PRECEDES_COULD_UNION) {
+            // All the remaining ranges start past the end of the interval
+            break;
+        }
+
+        if (cmp == Interval::INTERVAL_SUCCEEDS) {
+            continue;
+        }
+
+        if (out->size() == kMaxOwnedRangeIntervals) {
+            return false;
+        }
+
+        Interval piece = interval;
+        piece.intersect(owned, cmp);
+        out->push_back(piece);
+    }
+
+    return true;
+}
+
+/**
+ * Restricts the bounds of 'isn' on the shard key field to the ranges of shard key values owned by
+ * this shard, so that documents of other chunks are neither scanned nor fetched. Only single
+ * field shard keys are handled, as the owned ranges then map directly onto the bounds of that
+ * field.
+ *
+ * Returns true if the bounds were restricted. The scan then only returns documents owned by the
+ * shard, and needs no shard filter on top of it.
+ */
+bool restrictBoundsToOwnedRanges(const QueryPlannerParams& params, IndexScanNode* isn) {
+    const BSONObj& shardKey = params.shardKey;
+    if (!params.ownedShardKeyRanges || shardKey.nFields() != 1 || isn->indexIsMultiKey ||
+        isn->bounds.isSimpleRange) {
+        return false;
+    }
+
+    const BSONElement shardKeyElt = shardKey.firstElement();
+    const bool hashedShardKey = shardKeyElt.type() == String;
+
+    // Find the index field on which the shard key is, with the same kind of values
+    size_t fieldNo = 0;
+    BSONElement indexElt;
+    for (BSONObjIterator it(isn->indexKeyPattern); it.more(); ++fieldNo) {
+        BSONElement elt = it.next();
+        if (shardKeyElt.fieldNameStringData() == elt.fieldNameStringData()) {
+            indexElt = elt;
+            break;
+        }
+    }
+
+    if (indexElt.eoo() || fieldNo >= isn->bounds.fields.size()) {
+        return false;
+    }
+
+    // A hashed shard key only maps onto a hashed index of the same kind, and a plain shard key
+    // onto an ascending or descending index
+    if (hashedShardKey ? (indexElt.type() != String ||
+                          indexElt.valueStringData() != shardKeyElt.valueStringData())
+                       : !indexElt.isNumber()) {
+        return false;
+    }
+
+    // The intervals are ordered the way the scan walks the index
+    OrderedIntervalList& oil = isn->bounds.fields[fieldNo];
+    const bool descending = (indexElt.isNumber() && indexElt.number() < 0) != (isn->direction < 0);
+
+    std::vector<Interval> intervals = oil.intervals;
+    if (descending) {
+        std::reverse(intervals.begin(), intervals.end());
+        for (auto& interval : intervals) {
+            interval.reverse();
+        }
+    }
+
+    std::vector<Interval> restricted;
+    for (const auto& interval : intervals) {
+        if (!intersectWithOwnedRanges(interval,
+                                      *params.ownedShardKeyRanges,
+                                      shardKeyElt.fieldNameStringData(),
+                                      &restricted)) {
+            return false;
+        }
+    }
+
+    if (descending) {
+        std::reverse(restricted.begin(), restricted.end());
+        for (auto& interval : restricted) {
+            interval.reverse();
+        }
+    }
+
+    oil.intervals = std::move(restricted);
+    return true;
+}
+
+/**
+ * Restricts the bounds of every index scan of the tree 'root' to the ranges owned by this shard
+ * where possible. Returns true if every leaf of the tree is an index scan whose bounds were
+ * restricted, in which case the tree only produces documents owned by this shard.
+ */
+bool restrictScansToOwnedRanges(const QueryPlannerParams& params, QuerySolutionNode* root) {
+    vector<QuerySolutionNode*> leafNodes;
+    getLeafNodes(root, &leafNodes);
+
+    bool allRestricted = true;
+    for (QuerySolutionNode* leaf : leafNodes) {
+        if (STAGE_IXSCAN != leaf->getType() ||
+            !restrictBoundsToOwnedRanges(params, static_cast<IndexScanNode*>(leaf))) {
+            allRestricted = false;
+        }
+    }
+
+    return allRestricted;
+}
+
 }  // namespace
 
 // static
@@ -609,8 +755,10 @@ QuerySolution* QueryPlannerAnalysis::analyzeDataAccess(const CanonicalQuery& que
     // data.
 
     // If we're answering a query on a sharded system, we need to drop documents that aren't
-    // logically part of our shard.
-    if (params.options & QueryPlannerParams::INCLUDE_SHARD_FILTER) {
+    // logically part of our shard. Index scans over the shard key are restricted to the ranges we
+    // own, which makes the filter unnecessary if the whole plan is made of such scans.
+    if ((params.options & QueryPlannerParams::INCLUDE_SHARD_FILTER) &&
+        !restrictScansToOwnedRanges(params, solnRoot)) {
         if (!solnRoot->fetched()) {
             // See if we need to fetch information for our shard key.
             // NOTE: Solution nodes only list ordinary, non-transformed index keys for now
@@ -28,11 +28,13 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/query/index_entry.h"
 #include "mongo/db/query/query_knobs.h"
+#include "mongo/db/range_arithmetic.h"
 
 namespace mongo {
 
@@ -108,6 +110,11 @@ struct QueryPlannerParams {
     // forcing a fetch.
     BSONObj shardKey;
 
+    // Ranges of shard key values owned by this shard, mapping the inclusive min of every range to
+    // its exclusive max. If set along with INCLUDE_SHARD_FILTER, index scans over the shard key
+    // are restricted to these ranges, which can make the shard filter unnecessary.
+    std::shared_ptr<const RangeMap> ownedShardKeyRanges;
+
     // Were index filters applied to indices?
     bool indexFiltersApplied;
 
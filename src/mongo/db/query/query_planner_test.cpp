@@ -3788,6 +3788,123 @@ TEST_F(QueryPlannerTest, ShardFilterNoIndexNotCovered) {
         "{ixscan: {pattern: {b: 1}}}}}}}}}");
 }
 
+/**
+ * Returns the shard key ranges owned by a shard, given as pairs of values of field 'a'.
+ */
+std::shared_ptr<const RangeMap> makeOwnedRanges(
+    const std::vector<std::pair<BSONObj, BSONObj>>& bounds) {
+    auto ranges = std::make_shared<RangeMap>();
+    for (const auto& range : bounds) {
+        ranges->insert(std::make_pair(range.first, range.second));
+    }
+    return ranges;
+}
+
+TEST_F(QueryPlannerTest, ShardFilterOwnedRangesRestrictBounds) {
+    params.options = QueryPlannerParams::INCLUDE_SHARD_FILTER;
+    params.shardKey = BSON("a" << 1);
+    params.ownedShardKeyRanges = makeOwnedRanges(
+        {{BSON("a" << 0), BSON("a" << 10)}, {BSON("a" << 20), BSON("a" << 30)}});
+    addIndex(BSON("a" << 1));
+
+    runQuery(fromjson("{a: {$gte: 5, $lt: 25}}"));
+
+    // The scan only covers what the shard owns, so no shard filter is needed
+    assertNumSolutions(1U);
+    assertSolutionExists(
+        "{fetch: {node: {ixscan: {pattern: {a: 1}, "
+        "bounds: {a: [[5,10,true,false], [20,25,true,false]]}}}}}");
+}
+
+TEST_F(QueryPlannerTest, ShardFilterOwnedRangesRestrictBoundsCovered) {
+    params.options = QueryPlannerParams::INCLUDE_SHARD_FILTER;
+    params.shardKey = BSON("a" << 1);
+    params.ownedShardKeyRanges = makeOwnedRanges(
+        {{BSON("a" << 0), BSON("a" << 10)}, {BSON("a" << 20), BSON("a" << 30)}});
+    addIndex(BSON("a" << 1));
+
+    runQuerySortProj(fromjson("{a: {$in: [1, 15, 25]}}"), BSONObj(), fromjson("{_id: 0, a: 1}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists(
+        "{proj: {spec: {_id: 0, a: 1}, type: 'coveredIndex', node: "
+        "{ixscan: {pattern: {a: 1}, bounds: {a: [[1,1,true,true], [25,25,true,true]]}}}}}");
+}
+
+TEST_F(QueryPlannerTest, ShardFilterOwnedRangesRestrictDescendingBounds) {
+    params.options = QueryPlannerParams::INCLUDE_SHARD_FILTER;
+    params.shardKey = BSON("a" << 1);
+    params.ownedShardKeyRanges = makeOwnedRanges(
+        {{BSON("a" << 0), BSON("a" << 10)}, {BSON("a" << 20), BSON("a" << 30)}});
+    addIndex(BSON("a" << -1 << "b" << 1));
+
+    runQuery(fromjson("{a: {$gt: 5}, b: 1}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists(
+        "{fetch: {node: {ixscan: {pattern: {a: -1, b: 1}, "
+        "bounds: {a: [[30,20,false,true], [10,5,false,false]], b: [[1,1,true,true]]}}}}}");
+}
+
+TEST_F(QueryPlannerTest, ShardFilterOwnedRangesMultikeyIndexKeepsFilter) {
+    params.options = QueryPlannerParams::INCLUDE_SHARD_FILTER;
+    params.shardKey = BSON("a" << 1);
+    params.ownedShardKeyRanges = makeOwnedRanges({{BSON("a" << 0), BSON("a" << 10)}});
+    addIndex(BSON("a" << 1), true);
+
+    runQuery(fromjson("{a: {$in: [5, 25]}}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists(
+        "{sharding_filter: {node: {fetch: {node: {ixscan: {pattern: {a: 1}, "
+        "bounds: {a: [[5,5,true,true], [25,25,true,true]]}}}}}}}");
+}
+
+TEST_F(QueryPlannerTest, ShardFilterOwnedRangesOtherIndexKeepsFilter) {
+    params.options = QueryPlannerParams::INCLUDE_SHARD_FILTER;
+    params.shardKey = BSON("a" << 1);
+    params.ownedShardKeyRanges = makeOwnedRanges({{BSON("a" << 0), BSON("a" << 10)}});
+    addIndex(BSON("b" << 1));
+
+    runQuery(fromjson("{a: {$gte: 5, $lt: 25}, b: 1}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists(
+        "{sharding_filter: {node: {fetch: {node: {ixscan: {pattern: {b: 1}}}}}}}");
+}
+
+TEST_F(QueryPlannerTest, ShardFilterOwnedRangesHashedShardKeyPlainIndexKeepsFilter) {
+    params.options = QueryPlannerParams::INCLUDE_SHARD_FILTER;
+    params.shardKey = BSON("a"
+                           << "hashed");
+    params.ownedShardKeyRanges = makeOwnedRanges({{BSON("a" << 0LL), BSON("a" << 10LL)}});
+    addIndex(BSON("a" << 1));
+
+    runQuery(fromjson("{a: {$gte: 5, $lt: 25}}"));
+
+    // The owned ranges are of hashed values, which say nothing about the bounds of {a: 1}
+    assertNumSolutions(1U);
+    assertSolutionExists(
+        "{sharding_filter: {node: {fetch: {node: {ixscan: {pattern: {a: 1}, "
+        "bounds: {a: [[5,25,true,false]]}}}}}}}");
+}
+
+TEST_F(QueryPlannerTest, ShardFilterOwnedRangesOrKeepsFilterUnlessAllScansRestricted) {
+    params.options = QueryPlannerParams::INCLUDE_SHARD_FILTER | QueryPlannerParams::NO_TABLE_SCAN;
+    params.shardKey = BSON("a" << 1);
+    params.ownedShardKeyRanges = makeOwnedRanges({{BSON("a" << 0), BSON("a" << 10)}});
+    addIndex(BSON("a" << 1));
+    addIndex(BSON("b" << 1));
+
+    runQuery(fromjson("{$or: [{a: {$gt: 5}}, {b: 1}]}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists(
+        "{sharding_filter: {node: {fetch: {node: {or: {nodes: ["
+        "{ixscan: {pattern: {a: 1}, bounds: {a: [[5,10,false,false]]}}}, "
+        "{ixscan: {pattern: {b: 1}}}]}}}}}}");
+}
+
 TEST_F(QueryPlannerTest, CannotTrimIxisectParam) {
     params.options = QueryPlannerParams::CANNOT_TRIM_IXISECT;
     params.options |= QueryPlannerParams::INDEX_INTERSECTION;
@@ -198,6 +198,14 @@ public:
         return _keyFields.vector();
     }
 
+    /**
+     * Returns the ranges of shard key values owned by this shard, with adjacent chunks coalesced.
+     * Maps the inclusive min of every range to its exclusive max.
+     */
+    const RangeMap& getOwnedRanges() const {
+        return _rangesMap;
+    }
+
     BSONObj getMinKey() const;
 
     BSONObj getMaxKey() const;
@@ -32,6 +32,8 @@
 
 #include "mongo/db/s/migration_destination_manager.h"
 
+#include <algorithm>
+#include <deque>
 #include <list>
 #include <vector>
 
@@ -43,6 +45,7 @@
 #include "mongo/db/catalog/document_validation.h"
 #include "mongo/db/catalog/index_create.h"
 #include "mongo/db/client.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbhelpers.h"
@@ -50,6 +53,7 @@
 #include "mongo/db/operation_context.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/ops/delete.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/range_deleter_service.h"
 #include "mongo/db/repl/repl_client_info.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
@@ -57,6 +61,7 @@
 #include "mongo/db/storage/mmap_v1/dur.h"
 #include "mongo/db/s/sharded_connection_info.h"
 #include "mongo/db/s/sharding_state.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/logger/ramlog.h"
 #include "mongo/s/catalog/catalog_manager.h"
 #include "mongo/s/grid.h"
@@ -75,6 +80,26 @@ namespace {
 
 Tee* migrateLog = RamLog::get("migrate");
 
+// Number of concurrent _migrateClone requests the recipient keeps outstanding against the donor
+// during the initial clone. Configurable with server parameter "migrateCloneStreams".
+std::atomic<int> migrateCloneStreams(2);  // NOLINT
+
+class MigrateCloneStreams
+    : public ExportedServerParameter<int, ServerParameterType::kStartupAndRuntime> {
+public:
+    MigrateCloneStreams()
+        : ExportedServerParameter<int, ServerParameterType::kStartupAndRuntime>(
+              ServerParameterSet::getGlobal(), "migrateCloneStreams", &migrateCloneStreams) {}
+
+    virtual Status validate(const int& potentialNewValue) {
+        if (potentialNewValue < 1 || potentialNewValue > 16) {
+            return Status(ErrorCodes::BadValue, "migrateCloneStreams has to be >= 1 and <= 16");
+        }
+
+        return Status::OK();
+    }
+} migrateCloneStreamsConfig;
+
 /**
  * Returns a human-readabale name of the migration manager's state.
  */
@@ -187,6 +212,185 @@ BSONObj createTransferModsRequest(const MigrationSessionId& sessionId) {
     return builder.obj();
 }
 
+// Enabling this fail point makes the _migrateClone requests of the initial clone fail, as if the
+// stream which sent them had lost its connection to the donor.
+MONGO_FP_DECLARE(failMigrateCloneFetch);
+
+/**
+ * Fetches the documents for the initial clone from the donor shard on background threads, so that
+ * the round trips to the donor and its reads overlap with the inserts done by the migrate thread.
+ *
+ * Each stream uses its own connection and issues _migrateClone requests back to back. The donor
+ * hands out disjoint sets of documents to concurrent requests, so the streams never return the
+ * same document twice. Fetched batches are buffered in a bounded queue, which throttles the
+ * streams if the inserts fall behind.
+ */
+class CloneBatchFetcher {
+    MONGO_DISALLOW_COPYING(CloneBatchFetcher);
+
+public:
+    CloneBatchFetcher(std::string fromShard, BSONObj migrateCloneRequest, int numStreams)
+        : _fromShard(std::move(fromShard)),
+          _migrateCloneRequest(std::move(migrateCloneRequest)),
+          _maxBufferedBatches(numStreams),
+          _activeStreams(numStreams) {
+        for (int i = 0; i < numStreams; i++) {
+            _streams.emplace_back([this]() { _streamThread(); });
+        }
+    }
+
+    ~CloneBatchFetcher() {
+        {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            _shutdown = true;
+        }
+        _spaceAvailableCV.notify_all();
+
+        for (auto& stream : _streams) {
+            stream.join();
+        }
+    }
+
+    /**
+     * Blocks until the next batch of documents is available and returns it. Returns an empty
+     * array once the donor has no more documents to clone, or the error of the first failed
+     * request.
+     */
+    StatusWith<BSONObj> next() {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _batchAvailableCV.wait(
+            lk, [this] { return !_batches.empty() || !_status.isOK() || _activeStreams == 0; });
+
+        if (!_status.isOK()) {
+            return _status;
+        }
+
+        if (_batches.empty()) {
+            return BSONObj();
+        }
+
+        BSONObj batch = std::move(_batches.front());
+        _batches.pop_front();
+        _spaceAvailableCV.notify_one();
+
+        return batch;
+    }
+
+private:
+    void _streamThread() {
+        Client::initThread("migrateCloneFetcher");
+
+        try {
+            ScopedDbConnection conn(_fromShard);
+            _fetchBatches(conn.get());
+            conn.done();
+        } catch (const DBException& ex) {
+            _setStatus(ex.toStatus());
+        } catch (const std::exception& ex) {
+            _setStatus(Status(ErrorCodes::UnknownError, ex.what()));
+        }
+
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _activeStreams--;
+        _batchAvailableCV.notify_all();
+    }
+
+    void _fetchBatches(DBClientBase* conn) {
+        while (true) {
+            {
+                stdx::unique_lock<stdx::mutex> lk(_mutex);
+                _spaceAvailableCV.wait(lk, [this] {
+                    return _shutdown || !_status.isOK() ||
+                        _batches.size() < _maxBufferedBatches;
+                });
+
+                if (_shutdown || !_status.isOK()) {
+                    return;
+                }
+            }
+
+            if (MONGO_FAIL_POINT(failMigrateCloneFetch)) {
+                _setStatus(Status(ErrorCodes::OperationFailed,
+                                  "_migrateClone failed: failMigrateCloneFetch is enabled"));
+                return;
+            }
+
+            // gets array of objects to copy, in disk order
+            BSONObj res;
+            if (!conn->runCommand("admin", _migrateCloneRequest, res)) {
+                _setStatus(Status(ErrorCodes::OperationFailed,
+                                  str::stream() << "_migrateClone failed: " << res.toString()));
+                return;
+            }
+
+            BSONObj batch = res["objects"].Obj().getOwned();
+            if (batch.isEmpty()) {
+                // The donor has handed out all of its documents
+                return;
+            }
+
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            _batches.push_back(std::move(batch));
+            _batchAvailableCV.notify_one();
+        }
+    }
+
+    void _setStatus(Status status) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_status.isOK()) {
+            _status = std::move(status);
+        }
+        _batchAvailableCV.notify_all();
+        _spaceAvailableCV.notify_all();
+    }
+
+    const std::string _fromShard;
+    const BSONObj _migrateCloneRequest;
+    const size_t _maxBufferedBatches;
+
+    // Protects all the fields below
+    stdx::mutex _mutex;
+
+    // Signaled when a batch is queued, a stream fails or the last stream exits
+    stdx::condition_variable _batchAvailableCV;
+
+    // Signaled when a batch is consumed, a stream fails or the fetcher is shut down
+    stdx::condition_variable _spaceAvailableCV;
+
+    std::deque<BSONObj> _batches;
+    Status _status{Status::OK()};
+    int _activeStreams;
+    bool _shutdown{false};
+
+    std::vector<stdx::thread> _streams;
+};
+
+/**
+ * Inserts the cloned documents in [begin, end) in a single write unit of work. The caller must
+ * have checked that none of them exists on this shard yet. Returns false without having written
+ * anything if the inserts fail, in which case the documents should be applied one at a time.
+ */
+bool insertClonedDocuments(OperationContext* txn,
+                           Collection* collection,
+                           std::vector<BSONObj>::const_iterator begin,
+                           std::vector<BSONObj>::const_iterator end) {
+    if (begin == end) {
+        return true;
+    }
+
+    try {
+        WriteUnitOfWork wuow(txn);
+        if (!collection->insertDocuments(txn, begin, end, true, true).isOK()) {
+            return false;
+        }
+        wuow.commit();
+    } catch (const WriteConflictException&) {
+        return false;
+    }
+
+    return true;
+}
+
 MONGO_FP_DECLARE(failMigrationReceivedOutOfRangeDelete);
 
 }  // namespace
@@ -605,23 +809,27 @@ void MigrationDestinationManager::_migrateDriver(OperationContext* txn,
         // 3. Initial bulk clone
         setState(CLONE);
 
-        const BSONObj migrateCloneRequest = createMigrateCloneRequest(sessionId);
+        CloneBatchFetcher fetcher(
+            fromShard, createMigrateCloneRequest(sessionId), migrateCloneStreams.load());
+
+        // Documents are applied in groups, each under a single write context and write unit of
+        // work, sized like the groups of a batched insert command
+        const size_t maxGroupCount = std::max(1, internalQueryExecYieldIterations.load() / 2);
 
         while (true) {
-            BSONObj res;
-            if (!conn->runCommand("admin",
-                                  migrateCloneRequest,
-                                  res)) {  // gets array of objects to copy, in disk order
+            StatusWith<BSONObj> batchStatus = fetcher.next();
+            if (!batchStatus.isOK()) {
                 setState(FAIL);
-                errmsg = "_migrateClone failed: ";
-                errmsg += res.toString();
+                errmsg = batchStatus.getStatus().reason();
                 error() << errmsg << migrateLog;
                 conn.done();
                 return;
             }
 
-            BSONObj arr = res["objects"].Obj();
-            int thisTime = 0;
+            const BSONObj& arr = batchStatus.getValue();
+            if (arr.isEmpty()) {
+                break;
+            }
 
             BSONObjIterator i(arr);
             while (i.more()) {
@@ -634,31 +842,64 @@ void MigrationDestinationManager::_migrateDriver(OperationContext* txn,
                     return;
                 }
 
-                BSONObj docToClone = i.next().Obj();
+                std::vector<BSONObj> newDocs;
+                size_t groupCount = 0;
+                long long groupBytes = 0;
+
                 {
                     OldClientWriteContext cx(txn, ns);
 
-                    BSONObj localDoc;
-                    if (willOverrideLocalId(
-                            txn, ns, min, max, shardKeyPattern, cx.db(), docToClone, &localDoc)) {
-                        string errMsg = str::stream() << "cannot migrate chunk, local document "
-                                                      << localDoc << " has same _id as cloned "
-                                                      << "remote document " << docToClone;
-
-                        warning() << errMsg;
-
-                        // Exception will abort migration cleanly
-                        uasserted(16976, errMsg);
+                    Collection* const collection = cx.getCollection();
+                    const bool hasIdIndex =
+                        collection && collection->getIndexCatalog()->findIdIndex(txn);
+
+                    while (i.more() && groupCount < maxGroupCount &&
+                           groupBytes < insertVectorMaxBytes) {
+                        BSONObj docToClone = i.next().Obj();
+
+                        BSONObj localDoc;
+                        if (willOverrideLocalId(txn,
+                                                ns,
+                                                min,
+                                                max,
+                                                shardKeyPattern,
+                                                cx.db(),
+                                                docToClone,
+                                                &localDoc)) {
+                            string errMsg = str::stream()
+                                << "cannot migrate chunk, local document " << localDoc
+                                << " has same _id as cloned "
+                                << "remote document " << docToClone;
+
+                            warning() << errMsg;
+
+                            // Exception will abort migration cleanly
+                            uasserted(16976, errMsg);
+                        }
+
+                        if (hasIdIndex && localDoc.isEmpty()) {
+                            // Nothing to replace, so the document can be inserted with the rest
+                            // of the group
+                            newDocs.push_back(docToClone);
+                        } else {
+                            Helpers::upsert(txn, ns, docToClone, true);
+                        }
+
+                        groupCount++;
+                        groupBytes += docToClone.objsize();
                     }
 
-                    Helpers::upsert(txn, ns, docToClone, true);
+                    if (!insertClonedDocuments(txn, collection, newDocs.begin(), newDocs.end())) {
+                        for (const auto& doc : newDocs) {
+                            Helpers::upsert(txn, ns, doc, true);
+                        }
+                    }
                 }
-                thisTime++;
 
                 {
                     stdx::lock_guard<stdx::mutex> statsLock(_mutex);
-                    _numCloned++;
-                    _clonedBytes += docToClone.objsize();
+                    _numCloned += groupCount;
+                    _clonedBytes += groupBytes;
                 }
 
                 if (writeConcern.shouldWaitForOtherNodes()) {
@@ -675,9 +916,6 @@ void MigrationDestinationManager::_migrateDriver(OperationContext* txn,
                     }
                 }
             }
-
-            if (thisTime == 0)
-                break;
         }
 
         timing.done(3);
@@ -0,0 +1,97 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/stats/write_phase_stats.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+WritePhaseStats globalWritePhaseStats;
+
+const int WritePhaseStats::kNumBuckets;
+
+StringData writePhaseName(WritePhase phase) {
+    switch (phase) {
+        case WritePhase::kValidation:
+            return "validation";
+        case WritePhase::kKeyGeneration:
+            return "keyGeneration";
+        case WritePhase::kIndexWrite:
+            return "indexWrite";
+        case WritePhase::kOplog:
+            return "oplog";
+        case WritePhase::kJournal:
+            return "journal";
+        case WritePhase::kWriteConcern:
+            return "writeConcern";
+    }
+    MONGO_UNREACHABLE;
+}
+
+// static
+int WritePhaseStats::bucketFor(long long micros) {
+    int bucket = 0;
+    for (long long bound = 4; micros >= bound && bucket < kNumBuckets - 1; bound *= 4) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+void WritePhaseStats::record(WritePhase phase, long long micros) {
+    PhaseHistogram& histogram = _phases[static_cast<int>(phase)];
+    histogram.count.fetchAndAdd(1);
+    histogram.totalMicros.fetchAndAdd(micros);
+    histogram.buckets[bucketFor(micros)].fetchAndAdd(1);
+}
+
+void WritePhaseStats::append(BSONObjBuilder* builder) const {
+    for (int i = 0; i < kNumWritePhases; ++i) {
+        const PhaseHistogram& histogram = _phases[i];
+
+        BSONObjBuilder phaseBuilder(builder->subobjStart(writePhaseName(WritePhase(i))));
+        phaseBuilder.appendNumber("count", histogram.count.loadRelaxed());
+        phaseBuilder.appendNumber("totalMicros", histogram.totalMicros.loadRelaxed());
+
+        BSONObjBuilder bucketsBuilder(phaseBuilder.subobjStart("histogram"));
+        long long bound = 4;
+        for (int b = 0; b < kNumBuckets - 1; ++b, bound *= 4) {
+            const std::string bucketName = str::stream() << "lt" << bound;
+            bucketsBuilder.appendNumber(bucketName, histogram.buckets[b].loadRelaxed());
+        }
+        const std::string lastBucketName = str::stream() << "ge" << bound / 4;
+        bucketsBuilder.appendNumber(lastBucketName,
+                                    histogram.buckets[kNumBuckets - 1].loadRelaxed());
+    }
+}
+
+}  // namespace mongo
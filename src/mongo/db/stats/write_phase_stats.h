@@ -0,0 +1,102 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+
+/**
+ * The phases of a write whose latencies are broken out per operation in OpDebug and server-wide
+ * in WritePhaseStats.
+ */
+enum class WritePhase {
+    kValidation,     // Checking documents against the collection's validator.
+    kKeyGeneration,  // Generating index keys for the documents written.
+    kIndexWrite,     // Inserting and removing keys in each index.
+    kOplog,          // Writing the oplog entries for the operation.
+    kJournal,        // Waiting for the journal to make the write durable.
+    kWriteConcern,   // Waiting for replication to satisfy the write concern.
+};
+
+const int kNumWritePhases = static_cast<int>(WritePhase::kWriteConcern) + 1;
+
+/**
+ * Returns the name under which 'phase' is reported, e.g. "indexWrite".
+ */
+StringData writePhaseName(WritePhase phase);
+
+/**
+ * Server-wide latency histograms, one per WritePhase. Each operation that spent time in a phase
+ * contributes one sample of its total time in that phase.
+ *
+ * Buckets are powers of four in microseconds: bucket 0 counts samples under 4us, bucket i counts
+ * samples in [4^i, 4^(i+1)) and the last bucket counts everything from 4^(kNumBuckets-1)us up.
+ *
+ * Thread safe.
+ */
+class WritePhaseStats {
+    MONGO_DISALLOW_COPYING(WritePhaseStats);
+
+public:
+    static const int kNumBuckets = 11;
+
+    WritePhaseStats() = default;
+
+    void record(WritePhase phase, long long micros);
+
+    /**
+     * Appends one sub-object per phase, e.g.
+     *
+     * indexWrite: { count: 10, totalMicros: 450, histogram: { lt4: 0, lt16: 2, ... } }
+     */
+    void append(BSONObjBuilder* builder) const;
+
+    /**
+     * Returns the index of the bucket counting a sample of 'micros'.
+     */
+    static int bucketFor(long long micros);
+
+private:
+    struct PhaseHistogram {
+        AtomicInt64 count;
+        AtomicInt64 totalMicros;
+        AtomicInt64 buckets[kNumBuckets];
+    };
+
+    PhaseHistogram _phases[kNumWritePhases];
+};
+
+extern WritePhaseStats globalWritePhaseStats;
+
+}  // namespace mongo
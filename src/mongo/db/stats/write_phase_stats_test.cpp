@@ -0,0 +1,76 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/stats/write_phase_stats.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+using namespace mongo;
+
+TEST(WritePhaseStatsTest, BucketBoundaries) {
+    ASSERT_EQUALS(0, WritePhaseStats::bucketFor(0));
+    ASSERT_EQUALS(0, WritePhaseStats::bucketFor(3));
+    ASSERT_EQUALS(1, WritePhaseStats::bucketFor(4));
+    ASSERT_EQUALS(1, WritePhaseStats::bucketFor(15));
+    ASSERT_EQUALS(2, WritePhaseStats::bucketFor(16));
+    ASSERT_EQUALS(WritePhaseStats::kNumBuckets - 2, WritePhaseStats::bucketFor(1048575));
+    ASSERT_EQUALS(WritePhaseStats::kNumBuckets - 1, WritePhaseStats::bucketFor(1048576));
+    ASSERT_EQUALS(WritePhaseStats::kNumBuckets - 1, WritePhaseStats::bucketFor(1LL << 40));
+}
+
+TEST(WritePhaseStatsTest, AppendReportsEveryPhase) {
+    WritePhaseStats stats;
+    stats.record(WritePhase::kIndexWrite, 10);
+    stats.record(WritePhase::kIndexWrite, 20);
+    stats.record(WritePhase::kOplog, 2000000);
+
+    BSONObjBuilder builder;
+    stats.append(&builder);
+    BSONObj report = builder.obj();
+
+    ASSERT_EQUALS(kNumWritePhases, report.nFields());
+
+    BSONObj indexWrite = report["indexWrite"].Obj();
+    ASSERT_EQUALS(2, indexWrite["count"].numberLong());
+    ASSERT_EQUALS(30, indexWrite["totalMicros"].numberLong());
+    ASSERT_EQUALS(1, indexWrite["histogram"]["lt16"].numberLong());
+    ASSERT_EQUALS(1, indexWrite["histogram"]["lt64"].numberLong());
+    ASSERT_EQUALS(WritePhaseStats::kNumBuckets, indexWrite["histogram"].Obj().nFields());
+
+    BSONObj oplog = report["oplog"].Obj();
+    ASSERT_EQUALS(1, oplog["count"].numberLong());
+    ASSERT_EQUALS(1, oplog["histogram"]["ge1048576"].numberLong());
+
+    ASSERT_EQUALS(0, report["validation"]["count"].numberLong());
+}
+
+}  // namespace
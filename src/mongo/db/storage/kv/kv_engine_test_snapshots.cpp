@@ -129,6 +129,25 @@ public:
         wuow.commit();
     }
 
+    /**
+     * Overwrites 'damage.length()' bytes of the record at 'offset' with 'damage', given that
+     * the record currently holds 'oldContents'.
+     */
+    void updateRecordWithDamagesAndCommit(RecordId id,
+                                          std::string oldContents,
+                                          size_t offset,
+                                          std::string damage) {
+        auto op = makeOperation();
+        WriteUnitOfWork wuow(op);
+        mutablebson::DamageVector damages(1);
+        damages[0].sourceOffset = 0;
+        damages[0].targetOffset = offset;
+        damages[0].size = damage.length();
+        const RecordData oldRec(oldContents.c_str(), oldContents.length() + 1);
+        ASSERT_OK(rs->updateWithDamages(op, id, oldRec, damage.c_str(), damages).getStatus());
+        wuow.commit();
+    }
+
     void deleteRecordAndCommit(RecordId id) {
         auto op = makeOperation();
         WriteUnitOfWork wuow(op);
@@ -339,8 +358,11 @@ TEST_F(SnapshotManagerTests, UpdateAndDelete) {
     updateRecordAndCommit(id, "Cat");
     auto snapCat = prepareAndCreateSnapshot();
 
-    // Untested since no engine currently supports both updateWithDamanges and snapshots.
-    ASSERT(!rs->updateWithDamagesSupported());
+    const bool damagesSupported = rs->updateWithDamagesSupported();
+    if (damagesSupported) {
+        updateRecordWithDamagesAndCommit(id, "Cat", 1, "ow");
+    }
+    auto snapCow = prepareAndCreateSnapshot();
 
     deleteRecordAndCommit(id);
     auto snapAfterDelete = prepareAndCreateSnapshot();
@@ -357,6 +379,10 @@ TEST_F(SnapshotManagerTests, UpdateAndDelete) {
     ASSERT_EQ(itCountCommitted(), 1);
     ASSERT_EQ(readStringCommitted(id), "Cat");
 
+    snapshotManager->setCommittedSnapshot(snapCow);
+    ASSERT_EQ(itCountCommitted(), 1);
+    ASSERT_EQ(readStringCommitted(id), damagesSupported ? "Cow" : "Cat");
+
     snapshotManager->setCommittedSnapshot(snapAfterDelete);
     ASSERT_EQ(itCountCommitted(), 0);
     ASSERT(!readRecordCommitted(id));
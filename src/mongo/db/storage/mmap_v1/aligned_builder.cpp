@@ -57,6 +57,15 @@ void AlignedBuilder::reset() {
     }
 }
 
+void AlignedBuilder::resetAndReserve(unsigned sz) {
+    reset();
+    if (sz > _p._size) {
+        _len = sz;
+        growReallocate(0);
+        _len = 0;
+    }
+}
+
 /** reset with a hint as to the upcoming needed size specified */
 void AlignedBuilder::reset(unsigned sz) {
     _len = 0;
@@ -47,6 +47,10 @@ public:
     /** reset for a re-use. shrinks if > 128MB */
     void reset();
 
+    /** reset for a re-use, with room for at least sz bytes. unlike reset(sz), grows the buffer
+        only as far as needed, by doubling it like appends do. */
+    void resetAndReserve(unsigned sz);
+
     /** note this may be deallocated (realloced) if you keep writing or reset(). */
     const char* buf() const {
         return _p._data;
@@ -63,8 +63,14 @@
      UNLOCK mmmutex
      UNLOCK groupCommitMutex
 
-   every Nth groupCommit, at the end, we REMAPPRIVATEVIEW() at the end of the work. because of
-   that we are in W lock for that groupCommit, which is nonideal of course.
+   every Nth groupCommit, at the end, we REMAPPRIVATEVIEW() at the end of the work. where the
+   remap is atomic (everywhere except Windows and Solaris) this only keeps the flush lock in S
+   mode, which holds off writers but lets readers proceed. elsewhere the flush lock is upgraded
+   to X for the remap. either way the remap is done incrementally: each remap goes through
+   files for at most MaxRemapPrivateViewMillis and the remaining files of its pass are picked up
+   by the following remaps, so the stall is bounded regardless of the number of files. commits
+   which do not remap release the flush lock before their journal I/O (see
+   RemapPrivateViewSchedule).
 
    @see https://docs.google.com/drawings/edit?id=1TklsmZzm7ohIZkwgeK6rMvsdaR13KjtJYMsfLr175Zc
 */
@@ -86,6 +92,7 @@
 #include "mongo/db/storage/mmap_v1/dur_commitjob.h"
 #include "mongo/db/storage/mmap_v1/dur_journal.h"
 #include "mongo/db/storage/mmap_v1/dur_journal_writer.h"
+#include "mongo/db/storage/mmap_v1/dur_remap_schedule.h"
 #include "mongo/db/storage/mmap_v1/dur_recover.h"
 #include "mongo/db/storage/mmap_v1/dur_stats.h"
 #include "mongo/db/storage/mmap_v1/durable_mapped_file.h"
@@ -136,14 +143,27 @@ enum {
     NumCommitsBeforeRemap = 10,
 
     // How many outstanding journal flushes should be allowed before applying writer back
-    // pressure. Size of 1 allows two journal blocks to be in the process of being written -
-    // one on the journal writer's buffer and one blocked waiting to be picked up.
-    NumAsyncJournalWrites = 1,
+    // pressure. Size of 2 double-buffers the journal: one commit can be prepared and
+    // compressed while the previous one is being written and synced to disk. Each buffer
+    // costs memory for both the uncompressed and the compressed commit (see JournalWriter).
+    NumAsyncJournalWrites = 2,
+
+    // How long a single groupCommit may spend remapping private views, unless it is forced to
+    // remap everything it was asked to because of memory pressure
+    MaxRemapPrivateViewMillis = 10,
 };
 
 // Remap loop state
 unsigned remapFileToStartAt;
 
+// Whether the private views can be remapped while readers are accessing them. Elsewhere the
+// flush lock must be held in X mode for the remap.
+#if defined(_WIN32) || defined(__sun)
+const bool remapIsAtomic = false;
+#else
+const bool remapIsAtomic = true;
+#endif
+
 // How frequently to reset the durability statistics
 enum { DurStatsResetIntervalMillis = 3 * 1000 };
 
@@ -317,13 +337,17 @@ void debugValidateFileMapsMatch(const DurableMappedFile* mmf) {
 
 /**
  * Main code of the remap private view function.
+ *
+ * @return true if the current remap pass of 'schedule' completed, false if the time budget ran
+ *      out first. In that case the next remap picks up where this one stopped.
  */
-void remapPrivateViewImpl(double fraction) {
+bool remapPrivateViewImpl(RemapPrivateViewSchedule* schedule,
+                          const RemapPrivateViewSchedule::Step& step) {
     LOG(4) << "journal REMAPPRIVATEVIEW" << endl;
 
 // There is no way that the set of files can change while we are in this method, because
-// we hold the flush lock in X mode. For files to go away, a database needs to be dropped,
-// which means acquiring the flush lock in at least IX mode.
+// we hold the flush lock in at least S mode. For files to go away, a database needs to be
+// dropped, which means acquiring the flush lock in at least IX mode.
 //
 // However, the record fetcher logic unfortunately operates without any locks and on
 // Windows and Solaris remap is not atomic and there is a window where the record fetcher
@@ -343,34 +367,34 @@ void remapPrivateViewImpl(double fraction) {
     std::set<MongoFile*>& files = MongoFile::getAllFiles();
 
     const unsigned sz = files.size();
-    if (sz == 0) {
-        return;
+    const unsigned ntodo = schedule->filesToRemap(step, sz);
+    if (ntodo == 0) {
+        schedule->onRemapped(0, curTimeMicros64());
+        return true;
     }
 
-    unsigned ntodo = (unsigned)(sz * fraction);
-    if (ntodo < 1)
-        ntodo = 1;
-    if (ntodo > sz)
-        ntodo = sz;
-
     const set<MongoFile*>::iterator b = files.begin();
     const set<MongoFile*>::iterator e = files.end();
     set<MongoFile*>::iterator i = b;
 
     // Skip to our starting position as remembered from the last remap cycle
+    remapFileToStartAt %= sz;
     for (unsigned x = 0; x < remapFileToStartAt; x++) {
         i++;
-        if (i == e)
-            i = b;
     }
 
-    // Mark where to start on the next cycle
     const unsigned startedAt = remapFileToStartAt;
-    remapFileToStartAt = (remapFileToStartAt + ntodo) % sz;
 
     Timer t;
 
-    for (unsigned x = 0; x < ntodo; x++) {
+    unsigned ndone = 0;
+    while (ndone < ntodo) {
+        if (!step.force && t.millis() >= MaxRemapPrivateViewMillis) {
+            break;
+        }
+
+        ndone++;
+
         if ((*i)->isDurableMappedFile()) {
             DurableMappedFile* const mmf = (DurableMappedFile*)*i;
 
@@ -383,16 +407,22 @@ void remapPrivateViewImpl(double fraction) {
             if (mmf->willNeedRemap()) {
                 mmf->remapThePrivateView();
             }
+        }
 
-            i++;
+        i++;
 
-            if (i == e)
-                i = b;
-        }
+        if (i == e)
+            i = b;
     }
 
-    LOG(3) << "journal REMAPPRIVATEVIEW done startedAt: " << startedAt << " n:" << ntodo << ' '
-           << t.millis() << "ms";
+    // Mark where to start on the next cycle
+    remapFileToStartAt = (startedAt + ndone) % sz;
+
+    LOG(3) << "journal REMAPPRIVATEVIEW done startedAt: " << startedAt << " n:" << ndone << '/'
+           << ntodo << ' ' << t.millis() << "ms";
+
+    schedule->onRemapped(ndone, curTimeMicros64());
+    return !schedule->passInProgress();
 }
 
 
@@ -484,9 +514,12 @@ void Stats::S::_asObj(BSONObjBuilder* builder) const {
       << _journaledBytes / (_uncompressedBytes + 1.0) << "commitsInWriteLock" << _commitsInWriteLock
       << "earlyCommits" << 0 << "timeMs"
       << BSON("dt" << _durationMillis << "prepLogBuffer" << (unsigned)(_prepLogBufferMicros / 1000)
-                   << "writeToJournal" << (unsigned)(_writeToJournalMicros / 1000)
+                   << "compress" << (unsigned)(_compressMicros / 1000) << "writeToJournal"
+                   << (unsigned)(_writeToJournalMicros / 1000)
                    << "writeToDataFiles" << (unsigned)(_writeToDataFilesMicros / 1000)
-                   << "remapPrivateView" << (unsigned)(_remapPrivateViewMicros / 1000) << "commits"
+                   << "remapPrivateView" << (unsigned)(_remapPrivateViewMicros / 1000)
+                   << "remapPrivateViewMaxStall" << (unsigned)(_remapPrivateViewMaxMicros / 1000)
+                   << "commits"
                    << (unsigned)(_commitsMicros / 1000) << "commitsInWriteLock"
                    << (unsigned)(_commitsInWriteLockMicros / 1000));
 
@@ -619,21 +652,29 @@ void DurableImpl::start() {
  * copy-on-write/swap space. Must only be called after the in-memory journal has been flushed
  * to disk and applied on top of the shared view.
  *
- * @param fraction Value between (0, 1] indicating what fraction of the memory to remap.
- *      Remapping too much or too frequently incurs copy-on-write page fault cost.
+ * Goes through the files of the current remap pass of 'schedule', or of a new one if there is
+ * none in progress. Remapping too much or too frequently incurs copy-on-write page fault cost.
+ * Stops after MaxRemapPrivateViewMillis, unless 'step' is forced.
+ *
+ * @return true if the remap pass completed.
  */
-static void remapPrivateView(double fraction) {
+static bool remapPrivateView(RemapPrivateViewSchedule* schedule,
+                             const RemapPrivateViewSchedule::Step& step) {
     // Remapping private views must occur after WRITETODATAFILES otherwise we wouldn't see any
     // newly written data on reads.
     invariant(!commitJob.hasWritten());
 
     try {
         Timer t;
-        remapPrivateViewImpl(fraction);
-        stats.curr()->_remapPrivateViewMicros += t.micros();
+        const bool done = remapPrivateViewImpl(schedule, step);
+
+        const uint64_t micros = t.micros();
+        Stats::S* const curr = stats.curr();
+        curr->_remapPrivateViewMicros += micros;
+        curr->_remapPrivateViewMaxMicros = std::max(curr->_remapPrivateViewMaxMicros, micros);
 
         LOG(4) << "remapPrivateView end";
-        return;
+        return done;
     } catch (DBException& e) {
         severe() << "dbexception in remapPrivateView causing immediate shutdown: " << e.toString();
     } catch (std::ios_base::failure& e) {
@@ -649,6 +690,7 @@ static void remapPrivateView(double fraction) {
     }
 
     invariant(false);
+    return false;
 }
 
 
@@ -671,10 +713,8 @@ static void durThread() {
     JournalWriter journalWriter(&commitNotify, &applyToDataFilesNotify, NumAsyncJournalWrites);
     journalWriter.start();
 
-    // Used as an estimate of how much / how fast to remap
-    uint64_t commitCounter(0);
-    uint64_t estimatedPrivateMapSize(0);
-    uint64_t remapLastTimestamp(0);
+    // Decides which commits remap and how much
+    RemapPrivateViewSchedule remapSchedule(NumCommitsBeforeRemap, UncommittedBytesLimit);
 
     while (shutdownRequested.loadRelaxed() == 0) {
         unsigned ms = storageGlobalParams.journalCommitIntervalMs;
@@ -743,8 +783,7 @@ static void durThread() {
                 JournalWriter::Buffer* const buffer = journalWriter.newBuffer();
                 PREPLOGBUFFER(buffer->getHeader(), buffer->getBuilder());
 
-                estimatedPrivateMapSize += commitJob.bytes();
-                commitCounter++;
+                const uint64_t bytesCommitted = commitJob.bytes();
 
                 // Now that the write intents have been copied to the buffer, the commit job is
                 // free to be reused. We need to reset the commit job's contents while under
@@ -756,47 +795,19 @@ static void durThread() {
                     ProcessInfo::getSystemMemoryPressurePercentage();
 
                 // Now that the in-memory modifications have been collected, we can potentially
-                // release the flush lock if remap is not necessary.
-                // When we remap due to memory pressure, we look at two criteria
-                // 1. If the amount of 4k pages touched exceeds 512 MB,
-                //    a reasonable estimate of memory pressure on Linux.
-                // 2. Check if the amount of free memory on the machine is running low,
-                //    since #1 is underestimates the memory pressure on Windows since
-                //    commits in 64MB chunks.
-                const bool shouldRemap = (estimatedPrivateMapSize >= UncommittedBytesLimit) ||
-                    (systemMemoryPressurePercentage > 0.0) ||
-                    (commitCounter % NumCommitsBeforeRemap == 0) ||
-                    (mmapv1GlobalOptions.journalOptions & MMAPV1Options::JournalAlwaysRemap);
-
-                double remapFraction = 0.0;
-
-                if (shouldRemap) {
-                    // We want to remap all private views about every 2 seconds. There could be
-                    // ~1000 views so we do a little each pass. There will be copy on write
-                    // faults after remapping, so doing a little bit at a time will avoid big
-                    // load spikes when the pages are touched.
-                    //
-                    // TODO: Instead of the time-based logic above, consider using ProcessInfo
-                    //       and watching for getResidentSize to drop, which is more precise.
-                    remapFraction = (curTimeMicros64() - remapLastTimestamp) / 2000000.0;
-
-                    if (mmapv1GlobalOptions.journalOptions & MMAPV1Options::JournalAlwaysRemap) {
-                        remapFraction = 1;
-                    } else {
-                        // We don't want to get close to the UncommittedBytesLimit
-                        const double remapMemFraction =
-                            estimatedPrivateMapSize / ((double)UncommittedBytesLimit);
-
-                        remapFraction = std::max(remapMemFraction, remapFraction);
-
-                        remapFraction = std::max(systemMemoryPressurePercentage, remapFraction);
-                    }
-                } else {
+                // release the flush lock if remap is not necessary. A remap pass which ran out of
+                // time is continued by later remaps at the usual cadence, not by every commit.
+                const RemapPrivateViewSchedule::Step remapStep = remapSchedule.onCommit(
+                    bytesCommitted,
+                    systemMemoryPressurePercentage,
+                    mmapv1GlobalOptions.journalOptions & MMAPV1Options::JournalAlwaysRemap,
+                    curTimeMicros64());
+
+                if (!remapStep.remap) {
                     LOG(4) << "Early release flush lock";
 
                     // We will not be doing a remap so drop the flush lock. That way we will be
                     // doing the journal I/O outside of lock, so other threads can proceed.
-                    invariant(!shouldRemap);
                     autoFlushLock.release();
                 }
 
@@ -807,27 +818,27 @@ static void durThread() {
                 // Data has now been written to the shared view. If remap was requested, we
                 // would still be holding the S flush lock here, so just upgrade it and
                 // perform the remap.
-                if (shouldRemap) {
+                if (remapStep.remap) {
                     // Need to wait for the previously scheduled journal writes to complete
                     // before any remap is attempted.
                     journalWriter.flush();
                     journalWriter.assertIdle();
 
-                    // Upgrading the journal lock to flush stops all activity on the system,
-                    // because we will be remapping memory and we don't want readers to be
-                    // accessing it. Technically this step could be avoided on systems, which
-                    // support atomic remap.
-                    autoFlushLock.upgradeFlushLockToExclusive();
-                    remapPrivateView(remapFraction);
+                    // The S flush lock already keeps writers out. Where the remap is not atomic,
+                    // upgrading it to X also stops readers, which would otherwise see the
+                    // private view while it is being replaced.
+                    if (!remapIsAtomic) {
+                        autoFlushLock.upgradeFlushLockToExclusive();
+                    }
 
-                    autoFlushLock.release();
+                    remapPrivateView(&remapSchedule, remapStep);
 
-                    // Reset the private map estimate outside of the lock
-                    estimatedPrivateMapSize = 0;
-                    remapLastTimestamp = curTimeMicros64();
+                    autoFlushLock.release();
 
-                    stats.curr()->_commitsInWriteLock++;
-                    stats.curr()->_commitsInWriteLockMicros += t.micros();
+                    if (!remapIsAtomic) {
+                        stats.curr()->_commitsInWriteLock++;
+                        stats.curr()->_commitsInWriteLockMicros += t.micros();
+                    }
                 }
             }
 
@@ -750,19 +750,29 @@ void Journal::_rotate(unsigned long long lsnOfCurrentJournalEntry) {
     }
 }
 
+void COMPRESSJOURNALSECTION(const JSectHeader& h,
+                            const AlignedBuilder& uncompressed,
+                            AlignedBuilder* compressed) {
+    Timer t;
+    Journal::compress(h, uncompressed, compressed);
+    stats.curr()->_compressMicros += t.micros();
+}
+
 /** write (append) the buffer we have built to the journal and fsync it.
     outside of dbMutex lock as this could be slow.
-    @param uncompressed - a buffer that will be written to the journal after compression
+    @param compressed - a section built by COMPRESSJOURNALSECTION
     will not return until on disk
 */
-void WRITETOJOURNAL(const JSectHeader& h, const AlignedBuilder& uncompressed) {
+void WRITETOJOURNAL(JSectHeader* h, unsigned uncompressedLen, AlignedBuilder* compressed) {
     Timer t;
-    j.journal(h, uncompressed);
+    j.journal(h, uncompressedLen, compressed);
     stats.curr()->_writeToJournalMicros += t.micros();
 }
 
-void Journal::journal(const JSectHeader& h, const AlignedBuilder& uncompressed) {
-    static AlignedBuilder b(32 * 1024 * 1024);
+void Journal::compress(const JSectHeader& h,
+                       const AlignedBuilder& uncompressed,
+                       AlignedBuilder* compressed) {
+    AlignedBuilder& b = *compressed;
     /* buffer to journal will be
        JSectHeader
        compressed operations
@@ -770,10 +780,13 @@ void Journal::journal(const JSectHeader& h, const AlignedBuilder& uncompressed)
     */
     const unsigned headTailSize = sizeof(JSectHeader) + sizeof(JSectFooter);
     const unsigned max = maxCompressedLength(uncompressed.len()) + headTailSize;
-    b.reset(max);
+
+    // Each journal buffer keeps its own compressed builder, so only grow it as far as this
+    // section needs. reset(max) would round every one of them up to a multiple of 32MB.
+    b.resetAndReserve(max);
 
     {
-        dassert(h.sectionLen() == (unsigned)0xffffffff);  // we will backfill later
+        dassert(h.sectionLen() == (unsigned)0xffffffff);  // journal() will backfill it
         b.appendStruct(h);
     }
 
@@ -782,39 +795,48 @@ void Journal::journal(const JSectHeader& h, const AlignedBuilder& uncompressed)
     verify(compressedLength < 0xffffffff);
     verify(compressedLength < max);
     b.skip(compressedLength);
+}
 
-    // footer
-    unsigned L = 0xffffffff;
-    {
-        // pad to alignment, and set the total section length in the JSectHeader
-        verify(0xffffe000 == (~(Alignment - 1)));
-        unsigned lenUnpadded = b.len() + sizeof(JSectFooter);
-        L = (lenUnpadded + Alignment - 1) & (~(Alignment - 1));
-        dassert(L >= lenUnpadded);
-
-        ((JSectHeader*)b.atOfs(0))->setSectionLen(lenUnpadded);
-
-        JSectFooter f(b.buf(), b.len());  // computes checksum
-        b.appendStruct(f);
-        dassert(b.len() == lenUnpadded);
-
-        b.skip(L - lenUnpadded);
-        dassert(b.len() % Alignment == 0);
-    }
+void Journal::journal(JSectHeader* h, unsigned uncompressedLen, AlignedBuilder* compressed) {
+    AlignedBuilder& b = *compressed;
 
     try {
         stdx::lock_guard<SimpleMutex> lk(_curLogFileMutex);
 
-        // must already be open -- so that _curFileId is correct for previous buffer building
+        // must already be open -- so that _curFileId is correct for this section
         verify(_curLogFile);
 
-        stats.curr()->_uncompressedBytes += uncompressed.len();
+        // The section may have been compressed before the previous one rotated the journal
+        // file, so its fileId is only known here.
+        h->fileId = _curFileId;
+
+        // footer
+        unsigned L = 0xffffffff;
+        {
+            // pad to alignment, and set the total section length in the JSectHeader
+            verify(0xffffe000 == (~(Alignment - 1)));
+            unsigned lenUnpadded = b.len() + sizeof(JSectFooter);
+            L = (lenUnpadded + Alignment - 1) & (~(Alignment - 1));
+            dassert(L >= lenUnpadded);
+
+            h->setSectionLen(lenUnpadded);
+            memcpy(b.atOfs(0), h, sizeof(JSectHeader));
+
+            JSectFooter f(b.buf(), b.len());  // computes checksum
+            b.appendStruct(f);
+            dassert(b.len() == lenUnpadded);
+
+            b.skip(L - lenUnpadded);
+            dassert(b.len() % Alignment == 0);
+        }
+
+        stats.curr()->_uncompressedBytes += uncompressedLen;
         unsigned w = b.len();
         _written += w;
         verify(w <= L);
         stats.curr()->_journaledBytes += L;
         _curLogFile->synchronousAppend((const void*)b.buf(), L);
-        _rotate(h.seqNumber);
+        _rotate(h->seqNumber);
     } catch (std::exception& e) {
         log() << "error exception in dur::journal " << e.what() << endl;
         throw;
@@ -82,9 +82,19 @@ unsigned long long journalReadLSN();
 bool haveJournalFiles(bool anyFiles = false);
 
 /**
- * Writes the specified uncompressed buffer to the journal.
+ * Compresses the specified uncompressed buffer into a journal section, which WRITETOJOURNAL
+ * then completes and writes. This does not touch the journal files, so it can run while the
+ * previous section is still being written.
  */
-void WRITETOJOURNAL(const JSectHeader& h, const AlignedBuilder& uncompressed);
+void COMPRESSJOURNALSECTION(const JSectHeader& h,
+                            const AlignedBuilder& uncompressed,
+                            AlignedBuilder* compressed);
+
+/**
+ * Writes a section produced by COMPRESSJOURNALSECTION to the journal. Fills in the fileId of
+ * 'h' for the journal file the section goes to.
+ */
+void WRITETOJOURNAL(JSectHeader* h, unsigned uncompressedLen, AlignedBuilder* compressed);
 
 // in case disk controller buffers writes
 const long long ExtraKeepTimeMs = 10000;
@@ -185,6 +185,10 @@ void JournalWriter::writeBuffer(Buffer* buffer, NotifyAll::When commitNumber) {
 
     buffer->_commitNumber = commitNumber;
 
+    if (!buffer->_isNoop && !buffer->_isShutdown) {
+        COMPRESSJOURNALSECTION(buffer->_header, buffer->_builder, &buffer->_compressed);
+    }
+
     _journalQueue.push(buffer);
 }
 
@@ -234,7 +238,7 @@ void JournalWriter::_journalWriterThread() {
                    << ", size " << buffer->_builder.len() << " bytes)";
 
             // This performs synchronous I/O to the journal file and will block.
-            WRITETOJOURNAL(buffer->_header, buffer->_builder);
+            WRITETOJOURNAL(&buffer->_header, buffer->_builder.len(), &buffer->_compressed);
 
             // Data is now persisted in the journal, which is sufficient for acknowledging
             // durability.
@@ -278,7 +282,12 @@ void JournalWriter::_journalWriterThread() {
 //
 
 JournalWriter::Buffer::Buffer(size_t initialSize)
-    : _commitNumber(0), _isNoop(false), _isShutdown(false), _header(), _builder(initialSize) {}
+    : _commitNumber(0),
+      _isNoop(false),
+      _isShutdown(false),
+      _header(),
+      _builder(initialSize),
+      _compressed(initialSize) {}
 
 JournalWriter::Buffer::~Buffer() {
     _assertEmpty();
@@ -287,12 +296,14 @@ JournalWriter::Buffer::~Buffer() {
 void JournalWriter::Buffer::_assertEmpty() {
     invariant(_commitNumber == 0);
     invariant(_builder.len() == 0);
+    invariant(_compressed.len() == 0);
 }
 
 void JournalWriter::Buffer::_reset() {
     _commitNumber = 0;
     _isNoop = false;
     _builder.reset();
+    _compressed.reset();
 }
 
 }  // namespace dur
@@ -97,6 +97,10 @@ public:
 
         JSectHeader _header;
         AlignedBuilder _builder;
+
+        // The section compressed from _builder, which is what gets written to the journal. It
+        // grows by doubling as needed, like _builder.
+        AlignedBuilder _compressed;
     };
 
 
@@ -145,7 +149,8 @@ public:
     Buffer* newBuffer();
 
     /**
-     * Requests that the specified buffer be written asynchronously.
+     * Requests that the specified buffer be written asynchronously. The buffer is compressed on
+     * the calling thread first, so this overlaps with the write of the previous buffer.
      *
      * This method may block if there are too many outstanding unwritten buffers.
      *
@@ -166,7 +171,9 @@ private:
 
     typedef BlockingQueue<Buffer*> BufferQueue;
 
-    // Start all buffers with 4MB of size
+    // Start all buffers with 4MB of size. Each buffer holds an uncompressed and a compressed
+    // builder, which start at this size and grow by doubling with the commits they hold, so
+    // every buffer takes at least 8MB.
     enum { InitialBufferSizeBytes = 4 * 1024 * 1024 };
 
 
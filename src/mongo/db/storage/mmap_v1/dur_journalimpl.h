@@ -58,9 +58,15 @@ public:
      */
     void rotate();
 
-    /** append to the journal file
+    /** compress a section for journal(). does not need the journal file.
     */
-    void journal(const JSectHeader& h, const AlignedBuilder& b);
+    static void compress(const JSectHeader& h,
+                         const AlignedBuilder& uncompressed,
+                         AlignedBuilder* compressed);
+
+    /** append a compressed section to the journal file
+    */
+    void journal(JSectHeader* h, unsigned uncompressedLen, AlignedBuilder* compressed);
 
     boost::filesystem::path getFilePathFor(int filenumber) const;
 
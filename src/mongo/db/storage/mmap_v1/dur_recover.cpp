@@ -37,9 +37,11 @@
 #include <fcntl.h>
 #include <iomanip>
 #include <iostream>
+#include <map>
 #include <sys/stat.h>
 
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/mmap_v1/compress.h"
 #include "mongo/db/storage/mmap_v1/dur_commitjob.h"
 #include "mongo/db/storage/mmap_v1/dur_journal.h"
@@ -51,10 +53,12 @@
 #include "mongo/platform/strnlen.h"
 #include "mongo/util/bufreader.h"
 #include "mongo/util/checksum.h"
+#include "mongo/util/concurrency/old_thread_pool.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/hex.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/startup_test.h"
 
 namespace mongo {
@@ -84,6 +88,64 @@ namespace dur {
 // The singleton recovery job object
 RecoveryJob& RecoveryJob::_instance = *(new RecoveryJob());
 
+int RecoveryJob::recoveryThreadCount = 4;
+
+namespace {
+
+class ExportedRecoveryThreadCountParameter
+    : public ExportedServerParameter<int, ServerParameterType::kStartupOnly> {
+public:
+    ExportedRecoveryThreadCountParameter()
+        : ExportedServerParameter<int, ServerParameterType::kStartupOnly>(
+              ServerParameterSet::getGlobal(),
+              "journalRecoveryThreadCount",
+              &RecoveryJob::recoveryThreadCount) {}
+
+    virtual Status validate(const int& potentialNewValue) {
+        if (potentialNewValue < 1 || potentialNewValue > 256) {
+            return Status(ErrorCodes::BadValue,
+                          "journalRecoveryThreadCount must be between 1 and 256");
+        }
+
+        return Status::OK();
+    }
+
+} exportedRecoveryThreadCountParam;
+
+// Upper bounds on the journal sections gathered for checking and uncompressing in parallel
+// before they are applied.
+const size_t kMaxPrefetchSectionsPerThread = 2;
+const size_t kMaxPrefetchBytes = 64 * 1024 * 1024;
+
+/** A basic write whose target file has already been resolved, ready to be copied. */
+struct ResolvedWrite {
+    char* dest;  // NULL if the write lies past the end of the file
+    const char* src;
+    unsigned len;
+};
+
+/**
+ * Copies 'writes' into the mapped data files in order. All the target pages are advised first
+ * so that reading them in overlaps with the copying.
+ */
+void applyResolvedWrites(const std::vector<ResolvedWrite>* writes,
+                         unsigned long long* bytesWritten) {
+    for (auto&& write : *writes) {
+        if (write.dest) {
+            adviseWillNeed(write.dest, write.len);
+        }
+    }
+
+    for (auto&& write : *writes) {
+        if (write.dest) {
+            memcpy(write.dest, write.src, write.len);
+            *bytesWritten += write.len;
+        }
+    }
+}
+
+}  // namespace
+
 
 void removeJournalFiles();
 boost::filesystem::path getJournalDir();
@@ -161,6 +223,13 @@ public:
         _entries = unique_ptr<BufReader>(new BufReader(p, _uncompressed.size()));
     }
 
+    // Recovering from a section that was already checked and uncompressed on a worker thread
+    JournalSectionIterator(const JSectHeader& h, std::string uncompressed)
+        : _h(h), _lastDbName(0), _doDurOps(true), _uncompressed(std::move(uncompressed)) {
+        _entries =
+            unique_ptr<BufReader>(new BufReader(_uncompressed.c_str(), _uncompressed.size()));
+    }
+
     // We work with the uncompressed buffer when doing a WRITETODATAFILES (for speed)
     JournalSectionIterator(const JSectHeader& h, const void* p, unsigned len)
         : _entries(new BufReader((const char*)p, len)), _h(h), _lastDbName(0), _doDurOps(false) {}
@@ -256,7 +325,8 @@ RecoveryJob::RecoveryJob()
     : _recovering(false),
       _lastDataSyncedFromLastRun(0),
       _lastSeqSkipped(0),
-      _appliedAnySections(false) {}
+      _appliedAnySections(false),
+      _workerPool(NULL) {}
 
 RecoveryJob::~RecoveryJob() {
     DESTRUCTOR_GUARD(if (!_mmfs.empty()) {} close();)
@@ -369,8 +439,24 @@ void RecoveryJob::applyEntries(const vector<ParsedJournalEntry>& entries) {
     }
 
     Last last;
-    for (vector<ParsedJournalEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i) {
-        applyEntry(last, *i, apply, dump);
+    if (_workerPool && apply && !dump) {
+        // Runs of basic writes are copied on the worker threads. DurOps act as barriers and are
+        // replayed here once every write before them is done.
+        const ParsedJournalEntry* const end = entries.data() + entries.size();
+        const ParsedJournalEntry* runStart = entries.data();
+        for (const ParsedJournalEntry* i = runStart; i != end; ++i) {
+            if (!i->e) {
+                applyWritesInParallel(last, runStart, i);
+                applyEntry(last, *i, apply, dump);
+                runStart = i + 1;
+            }
+        }
+        applyWritesInParallel(last, runStart, end);
+    } else {
+        for (vector<ParsedJournalEntry>::const_iterator i = entries.begin(); i != entries.end();
+             ++i) {
+            applyEntry(last, *i, apply, dump);
+        }
     }
 
     if (dump) {
@@ -378,17 +464,88 @@ void RecoveryJob::applyEntries(const vector<ParsedJournalEntry>& entries) {
     }
 }
 
+void RecoveryJob::applyWritesInParallel(Last& last,
+                                        const ParsedJournalEntry* begin,
+                                        const ParsedJournalEntry* end) {
+    if (begin == end) {
+        return;
+    }
+
+    // Target files are resolved on this thread, as finding or opening them needs the files lock.
+    // Each file is assigned to one worker, so writes to a file are still applied in journal order.
+    std::vector<std::vector<ResolvedWrite>> writerVectors(recoveryThreadCount);
+    std::map<DurableMappedFile*, size_t> writerForFile;
+    for (const ParsedJournalEntry* i = begin; i != end; ++i) {
+        verify(i->e);
+        verify(i->dbName);
+
+        DurableMappedFile* mmf = last.newEntry(*i, *this);
+        auto writer = writerForFile.find(mmf);
+        if (writer == writerForFile.end()) {
+            const size_t nextWriter = writerForFile.size() % writerVectors.size();
+            writer = writerForFile.insert(std::make_pair(mmf, nextWriter)).first;
+        }
+
+        ResolvedWrite write = {NULL, i->e->srcData(), i->e->len};
+        if ((i->e->ofs + i->e->len) <= mmf->length()) {
+            verify(mmf->view_write());
+            verify(i->e->srcData());
+            write.dest = (char*)mmf->view_write() + i->e->ofs;
+        }
+        writerVectors[writer->second].push_back(write);
+    }
+
+    std::vector<unsigned long long> bytesWritten(writerVectors.size(), 0);
+    if (writerForFile.size() == 1) {
+        applyResolvedWrites(&writerVectors[writerForFile.begin()->second], &bytesWritten[0]);
+    } else {
+        for (size_t i = 0; i < writerVectors.size(); ++i) {
+            if (!writerVectors[i].empty()) {
+                _workerPool->schedule(&applyResolvedWrites, &writerVectors[i], &bytesWritten[i]);
+            }
+        }
+        _workerPool->join();
+    }
+
+    for (unsigned long long bytes : bytesWritten) {
+        stats.curr()->_writeToDataFilesBytes += bytes;
+    }
+}
+
+void RecoveryJob::prefetchSection(PrefetchedSection* section) const {
+    section->checksumOk = section->f->checkHash(section->h, section->len + sizeof(JSectHeader));
+
+    // Sections that _processSection() will skip are not worth uncompressing.
+    if (!section->checksumOk ||
+        _lastDataSyncedFromLastRun > section->h->seqNumber + ExtraKeepTimeMs) {
+        return;
+    }
+
+    section->uncompressed =
+        uncompress(section->data, section->len, &section->uncompressedData);
+}
+
 void RecoveryJob::processSection(const JSectHeader* h,
                                  const void* p,
                                  unsigned len,
                                  const JSectFooter* f) {
+    _processSection(h, p, len, f, NULL);
+}
+
+void RecoveryJob::_processSection(const JSectHeader* h,
+                                  const void* p,
+                                  unsigned len,
+                                  const JSectFooter* f,
+                                  PrefetchedSection* prefetched) {
     LockMongoFilesShared lkFiles;  // for RecoveryJob::Last
     stdx::lock_guard<stdx::mutex> lk(_mx);
 
     if (_recovering) {
         // Check the footer checksum before doing anything else.
         verify(((const char*)h) + sizeof(JSectHeader) == p);
-        if (!f->checkHash(h, len + sizeof(JSectHeader))) {
+        const bool checksumOk =
+            prefetched ? prefetched->checksumOk : f->checkHash(h, len + sizeof(JSectHeader));
+        if (!checksumOk) {
             log() << "journal section checksum doesn't match";
             throw JournalSectionCorruptException();
         }
@@ -428,7 +585,11 @@ void RecoveryJob::processSection(const JSectHeader* h,
     }
 
     unique_ptr<JournalSectionIterator> i;
-    if (_recovering) {
+    if (_recovering && prefetched && prefetched->uncompressed) {
+        i = unique_ptr<JournalSectionIterator>(
+            new JournalSectionIterator(*h, std::move(prefetched->uncompressedData)));
+    } else if (_recovering) {
+        // If uncompressing failed on the worker thread, this fails again and reports it.
         i = unique_ptr<JournalSectionIterator>(new JournalSectionIterator(*h, p, len, _recovering));
     } else {
         i = unique_ptr<JournalSectionIterator>(
@@ -464,6 +625,30 @@ void RecoveryJob::processSection(const JSectHeader* h,
     @return true if this is detected to be the last file (ends abruptly)
 */
 bool RecoveryJob::processFileBuffer(const void* p, unsigned len) {
+    // With worker threads, sections are gathered into batches that are checked and uncompressed
+    // in parallel, then applied in order.
+    std::vector<PrefetchedSection> batch;
+    size_t batchBytes = 0;
+    const auto applyBatch = [&] {
+        if (batch.empty()) {
+            return;
+        }
+
+        for (auto&& section : batch) {
+            _workerPool->schedule(&RecoveryJob::prefetchSection, this, &section);
+        }
+        _workerPool->join();
+
+        for (auto&& section : batch) {
+            _processSection(section.h, section.data, section.len, section.f, &section);
+
+            // ctrl c check
+            uassert(ErrorCodes::Interrupted, "interrupted during journal recovery", !inShutdown());
+        }
+        batch.clear();
+        batchBytes = 0;
+    };
+
     try {
         unsigned long long fileId;
         BufReader br(p, len);
@@ -506,6 +691,7 @@ bool RecoveryJob::processFileBuffer(const void* p, unsigned len) {
                           << " got:" << h.fileId << endl;
                     log() << "  sect len:" << h.sectionLen() << " seqnum:" << h.seqNumber << endl;
                 }
+                applyBatch();
                 return true;
             }
             unsigned slen = h.sectionLen();
@@ -513,12 +699,30 @@ bool RecoveryJob::processFileBuffer(const void* p, unsigned len) {
             const char* hdr = (const char*)br.skip(h.sectionLenWithPadding());
             const char* data = hdr + sizeof(JSectHeader);
             const char* footer = data + dataLen;
+
+            if (_workerPool) {
+                batch.emplace_back(
+                    (const JSectHeader*)hdr, data, dataLen, (const JSectFooter*)footer);
+                batchBytes += dataLen;
+                if (batch.size() >= kMaxPrefetchSectionsPerThread * recoveryThreadCount ||
+                    batchBytes >= kMaxPrefetchBytes) {
+                    applyBatch();
+                }
+                continue;
+            }
+
             processSection((const JSectHeader*)hdr, data, dataLen, (const JSectFooter*)footer);
 
             // ctrl c check
             uassert(ErrorCodes::Interrupted, "interrupted during journal recovery", !inShutdown());
         }
+        applyBatch();
     } catch (const BufReader::eof&) {
+        // The sections gathered before the truncated one are intact and must still be applied.
+        try {
+            applyBatch();
+        } catch (const JournalSectionCorruptException&) {
+        }
         if (mmapv1GlobalOptions.journalOptions & MMAPV1Options::JournalDumpJournal)
             log() << "ABRUPT END" << endl;
         return true;  // abrupt end
@@ -563,6 +767,14 @@ void RecoveryJob::go(vector<boost::filesystem::path>& files) {
     _lastDataSyncedFromLastRun = journalReadLSN();
     log() << "recover lsn: " << _lastDataSyncedFromLastRun << endl;
 
+    std::unique_ptr<OldThreadPool> workerPool;
+    if (recoveryThreadCount > 1) {
+        log() << "recover using " << recoveryThreadCount << " threads";
+        workerPool.reset(new OldThreadPool(recoveryThreadCount, "journal recovery worker "));
+    }
+    _workerPool = workerPool.get();
+    ON_BLOCK_EXIT([this] { _workerPool = NULL; });
+
     for (unsigned i = 0; i != files.size(); ++i) {
         bool abruptEnd = processFile(files[i]);
         if (abruptEnd && i + 1 < files.size()) {
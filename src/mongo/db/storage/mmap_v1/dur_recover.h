@@ -32,6 +32,8 @@
 
 #include <boost/filesystem/operations.hpp>
 #include <list>
+#include <string>
+#include <vector>
 
 #include "mongo/db/storage/mmap_v1/dur_journalformat.h"
 #include "mongo/util/concurrency/mutex.h"
@@ -39,6 +41,7 @@
 namespace mongo {
 
 class DurableMappedFile;
+class OldThreadPool;
 
 namespace dur {
 
@@ -65,7 +68,34 @@ public:
         return _instance;
     }
 
+    /**
+     * Number of threads used to uncompress journal sections and apply their writes during
+     * recovery. 1 replays the journal serially.
+     */
+    static int recoveryThreadCount;
+
 private:
+    /**
+     * A journal section located in a mapped journal file, together with the result of checking
+     * and uncompressing it ahead of time on a worker thread.
+     */
+    struct PrefetchedSection {
+        PrefetchedSection(const JSectHeader* h,
+                          const char* data,
+                          unsigned len,
+                          const JSectFooter* f)
+            : h(h), data(data), len(len), f(f) {}
+
+        const JSectHeader* h;
+        const char* data;
+        unsigned len;
+        const JSectFooter* f;
+
+        bool checksumOk = false;
+        bool uncompressed = false;  // false if the section is to be skipped or failed to uncompress
+        std::string uncompressedData;
+    };
+
     class Last {
     public:
         Last();
@@ -81,6 +111,15 @@ private:
     void write(Last& last, const ParsedJournalEntry& entry);  // actually writes to the file
     void applyEntry(Last& last, const ParsedJournalEntry& entry, bool apply, bool dump);
     void applyEntries(const std::vector<ParsedJournalEntry>& entries);
+    void applyWritesInParallel(Last& last,
+                               const ParsedJournalEntry* begin,
+                               const ParsedJournalEntry* end);
+    void _processSection(const JSectHeader* h,
+                         const void* data,
+                         unsigned len,
+                         const JSectFooter* f,
+                         PrefetchedSection* prefetched);
+    void prefetchSection(PrefetchedSection* section) const;
     bool processFileBuffer(const void*, unsigned len);
     bool processFile(boost::filesystem::path journalfile);
     void _close();  // doesn't lock
@@ -97,6 +136,8 @@ private:
     unsigned long long _lastSeqSkipped;
     bool _appliedAnySections;
 
+    // Worker threads for recovery, or NULL to replay serially. Only set during go().
+    OldThreadPool* _workerPool;
 
     static RecoveryJob& _instance;
 };
@@ -0,0 +1,127 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/mmap_v1/dur_remap_schedule.h"
+
+#include <algorithm>
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace dur {
+
+RemapPrivateViewSchedule::RemapPrivateViewSchedule(unsigned commitsBeforeRemap,
+                                                   uint64_t uncommittedBytesLimit)
+    : _commitsBeforeRemap(commitsBeforeRemap),
+      _uncommittedBytesLimit(uncommittedBytesLimit),
+      _commitCounter(0),
+      _estimatedPrivateMapSize(0),
+      _lastPassCompletedMicros(0),
+      _filesLeftInPass(0) {}
+
+RemapPrivateViewSchedule::Step RemapPrivateViewSchedule::onCommit(uint64_t bytesCommitted,
+                                                                  double systemMemoryPressure,
+                                                                  bool alwaysRemap,
+                                                                  uint64_t nowMicros) {
+    _estimatedPrivateMapSize += bytesCommitted;
+    _commitCounter++;
+
+    Step step;
+
+    // When we remap due to memory pressure, we look at two criteria
+    // 1. If the amount of 4k pages touched exceeds 512 MB,
+    //    a reasonable estimate of memory pressure on Linux.
+    // 2. Check if the amount of free memory on the machine is running low,
+    //    since #1 is underestimates the memory pressure on Windows since
+    //    commits in 64MB chunks.
+    step.force = (_estimatedPrivateMapSize >= _uncommittedBytesLimit) || alwaysRemap;
+    step.remap = step.force || (systemMemoryPressure > 0.0) ||
+        (_commitCounter % _commitsBeforeRemap == 0);
+
+    if (!step.remap) {
+        return step;
+    }
+
+    if (alwaysRemap) {
+        step.fraction = 1;
+        return step;
+    }
+
+    // We want to remap all private views about every 2 seconds. There could be ~1000 views so we
+    // do a little each pass. There will be copy on write faults after remapping, so doing a
+    // little bit at a time will avoid big load spikes when the pages are touched.
+    //
+    // TODO: Instead of the time-based logic above, consider using ProcessInfo and watching for
+    //       getResidentSize to drop, which is more precise.
+    step.fraction = (nowMicros - _lastPassCompletedMicros) / 2000000.0;
+
+    // We don't want to get close to the UncommittedBytesLimit
+    const double remapMemFraction = _estimatedPrivateMapSize / ((double)_uncommittedBytesLimit);
+    step.fraction = std::max(remapMemFraction, step.fraction);
+    step.fraction = std::max(systemMemoryPressure, step.fraction);
+
+    return step;
+}
+
+unsigned RemapPrivateViewSchedule::filesToRemap(const Step& step, unsigned numFiles) {
+    invariant(step.remap);
+
+    if (numFiles == 0) {
+        _filesLeftInPass = 0;
+        return 0;
+    }
+
+    unsigned ntodo = (unsigned)(numFiles * std::min(step.fraction, 1.0));
+    if (ntodo < 1)
+        ntodo = 1;
+
+    if (_filesLeftInPass == 0) {
+        _filesLeftInPass = ntodo;
+    } else if (step.force) {
+        _filesLeftInPass = std::max(_filesLeftInPass, ntodo);
+    }
+
+    // Files may have gone away since the pass started
+    _filesLeftInPass = std::min(_filesLeftInPass, numFiles);
+    return _filesLeftInPass;
+}
+
+void RemapPrivateViewSchedule::onRemapped(unsigned filesDone, uint64_t nowMicros) {
+    invariant(filesDone <= _filesLeftInPass);
+    _filesLeftInPass -= filesDone;
+
+    if (_filesLeftInPass == 0) {
+        _estimatedPrivateMapSize = 0;
+        _lastPassCompletedMicros = nowMicros;
+    }
+}
+
+}  // namespace dur
+}  // namespace mongo
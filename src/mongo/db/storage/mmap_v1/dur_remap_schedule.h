@@ -0,0 +1,107 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace mongo {
+namespace dur {
+
+/**
+ * Decides which group commits remap the private views, and how many files each of those remaps
+ * goes through.
+ *
+ * Remaps happen every commitsBeforeRemap commits, or on every commit under memory pressure. A
+ * commit which remaps keeps the flush lock across its journal I/O, so that no writes reach the
+ * private views before they are replaced, while all other commits release it first.
+ *
+ * The files to remap are covered by passes. The size of a pass is fixed when it starts, from the
+ * time elapsed since the previous pass completed and from the estimated size of the private
+ * views. A remap which runs out of time leaves the rest of the pass to the following remaps,
+ * which happen at the usual cadence, so a pass always completes in a bounded number of commits.
+ * Forced remaps, past the uncommitted bytes limit or with alwaysRemap, may grow the current pass.
+ */
+class RemapPrivateViewSchedule {
+public:
+    struct Step {
+        Step() : remap(false), force(false), fraction(0.0) {}
+
+        // Whether this commit remaps after its journal I/O
+        bool remap;
+
+        // Whether the remap must go through all of its files, however long it takes
+        bool force;
+
+        // Fraction of the files which a pass started or forced by this step covers
+        double fraction;
+    };
+
+    RemapPrivateViewSchedule(unsigned commitsBeforeRemap, uint64_t uncommittedBytesLimit);
+
+    /**
+     * Called for every group commit which has written something, before its journal I/O.
+     */
+    Step onCommit(uint64_t bytesCommitted,
+                  double systemMemoryPressure,
+                  bool alwaysRemap,
+                  uint64_t nowMicros);
+
+    /**
+     * Returns how many of the 'numFiles' files the remap of 'step' should go through. Starts a new
+     * pass unless one is in progress.
+     */
+    unsigned filesToRemap(const Step& step, unsigned numFiles);
+
+    /**
+     * Records that the remap went through 'filesDone' of the files returned by filesToRemap. The
+     * pass completes once all of them are done.
+     */
+    void onRemapped(unsigned filesDone, uint64_t nowMicros);
+
+    bool passInProgress() const {
+        return _filesLeftInPass > 0;
+    }
+
+private:
+    const unsigned _commitsBeforeRemap;
+    const uint64_t _uncommittedBytesLimit;
+
+    uint64_t _commitCounter;
+
+    // Bytes committed since the last pass completed, as an estimate of the private views' size
+    uint64_t _estimatedPrivateMapSize;
+
+    uint64_t _lastPassCompletedMicros;
+
+    // Files the current pass still has to go through, zero if there is no pass in progress
+    unsigned _filesLeftInPass;
+};
+
+}  // namespace dur
+}  // namespace mongo
@@ -0,0 +1,193 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/mmap_v1/dur_remap_schedule.h"
+
+#include <algorithm>
+
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace dur {
+namespace {
+
+const unsigned kCommitsBeforeRemap = 10;
+const uint64_t kUncommittedBytesLimit = 512 * 1024 * 1024;
+const uint64_t kOneSecond = 1000 * 1000;
+
+TEST(RemapPrivateViewScheduleTest, RemapsEveryNthCommit) {
+    RemapPrivateViewSchedule schedule(kCommitsBeforeRemap, kUncommittedBytesLimit);
+
+    uint64_t now = kOneSecond;
+    for (unsigned commit = 1; commit <= 3 * kCommitsBeforeRemap; commit++) {
+        const auto step = schedule.onCommit(1024, 0.0, false, now);
+
+        // Only the commits which remap keep the flush lock across their journal I/O
+        ASSERT_EQUALS(commit % kCommitsBeforeRemap == 0, step.remap);
+        ASSERT_FALSE(step.force);
+
+        if (step.remap) {
+            const unsigned ntodo = schedule.filesToRemap(step, 100);
+            schedule.onRemapped(ntodo, now);
+            ASSERT_FALSE(schedule.passInProgress());
+        }
+
+        now += kOneSecond / 10;
+    }
+}
+
+TEST(RemapPrivateViewScheduleTest, UnfinishedPassKeepsCadence) {
+    RemapPrivateViewSchedule schedule(kCommitsBeforeRemap, kUncommittedBytesLimit);
+
+    // A pass started one second in covers half of the files
+    uint64_t now = kOneSecond;
+    for (unsigned commit = 1; commit < kCommitsBeforeRemap; commit++) {
+        ASSERT_FALSE(schedule.onCommit(1024, 0.0, false, now).remap);
+    }
+
+    auto step = schedule.onCommit(1024, 0.0, false, now);
+    ASSERT(step.remap);
+    ASSERT_EQUALS(50U, schedule.filesToRemap(step, 100));
+
+    // The remap runs out of time after 5 files
+    schedule.onRemapped(5, now);
+    ASSERT(schedule.passInProgress());
+
+    // The following commits release the flush lock for their journal I/O as usual
+    for (unsigned commit = 1; commit < kCommitsBeforeRemap; commit++) {
+        now += kOneSecond;
+        ASSERT_FALSE(schedule.onCommit(1024, 0.0, false, now).remap);
+    }
+
+    // The next remap carries on with the pass, whose size does not grow with the time spent
+    now += kOneSecond;
+    step = schedule.onCommit(1024, 0.0, false, now);
+    ASSERT(step.remap);
+    ASSERT_EQUALS(45U, schedule.filesToRemap(step, 100));
+}
+
+TEST(RemapPrivateViewScheduleTest, PassCompletes) {
+    RemapPrivateViewSchedule schedule(kCommitsBeforeRemap, kUncommittedBytesLimit);
+    const unsigned numFiles = 1000;
+
+    // Time flies between commits, so every new pass would cover all the files. Each remap only
+    // gets through 7 files before running out of time.
+    uint64_t now = 0;
+    unsigned numRemaps = 0;
+    unsigned filesInPass = 0;
+    unsigned filesRemapped = 0;
+    for (unsigned commit = 1; commit <= 1000 * kCommitsBeforeRemap; commit++) {
+        now += 10 * kOneSecond;
+
+        const auto step = schedule.onCommit(1024, 0.0, false, now);
+        ASSERT_FALSE(step.force);
+        if (!step.remap) {
+            continue;
+        }
+
+        const unsigned ntodo = schedule.filesToRemap(step, numFiles);
+        if (numRemaps++ == 0) {
+            filesInPass = ntodo;
+            ASSERT_EQUALS(numFiles, filesInPass);
+        } else {
+            ASSERT_EQUALS(filesInPass - filesRemapped, ntodo);
+        }
+
+        const unsigned ndone = std::min(ntodo, 7U);
+        schedule.onRemapped(ndone, now);
+        filesRemapped += ndone;
+
+        if (!schedule.passInProgress()) {
+            break;
+        }
+    }
+
+    ASSERT_FALSE(schedule.passInProgress());
+    ASSERT_EQUALS(filesInPass, filesRemapped);
+    ASSERT_EQUALS((numFiles + 6) / 7, numRemaps);
+}
+
+TEST(RemapPrivateViewScheduleTest, ForcedPastUncommittedBytesLimit) {
+    RemapPrivateViewSchedule schedule(kCommitsBeforeRemap, kUncommittedBytesLimit);
+
+    // Start a small pass and leave it unfinished
+    uint64_t now = kOneSecond / 10;
+    for (unsigned commit = 1; commit < kCommitsBeforeRemap; commit++) {
+        schedule.onCommit(1024, 0.0, false, now);
+    }
+    auto step = schedule.onCommit(1024, 0.0, false, now);
+    ASSERT(step.remap);
+    ASSERT_EQUALS(5U, schedule.filesToRemap(step, 100));
+    schedule.onRemapped(1, now);
+
+    // Reaching the limit forces a remap of every file on the very next commit
+    step = schedule.onCommit(kUncommittedBytesLimit, 0.0, false, now);
+    ASSERT(step.remap);
+    ASSERT(step.force);
+    ASSERT_EQUALS(100U, schedule.filesToRemap(step, 100));
+    schedule.onRemapped(100, now);
+    ASSERT_FALSE(schedule.passInProgress());
+
+    // Which also resets the estimate of the private views' size
+    ASSERT_FALSE(schedule.onCommit(1024, 0.0, false, now).force);
+}
+
+TEST(RemapPrivateViewScheduleTest, MemoryPressureRemapsEveryCommit) {
+    RemapPrivateViewSchedule schedule(kCommitsBeforeRemap, kUncommittedBytesLimit);
+
+    for (unsigned commit = 1; commit < kCommitsBeforeRemap; commit++) {
+        const auto step = schedule.onCommit(1024, 0.3, false, kOneSecond / 10);
+        ASSERT(step.remap);
+        ASSERT_FALSE(step.force);
+        ASSERT_GREATER_THAN_OR_EQUALS(step.fraction, 0.3);
+    }
+}
+
+TEST(RemapPrivateViewScheduleTest, AlwaysRemap) {
+    RemapPrivateViewSchedule schedule(kCommitsBeforeRemap, kUncommittedBytesLimit);
+
+    const auto step = schedule.onCommit(1024, 0.0, true, kOneSecond);
+    ASSERT(step.remap);
+    ASSERT(step.force);
+    ASSERT_EQUALS(100U, schedule.filesToRemap(step, 100));
+}
+
+TEST(RemapPrivateViewScheduleTest, NoFiles) {
+    RemapPrivateViewSchedule schedule(kCommitsBeforeRemap, kUncommittedBytesLimit);
+
+    const auto step = schedule.onCommit(1024, 0.0, true, kOneSecond);
+    ASSERT_EQUALS(0U, schedule.filesToRemap(step, 0));
+    schedule.onRemapped(0, kOneSecond);
+    ASSERT_FALSE(schedule.passInProgress());
+}
+
+}  // namespace
+}  // namespace dur
+}  // namespace mongo
@@ -66,9 +66,11 @@ struct Stats {
         uint64_t _writeToDataFilesBytes;
 
         uint64_t _prepLogBufferMicros;
+        uint64_t _compressMicros;
         uint64_t _writeToJournalMicros;
         uint64_t _writeToDataFilesMicros;
         uint64_t _remapPrivateViewMicros;
+        uint64_t _remapPrivateViewMaxMicros;  // longest single remap, during which writers wait
         uint64_t _commitsMicros;
         uint64_t _commitsInWriteLockMicros;
     };
@@ -176,5 +176,14 @@ public:
      * Caller takes owernship of CacheHint
      */
     virtual CacheHint* cacheHint(const DiskLoc& extentLoc, const HintType& hint) = 0;
+
+    /**
+     * Tell the system that 'len' bytes starting 'ofs' bytes into the extent at 'extentLoc' are
+     * about to be read, so that it can start bringing them into memory in the background.
+     *
+     * @return false if the start of the range already appeared to be in memory, in which case
+     *      no hint was given.
+     */
+    virtual bool willNeed(const DiskLoc& extentLoc, int ofs, int len) const = 0;
 };
 }
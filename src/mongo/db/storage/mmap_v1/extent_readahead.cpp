@@ -0,0 +1,194 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/mmap_v1/extent_readahead.h"
+
+#include <algorithm>
+
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/mmap_v1/extent.h"
+#include "mongo/db/storage/mmap_v1/extent_manager.h"
+
+namespace mongo {
+
+std::atomic<int> ExtentReadahead::maxWindowMB(32);  // NOLINT
+
+const int ExtentReadahead::kInitialWindowBytes;
+const int ExtentReadahead::kMaxInMemoryWindows;
+
+namespace {
+
+class MaxWindowMBParameter
+    : public ExportedServerParameter<int, ServerParameterType::kStartupAndRuntime> {
+public:
+    MaxWindowMBParameter()
+        : ExportedServerParameter<int, ServerParameterType::kStartupAndRuntime>(
+              ServerParameterSet::getGlobal(),
+              "mmapv1ScanReadaheadMB",
+              &ExtentReadahead::maxWindowMB) {}
+
+    virtual Status validate(const int& potentialNewValue) {
+        if (potentialNewValue < 0 || potentialNewValue > 1024) {
+            return Status(ErrorCodes::BadValue, "mmapv1ScanReadaheadMB must be between 0 and 1024");
+        }
+
+        return Status::OK();
+    }
+
+} maxWindowMBParameter;
+
+// How much of the data at the scan position to check for being in memory
+const int kProbeBytes = 4096;
+
+}  // namespace
+
+ExtentReadahead::ExtentReadahead(const ExtentManager* em) : _em(em) {}
+
+void ExtentReadahead::advanceTo(const DiskLoc& loc) {
+    const int maxWindowBytes = maxWindowMB.load() * 1024 * 1024;
+    if (_inMemory || maxWindowBytes <= 0 || loc.isNull()) {
+        return;
+    }
+
+    if (_extents.empty() || !_extents.front().contains(loc)) {
+        _enterExtentOf(loc);
+    }
+
+    const VisitedExtent& extent = _extents.front();
+    _pos = extent.start + (loc.getOfs() - extent.loc.getOfs());
+    if (_aheadAtEnd || _aheadPos - _pos > _windowBytes / 2) {
+        return;
+    }
+
+    _readahead(maxWindowBytes);
+}
+
+void ExtentReadahead::reset() {
+    _extents.clear();
+    _aheadAtEnd = false;
+    _pendingHeaderLoc = DiskLoc();
+}
+
+void ExtentReadahead::_enterExtentOf(const DiskLoc& loc) {
+    // The scan normally moves on to the next extent, which the readahead has already entered.
+    while (!_extents.empty()) {
+        _extents.pop_front();
+        if (!_extents.empty() && _extents.front().contains(loc)) {
+            return;
+        }
+    }
+
+    // Otherwise start over from the extent of the record, with nothing read ahead. The scan
+    // reads the header of the extent it is in anyway.
+    const DiskLoc extentLoc = _em->extentLocForV1(loc);
+    const Extent* const e = _em->getExtent(extentLoc);
+    _extents.push_back({extentLoc, e->length, e->xnext, 0});
+
+    _aheadPos = loc.getOfs() - extentLoc.getOfs();
+    _aheadAtEnd = false;
+    _pendingHeaderLoc = DiskLoc();
+}
+
+void ExtentReadahead::_readahead(int maxWindowBytes) {
+    // If the data at the scan position is not in memory yet, the readahead did not get far
+    // enough ahead of the scan to hide the latency of reading it, so read further ahead.
+    const VisitedExtent& extent = _extents.front();
+    const int posInExtent = static_cast<int>(_pos - extent.start);
+    const int probeLen = std::min(kProbeBytes, extent.length - posInExtent);
+    if (_em->willNeed(extent.loc, posInExtent, probeLen)) {
+        _windowBytes = std::min(_windowBytes, maxWindowBytes / 2) * 2;
+    }
+
+    _aheadPos = std::max(_aheadPos, _pos);
+    _windowBytes = std::min(_windowBytes, maxWindowBytes);
+
+    const long long target = _pos + _windowBytes;
+    int numRanges = 0;
+    bool anyNeeded = false;
+    while (_aheadPos < target) {
+        const VisitedExtent& ahead = _extents.back();
+        if (_aheadPos >= ahead.start + ahead.length) {
+            if (ahead.next.isNull()) {
+                _aheadAtEnd = true;
+                break;
+            }
+
+            if (!_enterNextExtentAhead()) {
+                break;
+            }
+
+            continue;
+        }
+
+        const int ofs = static_cast<int>(_aheadPos - ahead.start);
+        const int len = static_cast<int>(std::min(target, ahead.start + ahead.length) - _aheadPos);
+        if (_em->willNeed(ahead.loc, ofs, len)) {
+            anyNeeded = true;
+        }
+        numRanges++;
+
+        _aheadPos += len;
+    }
+
+    // Readahead is only overhead for a scan over data that is already in memory.
+    if (numRanges == 0) {
+        return;
+    } else if (anyNeeded) {
+        _inMemoryWindows = 0;
+    } else if (++_inMemoryWindows >= kMaxInMemoryWindows) {
+        _inMemory = true;
+    }
+}
+
+bool ExtentReadahead::_enterNextExtentAhead() {
+    const VisitedExtent& ahead = _extents.back();
+
+    // Reading the header of an extent which is not in memory would stall the scan, and whatever
+    // locks it holds, until it is. So it is only handed to willNeed() at first, and read once it
+    // is in memory, or at the latest once the scan has got through a quarter of a window.
+    if (ahead.next != _pendingHeaderLoc) {
+        if (_em->willNeed(ahead.next, 0, Extent::HeaderSize())) {
+            _pendingHeaderLoc = ahead.next;
+            _pendingHeaderReadPos = _pos + _windowBytes / 4;
+            return false;
+        }
+    } else if (_pos < _pendingHeaderReadPos && _em->willNeed(ahead.next, 0, Extent::HeaderSize())) {
+        return false;
+    }
+
+    const DiskLoc loc = ahead.next;
+    const long long start = ahead.start + ahead.length;
+    const Extent* const e = _em->getExtent(loc);
+    _extents.push_back({loc, e->length, e->xnext, start});
+    _pendingHeaderLoc = DiskLoc();
+    return true;
+}
+
+}  // namespace mongo
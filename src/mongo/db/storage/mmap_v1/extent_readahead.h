@@ -0,0 +1,149 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/storage/mmap_v1/diskloc.h"
+
+namespace mongo {
+
+class ExtentManager;
+
+/**
+ * Reads ahead of a forward scan over the extents of a record store.
+ *
+ * The scan reports each record it reaches through advanceTo(). Once the scan gets within half
+ * a window of the end of what has been read ahead, the next window is handed to
+ * ExtentManager::willNeed(), following the extent chain as far as needed. The OS then brings
+ * it into memory in the background, while the scan works on the data it already has.
+ *
+ * The readahead only follows the extent chain through extent headers the scan or the readahead
+ * has already read. The header of the next extent is first handed to willNeed() itself, and only
+ * read once it is in memory or the scan has made some progress, so that reading it does not
+ * fault while the caller holds its locks.
+ *
+ * The window starts small and doubles, up to the "mmapv1ScanReadaheadMB" server parameter,
+ * every time the data at the scan position turns out not to be in memory yet, i.e. the scan
+ * would fault on it. Once several windows in a row were in memory already, readahead stops for
+ * the rest of the scan.
+ */
+class ExtentReadahead {
+    MONGO_DISALLOW_COPYING(ExtentReadahead);
+
+public:
+    explicit ExtentReadahead(const ExtentManager* em);
+
+    /**
+     * Reports that the scan has reached the record at 'loc'.
+     */
+    void advanceTo(const DiskLoc& loc);
+
+    /**
+     * Forgets the position of the scan. Must be called whenever the scan may not continue from
+     * the last reported position, or the extents of the record store may have changed.
+     */
+    void reset();
+
+    // Largest window in MB. Readahead is disabled if 0.
+    static std::atomic<int> maxWindowMB;  // NOLINT
+
+    static const int kInitialWindowBytes = 1024 * 1024;
+
+    // How many windows in a row must already be in memory for readahead to stop
+    static const int kMaxInMemoryWindows = 4;
+
+private:
+    /**
+     * An extent whose header was read when the scan or the readahead entered it.
+     */
+    struct VisitedExtent {
+        DiskLoc loc;
+        int length;
+        DiskLoc next;
+
+        // Position of the start of the extent
+        long long start;
+
+        bool contains(const DiskLoc& recordLoc) const {
+            return recordLoc.a() == loc.a() && recordLoc.getOfs() >= loc.getOfs() &&
+                recordLoc.getOfs() < loc.getOfs() + length;
+        }
+    };
+
+    /**
+     * Finds the extent containing 'loc' and makes it the current extent.
+     */
+    void _enterExtentOf(const DiskLoc& loc);
+
+    /**
+     * Hands the data up to a window past the scan position to the extent manager.
+     */
+    void _readahead(int maxWindowBytes);
+
+    /**
+     * Moves the readahead into the extent following the last one it entered. Returns false if
+     * the header of that extent may not be in memory yet, in which case the readahead stops
+     * there until a later call.
+     */
+    bool _enterNextExtentAhead();
+
+    const ExtentManager* const _em;
+
+    // Set when readahead has stopped for the rest of the scan
+    bool _inMemory = false;
+
+    // Positions are in bytes, counted along the extent chain from the start of the extent the
+    // scan was in when it was last reset.
+
+    // The extents from the one the scan is in, at the front, to the one the readahead is in, at
+    // the back. Empty if the scan position is unknown.
+    std::deque<VisitedExtent> _extents;
+
+    // The scan position
+    long long _pos = 0;
+
+    // Everything before this position has been read ahead, unless the scan is already past it
+    long long _aheadPos = 0;
+
+    // Set when the readahead reached the end of the extent chain
+    bool _aheadAtEnd = false;
+
+    // The extent whose header was handed to willNeed(), and the scan position from which it is
+    // read even if it does not appear to be in memory
+    DiskLoc _pendingHeaderLoc;
+    long long _pendingHeaderReadPos = 0;
+
+    int _windowBytes = kInitialWindowBytes;
+    int _inMemoryWindows = 0;
+};
+
+}  // namespace mongo
@@ -0,0 +1,216 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/mmap_v1/extent_readahead.h"
+
+#include "mongo/db/operation_context_noop.h"
+#include "mongo/db/storage/mmap_v1/extent.h"
+#include "mongo/db/storage/mmap_v1/record_store_v1_test_help.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+const int kMB = 1024 * 1024;
+
+class ExtentReadaheadTest : public unittest::Test {
+protected:
+    void setUp() final {
+        _savedMaxWindowMB = ExtentReadahead::maxWindowMB.load();
+        ExtentReadahead::maxWindowMB.store(4);
+
+        // A chain of 1MB extents, each in its own file of the dummy extent manager
+        OperationContextNoop txn;
+        DiskLoc prev;
+        for (int i = 0; i < 16; i++) {
+            const DiskLoc loc = em.allocateExtent(&txn, false, kMB, false);
+            ASSERT_EQUALS(kMB, em.getExtent(loc)->length);
+            if (!prev.isNull()) {
+                em.getExtent(prev)->xnext = loc;
+                em.getExtent(loc)->xprev = prev;
+            }
+            prev = loc;
+        }
+    }
+
+    void tearDown() final {
+        ExtentReadahead::maxWindowMB.store(_savedMaxWindowMB);
+    }
+
+    void setHeadersInMemory() {
+        for (int i = 0; i < 16; i++) {
+            em.inMemoryHeaders.insert(i);
+        }
+    }
+
+    void assertRange(size_t i, int extent, int ofs, int len) {
+        ASSERT_LESS_THAN(i, em.willNeedRanges.size());
+        const DummyExtentManager::WillNeedRange& range = em.willNeedRanges[i];
+        ASSERT_EQUALS(DiskLoc(extent, 0), range.extentLoc);
+        ASSERT_EQUALS(ofs, range.ofs);
+        ASSERT_EQUALS(len, range.len);
+    }
+
+    DummyExtentManager em;
+
+private:
+    int _savedMaxWindowMB;
+};
+
+TEST_F(ExtentReadaheadTest, ReadsAheadAcrossExtents) {
+    setHeadersInMemory();
+
+    ExtentReadahead readahead(&em);
+    readahead.advanceTo(DiskLoc(0, 100));
+
+    // The scan position is not in memory, which doubles the initial window to 2MB. The header of
+    // every extent entered is checked first.
+    ASSERT_EQUALS(6U, em.willNeedRanges.size());
+    assertRange(0, 0, 100, 4096);
+    assertRange(1, 0, 100, kMB - 100);
+    assertRange(2, 1, 0, Extent::HeaderSize());
+    assertRange(3, 1, 0, kMB);
+    assertRange(4, 2, 0, Extent::HeaderSize());
+    assertRange(5, 2, 0, 100);
+}
+
+TEST_F(ExtentReadaheadTest, WaitsForExtentHeaders) {
+    ExtentReadahead readahead(&em);
+    readahead.advanceTo(DiskLoc(0, 100));
+
+    // The header of the next extent is not in memory, so it is not read yet.
+    ASSERT_EQUALS(3U, em.willNeedRanges.size());
+    assertRange(0, 0, 100, 4096);
+    assertRange(1, 0, 100, kMB - 100);
+    assertRange(2, 1, 0, Extent::HeaderSize());
+
+    readahead.advanceTo(DiskLoc(0, 200));
+    ASSERT_EQUALS(5U, em.willNeedRanges.size());
+    assertRange(4, 1, 0, Extent::HeaderSize());
+
+    // A quarter of the 2MB window later, it is read anyway.
+    readahead.advanceTo(DiskLoc(0, 100 + kMB / 2));
+    ASSERT_EQUALS(8U, em.willNeedRanges.size());
+    assertRange(5, 0, 100 + kMB / 2, 4096);
+    assertRange(6, 1, 0, kMB);
+    assertRange(7, 2, 0, Extent::HeaderSize());
+
+    // Or as soon as it is in memory.
+    em.inMemoryHeaders.insert(2);
+    readahead.advanceTo(DiskLoc(0, 200 + kMB / 2));
+    ASSERT_EQUALS(12U, em.willNeedRanges.size());
+    assertRange(9, 2, 0, Extent::HeaderSize());
+    assertRange(10, 2, 0, kMB);
+    assertRange(11, 3, 0, Extent::HeaderSize());
+}
+
+TEST_F(ExtentReadaheadTest, WaitsForHalfAWindow) {
+    setHeadersInMemory();
+
+    ExtentReadahead readahead(&em);
+    readahead.advanceTo(DiskLoc(0, 100));
+    ASSERT_EQUALS(6U, em.willNeedRanges.size());
+
+    readahead.advanceTo(DiskLoc(0, 200));
+    readahead.advanceTo(DiskLoc(0, kMB - 100));
+    ASSERT_EQUALS(6U, em.willNeedRanges.size());
+
+    // Half of the 2MB window is left, so the next one is read ahead, in a window doubled again.
+    readahead.advanceTo(DiskLoc(1, 100));
+    ASSERT_EQUALS(14U, em.willNeedRanges.size());
+    assertRange(6, 1, 100, 4096);
+    assertRange(7, 2, 100, kMB - 100);
+    assertRange(9, 3, 0, kMB);
+    assertRange(11, 4, 0, kMB);
+    assertRange(13, 5, 0, 100);
+}
+
+TEST_F(ExtentReadaheadTest, WindowIsLimited) {
+    ExtentReadahead::maxWindowMB.store(1);
+
+    ExtentReadahead readahead(&em);
+    readahead.advanceTo(DiskLoc(0, 0));
+    ASSERT_EQUALS(2U, em.willNeedRanges.size());
+    assertRange(1, 0, 0, kMB);
+}
+
+TEST_F(ExtentReadaheadTest, DisabledWithZeroWindow) {
+    ExtentReadahead::maxWindowMB.store(0);
+
+    ExtentReadahead readahead(&em);
+    for (int i = 0; i < 16; i++) {
+        readahead.advanceTo(DiskLoc(i, 0));
+    }
+    ASSERT_EQUALS(0U, em.willNeedRanges.size());
+}
+
+TEST_F(ExtentReadaheadTest, StopsWhenDataIsInMemory) {
+    for (int i = 0; i < 16; i++) {
+        em.inMemoryExtents.insert(i);
+    }
+
+    ExtentReadahead readahead(&em);
+    for (int i = 0; i < 16; i++) {
+        readahead.advanceTo(DiskLoc(i, 0));
+    }
+
+    // The window stays at 1MB, so each extent the scan reaches is read ahead as one window.
+    // Nothing is read ahead after kMaxInMemoryWindows of them were all in memory.
+    const size_t numRanges = em.willNeedRanges.size();
+    ASSERT_EQUALS(DiskLoc(ExtentReadahead::kMaxInMemoryWindows - 1, 0),
+                  em.willNeedRanges.back().extentLoc);
+
+    // Not even once the scan starts over.
+    readahead.reset();
+    readahead.advanceTo(DiskLoc(0, 0));
+    ASSERT_EQUALS(numRanges, em.willNeedRanges.size());
+}
+
+TEST_F(ExtentReadaheadTest, ResetStartsOver) {
+    setHeadersInMemory();
+
+    ExtentReadahead readahead(&em);
+    readahead.advanceTo(DiskLoc(0, 100));
+    ASSERT_EQUALS(6U, em.willNeedRanges.size());
+
+    // The window keeps growing from where it was.
+    readahead.reset();
+    readahead.advanceTo(DiskLoc(10, 100));
+    ASSERT_EQUALS(16U, em.willNeedRanges.size());
+    assertRange(6, 10, 100, 4096);
+    assertRange(7, 10, 100, kMB - 100);
+    assertRange(9, 11, 0, kMB);
+    assertRange(11, 12, 0, kMB);
+    assertRange(13, 13, 0, kMB);
+    assertRange(15, 14, 0, 100);
+}
+
+}  // namespace
+}  // namespace mongo
@@ -59,6 +59,13 @@ private:
     unsigned _len;
 };
 
+/**
+ * Hints that the pages covering [p, p + len) will be accessed soon, so that the OS can start
+ * reading them in. Unlike MAdvise this is a one-off hint with nothing to undo. A no-op where the
+ * OS has no such hint.
+ */
+void adviseWillNeed(void* p, size_t len);
+
 // lock order: lock dbMutex before this if you lock both
 class LockMongoFilesShared {
     friend class LockMongoFilesExclusive;
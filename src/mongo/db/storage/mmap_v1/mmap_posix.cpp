@@ -125,6 +125,7 @@ public:
 #if defined(__sun)
 MAdvise::MAdvise(void*, unsigned, Advice) {}
 MAdvise::~MAdvise() {}
+void adviseWillNeed(void*, size_t) {}
 #else
 MAdvise::MAdvise(void* p, unsigned len, Advice a) {
     _p = _pageAlign(p);
@@ -148,6 +149,14 @@ MAdvise::MAdvise(void* p, unsigned len, Advice a) {
 MAdvise::~MAdvise() {
     madvise(_p, _len, MADV_NORMAL);
 }
+
+void adviseWillNeed(void* p, size_t len) {
+    void* start = _pageAlign(p);
+    len += reinterpret_cast<size_t>(p) - reinterpret_cast<size_t>(start);
+
+    // Only a hint, so a failure is not worth reporting.
+    madvise(start, len, MADV_WILLNEED);
+}
 #endif
 
 void* MemoryMappedFile::map(const char* filename, unsigned long long& length, int options) {
@@ -52,6 +52,7 @@
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/file.h"
 #include "mongo/util/log.h"
+#include "mongo/util/processinfo.h"
 
 namespace mongo {
 
@@ -632,6 +633,16 @@ ExtentManager::CacheHint* MmapV1ExtentManager::cacheHint(const DiskLoc& extentLo
     return new CacheHintMadvise(reinterpret_cast<void*>(e), e->length, MAdvise::Sequential);
 }
 
+bool MmapV1ExtentManager::willNeed(const DiskLoc& extentLoc, int ofs, int len) const {
+    char* const p = _getOpenFile(extentLoc.a())->p() + extentLoc.getOfs() + ofs;
+    if (ProcessInfo::blockCheckSupported() && ProcessInfo::blockInMemory(p)) {
+        return false;
+    }
+
+    adviseWillNeed(p, len);
+    return true;
+}
+
 MmapV1ExtentManager::FilesArray::~FilesArray() {
     for (int i = 0; i < size(); i++) {
         delete _files[i];
@@ -152,6 +152,8 @@ public:
 
     virtual CacheHint* cacheHint(const DiskLoc& extentLoc, const HintType& hint);
 
+    virtual bool willNeed(const DiskLoc& extentLoc, int ofs, int len) const;
+
 private:
     /**
      * will return NULL if nothing suitable in free list
@@ -34,6 +34,8 @@
 
 #include "mongo/db/storage/mmap_v1/record_store_v1_simple.h"
 
+#include <map>
+
 #include "mongo/base/counter.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/client.h"
@@ -107,7 +109,15 @@ DiskLoc SimpleRecordStoreV1::_allocFromExistingExtents(OperationContext* txn, in
         for (myBucket = bucket(lenToAlloc); myBucket < Buckets; myBucket++) {
             // Only look at the first entry in each bucket. This works because we are either
             // quantizing or allocating fixed-size blocks.
-            const DiskLoc head = _details->deletedListEntry(myBucket);
+            DiskLoc head = _details->deletedListEntry(myBucket);
+            while (!head.isNull() && _isInCompactingExtent(head)) {
+                // compactOnline() has not yet reached this one in its walk of the deleted lists.
+                // Nothing may be allocated in the extent it is emptying, so take it off now.
+                if (head == _walkPrev)
+                    _restartDeletedListsWalk();
+                head = drec(head)->nextDeleted();
+                _details->setDeletedListEntry(txn, myBucket, head);
+            }
             if (head.isNull())
                 continue;
             DeletedRecord* const candidate = drec(head);
@@ -122,6 +132,8 @@ DiskLoc SimpleRecordStoreV1::_allocFromExistingExtents(OperationContext* txn, in
             return DiskLoc();  // no space
 
         // Unlink ourself from the deleted list
+        if (loc == _walkPrev)
+            _restartDeletedListsWalk();
         _details->setDeletedListEntry(txn, myBucket, dr->nextDeleted());
         *txn->recoveryUnit()->writing(&dr->nextDeleted()) = DiskLoc().setInvalid();  // defensive
     }
@@ -193,6 +205,10 @@ StatusWith<DiskLoc> SimpleRecordStoreV1::allocRecord(OperationContext* txn,
 }
 
 Status SimpleRecordStoreV1::truncate(OperationContext* txn) {
+    // Any online compaction in progress is moot once all the extents are gone.
+    _compactingExtent = DiskLoc();
+    _resetDeletedListsWalk();
+
     const DiskLoc firstExtLoc = _details->firstExtent(txn);
     if (firstExtLoc.isNull() || !firstExtLoc.isValid()) {
         // Already empty
@@ -228,6 +244,11 @@ Status SimpleRecordStoreV1::truncate(OperationContext* txn) {
 }
 
 void SimpleRecordStoreV1::addDeletedRec(OperationContext* txn, const DiskLoc& dloc) {
+    if (_isInCompactingExtent(dloc)) {
+        // The whole extent is freed once compactOnline() has emptied it.
+        return;
+    }
+
     DeletedRecord* d = drec(dloc);
 
     int b = bucket(d->lengthWithHeaders());
@@ -283,6 +304,34 @@ private:
     size_t _allocationSize;
 };
 
+unsigned SimpleRecordStoreV1::_compactAllocationSize(const MmapV1RecordHeader* rec,
+                                                    unsigned rawDataSize,
+                                                    const CompactOptions* compactOptions) const {
+    // Allocation sizes include the headers and possibly some padding.
+    const unsigned minAllocationSize = rawDataSize + MmapV1RecordHeader::HeaderSize;
+    unsigned allocationSize = minAllocationSize;
+    switch (compactOptions->paddingMode) {
+        case CompactOptions::NONE:  // default padding
+            if (shouldPadInserts()) {
+                allocationSize = quantizeAllocationSpace(minAllocationSize);
+            }
+            break;
+
+        case CompactOptions::PRESERVE:  // keep original padding
+            allocationSize = rec->lengthWithHeaders();
+            break;
+
+        case CompactOptions::MANUAL:  // user specified how much padding to use
+            allocationSize = compactOptions->computeRecordSize(minAllocationSize);
+            if (allocationSize < minAllocationSize || allocationSize > BSONObjMaxUserSize / 2) {
+                allocationSize = minAllocationSize;
+            }
+            break;
+    }
+    invariant(allocationSize >= minAllocationSize);
+    return allocationSize;
+}
+
 void SimpleRecordStoreV1::_compactExtent(OperationContext* txn,
                                          const DiskLoc extentLoc,
                                          int extentNumber,
@@ -340,29 +389,8 @@ void SimpleRecordStoreV1::_compactExtent(OperationContext* txn,
                 oldObjSize += rawDataSize;
                 oldObjSizeWithPadding += recOld->netLength();
 
-                // Allocation sizes include the headers and possibly some padding.
-                const unsigned minAllocationSize = rawDataSize + MmapV1RecordHeader::HeaderSize;
-                unsigned allocationSize = minAllocationSize;
-                switch (compactOptions->paddingMode) {
-                    case CompactOptions::NONE:  // default padding
-                        if (shouldPadInserts()) {
-                            allocationSize = quantizeAllocationSpace(minAllocationSize);
-                        }
-                        break;
-
-                    case CompactOptions::PRESERVE:  // keep original padding
-                        allocationSize = recOld->lengthWithHeaders();
-                        break;
-
-                    case CompactOptions::MANUAL:  // user specified how much padding to use
-                        allocationSize = compactOptions->computeRecordSize(minAllocationSize);
-                        if (allocationSize < minAllocationSize ||
-                            allocationSize > BSONObjMaxUserSize / 2) {
-                            allocationSize = minAllocationSize;
-                        }
-                        break;
-                }
-                invariant(allocationSize >= minAllocationSize);
+                const unsigned allocationSize =
+                    _compactAllocationSize(recOld, rawDataSize, compactOptions);
 
                 // Copy the data to a new record. Because we orphaned the record freelist at the
                 // start of the compact, this insert will allocate a record in a new extent.
@@ -480,4 +508,218 @@ Status SimpleRecordStoreV1::compact(OperationContext* txn,
 
     return Status::OK();
 }
+
+bool SimpleRecordStoreV1::_isInCompactingExtent(const DiskLoc& loc) const {
+    if (_compactingExtent.isNull())
+        return false;
+
+    // Records and deleted records both start with their length and extent offset.
+    return loc.a() == _compactingExtent.a() &&
+        drec(loc)->extentOfs() == _compactingExtent.getOfs();
+}
+
+/**
+ * Restarts the walk of the deleted lists from the first bucket if the WriteUnitOfWork which took
+ * deleted records off the lists is rolled back, as they are back on lists already walked.
+ */
+class SimpleRecordStoreV1::RestartDeletedListsWalk : public RecoveryUnit::Change {
+public:
+    explicit RestartDeletedListsWalk(SimpleRecordStoreV1* rs) : _rs(rs) {}
+
+    virtual void commit() {}
+    virtual void rollback() {
+        _rs->_walkBucket = 0;
+        _rs->_walkPrev = DiskLoc();
+    }
+
+private:
+    SimpleRecordStoreV1* const _rs;
+};
+
+void SimpleRecordStoreV1::_restartDeletedListsWalk() {
+    _walkPrev = DiskLoc();
+    _walkBucketFreeBytes.clear();
+}
+
+void SimpleRecordStoreV1::_resetDeletedListsWalk() {
+    _walkBucket = 0;
+    _walkPrev = DiskLoc();
+    _walkFreeBytes.clear();
+    _walkBucketFreeBytes.clear();
+}
+
+bool SimpleRecordStoreV1::_walkDeletedLists(OperationContext* txn, int* budget) {
+    // The header of every deleted record lives in the data files next to the records, so each
+    // entry walked may page in data from anywhere in the collection. This is why the walk is
+    // bounded per step. Space still in the legacy grab bag is not counted, as inserts drain it.
+    const bool unlinking = !_compactingExtent.isNull();
+    if (unlinking)
+        txn->recoveryUnit()->registerChange(new RestartDeletedListsWalk(this));
+
+    while (_walkBucket < Buckets) {
+        const DiskLoc loc = _walkPrev.isNull() ? _details->deletedListEntry(_walkBucket)
+                                               : drec(_walkPrev)->nextDeleted();
+        if (loc.isNull()) {
+            for (const auto& extentFreeBytes : _walkBucketFreeBytes)
+                _walkFreeBytes[extentFreeBytes.first] += extentFreeBytes.second;
+            _walkBucketFreeBytes.clear();
+            _walkBucket++;
+            _walkPrev = DiskLoc();
+            continue;
+        }
+
+        if (*budget <= 0)
+            return false;
+        (*budget)--;
+
+        const DeletedRecord* const d = drec(loc);
+        if (!unlinking) {
+            _walkBucketFreeBytes[DiskLoc(loc.a(), d->extentOfs())] += d->lengthWithHeaders();
+            _walkPrev = loc;
+        } else if (_isInCompactingExtent(loc)) {
+            if (_walkPrev.isNull())
+                _details->setDeletedListEntry(txn, _walkBucket, d->nextDeleted());
+            else
+                *txn->recoveryUnit()->writing(&drec(_walkPrev)->nextDeleted()) = d->nextDeleted();
+        } else {
+            _walkPrev = loc;
+        }
+    }
+
+    return true;
+}
+
+DiskLoc SimpleRecordStoreV1::_pickExtentToCompactOnline(OperationContext* txn,
+                                                        const CompactOptions* options) {
+    // New records go to the last extent once the others are full, so emptying it would only
+    // make room for another one.
+    const DiskLoc lastExtLoc = _details->lastExtent(txn);
+
+    DiskLoc best;
+    double bestFreeFraction = 0;
+    for (DiskLoc extLoc = _details->firstExtent(txn); !extLoc.isNull() && extLoc != lastExtLoc;
+         extLoc = _getExtent(txn, extLoc)->xnext) {
+        std::map<DiskLoc, long long>::const_iterator it = _walkFreeBytes.find(extLoc);
+        const long long extentFreeBytes = it == _walkFreeBytes.end() ? 0 : it->second;
+        const double freeFraction = double(extentFreeBytes) / _getExtent(txn, extLoc)->length;
+        if (freeFraction >= options->minFreeFraction &&
+            (best.isNull() || freeFraction > bestFreeFraction)) {
+            best = extLoc;
+            bestFreeFraction = freeFraction;
+        }
+    }
+
+    return best;
+}
+
+StatusWith<bool> SimpleRecordStoreV1::compactOnline(OperationContext* txn,
+                                                    RecordStoreCompactAdaptor* adaptor,
+                                                    UpdateNotifier* notifier,
+                                                    const CompactOptions* options,
+                                                    CompactStats* stats) {
+    int walkBudget = options->maxDeletedRecordsPerStep;
+    if (_compactingExtent.isNull()) {
+        // The free space of each extent is only known once all the deleted lists are walked.
+        // Lists change between steps, so this is an estimate, which is all picking needs.
+        if (!_walkDeletedLists(txn, &walkBudget))
+            return StatusWith<bool>(true);
+
+        const DiskLoc extentLoc = _pickExtentToCompactOnline(txn, options);
+        _resetDeletedListsWalk();
+        if (extentLoc.isNull())
+            return StatusWith<bool>(false);
+
+        log() << "compactOnline begin extent " << extentLoc << " for namespace " << _ns;
+
+        // Nothing can be allocated in the extent from here on, so records only ever move out of
+        // it. Its deleted records are taken off the lists by walking them again, and allocations
+        // skip the ones the walk has not reached yet. If we stop before the extent is empty, the
+        // space already taken off the deleted lists is leaked until the collection is compacted
+        // again or dropped, as with an interrupted compact.
+        _compactingExtent = extentLoc;
+    }
+
+    if (_walkBucket < Buckets) {
+        WriteUnitOfWork wunit(txn);
+        const bool walked = _walkDeletedLists(txn, &walkBudget);
+        wunit.commit();
+        if (!walked)
+            return StatusWith<bool>(true);
+    }
+
+    Extent* const sourceExtent = _extentManager->getExtent(_compactingExtent);
+    for (int moved = 0; !sourceExtent->firstRecord.isNull() && moved < options->maxRecordsPerStep;
+         moved++) {
+        txn->checkForInterrupt();
+
+        WriteUnitOfWork wunit(txn);
+        const DiskLoc oldLoc = sourceExtent->firstRecord;
+        const MmapV1RecordHeader* recOld = recordFor(oldLoc);
+        const unsigned rawDataSize = adaptor->dataSize(recOld->toRecordData());
+
+        CompactDocWriter writer(
+            recOld, rawDataSize, _compactAllocationSize(recOld, rawDataSize, options));
+        StatusWith<RecordId> newLocation = insertRecord(txn, &writer, false);
+        if (!newLocation.isOK())
+            return StatusWith<bool>(newLocation.getStatus());
+        const DiskLoc newLoc = DiskLoc::fromRecordId(newLocation.getValue());
+        invariant(!_isInCompactingExtent(newLoc));
+
+        // Same sequence as updateRecord() moving a record: the notifier invalidates cursors on
+        // the old location and unindexes it, then the new location is indexed.
+        Status moveStatus = notifier->recordStoreGoingToMove(
+            txn, oldLoc.toRecordId(), recOld->data(), recOld->netLength());
+        if (!moveStatus.isOK())
+            return StatusWith<bool>(moveStatus);
+        adaptor->inserted(recordFor(newLoc)->toRecordData(), newLocation.getValue());
+
+        deleteRecord(txn, oldLoc.toRecordId());
+        wunit.commit();
+        stats->recordsMoved++;
+    }
+
+    if (!sourceExtent->firstRecord.isNull())
+        return StatusWith<bool>(true);
+
+    // The extent is empty. Unlink it from the extent list and return it to the extent manager.
+    const DiskLoc extentLoc = _compactingExtent;
+    {
+        WriteUnitOfWork wunit(txn);
+        const DiskLoc prevLoc = sourceExtent->xprev;
+        const DiskLoc nextLoc = sourceExtent->xnext;
+        invariant(!nextLoc.isNull());  // the last extent is never compacted online
+
+        if (prevLoc.isNull()) {
+            invariant(_details->firstExtent(txn) == extentLoc);
+            _details->setFirstExtent(txn, nextLoc);
+        } else {
+            *txn->recoveryUnit()->writing(&_extentManager->getExtent(prevLoc)->xnext) = nextLoc;
+        }
+        *txn->recoveryUnit()->writing(&_extentManager->getExtent(nextLoc)->xprev) = prevLoc;
+
+        _extentManager->freeExtent(txn, extentLoc);
+        wunit.commit();
+    }
+    _compactingExtent = DiskLoc();
+    _resetDeletedListsWalk();
+    stats->extentsFreed++;
+
+    log() << "compactOnline freed extent " << extentLoc << " for namespace " << _ns;
+
+    // Other extents may still be sparse enough.
+    return StatusWith<bool>(true);
+}
+
+void SimpleRecordStoreV1::compactOnlineDone(OperationContext* txn) {
+    _resetDeletedListsWalk();
+    if (_compactingExtent.isNull())
+        return;
+
+    // Deleted records the walk had not reached yet are still on the lists and simply become
+    // usable again.
+    log() << "compactOnline stopped before emptying extent " << _compactingExtent
+          << " for namespace " << _ns << "; the free space taken off the deleted lists is not "
+          << "reused until the next compact";
+    _compactingExtent = DiskLoc();
+}
 }
@@ -30,6 +30,8 @@
 
 #pragma once
 
+#include <map>
+
 #include "mongo/db/catalog/collection_options.h"
 #include "mongo/db/storage/mmap_v1/diskloc.h"
 #include "mongo/db/storage/mmap_v1/record_store_v1_base.h"
@@ -75,6 +77,16 @@ public:
                            const CompactOptions* options,
                            CompactStats* stats);
 
+    virtual bool compactOnlineSupported() const {
+        return true;
+    }
+    virtual StatusWith<bool> compactOnline(OperationContext* txn,
+                                           RecordStoreCompactAdaptor* adaptor,
+                                           UpdateNotifier* notifier,
+                                           const CompactOptions* options,
+                                           CompactStats* stats);
+    virtual void compactOnlineDone(OperationContext* txn);
+
 protected:
     virtual bool isCapped() const {
         return false;
@@ -99,8 +111,58 @@ private:
                         const CompactOptions* compactOptions,
                         CompactStats* stats);
 
+    unsigned _compactAllocationSize(const MmapV1RecordHeader* rec,
+                                    unsigned rawDataSize,
+                                    const CompactOptions* compactOptions) const;
+
+    class RestartDeletedListsWalk;
+
+    /**
+     * Returns the extent with the largest fraction of free space according to the walk of the
+     * deleted lists, or a null DiskLoc if none has at least options->minFreeFraction free. The
+     * last extent is never picked.
+     */
+    DiskLoc _pickExtentToCompactOnline(OperationContext* txn, const CompactOptions* options);
+
+    /**
+     * Continues the walk of the deleted lists for compactOnline(), visiting at most '*budget'
+     * entries and taking them off '*budget'. Returns true once every list has been walked.
+     *
+     * While no extent is being compacted, the walk adds up the free space of every extent. Once
+     * one is, the walk takes that extent's deleted records off the lists instead, and must be
+     * called in a WriteUnitOfWork.
+     */
+    bool _walkDeletedLists(OperationContext* txn, int* budget);
+
+    /**
+     * Walks the current bucket again from its head, after '_walkPrev' was taken off its list.
+     */
+    void _restartDeletedListsWalk();
+
+    /**
+     * Starts the next walk of the deleted lists from the first bucket with no free space counted.
+     */
+    void _resetDeletedListsWalk();
+
+    bool _isInCompactingExtent(const DiskLoc& loc) const;
+
     bool _normalCollection;
 
+    // The extent compactOnline() is emptying, or null. Space freed inside it is not put back on
+    // the deleted lists, as the whole extent is returned to the ExtentManager once empty.
+    DiskLoc _compactingExtent;
+
+    // Position of the walk of the deleted lists, which compactOnline() spreads over its steps.
+    // The walk is in bucket '_walkBucket', right after '_walkPrev', or at the head of the list if
+    // '_walkPrev' is null. Entries are only ever taken off the head of a list, so '_walkPrev' stays
+    // on its list unless it is allocated, in which case the bucket is walked again from its head.
+    int _walkBucket = 0;
+    DiskLoc _walkPrev;
+
+    // Free bytes per extent, from the buckets the walk has finished and from '_walkBucket'.
+    std::map<DiskLoc, long long> _walkFreeBytes;
+    std::map<DiskLoc, long long> _walkBucketFreeBytes;
+
     friend class SimpleRecordStoreV1Iterator;
 };
 }
@@ -42,7 +42,10 @@ namespace mongo {
 SimpleRecordStoreV1Iterator::SimpleRecordStoreV1Iterator(OperationContext* txn,
                                                          const SimpleRecordStoreV1* collection,
                                                          bool forward)
-    : _txn(txn), _recordStore(collection), _forward(forward) {
+    : _txn(txn),
+      _recordStore(collection),
+      _forward(forward),
+      _readahead(_recordStore->_extentManager) {
     // Eagerly seek to first Record on creation since it is cheap.
     const ExtentManager* em = _recordStore->_extentManager;
     if (_recordStore->details()->firstExtent(txn).isNull()) {
@@ -86,6 +89,7 @@ boost::optional<Record> SimpleRecordStoreV1Iterator::next() {
 
 boost::optional<Record> SimpleRecordStoreV1Iterator::seekExact(const RecordId& id) {
     _curr = DiskLoc::fromRecordId(id);
+    _readahead.reset();
     advance();
     return {{id, _recordStore->RecordStore::dataFor(_txn, id)}};
 }
@@ -94,6 +98,9 @@ void SimpleRecordStoreV1Iterator::advance() {
     // Move to the next thing.
     if (!isEOF()) {
         if (_forward) {
+            // Report the record being moved past rather than the next one, whose header may
+            // not be in memory yet.
+            _readahead.advanceTo(_curr);
             _curr = _recordStore->getNextRecord(_txn, _curr);
         } else {
             _curr = _recordStore->getPrevRecord(_txn, _curr);
@@ -115,6 +122,9 @@ void SimpleRecordStoreV1Iterator::invalidate(OperationContext* txn, const Record
 void SimpleRecordStoreV1Iterator::save() {}
 
 bool SimpleRecordStoreV1Iterator::restore() {
+    // The extents may have changed while the cursor was saved.
+    _readahead.reset();
+
     // if the collection is dropped, then the cursor should be destroyed
     return true;
 }
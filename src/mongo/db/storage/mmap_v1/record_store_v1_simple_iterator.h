@@ -29,6 +29,7 @@
 #pragma once
 
 #include "mongo/db/storage/mmap_v1/diskloc.h"
+#include "mongo/db/storage/mmap_v1/extent_readahead.h"
 #include "mongo/db/storage/record_store.h"
 
 namespace mongo {
@@ -74,6 +75,9 @@ private:
     DiskLoc _curr;
     const SimpleRecordStoreV1* const _recordStore;
     const bool _forward;
+
+    // Only used by forward scans
+    ExtentReadahead _readahead;
 };
 
 }  // namespace mongo
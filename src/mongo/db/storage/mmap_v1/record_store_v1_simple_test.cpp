@@ -30,6 +30,7 @@
 
 #include "mongo/db/storage/mmap_v1/record_store_v1_simple.h"
 
+#include "mongo/db/catalog/collection.h"
 #include "mongo/db/operation_context_noop.h"
 #include "mongo/db/storage/mmap_v1/extent.h"
 #include "mongo/db/storage/mmap_v1/record.h"
@@ -449,4 +450,211 @@ TEST(SimpleRecordStoreV1, Truncate) {
         assertStateV1RS(&txn, recs, drecs, NULL, &em, md);
     }
 }
+
+// -----------------
+
+class CompactOnlineRecorder : public RecordStoreCompactAdaptor, public UpdateNotifier {
+public:
+    virtual bool isDataValid(const RecordData& recData) {
+        return true;
+    }
+    virtual size_t dataSize(const RecordData& recData) {
+        return recData.size();
+    }
+    virtual void inserted(const RecordData& recData, const RecordId& newLocation) {
+        inserts.push_back(DiskLoc::fromRecordId(newLocation));
+    }
+
+    virtual Status recordStoreGoingToMove(OperationContext* txn,
+                                          const RecordId& oldLocation,
+                                          const char* oldBuffer,
+                                          size_t oldSize) {
+        moves.push_back(DiskLoc::fromRecordId(oldLocation));
+        return Status::OK();
+    }
+    virtual Status recordStoreGoingToUpdateInPlace(OperationContext* txn, const RecordId& loc) {
+        return Status::OK();
+    }
+
+    std::vector<DiskLoc> moves;
+    std::vector<DiskLoc> inserts;
+};
+
+/**
+ * compactOnline() empties the sparsest extent into free space elsewhere and unlinks it.
+ */
+TEST(SimpleRecordStoreV1, CompactOnlineEmptiesSparsestExtent) {
+    OperationContextNoop txn;
+    DummyExtentManager em;
+    DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData(false, 0);
+    SimpleRecordStoreV1 rs(&txn, "test.foo", md, &em, false);
+
+    {
+        LocAndSize recs[] = {{DiskLoc(0, 1000), 100},
+                             {DiskLoc(1, 1000), 100},
+                             {DiskLoc(2, 1000), 100},
+                             {DiskLoc(3, 1000), 100},
+                             {}};
+        LocAndSize drecs[] = {{DiskLoc(0, 1100), 100},
+                              {DiskLoc(2, 1100), 100},
+                              {DiskLoc(1, 1100), 2000},
+                              {DiskLoc(3, 1100), 4000},
+                              {}};
+        initializeV1RS(&txn, recs, drecs, NULL, &em, md);
+    }
+
+    CompactOptions options;
+    options.paddingMode = CompactOptions::PRESERVE;
+    options.minFreeFraction = 0.25;
+    CompactStats stats;
+    CompactOnlineRecorder recorder;
+
+    StatusWith<bool> more = rs.compactOnline(&txn, &recorder, &recorder, &options, &stats);
+    ASSERT_OK(more.getStatus());
+    ASSERT_TRUE(more.getValue());
+
+    more = rs.compactOnline(&txn, &recorder, &recorder, &options, &stats);
+    ASSERT_OK(more.getStatus());
+    ASSERT_FALSE(more.getValue());
+    rs.compactOnlineDone(&txn);
+
+    ASSERT_EQUALS(1, stats.recordsMoved);
+    ASSERT_EQUALS(1, stats.extentsFreed);
+    ASSERT_EQUALS(1U, recorder.moves.size());
+    ASSERT_EQUALS(DiskLoc(1, 1000), recorder.moves[0]);
+    ASSERT_EQUALS(1U, recorder.inserts.size());
+    ASSERT_EQUALS(DiskLoc(0, 1100), recorder.inserts[0]);
+
+    // Extent 1 is no longer part of the record store.
+    ASSERT_EQUALS(DiskLoc(2, 0), em.getExtent(DiskLoc(0, 0))->xnext);
+    ASSERT_EQUALS(DiskLoc(0, 0), em.getExtent(DiskLoc(2, 0))->xprev);
+
+    {
+        LocAndSize recs[] = {{DiskLoc(0, 1000), 100},
+                             {DiskLoc(0, 1100), 100},
+                             {DiskLoc(2, 1000), 100},
+                             {DiskLoc(3, 1000), 100},
+                             {}};
+        LocAndSize drecs[] = {{DiskLoc(2, 1100), 100}, {DiskLoc(3, 1100), 4000}, {}};
+        assertStateV1RS(&txn, recs, drecs, NULL, &em, md);
+    }
+}
+
+/**
+ * compactOnline() walks at most maxDeletedRecordsPerStep deleted records per call, and nothing is
+ * allocated in the extent it picked while its deleted records are still being taken off the lists.
+ */
+TEST(SimpleRecordStoreV1, CompactOnlineWalksDeletedListsInSteps) {
+    OperationContextNoop txn;
+    DummyExtentManager em;
+    DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData(false, 0);
+    SimpleRecordStoreV1 rs(&txn, "test.foo", md, &em, false);
+
+    {
+        LocAndSize recs[] = {{DiskLoc(0, 1000), 100},
+                             {DiskLoc(1, 1000), 100},
+                             {DiskLoc(2, 1000), 100},
+                             {DiskLoc(3, 1000), 100},
+                             {}};
+        LocAndSize drecs[] = {{DiskLoc(0, 1100), 100},
+                              {DiskLoc(2, 1100), 100},
+                              {DiskLoc(1, 1100), 2000},
+                              {DiskLoc(3, 1100), 4000},
+                              {}};
+        initializeV1RS(&txn, recs, drecs, NULL, &em, md);
+    }
+
+    CompactOptions options;
+    options.paddingMode = CompactOptions::PRESERVE;
+    options.minFreeFraction = 0.25;
+    options.maxDeletedRecordsPerStep = 1;
+    CompactStats stats;
+    CompactOnlineRecorder recorder;
+
+    // One deleted record per step, so extent 1 is only picked in the fourth step.
+    for (int i = 0; i < 4; i++) {
+        StatusWith<bool> more = rs.compactOnline(&txn, &recorder, &recorder, &options, &stats);
+        ASSERT_OK(more.getStatus());
+        ASSERT_TRUE(more.getValue());
+        ASSERT_EQUALS(0, stats.recordsMoved);
+    }
+
+    // The free space in extent 1 is still on the deleted lists, but is skipped.
+    BsonDocWriter docWriter(docForRecordSize(1000), false);
+    StatusWith<RecordId> result = rs.insertRecord(&txn, &docWriter, false);
+    ASSERT_OK(result.getStatus());
+    ASSERT_EQUALS(DiskLoc(3, 1100), DiskLoc::fromRecordId(result.getValue()));
+
+    int steps = 4;
+    StatusWith<bool> more(true);
+    while (more.getValue()) {
+        ASSERT_LESS_THAN(steps++, 20);
+        more = rs.compactOnline(&txn, &recorder, &recorder, &options, &stats);
+        ASSERT_OK(more.getStatus());
+    }
+    rs.compactOnlineDone(&txn);
+
+    ASSERT_EQUALS(1, stats.recordsMoved);
+    ASSERT_EQUALS(1, stats.extentsFreed);
+    ASSERT_EQUALS(DiskLoc(1, 1000), recorder.moves[0]);
+    ASSERT_EQUALS(DiskLoc(2, 0), em.getExtent(DiskLoc(0, 0))->xnext);
+    ASSERT_EQUALS(DiskLoc(0, 0), em.getExtent(DiskLoc(2, 0))->xprev);
+}
+
+/**
+ * compactOnline() moves at most maxRecordsPerStep records per call and can empty the first
+ * extent.
+ */
+TEST(SimpleRecordStoreV1, CompactOnlineMovesInBatches) {
+    OperationContextNoop txn;
+    DummyExtentManager em;
+    DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData(false, 0);
+    SimpleRecordStoreV1 rs(&txn, "test.foo", md, &em, false);
+
+    {
+        LocAndSize recs[] = {{DiskLoc(0, 1000), 100},
+                             {DiskLoc(0, 1100), 100},
+                             {DiskLoc(1, 1000), 100},
+                             {}};
+        LocAndSize drecs[] = {{DiskLoc(1, 1100), 1000}, {DiskLoc(0, 1200), 2000}, {}};
+        initializeV1RS(&txn, recs, drecs, NULL, &em, md);
+    }
+
+    CompactOptions options;
+    options.paddingMode = CompactOptions::PRESERVE;
+    options.minFreeFraction = 0.25;
+    options.maxRecordsPerStep = 1;
+    CompactStats stats;
+    CompactOnlineRecorder recorder;
+
+    StatusWith<bool> more = rs.compactOnline(&txn, &recorder, &recorder, &options, &stats);
+    ASSERT_OK(more.getStatus());
+    ASSERT_TRUE(more.getValue());
+    ASSERT_EQUALS(1, stats.recordsMoved);
+    ASSERT_EQUALS(0, stats.extentsFreed);
+
+    more = rs.compactOnline(&txn, &recorder, &recorder, &options, &stats);
+    ASSERT_OK(more.getStatus());
+    ASSERT_TRUE(more.getValue());
+    ASSERT_EQUALS(2, stats.recordsMoved);
+    ASSERT_EQUALS(1, stats.extentsFreed);
+
+    // Only the last extent is left, and it is never compacted.
+    more = rs.compactOnline(&txn, &recorder, &recorder, &options, &stats);
+    ASSERT_OK(more.getStatus());
+    ASSERT_FALSE(more.getValue());
+    rs.compactOnlineDone(&txn);
+
+    ASSERT_EQUALS(DiskLoc(1, 0), md->firstExtent(&txn));
+    ASSERT_TRUE(em.getExtent(DiskLoc(1, 0))->xprev.isNull());
+
+    {
+        LocAndSize recs[] = {{DiskLoc(1, 1000), 100},
+                             {DiskLoc(1, 1100), 100},
+                             {DiskLoc(1, 1200), 100},
+                             {}};
+        LocAndSize drecs[] = {{DiskLoc(1, 1300), 800}, {}};
+        assertStateV1RS(&txn, recs, drecs, NULL, &em, md);
+    }
+}
 }
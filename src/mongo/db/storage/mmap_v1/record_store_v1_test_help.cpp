@@ -295,6 +295,15 @@ DummyExtentManager::CacheHint* DummyExtentManager::cacheHint(const DiskLoc& exte
     return new CacheHint();
 }
 
+bool DummyExtentManager::willNeed(const DiskLoc& extentLoc, int ofs, int len) const {
+    invariant(ofs >= 0 && len > 0);
+    invariant(static_cast<size_t>(ofs + len) <= _extents[extentLoc.a()].length);
+    willNeedRanges.push_back({extentLoc, ofs, len});
+    if (ofs == 0 && len == Extent::HeaderSize() && inMemoryHeaders.count(extentLoc.a()))
+        return false;
+    return !inMemoryExtents.count(extentLoc.a());
+}
+
 namespace {
 void accumulateExtentSizeRequirements(const LocAndSize* las, std::map<int, size_t>* sizes) {
     if (!las)
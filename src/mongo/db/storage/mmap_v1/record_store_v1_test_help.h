@@ -30,6 +30,7 @@
 
 #pragma once
 
+#include <set>
 #include <vector>
 
 #include "mongo/db/storage/mmap_v1/extent_manager.h"
@@ -141,6 +142,23 @@ public:
 
     virtual CacheHint* cacheHint(const DiskLoc& extentLoc, const HintType& hint);
 
+    virtual bool willNeed(const DiskLoc& extentLoc, int ofs, int len) const;
+
+    struct WillNeedRange {
+        DiskLoc extentLoc;
+        int ofs;
+        int len;
+    };
+
+    /**
+     * The ranges passed to willNeed(), in order. Ranges in extents whose index is in
+     * 'inMemoryExtents' are reported as already being in memory, and so are the headers of
+     * extents whose index is in 'inMemoryHeaders'.
+     */
+    mutable std::vector<WillNeedRange> willNeedRanges;
+    std::set<int> inMemoryExtents;
+    std::set<int> inMemoryHeaders;
+
 protected:
     struct ExtentInfo {
         char* data;
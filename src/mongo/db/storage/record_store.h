@@ -519,6 +519,39 @@ public:
         invariant(false);
     }
 
+    /**
+     * does this RecordStore support compactOnline()?
+     */
+    virtual bool compactOnlineSupported() const {
+        return false;
+    }
+
+    /**
+     * Does a bounded amount of work towards reducing the storage space used by this RecordStore
+     * while it stays available. Unlike compact(), this only needs an intent lock on the
+     * collection, and callers are expected to release their locks between calls.
+     *
+     * Records are moved the same way updateRecord() moves a record that outgrew its space:
+     * 'notifier' is told before the old location is deleted and 'adaptor' is told about the
+     * new location. The RecordIds of moved records change.
+     *
+     * Only called if compactOnlineSupported() returns true.
+     * @return true if there is more work to do
+     */
+    virtual StatusWith<bool> compactOnline(OperationContext* txn,
+                                           RecordStoreCompactAdaptor* adaptor,
+                                           UpdateNotifier* notifier,
+                                           const CompactOptions* options,
+                                           CompactStats* stats) {
+        invariant(false);
+    }
+
+    /**
+     * Called once no more compactOnline() calls will follow, whether or not the last one
+     * returned false, so that any state kept between calls can be dropped.
+     */
+    virtual void compactOnlineDone(OperationContext* txn) {}
+
     /**
      * @param full - does more checks
      * @param scanData - scans each document
@@ -1425,7 +1425,7 @@ StatusWith<RecordId> WiredTigerRecordStore::updateRecord(OperationContext* txn,
 }
 
 bool WiredTigerRecordStore::updateWithDamagesSupported() const {
-    return false;
+    return true;
 }
 
 StatusWith<RecordData> WiredTigerRecordStore::updateWithDamages(
@@ -1434,7 +1434,31 @@ StatusWith<RecordData> WiredTigerRecordStore::updateWithDamages(
     const RecordData& oldRec,
     const char* damageSource,
     const mutablebson::DamageVector& damages) {
-    MONGO_UNREACHABLE;
+    // WiredTiger cannot modify part of a value, so the damages are applied over a copy of the
+    // old record which then replaces it. This still spares the caller from building the new
+    // document and maintaining the indexes, and the size of the record does not change.
+    const int len = oldRec.size();
+    SharedBuffer data = SharedBuffer::allocate(len);
+    memcpy(data.get(), oldRec.data(), len);
+
+    mutablebson::DamageVector::const_iterator where = damages.begin();
+    const mutablebson::DamageVector::const_iterator end = damages.end();
+    for (; where != end; ++where) {
+        invariant(where->targetOffset + where->size <= static_cast<size_t>(len));
+        memcpy(data.get() + where->targetOffset, damageSource + where->sourceOffset, where->size);
+    }
+
+    WiredTigerCursor curwrap(_uri, _tableId, true, txn);
+    curwrap.assertInActiveTxn();
+    WT_CURSOR* c = curwrap.get();
+    invariant(c);
+    c->set_key(c, _makeKey(id));
+    WiredTigerItem value(data.get(), len);
+    c->set_value(c, value.Get());
+    int ret = WT_OP_CHECK(c->insert(c));
+    invariantWTOK(ret);
+
+    return RecordData(std::move(data), len);
 }
 
 void WiredTigerRecordStore::_oplogSetStartHack(WiredTigerRecoveryUnit* wru) const {
@@ -36,6 +36,7 @@
 #include "mongo/bson/util/bson_extract.h"
 #include "mongo/db/client.h"
 #include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/curop.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/repl/optime.h"
@@ -271,7 +272,11 @@ Status waitForWriteConcern(OperationContext* txn,
             break;
     }
 
-    result->syncMillis = syncTimer.millis();
+    const long long syncMicros = syncTimer.micros();
+    result->syncMillis = syncMicros / 1000;
+    if (writeConcernWithPopulatedSyncMode.syncMode != WriteConcernOptions::SyncMode::NONE) {
+        CurOp::get(txn)->debug().recordWritePhase(WritePhase::kJournal, syncMicros);
+    }
 
     // Now wait for replication
 
@@ -302,6 +307,8 @@ Status waitForWriteConcern(OperationContext* txn,
         replOpTime,
         writeConcernWithPopulatedSyncMode.syncMode == WriteConcernOptions::SyncMode::JOURNAL);
     gleWtimeStats.recordMillis(durationCount<Milliseconds>(replStatus.duration));
+    CurOp::get(txn)->debug().recordWritePhase(WritePhase::kWriteConcern,
+                                              durationCount<Microseconds>(replStatus.duration));
     result->wTime = durationCount<Milliseconds>(replStatus.duration);
 
     return replStatus.status;
@@ -149,7 +149,7 @@ TEST_F(ChunkManagerTests, Basic) {
 
     ASSERT_EQ(version.epoch(), manager.getVersion().epoch());
     ASSERT_EQ(numChunks - 1, manager.getVersion().minorVersion());
-    ASSERT_EQ(numChunks, static_cast<int>(manager.getChunkMap().size()));
+    ASSERT_EQ(numChunks, manager.numChunks());
 
     // Modify chunks collection
     BSONObjBuilder b;
@@ -162,7 +162,7 @@ TEST_F(ChunkManagerTests, Basic) {
     ChunkManager newManager(manager.getns(), manager.getShardKeyPattern(), manager.isUnique());
     newManager.loadExistingRanges(&_txn, &manager);
 
-    ASSERT_EQ(numChunks, static_cast<int>(manager.getChunkMap().size()));
+    ASSERT_EQ(numChunks, manager.numChunks());
     ASSERT_EQ(laterVersion.toString(), newManager.getVersion().toString());
 }
 
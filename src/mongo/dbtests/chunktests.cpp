@@ -52,16 +52,16 @@ public:
         mySplitPoints.insert(mySplitPoints.begin(), _keyPattern.getKeyPattern().globalMin());
         mySplitPoints.push_back(_keyPattern.getKeyPattern().globalMax());
 
+        ChunkRoutingTable::Builder builder;
         for (unsigned i = 1; i < mySplitPoints.size(); ++i) {
             const string shardId = str::stream() << (i - 1);
             _shardIds.insert(shardId);
 
-            std::shared_ptr<Chunk> chunk(
-                new Chunk(this, mySplitPoints[i - 1], mySplitPoints[i], shardId));
-            _chunkMap[mySplitPoints[i]] = chunk;
+            builder.append(
+                ChunkRoutingTable::Change(mySplitPoints[i - 1], mySplitPoints[i], shardId));
         }
 
-        _chunkRanges.reloadAll(_chunkMap);
+        _setRoutingTable(builder.done());
     }
 };
 
@@ -28,6 +28,9 @@
 
 #include "mongo/platform/basic.h"
 
+#include <boost/filesystem/operations.hpp>
+#include <fstream>
+
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database_holder.h"
@@ -36,6 +39,7 @@
 #include "mongo/db/dbhelpers.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/range_arithmetic.h"
+#include "mongo/db/storage/storage_options.h"
 #include "mongo/db/write_concern_options.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/unittest/unittest.h"
@@ -105,11 +109,104 @@ private:
     int _max;
 };
 
+/**
+ * Removes a range which spans several removeRange batches (128 documents by default), optionally
+ * saving the removed documents with a RemoveSaver.
+ */
+class RemoveRangeMultipleBatches {
+public:
+    RemoveRangeMultipleBatches(bool useSaver) : _useSaver(useSaver) {}
+
+    void run() {
+        OperationContextImpl txn;
+        DBDirectClient client(&txn);
+        client.dropCollection(ns);
+
+        for (int i = 0; i < kNumDocs; ++i) {
+            client.insert(ns, BSON("_id" << i << "x" << std::string(100, 'x')));
+        }
+
+        const std::string why = str::stream() << "removeRangeMultipleBatches." << _useSaver;
+        long long numDeleted;
+        {
+            std::unique_ptr<Helpers::RemoveSaver> saver;
+            if (_useSaver) {
+                saver.reset(new Helpers::RemoveSaver("moveChunk", ns, why));
+            }
+
+            KeyRange range(ns, BSON("_id" << kMin), BSON("_id" << kMax), BSON("_id" << 1));
+            mongo::WriteConcernOptions dummyWriteConcern;
+            numDeleted = Helpers::removeRange(&txn, range, false, dummyWriteConcern, saver.get());
+        }
+
+        ASSERT_EQUALS(kMax - kMin, numDeleted);
+        ASSERT_EQUALS(static_cast<unsigned long long>(kNumDocs - (kMax - kMin)), client.count(ns));
+        ASSERT_EQUALS(0U, client.count(ns, BSON("_id" << BSON("$gte" << kMin << "$lt" << kMax))));
+
+        if (_useSaver) {
+            // Every removed document is saved exactly once
+            std::vector<BSONObj> saved = savedDocs(why);
+            ASSERT_EQUALS(static_cast<size_t>(kMax - kMin), saved.size());
+
+            set<int> ids;
+            for (const auto& doc : saved) {
+                const int id = doc["_id"].numberInt();
+                ASSERT_GREATER_THAN_OR_EQUALS(id, kMin);
+                ASSERT_LESS_THAN(id, kMax);
+                ids.insert(id);
+            }
+            ASSERT_EQUALS(saved.size(), ids.size());
+        }
+    }
+
+private:
+    /**
+     * Reads back the documents written by the RemoveSavers named 'why' and removes their files.
+     */
+    static std::vector<BSONObj> savedDocs(const std::string& why) {
+        namespace fs = boost::filesystem;
+
+        std::vector<BSONObj> docs;
+        const fs::path root = fs::path(storageGlobalParams.dbpath) / "moveChunk" / ns;
+        std::vector<fs::path> files;
+        for (fs::directory_iterator it(root); it != fs::directory_iterator(); ++it) {
+            if (it->path().filename().string().compare(0, why.size(), why) == 0) {
+                files.push_back(it->path());
+            }
+        }
+
+        for (const auto& file : files) {
+            std::ifstream in(file.string().c_str(), std::ios_base::in | std::ios_base::binary);
+            const std::string data((std::istreambuf_iterator<char>(in)),
+                                   std::istreambuf_iterator<char>());
+            size_t offset = 0;
+            while (offset < data.size()) {
+                BSONObj doc(data.data() + offset);
+                docs.push_back(doc.getOwned());
+                offset += doc.objsize();
+            }
+
+            in.close();
+            fs::remove(file);
+        }
+
+        return docs;
+    }
+
+    static const int kNumDocs = 1000;
+    static const int kMin = 10;
+    static const int kMax = 990;
+
+    const bool _useSaver;
+};
+
 class All : public Suite {
 public:
     All() : Suite("remove") {}
     void setupTests() {
         add<RemoveRange>();
+        add<RemoveRangeMultipleBatches>(false);
+        add<RemoveRangeMultipleBatches>(true);
     }
 } myall;
 
@@ -33,9 +33,12 @@
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/catalog/index_create.h"
+#include "mongo/db/curop.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/dbhelpers.h"
+#include "mongo/db/field_ref.h"
+#include "mongo/db/field_ref_set.h"
 #include "mongo/db/service_context_d.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/index/index_descriptor.h"
@@ -883,6 +886,134 @@ public:
     }
 };
 
+/**
+ * Fixture for the tests of Collection::updateDocument() when it is told which paths the update
+ * touched, with an index on 'a.b', one on 'c' and a document with an array under 'a'.
+ */
+class UpdateDocumentBase : public IndexBuildBase {
+public:
+    UpdateDocumentBase() {
+        ASSERT_OK(createIndex("unittest",
+                              BSON("name"
+                                   << "a.b_1"
+                                   << "ns" << _ns << "key" << BSON("a.b" << 1))));
+        ASSERT_OK(createIndex("unittest",
+                              BSON("name"
+                                   << "c_1"
+                                   << "ns" << _ns << "key" << BSON("c" << 1))));
+
+        WriteUnitOfWork wunit(&_txn);
+        ASSERT_OK(collection()->insertDocument(&_txn, fromjson(kDoc), true));
+        wunit.commit();
+    }
+
+protected:
+    /**
+     * Updates the document to 'newDoc' in place, telling that the update only touched the paths
+     * in 'updatedPaths'. Returns the number of index keys added.
+     */
+    long long update(const char* newDoc, const std::vector<std::string>& updatedPaths) {
+        RecordId loc = Helpers::findOne(&_txn, collection(), BSON("_id" << 0), false);
+        ASSERT(!loc.isNull());
+
+        std::vector<std::unique_ptr<FieldRef>> fieldRefs;
+        FieldRefSet updatedFields;
+        for (const auto& path : updatedPaths) {
+            fieldRefs.emplace_back(new FieldRef(path));
+            updatedFields.insert(fieldRefs.back().get());
+        }
+
+        OpDebug debug;
+        oplogUpdateEntryArgs args;
+        WriteUnitOfWork wunit(&_txn);
+        auto newLoc = collection()->updateDocument(&_txn,
+                                                   loc,
+                                                   collection()->docFor(&_txn, loc),
+                                                   fromjson(newDoc),
+                                                   true,
+                                                   true,
+                                                   &updatedFields,
+                                                   &debug,
+                                                   args);
+        ASSERT_OK(newLoc.getStatus());
+        ASSERT_EQUALS(loc, newLoc.getValue());
+        wunit.commit();
+
+        return debug.keyUpdates;
+    }
+
+    /**
+     * Returns the values of the keys in the single field index named 'indexName', in key order.
+     */
+    BSONArray indexKeys(const std::string& indexName) {
+        IndexCatalog* catalog = collection()->getIndexCatalog();
+        IndexDescriptor* desc = catalog->findIndexByName(&_txn, indexName);
+        ASSERT(desc);
+
+        BSONArrayBuilder keys;
+        auto cursor = catalog->getIndex(desc)->newCursor(&_txn);
+        for (auto kv = cursor->seek(kMinBSONKey, true); kv; kv = cursor->next()) {
+            keys.append(kv->key.firstElement());
+        }
+        return keys.arr();
+    }
+
+    static const char* const kDoc;
+};
+
+const char* const UpdateDocumentBase::kDoc = "{_id: 0, a: [{b: 1}, {b: 2}], c: 1, d: 1}";
+
+/**
+ * Only the index over the path which the update touched gets its keys maintained. The update
+ * changes 'c' as well to show that the index on 'c' is left alone.
+ */
+class UpdateDocumentMaintainsOnlyIndexesOverUpdatedPaths : public UpdateDocumentBase {
+public:
+    void run() {
+        ASSERT_EQUALS(1, update("{_id: 0, a: [{b: 3}, {b: 2}], c: 2, d: 1}", {"a.0.b"}));
+        ASSERT_EQUALS(BSON_ARRAY(2 << 3), indexKeys("a.b_1"));
+        ASSERT_EQUALS(BSON_ARRAY(1), indexKeys("c_1"));
+        ASSERT_EQUALS(BSON_ARRAY(0), indexKeys("_id_"));
+    }
+};
+
+/**
+ * Updates of a prefix of an indexed path, of a path below it, or of an element of the array on
+ * the way to it, all maintain the multikey index.
+ */
+class UpdateDocumentMaintainsIndexesOverPrefixesOfUpdatedPaths : public UpdateDocumentBase {
+public:
+    void run() {
+        ASSERT_EQUALS(1, update("{_id: 0, a: [{b: 4}, {b: 2}], c: 1, d: 1}", {"a"}));
+        ASSERT_EQUALS(BSON_ARRAY(2 << 4), indexKeys("a.b_1"));
+
+        ASSERT_EQUALS(1, update("{_id: 0, a: [{b: 4}, {b: 5}], c: 1, d: 1}", {"a.1"}));
+        ASSERT_EQUALS(BSON_ARRAY(4 << 5), indexKeys("a.b_1"));
+
+        ASSERT_EQUALS(1, update("{_id: 0, a: [{b: 6}, {b: 5}], c: 1, d: 1}", {"a.b.x"}));
+        ASSERT_EQUALS(BSON_ARRAY(5 << 6), indexKeys("a.b_1"));
+
+        // The index is left alone for 'ab', which only shares a prefix of characters with 'a.b',
+        // not a prefix of fields
+        ASSERT_EQUALS(0, update("{_id: 0, a: [{b: 7}, {b: 5}], c: 1, d: 1}", {"ab"}));
+        ASSERT_EQUALS(BSON_ARRAY(5 << 6), indexKeys("a.b_1"));
+        ASSERT_EQUALS(BSON_ARRAY(1), indexKeys("c_1"));
+    }
+};
+
+/**
+ * An update which touches no indexed path leaves every index alone.
+ */
+class UpdateDocumentOfNoIndexedPath : public UpdateDocumentBase {
+public:
+    void run() {
+        ASSERT_EQUALS(0, update("{_id: 0, a: [{b: 1}, {b: 2}], c: 1, d: 2}", {"d"}));
+        ASSERT_EQUALS(BSON_ARRAY(0), indexKeys("_id_"));
+        ASSERT_EQUALS(BSON_ARRAY(1 << 2), indexKeys("a.b_1"));
+        ASSERT_EQUALS(BSON_ARRAY(1), indexKeys("c_1"));
+    }
+};
+
 class IndexUpdateTests : public Suite {
 public:
     IndexUpdateTests() : Suite("indexupdate") {}
@@ -915,6 +1046,9 @@ public:
         add<SameSpecDifferentSparse>();
         add<SameSpecDifferentTTL>();
         add<StorageEngineOptions>();
+        add<UpdateDocumentMaintainsOnlyIndexesOverUpdatedPaths>();
+        add<UpdateDocumentMaintainsIndexesOverPrefixesOfUpdatedPaths>();
+        add<UpdateDocumentOfNoIndexedPath>();
 
         add<IndexCatatalogFixIndexKey>();
     }
@@ -46,10 +46,13 @@
 #include <iostream>
 #include <mutex>
 
+#include "mongo/bson/bson_field_index.h"
+#include "mongo/bson/bson_validate.h"
 #include "mongo/config.h"
 #include "mongo/db/client.h"
 #include "mongo/db/db.h"
 #include "mongo/db/dbdirectclient.h"
+#include "mongo/db/json.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/storage/mmap_v1/dur_stats.h"
@@ -60,6 +63,7 @@
 #include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/thread.h"
 #include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
 #include "mongo/util/timer.h"
 #include "mongo/util/version.h"
 
@@ -444,6 +448,129 @@ public:
     }
 };
 
+// Looks up 10 fields spread over a 150 field document, as a matcher or compound index would.
+class GetFieldBase : public B {
+public:
+    GetFieldBase() {
+        BSONObjBuilder bob;
+        for (int i = 0; i < 150; ++i) {
+            bob.append(std::string(str::stream() << "field" << i), i);
+        }
+        _doc = bob.obj();
+        for (int i = 5; i < 150; i += 15) {
+            _fieldNames.push_back(str::stream() << "field" << i);
+        }
+    }
+    virtual int howLongMillis() {
+        return 500;
+    }
+    virtual bool showDurStats() {
+        return false;
+    }
+
+protected:
+    BSONObj _doc;
+    std::vector<std::string> _fieldNames;
+    long long _sum = 0;
+};
+class getfieldlinear : public GetFieldBase {
+public:
+    string name() {
+        return "BSONObj::getField";
+    }
+    void timed() {
+        for (const auto& fieldName : _fieldNames) {
+            _sum += _doc.getField(fieldName).numberInt();
+        }
+    }
+};
+class getfieldindexed : public GetFieldBase {
+public:
+    string name() {
+        return "BSONFieldIndex::getField";
+    }
+    void timed() {
+        BSONFieldIndex index(_doc);
+        for (const auto& fieldName : _fieldNames) {
+            _sum += index.getField(fieldName).numberInt();
+        }
+    }
+};
+
+// Validates a typical small document, as done for every inbound document with objcheck.
+class validatebson : public B {
+public:
+    validatebson() {
+        BSONObjBuilder bob;
+        bob.append("_id", OID::gen());
+        for (int i = 0; i < 20; ++i) {
+            bob.append(std::string(str::stream() << "field" << i), i);
+        }
+        bob.append("str", "hello world");
+        bob.append("sub", BSON("a" << 1 << "b" << 2.5 << "c" << BSON_ARRAY(1 << 2 << 3)));
+        _doc = bob.obj();
+    }
+    string name() {
+        return "validateBSON";
+    }
+    virtual int howLongMillis() {
+        return 500;
+    }
+    virtual bool showDurStats() {
+        return false;
+    }
+    void timed() {
+        invariant(validateBSON(_doc.objdata(), _doc.objsize()).isOK());
+    }
+
+private:
+    BSONObj _doc;
+};
+
+// Serializes and parses a 150 field document of numbers, strings and subdocuments.
+class JsonBase : public B {
+public:
+    JsonBase() {
+        BSONObjBuilder bob;
+        for (int i = 0; i < 50; ++i) {
+            bob.append(std::string(str::stream() << "num" << i), i);
+            bob.append(std::string(str::stream() << "str" << i), "a moderately long string value");
+            bob.append(std::string(str::stream() << "obj" << i),
+                       BSON("a" << 1.5 << "b" << BSON_ARRAY(1 << 2 << 3)));
+        }
+        _doc = bob.obj();
+        _json = _doc.jsonString();
+    }
+    virtual int howLongMillis() {
+        return 500;
+    }
+    virtual bool showDurStats() {
+        return false;
+    }
+
+protected:
+    BSONObj _doc;
+    std::string _json;
+};
+class tojson : public JsonBase {
+public:
+    string name() {
+        return "BSONObj::jsonString";
+    }
+    void timed() {
+        invariant(_doc.jsonString().size() == _json.size());
+    }
+};
+class fromjsonspeed : public JsonBase {
+public:
+    string name() {
+        return "fromjson";
+    }
+    void timed() {
+        invariant(fromjson(_json).objsize() == _doc.objsize());
+    }
+};
+
 
 class All : public Suite {
 public:
@@ -457,6 +584,11 @@ public:
         add<boosttimed_mutexspeed>();
         add<stdmutexspeed>();
         add<stdtimed_mutexspeed>();
+        add<getfieldlinear>();
+        add<getfieldindexed>();
+        add<validatebson>();
+        add<tojson>();
+        add<fromjsonspeed>();
     }
 } myall;
 }
@@ -124,6 +124,7 @@ public:
                               false,
                               true,
                               NULL,
+                              NULL,
                               args);
         wunit.commit();
     }
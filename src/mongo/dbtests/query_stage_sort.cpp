@@ -355,7 +355,7 @@ public:
         oplogUpdateEntryArgs args;
         {
             WriteUnitOfWork wuow(&_txn);
-            coll->updateDocument(&_txn, *it, oldDoc, newDoc, false, false, NULL, args);
+            coll->updateDocument(&_txn, *it, oldDoc, newDoc, false, false, NULL, NULL, args);
             wuow.commit();
         }
         exec->restoreState();
@@ -373,7 +373,7 @@ public:
             oldDoc = coll->docFor(&_txn, *it);
             {
                 WriteUnitOfWork wuow(&_txn);
-                coll->updateDocument(&_txn, *it++, oldDoc, newDoc, false, false, NULL, args);
+                coll->updateDocument(&_txn, *it++, oldDoc, newDoc, false, false, NULL, NULL, args);
                 wuow.commit();
             }
         }
@@ -31,6 +31,8 @@
 
 #include "mongo/executor/connection_pool.h"
 
+#include <cmath>
+
 #include "mongo/executor/connection_pool_stats.h"
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/executor/remote_command_request.h"
@@ -48,6 +50,17 @@
 
 namespace mongo {
 namespace executor {
+namespace {
+
+// With adaptive sizing, a pool keeps up to this many times its average load in connections, so that
+// ordinary fluctuations do not cause connections to be closed and reopened
+const double kAdaptiveSizingHeadroom = 1.25;
+
+// Least weight of each new sample in the moving average of the time connections stay checked
+// out. A sample which comes a while after the previous one weighs more, as the load would.
+const double kUseTimeSampleWeight = 0.1;
+
+}  // namespace
 
 /**
  * A pool for a specific HostAndPort
@@ -98,6 +111,27 @@ public:
      */
     size_t createdConnections(const stdx::unique_lock<stdx::mutex>& lk);
 
+    /**
+     * Returns the number of connections in setup or refresh.
+     */
+    size_t pendingConnections(const stdx::unique_lock<stdx::mutex>& lk);
+
+    /**
+     * Returns the number of connections this pool aims to keep around given its recent load. Only
+     * meaningful with adaptive sizing.
+     */
+    size_t targetConnections(const stdx::unique_lock<stdx::mutex>& lk);
+
+    /**
+     * Returns the moving average of the number of connections in use plus requests waiting.
+     */
+    double averageLoad(const stdx::unique_lock<stdx::mutex>& lk);
+
+    /**
+     * Returns the moving average of the time connections stay checked out, in milliseconds.
+     */
+    double averageUseMillis(const stdx::unique_lock<stdx::mutex>& lk);
+
 private:
     using OwnedConnection = std::unique_ptr<ConnectionInterface>;
     using OwnershipPool = std::unordered_map<ConnectionInterface*, OwnedConnection>;
@@ -121,6 +155,28 @@ private:
 
     void updateStateInLock();
 
+    /**
+     * Folds the load since the previous sample into _loadAverage. Must be called before every
+     * change to the number of requests or checked out connections.
+     */
+    void sampleLoad();
+
+    /**
+     * Returns how much moving averages of the pool decay between 'from' and 'to', given the load
+     * decay period.
+     */
+    double decayBetween(Date_t from, Date_t to) const;
+
+    /**
+     * Returns the number of connections the pool expects to be in use or waited for. That is the
+     * larger of the load average and, by Little's law, the rate at which connections are handed
+     * out times the average time they stay checked out. The latter follows a change in the
+     * latency of a host within a few returned connections, long before the load average does.
+     */
+    double expectedLoad() const;
+
+    size_t adaptiveTarget() const;
+
 private:
     ConnectionPool* const _parent;
 
@@ -140,6 +196,25 @@ private:
 
     size_t _created;
 
+    // Moving average of the number of connections checked out plus requests waiting, weighted by
+    // time, and the time at which it was last updated
+    double _loadAverage;
+    Date_t _lastLoadSample;
+
+    // Moving average of the time connections stay checked out, the time at which it was last
+    // updated, and the time at which each connection checked out by a user was handed out
+    double _useMillisAverage;
+    Date_t _lastUseSample;
+    std::unordered_map<ConnectionInterface*, Date_t> _checkoutTimes;
+
+    // Moving average of the rate at which connections are handed out to users, per millisecond,
+    // and the time at which it was last updated
+    double _checkoutRateAverage;
+    Date_t _lastCheckout;
+
+    // Prevents spawnConnections from recursing through setup callbacks which complete inline
+    bool _inSpawnConnections;
+
     /**
      * The current state of the pool
      *
@@ -169,6 +244,7 @@ private:
 Milliseconds const ConnectionPool::kDefaultRefreshTimeout = Seconds(20);
 Milliseconds const ConnectionPool::kDefaultRefreshRequirement = Seconds(60);
 Milliseconds const ConnectionPool::kDefaultHostTimeout = Minutes(5);
+Milliseconds const ConnectionPool::kDefaultLoadDecayPeriod = Seconds(10);
 
 const Status ConnectionPool::kConnectionStateUnknown =
     Status(ErrorCodes::InternalError, "Connection is in an unknown state");
@@ -222,6 +298,12 @@ void ConnectionPool::appendConnectionStats(ConnectionPoolStats* stats) const {
         ConnectionStatsPerHost hostStats{pool->inUseConnections(lk),
                                          pool->availableConnections(lk),
                                          pool->createdConnections(lk)};
+        hostStats.pending = pool->pendingConnections(lk);
+        if (_options.adaptiveSizing) {
+            hostStats.target = pool->targetConnections(lk);
+        }
+        hostStats.averageLoad = pool->averageLoad(lk);
+        hostStats.averageUseMillis = pool->averageUseMillis(lk);
         stats->updateStatsForHost(host, hostStats);
     }
 }
@@ -243,6 +325,10 @@ ConnectionPool::SpecificPool::SpecificPool(ConnectionPool* parent, const HostAnd
       _generation(0),
       _inFulfillRequests(false),
       _created(0),
+      _loadAverage(0),
+      _useMillisAverage(0),
+      _checkoutRateAverage(0),
+      _inSpawnConnections(false),
       _state(State::kRunning) {}
 
 ConnectionPool::SpecificPool::~SpecificPool() {
@@ -262,6 +348,60 @@ size_t ConnectionPool::SpecificPool::createdConnections(const stdx::unique_lock<
     return _created;
 }
 
+size_t ConnectionPool::SpecificPool::pendingConnections(const stdx::unique_lock<stdx::mutex>& lk) {
+    return _processingPool.size();
+}
+
+size_t ConnectionPool::SpecificPool::targetConnections(const stdx::unique_lock<stdx::mutex>& lk) {
+    return adaptiveTarget();
+}
+
+double ConnectionPool::SpecificPool::averageLoad(const stdx::unique_lock<stdx::mutex>& lk) {
+    return _loadAverage;
+}
+
+double ConnectionPool::SpecificPool::averageUseMillis(const stdx::unique_lock<stdx::mutex>& lk) {
+    return _useMillisAverage;
+}
+
+void ConnectionPool::SpecificPool::sampleLoad() {
+    const auto now = _parent->_factory->now();
+    const double load = _requests.size() + _checkedOutPool.size();
+
+    if (_lastLoadSample == Date_t()) {
+        _loadAverage = load;
+    } else if (now > _lastLoadSample) {
+        // The load has been constant since the previous sample, so weigh it by how long it lasted
+        const double decay = decayBetween(_lastLoadSample, now);
+        _loadAverage = _loadAverage * decay + load * (1 - decay);
+    }
+
+    _lastLoadSample = now;
+}
+
+double ConnectionPool::SpecificPool::decayBetween(Date_t from, Date_t to) const {
+    if (to <= from) {
+        return 1;
+    }
+
+    const double elapsed = durationCount<Milliseconds>(to - from);
+    const double period =
+        std::max(durationCount<Milliseconds>(_parent->_options.loadDecayPeriod), 1LL);
+    return std::exp(-elapsed / period);
+}
+
+double ConnectionPool::SpecificPool::expectedLoad() const {
+    const double checkoutRate =
+        _checkoutRateAverage * decayBetween(_lastCheckout, _parent->_factory->now());
+    return std::max(_loadAverage, checkoutRate * _useMillisAverage);
+}
+
+size_t ConnectionPool::SpecificPool::adaptiveTarget() const {
+    const auto target = static_cast<size_t>(std::ceil(expectedLoad() * kAdaptiveSizingHeadroom));
+    return std::max(_parent->_options.minConnections,
+                    std::min(target, _parent->_options.maxConnections));
+}
+
 void ConnectionPool::SpecificPool::getConnection(const HostAndPort& hostAndPort,
                                                  Milliseconds timeout,
                                                  stdx::unique_lock<stdx::mutex> lk,
@@ -273,6 +413,7 @@ void ConnectionPool::SpecificPool::getConnection(const HostAndPort& hostAndPort,
         ? RemoteCommandRequest::kNoExpirationDate
         : _parent->_factory->now() + timeout;
 
+    sampleLoad();
     _requests.push(make_pair(expiration, std::move(cb)));
 
     updateStateInLock();
@@ -285,6 +426,21 @@ void ConnectionPool::SpecificPool::returnConnection(ConnectionInterface* connPtr
                                                     stdx::unique_lock<stdx::mutex> lk) {
     auto needsRefreshTP = connPtr->getLastUsed() + _parent->_options.refreshRequirement;
 
+    sampleLoad();
+
+    // Connections checked out internally for a refresh have no checkout time
+    auto checkoutIter = _checkoutTimes.find(connPtr);
+    if (checkoutIter != _checkoutTimes.end()) {
+        const auto now = _parent->_factory->now();
+        const double useMillis = durationCount<Milliseconds>(now - checkoutIter->second);
+        const double weight = _lastUseSample == Date_t()
+            ? 1
+            : std::max(kUseTimeSampleWeight, 1 - decayBetween(_lastUseSample, now));
+        _useMillisAverage += (useMillis - _useMillisAverage) * weight;
+        _lastUseSample = now;
+        _checkoutTimes.erase(checkoutIter);
+    }
+
     auto conn = takeFromPool(_checkedOutPool, connPtr);
 
     updateStateInLock();
@@ -344,6 +500,12 @@ void ConnectionPool::SpecificPool::returnConnection(ConnectionInterface* connPtr
                              processFailure(status, std::move(lk));
                          });
         lk.lock();
+    } else if (_parent->_options.adaptiveSizing && _requests.empty() &&
+               _readyPool.size() + _processingPool.size() + _checkedOutPool.size() >=
+                   adaptiveTarget()) {
+        // If nobody is waiting and the pool is already as large as its recent load warrants, let
+        // the connection lapse
+        return;
     } else {
         // If it's fine as it is, just put it in the ready queue
         addToReady(lk, std::move(conn));
@@ -406,6 +568,8 @@ void ConnectionPool::SpecificPool::processFailure(const Status& status,
     }
     _processingPool.clear();
 
+    sampleLoad();
+
     // Move the requests out so they aren't visible
     // in other threads
     decltype(_requests) requestsToFail;
@@ -470,7 +634,15 @@ void ConnectionPool::SpecificPool::fulfillRequests(stdx::unique_lock<stdx::mutex
         auto connPtr = conn.get();
 
         // check out the connection
+        const auto now = _parent->_factory->now();
         _checkedOutPool[connPtr] = std::move(conn);
+        _checkoutTimes[connPtr] = now;
+
+        // Each hand out adds one over the decay period to the rate, which decays like the load
+        const double period =
+            std::max(durationCount<Milliseconds>(_parent->_options.loadDecayPeriod), 1LL);
+        _checkoutRateAverage = _checkoutRateAverage * decayBetween(_lastCheckout, now) + 1 / period;
+        _lastCheckout = now;
 
         updateStateInLock();
 
@@ -483,18 +655,32 @@ void ConnectionPool::SpecificPool::fulfillRequests(stdx::unique_lock<stdx::mutex
 }
 
 // spawn enough connections to satisfy open requests and minpool, while
-// honoring maxpool
+// honoring maxpool and the limit on connections in setup
 void ConnectionPool::SpecificPool::spawnConnections(stdx::unique_lock<stdx::mutex>& lk,
                                                     const HostAndPort& hostAndPort) {
-    // We want minConnections <= outstanding requests <= maxConnections
+    // If some other call (possibly a setup callback which completed inline within this one) is
+    // already spawning connections, it will re-evaluate the target when it resumes
+    if (_inSpawnConnections)
+        return;
+
+    _inSpawnConnections = true;
+    auto guard = MakeGuard([&] { _inSpawnConnections = false; });
+
+    // We want minConnections <= outstanding requests <= maxConnections. With adaptive sizing we
+    // also open connections ahead of time up to the expected load.
     auto target = [&] {
-        return std::max(
-            _parent->_options.minConnections,
-            std::min(_requests.size() + _checkedOutPool.size(), _parent->_options.maxConnections));
+        size_t demand = _requests.size() + _checkedOutPool.size();
+        if (_parent->_options.adaptiveSizing) {
+            demand = std::max(demand, static_cast<size_t>(std::ceil(expectedLoad())));
+        }
+
+        return std::max(_parent->_options.minConnections,
+                        std::min(demand, _parent->_options.maxConnections));
     };
 
     // While all of our inflight connections are less than our target
-    while (_readyPool.size() + _processingPool.size() + _checkedOutPool.size() < target()) {
+    while (_readyPool.size() + _processingPool.size() + _checkedOutPool.size() < target() &&
+           _processingPool.size() < _parent->_options.maxConnecting) {
         // make a new connection and put it in processing
         auto handle = _parent->_factory->makeConnection(hostAndPort, _generation);
         auto connPtr = handle.get();
@@ -517,6 +703,9 @@ void ConnectionPool::SpecificPool::spawnConnections(stdx::unique_lock<stdx::mute
                                // connection lapse
                            } else if (status.isOK()) {
                                addToReady(lk, std::move(conn));
+
+                               // Start any connections held back by maxConnecting
+                               spawnConnections(lk, _hostAndPort);
                            } else {
                                // If the setup failed, cascade the failure edge
                                processFailure(status, std::move(lk));
@@ -619,6 +808,7 @@ void ConnectionPool::SpecificPool::updateStateInLock() {
 
                     if (x.first <= now) {
                         auto cb = std::move(x.second);
+                        sampleLoad();
                         _requests.pop();
 
                         lk.unlock();
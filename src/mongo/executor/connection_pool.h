@@ -70,6 +70,7 @@ public:
     static const Milliseconds kDefaultRefreshTimeout;
     static const Milliseconds kDefaultRefreshRequirement;
     static const Milliseconds kDefaultHostTimeout;
+    static const Milliseconds kDefaultLoadDecayPeriod;
 
     static const Status kConnectionStateUnknown;
 
@@ -89,6 +90,36 @@ public:
          */
         size_t maxConnections = std::numeric_limits<size_t>::max();
 
+        /**
+         * The maximum number of connections to a host which may be in setup or
+         * refresh at the same time. Connections needed beyond that are started
+         * as earlier ones complete, which limits the rate at which a burst of
+         * requests opens connections to a single host.
+         */
+        size_t maxConnecting = std::numeric_limits<size_t>::max();
+
+        /**
+         * Whether the number of connections kept to a host follows its observed
+         * load. Each pool then maintains moving averages of its connections in
+         * use plus requests waiting, of the rate at which it hands out
+         * connections and of the time they stay checked out. It expects the
+         * larger of the load average and the rate times the checkout time to be
+         * in use, opens connections ahead of time up to that, and lets returned
+         * connections lapse once it holds a quarter more, never going below
+         * minConnections.
+         *
+         * Otherwise idle connections above minConnections only lapse when they
+         * come due for a refresh.
+         */
+        bool adaptiveSizing = false;
+
+        /**
+         * Time constant of the moving average of the load of a host used by
+         * adaptiveSizing. Load observed this long ago weighs about a third as
+         * much as current load.
+         */
+        Milliseconds loadDecayPeriod = kDefaultLoadDecayPeriod;
+
         /**
          * Amount of time to wait before timing out a refresh attempt
          */
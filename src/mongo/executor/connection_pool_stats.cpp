@@ -30,6 +30,8 @@
 
 #include "mongo/executor/connection_pool_stats.h"
 
+#include <algorithm>
+
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/util/map_util.h"
 
@@ -45,6 +47,10 @@ ConnectionStatsPerHost& ConnectionStatsPerHost::operator+=(const ConnectionStats
     inUse += other.inUse;
     available += other.available;
     created += other.created;
+    pending += other.pending;
+    target += other.target;
+    averageLoad += other.averageLoad;
+    averageUseMillis = std::max(averageUseMillis, other.averageUseMillis);
 
     return *this;
 }
@@ -74,6 +80,10 @@ void ConnectionPoolStats::appendToBSON(mongo::BSONObjBuilder& result) {
         hostInfo.appendNumber("inUse", hostStats.inUse);
         hostInfo.appendNumber("available", hostStats.available);
         hostInfo.appendNumber("created", hostStats.created);
+        hostInfo.appendNumber("pending", hostStats.pending);
+        hostInfo.appendNumber("target", hostStats.target);
+        hostInfo.append("averageLoad", hostStats.averageLoad);
+        hostInfo.append("averageUseMillis", hostStats.averageUseMillis);
     }
 }
 
@@ -49,6 +49,20 @@ struct ConnectionStatsPerHost {
     size_t inUse = 0u;
     size_t available = 0u;
     size_t created = 0u;
+
+    // Connections in setup or refresh
+    size_t pending = 0u;
+
+    // Number of connections the pool aims to keep given its recent load, zero if it does not
+    // size itself adaptively
+    size_t target = 0u;
+
+    // Moving average of the connections in use plus requests waiting for one
+    double averageLoad = 0;
+
+    // Moving average of the time connections stay in use, in milliseconds. When combining the
+    // stats of several pools, the largest one is kept.
+    double averageUseMillis = 0;
 };
 
 /**
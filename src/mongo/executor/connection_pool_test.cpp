@@ -29,7 +29,10 @@
 
 #include "mongo/executor/connection_pool_test_fixture.h"
 
+#include <deque>
+
 #include "mongo/executor/connection_pool.h"
+#include "mongo/executor/connection_pool_stats.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/stdx/future.h"
@@ -52,6 +55,12 @@ protected:
         static_cast<ConnectionImpl*>(swConn.get())->indicateSuccess();
     }
 
+    ConnectionStatsPerHost statsFor(const ConnectionPool& pool) {
+        ConnectionPoolStats stats;
+        pool.appendConnectionStats(&stats);
+        return stats.statsByHost[HostAndPort()];
+    }
+
 private:
 };
 
@@ -830,6 +839,173 @@ TEST_F(ConnectionPoolTest, dropConnections) {
     ASSERT(reachedB);
 }
 
+/**
+ * Verify that no more than maxConnecting connections are in setup at once, and that the
+ * connections held back are started as earlier ones complete.
+ */
+TEST_F(ConnectionPoolTest, maxConnectingRespected) {
+    ConnectionPool::Options options;
+    options.maxConnecting = 2;
+    ConnectionPool pool(stdx::make_unique<PoolImpl>(), options);
+
+    std::vector<ConnectionPool::ConnectionHandle> conns(4);
+    for (auto& conn : conns) {
+        pool.get(HostAndPort(),
+                 Milliseconds(5000),
+                 [&conn](StatusWith<ConnectionPool::ConnectionHandle> swConn) {
+                     ASSERT(swConn.isOK());
+                     conn = std::move(swConn.getValue());
+                 });
+    }
+
+    ASSERT_EQ(2U, statsFor(pool).pending);
+
+    // Completing a setup starts the next one
+    ConnectionImpl::pushSetup(Status::OK());
+    ASSERT(conns[0]);
+    ASSERT_EQ(2U, statsFor(pool).pending);
+
+    ConnectionImpl::pushSetup(Status::OK());
+    ConnectionImpl::pushSetup(Status::OK());
+    ConnectionImpl::pushSetup(Status::OK());
+    ASSERT_EQ(0U, statsFor(pool).pending);
+    ASSERT_EQ(4U, statsFor(pool).created);
+
+    for (auto& conn : conns) {
+        ASSERT(conn);
+        doneWith(conn);
+    }
+}
+
+/**
+ * Verify that with adaptive sizing, connections opened for a burst are kept while the load lasts
+ * and lapse once it has gone down.
+ */
+TEST_F(ConnectionPoolTest, adaptiveSizingFollowsLoad) {
+    ConnectionPool::Options options;
+    options.minConnections = 1;
+    options.adaptiveSizing = true;
+    options.loadDecayPeriod = Seconds(1);
+    ConnectionPool pool(stdx::make_unique<PoolImpl>(), options);
+
+    auto now = Date_t::now();
+    PoolImpl::setNow(now);
+
+    // Keep 4 connections busy for a while
+    std::vector<ConnectionPool::ConnectionHandle> conns(4);
+    for (auto& conn : conns) {
+        ConnectionImpl::pushSetup(Status::OK());
+        pool.get(HostAndPort(),
+                 Milliseconds(5000),
+                 [&conn](StatusWith<ConnectionPool::ConnectionHandle> swConn) {
+                     ASSERT(swConn.isOK());
+                     conn = std::move(swConn.getValue());
+                 });
+        ASSERT(conn);
+    }
+
+    PoolImpl::setNow(now + Seconds(10));
+
+    // All of them are still warranted by the load when they come back
+    for (auto& conn : conns) {
+        doneWith(conn);
+        conn.reset();
+    }
+
+    auto stats = statsFor(pool);
+    ASSERT_EQ(4U, stats.available);
+    ASSERT_EQ(5U, stats.target);
+    ASSERT_GT(stats.averageLoad, 3.9);
+    ASSERT_GT(stats.averageUseMillis, 0.0);
+
+    // After a long idle period, a single connection is enough and the returned one lapses
+    PoolImpl::setNow(now + Seconds(20));
+
+    ConnectionPool::ConnectionHandle conn;
+    pool.get(HostAndPort(),
+             Milliseconds(5000),
+             [&conn](StatusWith<ConnectionPool::ConnectionHandle> swConn) {
+                 ASSERT(swConn.isOK());
+                 conn = std::move(swConn.getValue());
+             });
+    ASSERT(conn);
+    doneWith(conn);
+    conn.reset();
+
+    stats = statsFor(pool);
+    ASSERT_EQ(3U, stats.available);
+    ASSERT_EQ(1U, stats.target);
+    ASSERT_EQ(4U, stats.created);
+}
+
+/**
+ * Verify that with adaptive sizing, the pool grows as soon as connections stay checked out longer,
+ * before the load average catches up.
+ */
+TEST_F(ConnectionPoolTest, adaptiveSizingFollowsLatency) {
+    ConnectionPool::Options options;
+    options.minConnections = 1;
+    options.adaptiveSizing = true;
+    options.loadDecayPeriod = Seconds(1);
+    ConnectionPool pool(stdx::make_unique<PoolImpl>(), options);
+
+    auto now = Date_t::now();
+    PoolImpl::setNow(now);
+
+    for (int i = 0; i < 10; ++i) {
+        ConnectionImpl::pushSetup(Status::OK());
+    }
+
+    auto getConnection = [&pool](ConnectionPool::ConnectionHandle* conn) {
+        pool.get(HostAndPort(),
+                 Milliseconds(5000),
+                 [conn](StatusWith<ConnectionPool::ConnectionHandle> swConn) {
+                     ASSERT(swConn.isOK());
+                     *conn = std::move(swConn.getValue());
+                 });
+        ASSERT(*conn);
+    };
+
+    // One request every 10ms, each of which holds its connection for 10ms
+    for (int i = 0; i < 600; ++i) {
+        ConnectionPool::ConnectionHandle conn;
+        getConnection(&conn);
+
+        now = now + Milliseconds(10);
+        PoolImpl::setNow(now);
+
+        doneWith(conn);
+        conn.reset();
+    }
+
+    ASSERT_EQ(2U, statsFor(pool).target);
+
+    // The host slows down, and requests now hold their connections for 40ms
+    std::deque<ConnectionPool::ConnectionHandle> conns;
+    for (int i = 0; i < 20; ++i) {
+        if (conns.size() == 4) {
+            doneWith(conns.front());
+            conns.pop_front();
+        }
+
+        conns.emplace_back();
+        getConnection(&conns.back());
+
+        now = now + Milliseconds(10);
+        PoolImpl::setNow(now);
+    }
+
+    // Four connections are in use, which the load average only reflects a while later
+    auto stats = statsFor(pool);
+    ASSERT_LT(stats.averageLoad, 2.0);
+    ASSERT_GT(stats.averageUseMillis, 30.0);
+    ASSERT_EQ(5U, stats.target);
+
+    for (auto& conn : conns) {
+        doneWith(conn);
+    }
+}
+
 }  // namespace connection_pool_test_details
 }  // namespace executor
 }  // namespace mongo
@@ -116,9 +116,12 @@ void ConnectionImpl::pushSetup(PushSetupCallback status) {
     _pushSetupQueue.push_back(status);
 
     if (_setupQueue.size()) {
-        _setupQueue.front()->_setupCallback(_setupQueue.front(), _pushSetupQueue.front()());
+        // Dequeue before running the callback, which may start another setup
+        auto conn = _setupQueue.front();
+        auto answer = std::move(_pushSetupQueue.front());
         _setupQueue.pop_front();
         _pushSetupQueue.pop_front();
+        conn->_setupCallback(conn, answer());
     }
 }
 
@@ -130,9 +133,12 @@ void ConnectionImpl::pushRefresh(PushRefreshCallback status) {
     _pushRefreshQueue.push_back(status);
 
     if (_refreshQueue.size()) {
-        _refreshQueue.front()->_refreshCallback(_refreshQueue.front(), _pushRefreshQueue.front()());
+        // Dequeue before running the callback, which may start another refresh
+        auto conn = _refreshQueue.front();
+        auto answer = std::move(_pushRefreshQueue.front());
         _refreshQueue.pop_front();
         _pushRefreshQueue.pop_front();
+        conn->_refreshCallback(conn, answer());
     }
 }
 
@@ -166,9 +172,12 @@ void ConnectionImpl::setup(Milliseconds timeout, SetupCallback cb) {
     _setupQueue.push_back(this);
 
     if (_pushSetupQueue.size()) {
-        _setupQueue.front()->_setupCallback(_setupQueue.front(), _pushSetupQueue.front()());
+        // Dequeue before running the callback, which may start another setup
+        auto conn = _setupQueue.front();
+        auto answer = std::move(_pushSetupQueue.front());
         _setupQueue.pop_front();
         _pushSetupQueue.pop_front();
+        conn->_setupCallback(conn, answer());
     }
 }
 
@@ -182,9 +191,12 @@ void ConnectionImpl::refresh(Milliseconds timeout, RefreshCallback cb) {
     _refreshQueue.push_back(this);
 
     if (_pushRefreshQueue.size()) {
-        _refreshQueue.front()->_refreshCallback(_refreshQueue.front(), _pushRefreshQueue.front()());
+        // Dequeue before running the callback, which may start another refresh
+        auto conn = _refreshQueue.front();
+        auto answer = std::move(_pushRefreshQueue.front());
         _refreshQueue.pop_front();
         _pushRefreshQueue.pop_front();
+        conn->_refreshCallback(conn, answer());
     }
 }
 
@@ -119,7 +119,9 @@ void asyncRecvMessageBody(AsyncStreamInterface& stream,
 
     int z = (len + 1023) & 0xfffffc00;
     invariant(z >= len);
-    m->setData(reinterpret_cast<char*>(mongoMalloc(z)), true);
+    // The reply is received into a shared buffer, so that documents in it can be kept without
+    // copying them out of the message.
+    m->setSharedData(SharedBuffer::allocate(z));
     MsgData::View mdView = m->buf();
 
     // copy header data into master buffer
@@ -44,6 +44,41 @@
 
 namespace mongo {
 namespace executor {
+namespace {
+
+// Whether the connection pools of network interfaces size themselves according to the load of
+// each host. See ConnectionPool::Options::adaptiveSizing.
+bool connectionPoolAdaptiveSizing = false;
+
+ExportedServerParameter<bool, ServerParameterType::kStartupOnly>  //
+    connectionPoolAdaptiveSizingParameter(ServerParameterSet::getGlobal(),
+                                          "connectionPoolAdaptiveSizing",
+                                          &connectionPoolAdaptiveSizing);
+
+// Maximum number of connections to a single host which may be in setup at the same time
+int connectionPoolMaxConnecting = 8;
+
+class ConnectionPoolMaxConnectingParameter
+    : public ExportedServerParameter<int, ServerParameterType::kStartupOnly> {
+public:
+    ConnectionPoolMaxConnectingParameter()
+        : ExportedServerParameter<int, ServerParameterType::kStartupOnly>(
+              ServerParameterSet::getGlobal(),
+              "connectionPoolMaxConnecting",
+              &connectionPoolMaxConnecting) {}
+
+    virtual Status validate(const int& potentialNewValue) {
+        if (potentialNewValue < 1) {
+            return Status(ErrorCodes::BadValue,
+                          "connectionPoolMaxConnecting must be greater than or equal to 1");
+        }
+
+        return Status::OK();
+    }
+
+} connectionPoolMaxConnectingParameter;
+
+}  // namespace
 
 std::unique_ptr<NetworkInterface> makeNetworkInterface(std::string instanceName) {
     return makeNetworkInterface(std::move(instanceName), nullptr, nullptr);
@@ -58,6 +93,8 @@ std::unique_ptr<NetworkInterface> makeNetworkInterface(
     options.networkConnectionHook = std::move(hook);
     options.metadataHook = std::move(metadataHook);
     options.timerFactory = stdx::make_unique<AsyncTimerFactoryASIO>();
+    options.connectionPoolOptions.adaptiveSizing = connectionPoolAdaptiveSizing;
+    options.connectionPoolOptions.maxConnecting = connectionPoolMaxConnecting;
 
 #ifdef MONGO_CONFIG_SSL
     if (SSLManagerInterface* manager = getSSLManager()) {
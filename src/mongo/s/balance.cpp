@@ -40,6 +40,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/server_options.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/write_concern.h"
 #include "mongo/db/write_concern_options.h"
 #include "mongo/s/balancer_policy.h"
@@ -79,10 +80,11 @@ class BalanceRoundDetails {
 public:
     BalanceRoundDetails() : _executionTimer() {}
 
-    void setSucceeded(int candidateChunks, int chunksMoved) {
+    void setSucceeded(int candidateChunks, int chunksMoved, int maxConcurrentMigrations) {
         invariant(!_errMsg);
         _candidateChunks = candidateChunks;
         _chunksMoved = chunksMoved;
+        _maxConcurrentMigrations = maxConcurrentMigrations;
     }
 
     void setFailed(const string& errMsg) {
@@ -99,6 +101,7 @@ public:
         } else {
             builder.append("candidateChunks", _candidateChunks);
             builder.append("chunksMoved", _chunksMoved);
+            builder.append("maxConcurrentMigrations", _maxConcurrentMigrations);
         }
 
         return builder.obj();
@@ -110,6 +113,7 @@ private:
     // Set only on success
     int _candidateChunks{0};
     int _chunksMoved{0};
+    int _maxConcurrentMigrations{0};
 
     // Set only on failure
     boost::optional<std::string> _errMsg;
@@ -121,10 +125,64 @@ MONGO_FP_DECLARE(skipBalanceRound);
 MONGO_FP_DECLARE(balancerRoundIntervalSetting);
 
 namespace {
+
 const Seconds kBalanceRoundDefaultInterval(10);
 const Seconds kShortBalanceRoundInterval(1);
+
+// Maximum number of chunk migrations the balancer runs at the same time. Every shard takes part in
+// at most one of them, either as donor or as recipient. Configurable with server parameter
+// "balancerMaxConcurrentMigrations".
+std::atomic<int> balancerMaxConcurrentMigrations(4);  // NOLINT
+
+class BalancerMaxConcurrentMigrations
+    : public ExportedServerParameter<int, ServerParameterType::kStartupAndRuntime> {
+public:
+    BalancerMaxConcurrentMigrations()
+        : ExportedServerParameter<int, ServerParameterType::kStartupAndRuntime>(
+              ServerParameterSet::getGlobal(),
+              "balancerMaxConcurrentMigrations",
+              &balancerMaxConcurrentMigrations) {}
+
+    virtual Status validate(const int& potentialNewValue) {
+        if (potentialNewValue < 1 || potentialNewValue > 64) {
+            return Status(ErrorCodes::BadValue,
+                          "balancerMaxConcurrentMigrations has to be >= 1 and <= 64");
+        }
+
+        return Status::OK();
+    }
+} balancerMaxConcurrentMigrationsConfig;
+
+/**
+ * Returns false if balancing was disabled since the round started, or if the balancer settings
+ * could not be read.
+ */
+bool isBalancerStillEnabled(OperationContext* txn) {
+    const auto balSettingsResult =
+        grid.catalogManager(txn)->getGlobalSettings(txn, SettingsType::BalancerDocKey);
+
+    const bool isBalSettingsAbsent =
+        balSettingsResult.getStatus() == ErrorCodes::NoMatchingDocument;
+
+    if (!balSettingsResult.isOK() && !isBalSettingsAbsent) {
+        warning() << balSettingsResult.getStatus();
+        return false;
+    }
+
+    const SettingsType& balancerConfig =
+        isBalSettingsAbsent ? SettingsType{} : balSettingsResult.getValue();
+
+    if ((!isBalSettingsAbsent && !grid.shouldBalance(balancerConfig)) ||
+        MONGO_FAIL_POINT(skipBalanceRound)) {
+        LOG(1) << "Stopping balancing round early as balancing was disabled";
+        return false;
+    }
+
+    return true;
 }
 
+}  // namespace
+
 Balancer balancer;
 
 Balancer::Balancer() : _balancedLastTime(0), _policy(new BalancerPolicy()) {}
@@ -134,120 +192,111 @@ Balancer::~Balancer() = default;
 int Balancer::_moveChunks(OperationContext* txn,
                           const vector<shared_ptr<MigrateInfo>>& candidateChunks,
                           const WriteConcernOptions* writeConcern,
-                          bool waitForDelete) {
-    int movedCount = 0;
-
-    for (const auto& migrateInfo : candidateChunks) {
-        // If the balancer was disabled since we started this round, don't start new chunks
-        // moves.
-        const auto balSettingsResult =
-            grid.catalogManager(txn)->getGlobalSettings(txn, SettingsType::BalancerDocKey);
-
-        const bool isBalSettingsAbsent =
-            balSettingsResult.getStatus() == ErrorCodes::NoMatchingDocument;
-
-        if (!balSettingsResult.isOK() && !isBalSettingsAbsent) {
-            warning() << balSettingsResult.getStatus();
-            return movedCount;
-        }
-
-        const SettingsType& balancerConfig =
-            isBalSettingsAbsent ? SettingsType{} : balSettingsResult.getValue();
-
-        if ((!isBalSettingsAbsent && !grid.shouldBalance(balancerConfig)) ||
-            MONGO_FAIL_POINT(skipBalanceRound)) {
-            LOG(1) << "Stopping balancing round early as balancing was disabled";
-            return movedCount;
-        }
+                          bool waitForDelete,
+                          int* maxConcurrentMigrations) {
+    return BalancerPolicy::runMigrations(
+        candidateChunks,
+        balancerMaxConcurrentMigrations.load(),
+        // If the balancer was disabled since we started this round, don't start new chunks moves.
+        [txn]() { return isBalancerStillEnabled(txn); },
+        [&](const MigrateInfo& migrateInfo) {
+            Client::initThread("BalancerMigration");
+            auto migrationTxn = cc().makeOperationContext();
+            return _moveChunk(migrationTxn.get(), migrateInfo, writeConcern, waitForDelete);
+        },
+        maxConcurrentMigrations);
+}
 
-        // Changes to metadata, borked metadata, and connectivity problems between shards
-        // should cause us to abort this chunk move, but shouldn't cause us to abort the entire
-        // round of chunks.
-        //
-        // TODO(spencer): We probably *should* abort the whole round on issues communicating
-        // with the config servers, but its impossible to distinguish those types of failures
-        // at the moment.
-        //
-        // TODO: Handle all these things more cleanly, since they're expected problems
+bool Balancer::_moveChunk(OperationContext* txn,
+                          const MigrateInfo& migrateInfo,
+                          const WriteConcernOptions* writeConcern,
+                          bool waitForDelete) {
+    // Changes to metadata, borked metadata, and connectivity problems between shards
+    // should cause us to abort this chunk move, but shouldn't cause us to abort the entire
+    // round of chunks.
+    //
+    // TODO(spencer): We probably *should* abort the whole round on issues communicating
+    // with the config servers, but its impossible to distinguish those types of failures
+    // at the moment.
+    //
+    // TODO: Handle all these things more cleanly, since they're expected problems
 
-        const NamespaceString nss(migrateInfo->ns);
+    const NamespaceString nss(migrateInfo.ns);
 
-        try {
-            shared_ptr<DBConfig> cfg =
-                uassertStatusOK(grid.catalogCache()->getDatabase(txn, nss.db().toString()));
+    try {
+        shared_ptr<DBConfig> cfg =
+            uassertStatusOK(grid.catalogCache()->getDatabase(txn, nss.db().toString()));
 
-            // NOTE: We purposely do not reload metadata here, since _doBalanceRound already
-            // tried to do so once.
-            shared_ptr<ChunkManager> cm = cfg->getChunkManager(txn, migrateInfo->ns);
-            uassert(28628,
-                    str::stream()
-                        << "Collection " << migrateInfo->ns
-                        << " was deleted while balancing was active. Aborting balancing round.",
-                    cm);
+        // NOTE: We purposely do not reload metadata here, since _doBalanceRound already
+        // tried to do so once.
+        shared_ptr<ChunkManager> cm = cfg->getChunkManager(txn, migrateInfo.ns);
+        uassert(28628,
+                str::stream()
+                    << "Collection " << migrateInfo.ns
+                    << " was deleted while balancing was active. Aborting balancing round.",
+                cm);
 
-            ChunkPtr c = cm->findIntersectingChunk(txn, migrateInfo->chunk.min);
+        ChunkPtr c = cm->findIntersectingChunk(txn, migrateInfo.chunk.min);
 
-            if (c->getMin().woCompare(migrateInfo->chunk.min) ||
-                c->getMax().woCompare(migrateInfo->chunk.max)) {
-                // Likely a split happened somewhere, so force reload the chunk manager
-                cm = cfg->getChunkManager(txn, migrateInfo->ns, true);
-                invariant(cm);
+        if (c->getMin().woCompare(migrateInfo.chunk.min) ||
+            c->getMax().woCompare(migrateInfo.chunk.max)) {
+            // Likely a split happened somewhere, so force reload the chunk manager
+            cm = cfg->getChunkManager(txn, migrateInfo.ns, true);
+            invariant(cm);
 
-                c = cm->findIntersectingChunk(txn, migrateInfo->chunk.min);
+            c = cm->findIntersectingChunk(txn, migrateInfo.chunk.min);
 
-                if (c->getMin().woCompare(migrateInfo->chunk.min) ||
-                    c->getMax().woCompare(migrateInfo->chunk.max)) {
-                    log() << "chunk mismatch after reload, ignoring will retry issue "
-                          << migrateInfo->chunk.toString();
+            if (c->getMin().woCompare(migrateInfo.chunk.min) ||
+                c->getMax().woCompare(migrateInfo.chunk.max)) {
+                log() << "chunk mismatch after reload, ignoring will retry issue "
+                      << migrateInfo.chunk.toString();
 
-                    continue;
-                }
+                return false;
             }
+        }
 
-            BSONObj res;
-            if (c->moveAndCommit(txn,
-                                 migrateInfo->to,
-                                 Chunk::MaxChunkSize,
-                                 writeConcern,
-                                 waitForDelete,
-                                 0, /* maxTimeMS */
-                                 res)) {
-                movedCount++;
-                continue;
-            }
+        BSONObj res;
+        if (c->moveAndCommit(txn,
+                             migrateInfo.to,
+                             Chunk::MaxChunkSize,
+                             writeConcern,
+                             waitForDelete,
+                             0, /* maxTimeMS */
+                             res)) {
+            return true;
+        }
 
-            // The move requires acquiring the collection metadata's lock, which can fail.
-            log() << "balancer move failed: " << res << " from: " << migrateInfo->from
-                  << " to: " << migrateInfo->to << " chunk: " << migrateInfo->chunk;
+        // The move requires acquiring the collection metadata's lock, which can fail.
+        log() << "balancer move failed: " << res << " from: " << migrateInfo.from
+              << " to: " << migrateInfo.to << " chunk: " << migrateInfo.chunk;
 
-            if (res["chunkTooBig"].trueValue()) {
-                // Reload just to be safe
-                cm = cfg->getChunkManager(txn, migrateInfo->ns);
-                invariant(cm);
+        if (res["chunkTooBig"].trueValue()) {
+            // Reload just to be safe
+            cm = cfg->getChunkManager(txn, migrateInfo.ns);
+            invariant(cm);
 
-                c = cm->findIntersectingChunk(txn, migrateInfo->chunk.min);
+            c = cm->findIntersectingChunk(txn, migrateInfo.chunk.min);
 
-                log() << "performing a split because migrate failed for size reasons";
+            log() << "performing a split because migrate failed for size reasons";
 
-                Status status = c->split(txn, Chunk::normal, NULL, NULL);
-                log() << "split results: " << status;
+            Status status = c->split(txn, Chunk::normal, NULL, NULL);
+            log() << "split results: " << status;
 
-                if (!status.isOK()) {
-                    log() << "marking chunk as jumbo: " << c->toString();
+            if (!status.isOK()) {
+                log() << "marking chunk as jumbo: " << c->toString();
 
-                    c->markAsJumbo(txn);
+                c->markAsJumbo(txn);
 
-                    // We increment moveCount so we do another round right away
-                    movedCount++;
-                }
+                // We count the chunk as moved so we do another round right away
+                return true;
             }
-        } catch (const DBException& ex) {
-            warning() << "could not move chunk " << migrateInfo->chunk.toString()
-                      << ", continuing balancing round" << causedBy(ex);
         }
+    } catch (const DBException& ex) {
+        warning() << "could not move chunk " << migrateInfo.chunk.toString()
+                  << ", continuing balancing round" << causedBy(ex);
     }
 
-    return movedCount;
+    return false;
 }
 
 void Balancer::_ping(OperationContext* txn, bool waiting) {
@@ -497,9 +546,17 @@ void Balancer::_doBalanceRound(OperationContext* txn,
             continue;
         }
 
-        shared_ptr<MigrateInfo> migrateInfo(
-            _policy->balance(nss.ns(), distStatus, _balancedLastTime));
-        if (migrateInfo) {
+        // Ask for as many moves as there are disjoint pairs of shards to move chunks between. The
+        // scheduler in _moveChunks takes care of migrations of different collections which
+        // involve the same shards.
+        set<ShardId> usedShards;
+        while (true) {
+            shared_ptr<MigrateInfo> migrateInfo(
+                _policy->balance(nss.ns(), distStatus, _balancedLastTime, &usedShards));
+            if (!migrateInfo) {
+                break;
+            }
+
             candidateChunks->push_back(migrateInfo);
         }
     }
@@ -642,11 +699,16 @@ void Balancer::run() {
                     LOG(1) << "no need to move any chunk";
                     _balancedLastTime = 0;
                 } else {
-                    _balancedLastTime =
-                        _moveChunks(txn.get(), candidateChunks, writeConcern.get(), waitForDelete);
+                    int maxConcurrentMigrations;
+                    _balancedLastTime = _moveChunks(txn.get(),
+                                                    candidateChunks,
+                                                    writeConcern.get(),
+                                                    waitForDelete,
+                                                    &maxConcurrentMigrations);
 
                     roundDetails.setSucceeded(static_cast<int>(candidateChunks.size()),
-                                              _balancedLastTime);
+                                              _balancedLastTime,
+                                              maxConcurrentMigrations);
 
                     grid.catalogManager(txn.get())
                         ->logAction(txn.get(), "balancer.round", "", roundDetails.toBSON());
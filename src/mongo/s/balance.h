@@ -48,7 +48,8 @@ struct WriteConcernOptions;
  *
  * The balancer does act continuously but in "rounds". At a given round, it would decide if
  * there is an imbalance by checking the difference in chunks between the most and least
- * loaded shards. It would issue a request for a chunk migration per round, if it found so.
+ * loaded shards. If it found so, it would issue requests for chunk migrations between disjoint
+ * pairs of shards, which run concurrently.
  */
 class Balancer : public BackgroundJob {
 public:
@@ -90,24 +91,41 @@ private:
      * candidate chunks to be moved.
      *
      * @param conn is the connection with the config server(s)
-     * @param candidateChunks (IN/OUT) filled with candidate chunks, one per collection, that could
-     *                          possibly be moved
+     * @param candidateChunks (IN/OUT) filled with candidate chunks that could possibly be moved.
+     *                          Within a collection, every shard is involved in at most one of them.
      */
     void _doBalanceRound(OperationContext* txn,
                          ForwardingCatalogManager::ScopedDistLock* distLock,
                          std::vector<std::shared_ptr<MigrateInfo>>* candidateChunks);
 
     /**
-     * Issues chunk migration request, one at a time.
+     * Issues the chunk migration requests. Migrations run concurrently, up to the limit set by the
+     * balancerMaxConcurrentMigrations server parameter. Every shard takes part in at most one
+     * migration at a time, either as donor or as recipient, and so does every collection, since
+     * its migrations all need its distributed lock. Candidates involving a busy shard or
+     * collection wait until its migration completes. See BalancerPolicy::runMigrations.
      *
      * @param candidateChunks possible chunks to move
      * @param writeConcern detailed write concern. NULL means the default write concern.
      * @param waitForDelete wait for deletes to complete after each chunk move
+     * @param maxConcurrentMigrations (OUT) largest number of migrations which ran at the same time
      * @return number of chunks effectively moved
      */
     int _moveChunks(OperationContext* txn,
                     const std::vector<std::shared_ptr<MigrateInfo>>& candidateChunks,
                     const WriteConcernOptions* writeConcern,
+                    bool waitForDelete,
+                    int* maxConcurrentMigrations);
+
+    /**
+     * Issues a single chunk migration request.
+     *
+     * @return true if the chunk was moved, or if it was found to be too big to move and marked as
+     *         jumbo, so that another round starts right away
+     */
+    bool _moveChunk(OperationContext* txn,
+                    const MigrateInfo& migrateInfo,
+                    const WriteConcernOptions* writeConcern,
                     bool waitForDelete);
 
     /**
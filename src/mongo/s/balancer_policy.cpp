@@ -34,6 +34,7 @@
 #include "mongo/s/balancer_policy.h"
 
 #include <algorithm>
+#include <list>
 
 #include "mongo/client/read_preference.h"
 #include "mongo/client/remote_command_targeter.h"
@@ -45,8 +46,12 @@
 #include "mongo/s/client/shard_registry.h"
 #include "mongo/s/grid.h"
 #include "mongo/s/shard_util.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/util/log.h"
 #include "mongo/util/stringutils.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -142,10 +147,20 @@ unsigned DistributionStatus::numberOfChunksInShardWithTag(const ShardId& shardId
 }
 
 string DistributionStatus::getBestReceieverShard(const string& tag) const {
+    return getBestReceieverShard(tag, set<ShardId>());
+}
+
+string DistributionStatus::getBestReceieverShard(const string& tag,
+                                                 const set<ShardId>& excludedShards) const {
     string best;
     unsigned minChunks = numeric_limits<unsigned>::max();
 
     for (ShardInfoMap::const_iterator i = _shardInfo.begin(); i != _shardInfo.end(); ++i) {
+        if (excludedShards.count(i->first)) {
+            LOG(1) << i->first << " is already involved in a migration.";
+            continue;
+        }
+
         if (i->second.isSizeMaxed()) {
             LOG(1) << i->first << " has already reached the maximum total chunk size.";
             continue;
@@ -176,10 +191,18 @@ string DistributionStatus::getBestReceieverShard(const string& tag) const {
 }
 
 string DistributionStatus::getMostOverloadedShard(const string& tag) const {
+    return getMostOverloadedShard(tag, set<ShardId>());
+}
+
+string DistributionStatus::getMostOverloadedShard(const string& tag,
+                                                  const set<ShardId>& excludedShards) const {
     string worst;
     unsigned maxChunks = 0;
 
     for (ShardInfoMap::const_iterator i = _shardInfo.begin(); i != _shardInfo.end(); ++i) {
+        if (excludedShards.count(i->first))
+            continue;
+
         unsigned myChunks = numberOfChunksInShardWithTag(i->first, tag);
         if (myChunks <= maxChunks)
             continue;
@@ -315,10 +338,7 @@ void DistributionStatus::populateShardToChunksMap(const ShardInfoMap& allShards,
         (*shardToChunksMap)[it->first];
     }
 
-    const ChunkMap& chunkMap = chunkMgr.getChunkMap();
-    for (ChunkMap::const_iterator it = chunkMap.begin(); it != chunkMap.end(); ++it) {
-        const ChunkPtr chunkPtr = it->second;
-
+    for (const ChunkPtr& chunkPtr : chunkMgr.getChunks()) {
         ChunkType chunk;
         chunk.setNS(chunkMgr.getns());
         chunk.setMin(chunkPtr->getMin().getOwned());
@@ -335,6 +355,22 @@ void DistributionStatus::populateShardToChunksMap(const ShardInfoMap& allShards,
 MigrateInfo* BalancerPolicy::balance(const string& ns,
                                      const DistributionStatus& distribution,
                                      int balancedLastTime) {
+    set<ShardId> usedShards;
+    return balance(ns, distribution, balancedLastTime, &usedShards);
+}
+
+MigrateInfo* BalancerPolicy::balance(const string& ns,
+                                     const DistributionStatus& distribution,
+                                     int balancedLastTime,
+                                     set<ShardId>* usedShards) {
+    invariant(usedShards);
+
+    auto makeMigration = [&](const ShardId& to, const ShardId& from, const ChunkType& chunk) {
+        usedShards->insert(to);
+        usedShards->insert(from);
+        return new MigrateInfo(ns, to, from, chunk.toBSON());
+    };
+
     // 1) check for shards that policy require to us to move off of:
     //    draining only
     // 2) check tag policy violations
@@ -353,6 +389,9 @@ MigrateInfo* BalancerPolicy::balance(const string& ns,
             if (distribution.numberOfChunksInShard(shardId) == 0)
                 continue;
 
+            if (usedShards->count(shardId))
+                continue;
+
             // now we know we need to move to chunks off this shard
             // we will if we are allowed
             const vector<ChunkType>& chunks = distribution.getChunks(shardId);
@@ -367,7 +406,7 @@ MigrateInfo* BalancerPolicy::balance(const string& ns,
                 }
 
                 string tag = distribution.getTagForChunk(chunkToMove);
-                const ShardId to = distribution.getBestReceieverShard(tag);
+                const ShardId to = distribution.getBestReceieverShard(tag, *usedShards);
 
                 if (to.size() == 0) {
                     warning() << "want to move chunk: " << chunkToMove << "(" << tag << ") "
@@ -378,7 +417,7 @@ MigrateInfo* BalancerPolicy::balance(const string& ns,
                 log() << "going to move " << chunkToMove << " from " << shardId << "(" << tag << ")"
                       << " to " << to;
 
-                return new MigrateInfo(ns, to, shardId, chunkToMove.toBSON());
+                return makeMigration(to, shardId, chunkToMove);
             }
 
             warning() << "can't find any chunk to move from: " << shardId << " but we want to. "
@@ -391,6 +430,9 @@ MigrateInfo* BalancerPolicy::balance(const string& ns,
         for (const ShardId& shardId : distribution.shardIds()) {
             const ShardInfo& info = distribution.shardInfo(shardId);
 
+            if (usedShards->count(shardId))
+                continue;
+
             const vector<ChunkType>& chunks = distribution.getChunks(shardId);
             for (unsigned j = 0; j < chunks.size(); j++) {
                 const ChunkType& chunk = chunks[j];
@@ -407,14 +449,14 @@ MigrateInfo* BalancerPolicy::balance(const string& ns,
                     continue;
                 }
 
-                const ShardId to = distribution.getBestReceieverShard(tag);
+                const ShardId to = distribution.getBestReceieverShard(tag, *usedShards);
                 if (to.size() == 0) {
                     log() << "no where to put it :(";
                     continue;
                 }
                 verify(to != shardId);
                 log() << " going to move to: " << to;
-                return new MigrateInfo(ns, to, shardId, chunk.toBSON());
+                return makeMigration(to, shardId, chunk);
             }
         }
     }
@@ -442,7 +484,7 @@ MigrateInfo* BalancerPolicy::balance(const string& ns,
     for (unsigned i = 0; i < tags.size(); i++) {
         string tag = tags[i];
 
-        const ShardId from = distribution.getMostOverloadedShard(tag);
+        const ShardId from = distribution.getMostOverloadedShard(tag, *usedShards);
         if (from.size() == 0)
             continue;
 
@@ -450,7 +492,7 @@ MigrateInfo* BalancerPolicy::balance(const string& ns,
         if (max == 0)
             continue;
 
-        string to = distribution.getBestReceieverShard(tag);
+        string to = distribution.getBestReceieverShard(tag, *usedShards);
         if (to.size() == 0) {
             log() << "no available shards to take chunks for tag [" << tag << "]";
             return NULL;
@@ -482,7 +524,7 @@ MigrateInfo* BalancerPolicy::balance(const string& ns,
 
             log() << " ns: " << ns << " going to move " << chunk << " from: " << from
                   << " to: " << to << " tag [" << tag << "]";
-            return new MigrateInfo(ns, to, from, chunk.toBSON());
+            return makeMigration(to, from, chunk);
         }
 
         if (numJumboChunks) {
@@ -552,4 +594,106 @@ string ChunkInfo::toString() const {
     return buf.str();
 }
 
+int BalancerPolicy::runMigrations(const vector<std::shared_ptr<MigrateInfo>>& candidates,
+                                  size_t maxInProgress,
+                                  const stdx::function<bool()>& shouldContinue,
+                                  const stdx::function<bool(const MigrateInfo&)>& moveChunk,
+                                  int* maxConcurrentMigrations) {
+    // Protects all the scheduling state below, which is shared with the migration threads
+    stdx::mutex mutex;
+    stdx::condition_variable migrationDoneCV;
+
+    std::list<std::shared_ptr<MigrateInfo>> pending(candidates.begin(), candidates.end());
+    set<ShardId> busyShards;
+    set<string> busyNamespaces;
+    size_t numInProgress = 0;
+    size_t numDone = 0;
+    int movedCount = 0;
+
+    vector<stdx::thread> migrationThreads;
+    const Timer roundTimer;
+
+    *maxConcurrentMigrations = 0;
+
+    stdx::unique_lock<stdx::mutex> lk(mutex);
+
+    bool stopScheduling = false;
+    while (!pending.empty() && !stopScheduling) {
+        // Start every pending migration whose shards and collection are idle, in the order in
+        // which they were suggested, up to the limit on concurrent migrations
+        for (auto it = pending.begin(); it != pending.end() && numInProgress < maxInProgress;) {
+            const std::shared_ptr<MigrateInfo> migrateInfo = *it;
+            if (busyShards.count(migrateInfo->from) || busyShards.count(migrateInfo->to) ||
+                busyNamespaces.count(migrateInfo->ns)) {
+                ++it;
+                continue;
+            }
+
+            lk.unlock();
+            const bool keepGoing = shouldContinue();
+            lk.lock();
+
+            if (!keepGoing) {
+                stopScheduling = true;
+                break;
+            }
+
+            it = pending.erase(it);
+            busyShards.insert(migrateInfo->from);
+            busyShards.insert(migrateInfo->to);
+            busyNamespaces.insert(migrateInfo->ns);
+            numInProgress++;
+            *maxConcurrentMigrations =
+                std::max(*maxConcurrentMigrations, static_cast<int>(numInProgress));
+
+            migrationThreads.emplace_back([&, migrateInfo]() {
+                bool moved = false;
+                try {
+                    moved = moveChunk(*migrateInfo);
+                } catch (const std::exception& e) {
+                    warning() << "could not move chunk " << migrateInfo->chunk.toString()
+                              << ", continuing balancing round" << causedBy(e.what());
+                }
+
+                stdx::lock_guard<stdx::mutex> migrationLock(mutex);
+                busyShards.erase(migrateInfo->from);
+                busyShards.erase(migrateInfo->to);
+                busyNamespaces.erase(migrateInfo->ns);
+                numInProgress--;
+                numDone++;
+                if (moved) {
+                    movedCount++;
+                }
+
+                LOG(1) << "balancer migration of " << migrateInfo->ns << " from "
+                       << migrateInfo->from << " to " << migrateInfo->to
+                       << (moved ? " finished" : " failed") << ", " << numDone << " of "
+                       << candidates.size() << " done, " << numInProgress << " in progress, "
+                       << movedCount << " chunks moved in " << roundTimer.seconds() << "s";
+
+                migrationDoneCV.notify_all();
+            });
+        }
+
+        if (pending.empty() || stopScheduling) {
+            break;
+        }
+
+        // All the remaining migrations involve a busy shard or collection, or the limit is
+        // reached, so wait for one of the migrations in progress to complete
+        invariant(numInProgress > 0);
+        const size_t numDoneBefore = numDone;
+        migrationDoneCV.wait(lk, [&] { return numDone != numDoneBefore; });
+    }
+
+    migrationDoneCV.wait(lk, [&] { return numInProgress == 0; });
+    lk.unlock();
+
+    for (auto& migrationThread : migrationThreads) {
+        migrationThread.join();
+    }
+
+    return movedCount;
+}
+
 }  // namespace mongo
@@ -34,6 +34,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/s/catalog/type_chunk.h"
 #include "mongo/s/client/shard.h"
+#include "mongo/stdx/functional.h"
 
 namespace mongo {
 
@@ -156,12 +157,24 @@ public:
      */
     std::string getBestReceieverShard(const std::string& forTag) const;
 
+    /**
+     * Same as above, but never returns any of the shards in excludedShards.
+     */
+    std::string getBestReceieverShard(const std::string& forTag,
+                                      const std::set<ShardId>& excludedShards) const;
+
     /**
      * @return the shard with the most chunks
      *         based on # of chunks with the given tag
      */
     std::string getMostOverloadedShard(const std::string& forTag) const;
 
+    /**
+     * Same as above, but never returns any of the shards in excludedShards.
+     */
+    std::string getMostOverloadedShard(const std::string& forTag,
+                                       const std::set<ShardId>& excludedShards) const;
+
 
     // ---- basic accessors, counters, etc...
 
@@ -234,6 +247,38 @@ public:
     static MigrateInfo* balance(const std::string& ns,
                                 const DistributionStatus& distribution,
                                 int balancedLastTime);
+
+    /**
+     * Same as above, but only suggests moves between shards which are not in usedShards, so that
+     * the resulting migrations can run concurrently. If a move is returned, its donor and
+     * recipient shards are added to usedShards.
+     *
+     * Calling this repeatedly with the same usedShards yields a set of migrations in which every
+     * shard is involved at most once, either as a donor or as a recipient.
+     */
+    static MigrateInfo* balance(const std::string& ns,
+                                const DistributionStatus& distribution,
+                                int balancedLastTime,
+                                std::set<ShardId>* usedShards);
+
+    /**
+     * Calls 'moveChunk' for each of 'candidates', every call on its own thread, with at most
+     * 'maxInProgress' of them running at the same time. A migration only starts once neither its
+     * donor, nor its recipient, nor its collection takes part in another migration in progress.
+     * Migrations of the same collection all need the collection's distributed lock, so running
+     * them together would only make all but one of them fail.
+     *
+     * 'shouldContinue' is called before starting each migration. Once it returns false, no more
+     * migrations are started and the ones in progress are waited for.
+     *
+     * @param maxConcurrentMigrations (OUT) largest number of migrations which ran at the same time
+     * @return number of calls to 'moveChunk' which returned true
+     */
+    static int runMigrations(const std::vector<std::shared_ptr<MigrateInfo>>& candidates,
+                             size_t maxInProgress,
+                             const stdx::function<bool()>& shouldContinue,
+                             const stdx::function<bool(const MigrateInfo&)>& moveChunk,
+                             int* maxConcurrentMigrations);
 };
 
 }  // namespace mongo
@@ -32,8 +32,10 @@
 #include "mongo/s/balancer_policy.h"
 #include "mongo/s/catalog/type_chunk.h"
 #include "mongo/s/config.h"
+#include "mongo/stdx/mutex.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/log.h"
+#include "mongo/util/time_support.h"
 
 namespace {
 
@@ -309,6 +311,133 @@ TEST(BalancerPolicyTests, MultipleDraining) {
     ASSERT_EQUALS("shard2", m->to);
 }
 
+TEST(BalancerPolicyTests, ConcurrentMovesUseDisjointShards) {
+    ShardToChunksMap chunks;
+    addShard(chunks, 20, false);
+    addShard(chunks, 20, false);
+    addShard(chunks, 0, false);
+    addShard(chunks, 0, true);
+
+    ShardInfoMap shards;
+    shards["shard0"] = ShardInfo(0, 20, false);
+    shards["shard1"] = ShardInfo(0, 20, false);
+    shards["shard2"] = ShardInfo(0, 0, false);
+    shards["shard3"] = ShardInfo(0, 0, false);
+
+    DistributionStatus d(shards, chunks);
+    std::set<ShardId> usedShards;
+
+    std::unique_ptr<MigrateInfo> first(BalancerPolicy::balance("ns", d, 0, &usedShards));
+    ASSERT(first);
+    ASSERT_EQUALS(2U, usedShards.size());
+
+    std::unique_ptr<MigrateInfo> second(BalancerPolicy::balance("ns", d, 0, &usedShards));
+    ASSERT(second);
+    ASSERT_EQUALS(4U, usedShards.size());
+
+    ASSERT_NOT_EQUALS(first->from, second->from);
+    ASSERT_NOT_EQUALS(first->to, second->to);
+    ASSERT(second->from == "shard0" || second->from == "shard1");
+    ASSERT(second->to == "shard2" || second->to == "shard3");
+
+    // Every shard is in use, so nothing else can be moved concurrently
+    std::unique_ptr<MigrateInfo> third(BalancerPolicy::balance("ns", d, 0, &usedShards));
+    ASSERT(!third);
+}
+
+TEST(BalancerPolicyTests, ConcurrentMovesSkipUsedDrainingShard) {
+    ShardToChunksMap chunks;
+    addShard(chunks, 5, false);
+    addShard(chunks, 5, false);
+    addShard(chunks, 5, true);
+
+    ShardInfoMap shards;
+    shards["shard0"] = ShardInfo(0, 5, true);
+    shards["shard1"] = ShardInfo(0, 5, false);
+    shards["shard2"] = ShardInfo(0, 5, false);
+
+    DistributionStatus d(shards, chunks);
+    std::set<ShardId> usedShards;
+
+    std::unique_ptr<MigrateInfo> m(BalancerPolicy::balance("ns", d, 0, &usedShards));
+    ASSERT(m);
+    ASSERT_EQUALS("shard0", m->from);
+
+    // The draining shard already has a migration, and the remaining shard is balanced against
+    // nothing, so there is nothing left to do this round
+    m.reset(BalancerPolicy::balance("ns", d, 0, &usedShards));
+    ASSERT(!m);
+}
+
+
+std::shared_ptr<MigrateInfo> makeMigrateInfo(const string& ns,
+                                             const ShardId& from,
+                                             const ShardId& to) {
+    return std::make_shared<MigrateInfo>(
+        ns, to, from, BSON("min" << BSON("x" << 0) << "max" << BSON("x" << 10)));
+}
+
+TEST(BalancerPolicyTests, RunMigrationsSerializesMovesOfTheSameCollection) {
+    // The first two moves use disjoint shards, but need the distributed lock of the same collection
+    vector<std::shared_ptr<MigrateInfo>> candidates;
+    candidates.push_back(makeMigrateInfo("test.a", "shard0", "shard2"));
+    candidates.push_back(makeMigrateInfo("test.a", "shard1", "shard3"));
+    candidates.push_back(makeMigrateInfo("test.b", "shard4", "shard5"));
+
+    stdx::mutex mutex;
+    map<string, int> inProgress;
+    map<string, int> maxInProgress;
+    vector<ShardId> donors;
+
+    int maxConcurrentMigrations = 0;
+    const int moved = BalancerPolicy::runMigrations(
+        candidates,
+        4,
+        []() { return true; },
+        [&](const MigrateInfo& migrateInfo) {
+            {
+                stdx::lock_guard<stdx::mutex> lk(mutex);
+                const int n = ++inProgress[migrateInfo.ns];
+                maxInProgress[migrateInfo.ns] = std::max(maxInProgress[migrateInfo.ns], n);
+                donors.push_back(migrateInfo.from);
+            }
+
+            sleepmillis(20);
+
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            inProgress[migrateInfo.ns]--;
+            return true;
+        },
+        &maxConcurrentMigrations);
+
+    ASSERT_EQUALS(3, moved);
+    ASSERT_EQUALS(1, maxInProgress["test.a"]);
+    ASSERT_EQUALS(1, maxInProgress["test.b"]);
+    ASSERT_EQUALS(2, maxConcurrentMigrations);
+
+    // Moves of the same collection still run in the order in which they were suggested
+    ASSERT_EQUALS(3U, donors.size());
+    ASSERT_EQUALS(ShardId("shard1"), donors.back());
+}
+
+TEST(BalancerPolicyTests, RunMigrationsStopsWhenToldTo) {
+    vector<std::shared_ptr<MigrateInfo>> candidates;
+    candidates.push_back(makeMigrateInfo("test.a", "shard0", "shard1"));
+    candidates.push_back(makeMigrateInfo("test.a", "shard0", "shard2"));
+
+    int checks = 0;
+    int maxConcurrentMigrations = 0;
+    const int moved = BalancerPolicy::runMigrations(
+        candidates,
+        4,
+        [&]() { return ++checks == 1; },
+        [](const MigrateInfo& migrateInfo) { return true; },
+        &maxConcurrentMigrations);
+
+    ASSERT_EQUALS(1, moved);
+    ASSERT_EQUALS(2, checks);
+    ASSERT_EQUALS(1, maxConcurrentMigrations);
+}
 
 TEST(BalancerPolicyTests, TagsDraining) {
     ShardToChunksMap chunks;
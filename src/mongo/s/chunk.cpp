@@ -161,7 +161,9 @@ int Chunk::MaxObjectPerChunk = 250000;
 bool Chunk::ShouldAutoSplit = true;
 
 Chunk::Chunk(OperationContext* txn, const ChunkManager* manager, const ChunkType& from)
-    : _manager(manager), _lastmod(0, 0, OID()), _dataWritten(mkDataWritten()) {
+    : _manager(manager),
+      _lastmod(0, 0, OID()),
+      _dataWritten(std::make_shared<long long>(mkDataWritten())) {
     string ns = from.getNS();
     _shardId = from.getShard();
 
@@ -191,7 +193,22 @@ Chunk::Chunk(const ChunkManager* info,
       _shardId(shardId),
       _lastmod(lastmod),
       _jumbo(false),
-      _dataWritten(mkDataWritten()) {}
+      _dataWritten(std::make_shared<long long>(mkDataWritten())) {}
+
+Chunk::Chunk(const ChunkManager* info,
+             const BSONObj& min,
+             const BSONObj& max,
+             const ShardId& shardId,
+             ChunkVersion lastmod,
+             bool jumbo,
+             std::shared_ptr<long long> dataWritten)
+    : _manager(info),
+      _min(min),
+      _max(max),
+      _shardId(shardId),
+      _lastmod(lastmod),
+      _jumbo(jumbo),
+      _dataWritten(std::move(dataWritten)) {}
 
 int Chunk::mkDataWritten() {
     PseudoRandom r(static_cast<int64_t>(time(0)));
@@ -202,11 +219,6 @@ bool Chunk::containsKey(const BSONObj& shardKey) const {
     return getMin().woCompare(shardKey) <= 0 && shardKey.woCompare(getMax()) < 0;
 }
 
-bool ChunkRange::containsKey(const BSONObj& shardKey) const {
-    // same as Chunk method
-    return getMin().woCompare(shardKey) <= 0 && shardKey.woCompare(getMax()) < 0;
-}
-
 bool Chunk::_minIsInf() const {
     return 0 == _manager->getShardKeyPattern().getKeyPattern().globalMin().woCompare(getMin());
 }
@@ -341,13 +353,13 @@ void Chunk::determineSplitPoints(OperationContext* txn,
         long long chunkSize = _manager->getCurrentDesiredChunkSize();
 
         // Note: One split point for every 1/2 chunk size.
-        const int estNumSplitPoints = _dataWritten / chunkSize * 2;
+        const int estNumSplitPoints = *_dataWritten / chunkSize * 2;
         if (estNumSplitPoints >= kTooManySplitPoints) {
             // The current desired chunk size will split the chunk into lots of small chunks
             // (At the worst case, this can result into thousands of chunks); so check and
             // see if a bigger value can be used.
 
-            chunkSize = std::min(_dataWritten, Chunk::MaxChunkSize);
+            chunkSize = std::min(*_dataWritten, Chunk::MaxChunkSize);
         }
 
         pickSplitVector(txn, *splitPoints, chunkSize, 0, MaxObjectPerChunk);
@@ -537,13 +549,13 @@ bool Chunk::splitIfShould(OperationContext* txn, long dataWritten) const {
     LastError::Disabled d(&LastError::get(cc()));
 
     try {
-        _dataWritten += dataWritten;
+        *_dataWritten += dataWritten;
         int splitThreshold = getManager()->getCurrentDesiredChunkSize();
         if (_minIsInf() || _maxIsInf()) {
             splitThreshold = (int)((double)splitThreshold * .9);
         }
 
-        if (_dataWritten < splitThreshold / ChunkManager::SplitHeuristics::splitTestFactor)
+        if (*_dataWritten < splitThreshold / ChunkManager::SplitHeuristics::splitTestFactor)
             return false;
 
         if (!getManager()->_splitHeuristics._splitTickets.tryAcquire()) {
@@ -566,7 +578,7 @@ bool Chunk::splitIfShould(OperationContext* txn, long dataWritten) const {
             return false;
         }
 
-        LOG(1) << "about to initiate autosplit: " << *this << " dataWritten: " << _dataWritten
+        LOG(1) << "about to initiate autosplit: " << *this << " dataWritten: " << *_dataWritten
                << " splitThreshold: " << splitThreshold;
 
         BSONObj res;
@@ -575,7 +587,7 @@ bool Chunk::splitIfShould(OperationContext* txn, long dataWritten) const {
         if (!status.isOK()) {
             // Split would have issued a message if we got here. This means there wasn't enough
             // data to split, so don't want to try again until considerable more data
-            _dataWritten = 0;
+            *_dataWritten = 0;
             return false;
         }
 
@@ -584,7 +596,7 @@ bool Chunk::splitIfShould(OperationContext* txn, long dataWritten) const {
             // right away
         } else {
             // we're splitting, so should wait a bit
-            _dataWritten = 0;
+            *_dataWritten = 0;
         }
 
         bool shouldBalance = grid.getConfigShouldBalance(txn);
@@ -627,7 +639,7 @@ bool Chunk::splitIfShould(OperationContext* txn, long dataWritten) const {
     } catch (DBException& e) {
         // TODO: Make this better - there are lots of reasons a split could fail
         // Random so that we don't sync up with other failed splits
-        _dataWritten = mkDataWritten();
+        *_dataWritten = mkDataWritten();
 
         // if the collection lock is taken (e.g. we're migrating), it is fine for the split to fail.
         warning() << "could not autosplit collection " << _manager->getns() << causedBy(e);
@@ -70,6 +70,18 @@ public:
           const ShardId& shardId,
           ChunkVersion lastmod = ChunkVersion());
 
+    /**
+     * Creates a chunk whose bytes written counter is 'dataWritten', which lets the chunks of
+     * successive chunk managers for the same range keep a single count.
+     */
+    Chunk(const ChunkManager* info,
+          const BSONObj& min,
+          const BSONObj& max,
+          const ShardId& shardId,
+          ChunkVersion lastmod,
+          bool jumbo,
+          std::shared_ptr<long long> dataWritten);
+
     //
     // chunk boundary support
     //
@@ -108,12 +120,12 @@ public:
     //
 
     long long getBytesWritten() const {
-        return _dataWritten;
+        return *_dataWritten;
     }
-    // Const since _dataWritten is mutable and a heuristic
+    // Const since _dataWritten is a heuristic
     // TODO: Split data tracking and chunk information
     void setBytesWritten(long long bytesWritten) const {
-        _dataWritten = bytesWritten;
+        *_dataWritten = bytesWritten;
     }
 
     /**
@@ -267,7 +279,8 @@ private:
 
     // transient stuff
 
-    mutable long long _dataWritten;
+    // May be shared with the routing table of the manager, see ChunkRoutingTable::bytesWrittenAt
+    const std::shared_ptr<long long> _dataWritten;
 
     // methods, etc..
 
@@ -32,7 +32,6 @@
 
 #include "mongo/s/chunk_manager.h"
 
-#include <boost/next_prior.hpp>
 #include <map>
 #include <set>
 
@@ -71,6 +70,16 @@ using std::vector;
 
 namespace {
 
+// Queries larger than this are not cached by getShardIdsForQuery, since they are unlikely to be
+// repeated verbatim and would take up a lot of space
+const int kMaxCachedQuerySize = 1024;
+
+// Maximum number of queries cached per ChunkManager. The cache is emptied when it fills up.
+const size_t kMaxCachedQueries = 1024;
+
+// The key for the map is max for each Chunk
+typedef map<BSONObj, shared_ptr<Chunk>, BSONObjCmp> ChunkMap;
+
 /**
  * This is an adapter so we can use config diffs - mongos and mongod do them slightly
  * differently
@@ -79,7 +88,7 @@ namespace {
  */
 class CMConfigDiffTracker : public ConfigDiffTracker<shared_ptr<Chunk>> {
 public:
-    CMConfigDiffTracker(ChunkManager* manager) : _manager(manager) {}
+    explicit CMConfigDiffTracker(ChunkManager* manager) : _manager(manager) {}
 
     bool isTracked(const ChunkType& chunk) const final {
         // Mongos tracks all shards
@@ -116,7 +125,14 @@ bool allOfType(BSONType type, const BSONObj& o) {
     return true;
 }
 
-bool isChunkMapValid(const ChunkMap& chunkMap) {
+/**
+ * Checks that 'routingTable', to which 'changes' were just applied, covers the whole key space
+ * without gaps or overlaps. Every chunk which was not changed was already checked when it was
+ * loaded, so only the neighbourhood of each change needs to be, which keeps a refresh in
+ * O(K log N) for K changes instead of O(N).
+ */
+bool isRoutingTableValid(const ChunkRoutingTable& routingTable,
+                         const vector<ChunkRoutingTable::Change>& changes) {
 #define ENSURE(x)                                          \
     do {                                                   \
         if (!(x)) {                                        \
@@ -125,28 +141,32 @@ bool isChunkMapValid(const ChunkMap& chunkMap) {
         }                                                  \
     } while (0)
 
-    if (chunkMap.empty()) {
+    if (routingTable.empty()) {
         return true;
     }
 
     // Check endpoints
-    ENSURE(allOfType(MinKey, chunkMap.begin()->second->getMin()));
-    ENSURE(allOfType(MaxKey, boost::prior(chunkMap.end())->second->getMax()));
-
-    // Make sure there are no gaps or overlaps
-    for (ChunkMap::const_iterator it = boost::next(chunkMap.begin()), end = chunkMap.end();
-         it != end;
-         ++it) {
-        ChunkMap::const_iterator last = boost::prior(it);
-
-        if (!(it->second->getMin() == last->second->getMax())) {
-            log() << last->second->toString();
-            log() << it->second->toString();
-            log() << it->second->getMin();
-            log() << last->second->getMax();
+    ENSURE(allOfType(MinKey, routingTable.minAt(0)));
+    ENSURE(allOfType(MaxKey, routingTable.maxAt(routingTable.size() - 1)));
+
+    // Make sure there are no gaps or overlaps around the changed chunks
+    for (const auto& change : changes) {
+        const size_t i = routingTable.upperBound(change.min);
+        ENSURE(i < routingTable.size() && routingTable.maxAt(i) == change.max);
+
+        if (i > 0 && !(routingTable.maxAt(i - 1) == change.min)) {
+            log() << routingTable.maxAt(i - 1);
+            log() << change.min;
+        }
+
+        ENSURE(i == 0 || routingTable.maxAt(i - 1) == change.min);
+
+        if (i + 1 < routingTable.size() && !(routingTable.minAt(i + 1) == change.max)) {
+            log() << change.max;
+            log() << routingTable.minAt(i + 1);
         }
 
-        ENSURE(it->second->getMin() == last->second->getMax());
+        ENSURE(i + 1 == routingTable.size() || routingTable.minAt(i + 1) == change.max);
     }
 
     return true;
@@ -162,15 +182,13 @@ ChunkManager::ChunkManager(const string& ns, const ShardKeyPattern& pattern, boo
     : _ns(ns),
       _keyPattern(pattern.getKeyPattern()),
       _unique(unique),
-      _sequenceNumber(NextSequenceNumber.addAndFetch(1)),
-      _chunkRanges() {}
+      _sequenceNumber(NextSequenceNumber.addAndFetch(1)) {}
 
 ChunkManager::ChunkManager(const CollectionType& coll)
     : _ns(coll.getNs().ns()),
       _keyPattern(coll.getKeyPattern()),
       _unique(coll.getUnique()),
-      _sequenceNumber(NextSequenceNumber.addAndFetch(1)),
-      _chunkRanges() {
+      _sequenceNumber(NextSequenceNumber.addAndFetch(1)) {
     // coll does not have correct version. Use same initial version as _load and createFirstChunks.
     _version = ChunkVersion(0, 0, coll.getEpoch());
 }
@@ -179,13 +197,14 @@ void ChunkManager::loadExistingRanges(OperationContext* txn, const ChunkManager*
     int tries = 3;
 
     while (tries--) {
-        ChunkMap chunkMap;
+        shared_ptr<const ChunkRoutingTable> routingTable;
+        vector<ChunkRoutingTable::Change> changes;
         set<ShardId> shardIds;
         ShardVersionMap shardVersions;
 
         Timer t;
 
-        bool success = _load(txn, chunkMap, shardIds, &shardVersions, oldManager);
+        bool success = _load(txn, &routingTable, &changes, shardIds, &shardVersions, oldManager);
         if (success) {
             log() << "ChunkManager: time to load chunks for " << _ns << ": " << t.millis() << "ms"
                   << " sequenceNumber: " << _sequenceNumber << " version: " << _version.toString()
@@ -193,17 +212,16 @@ void ChunkManager::loadExistingRanges(OperationContext* txn, const ChunkManager*
                   << (oldManager ? oldManager->getVersion().toString() : "(empty)");
 
             // TODO: Merge into diff code above, so we validate in one place
-            if (isChunkMapValid(chunkMap)) {
-                _chunkMap.swap(chunkMap);
+            if (isRoutingTableValid(*routingTable, changes)) {
+                _setRoutingTable(std::move(routingTable));
                 _shardIds.swap(shardIds);
                 _shardVersions.swap(shardVersions);
-                _chunkRanges.reloadAll(_chunkMap);
 
                 return;
             }
         }
 
-        if (_chunkMap.size() < 10) {
+        if (numChunks() < 10) {
             _printChunks();
         }
 
@@ -219,46 +237,40 @@ void ChunkManager::loadExistingRanges(OperationContext* txn, const ChunkManager*
 }
 
 bool ChunkManager::_load(OperationContext* txn,
-                         ChunkMap& chunkMap,
+                         shared_ptr<const ChunkRoutingTable>* routingTable,
+                         vector<ChunkRoutingTable::Change>* changes,
                          set<ShardId>& shardIds,
                          ShardVersionMap* shardVersions,
                          const ChunkManager* oldManager) {
     // Reset the max version, but not the epoch, when we aren't loading from the oldManager
     _version = ChunkVersion(0, 0, _version.epoch());
 
+    // Chunks are loaded on top of an empty table, unless there is an old manager to work from
+    shared_ptr<const ChunkRoutingTable> baseRoutingTable = ChunkRoutingTable::Builder().done();
+
     // If we have a previous version of the ChunkManager to work from, use that info to reduce
     // our config query
-    if (oldManager && oldManager->getVersion().isSet()) {
+    if (oldManager && oldManager->getVersion().isSet() && oldManager->_routingTable) {
         // Get the old max version
         _version = oldManager->getVersion();
 
         // Load a copy of the old versions
         *shardVersions = oldManager->_shardVersions;
 
-        // Load a copy of the chunk map, replacing the chunk manager with our own
-        const ChunkMap& oldChunkMap = oldManager->getChunkMap();
-
-        // Could be v.expensive
-        // TODO: If chunks were immutable and didn't reference the manager, we could do more
-        // interesting things here
-        for (const auto& oldChunkMapEntry : oldChunkMap) {
-            shared_ptr<Chunk> oldC = oldChunkMapEntry.second;
-            shared_ptr<Chunk> newC(new Chunk(
-                this, oldC->getMin(), oldC->getMax(), oldC->getShardId(), oldC->getLastmod()));
-
-            newC->setBytesWritten(oldC->getBytesWritten());
-
-            chunkMap.insert(make_pair(oldC->getMax(), newC));
-        }
+        // The routing table is immutable and does not reference the manager, so it is shared
+        // rather than copied and only the chunks which changed are applied to it
+        baseRoutingTable = oldManager->_routingTable;
 
         LOG(2) << "loading chunk manager for collection " << _ns
                << " using old chunk manager w/ version " << _version.toString() << " and "
-               << oldChunkMap.size() << " chunks";
+               << baseRoutingTable->size() << " chunks";
     }
 
-    // Attach a diff tracker for the versioned chunk data
+    // Attach a diff tracker for the versioned chunk data. It starts from an empty map, so that
+    // it only ends up holding the chunks which changed.
+    ChunkMap changedChunks;
     CMConfigDiffTracker differ(this);
-    differ.attach(_ns, chunkMap, _version, *shardVersions);
+    differ.attach(_ns, changedChunks, _version, *shardVersions);
 
     // Diff tracker should *always* find at least one chunk if collection exists
     // Get the diff query required
@@ -290,6 +302,26 @@ bool ChunkManager::_load(OperationContext* txn,
 
         _configOpTime = opTime;
 
+        for (const auto& entry : changedChunks) {
+            const Chunk& c = *entry.second;
+            changes->emplace_back(c.getMin(),
+                                  c.getMax(),
+                                  c.getShardId(),
+                                  c.getLastmod(),
+                                  c.isJumbo(),
+                                  c.getBytesWritten());
+        }
+
+        // Fails if the changes overlap each other, which the diff tracker already checks for
+        *routingTable = baseRoutingTable->makeUpdated(*changes);
+        if (!*routingTable) {
+            return false;
+        }
+
+        LOG(2) << "applied " << changes->size() << " chunk changes to the routing table of "
+               << _ns << ", reusing " << (*routingTable)->numLeavesSharedWith(*baseRoutingTable)
+               << " of " << (*routingTable)->numLeaves() << " leaves";
+
         return true;
     } else if (diffsApplied == 0) {
         // No chunks were found for the ns
@@ -297,7 +329,7 @@ bool ChunkManager::_load(OperationContext* txn,
                   << _version;
 
         // Set all our data to empty
-        chunkMap.clear();
+        *routingTable = ChunkRoutingTable::Builder().done();
         shardVersions->clear();
 
         _version = ChunkVersion(0, 0, OID());
@@ -319,7 +351,7 @@ bool ChunkManager::_load(OperationContext* txn,
         }
 
         // Set all our data to empty to be extra safe
-        chunkMap.clear();
+        *routingTable = ChunkRoutingTable::Builder().done();
         shardVersions->clear();
 
         _version = ChunkVersion(0, 0, OID());
@@ -336,8 +368,8 @@ shared_ptr<ChunkManager> ChunkManager::reload(OperationContext* txn, bool force)
 }
 
 void ChunkManager::_printChunks() const {
-    for (ChunkMap::const_iterator it = _chunkMap.begin(), end = _chunkMap.end(); it != end; ++it) {
-        log() << *it->second;
+    for (const auto& chunk : getChunks()) {
+        log() << *chunk;
     }
 }
 
@@ -347,7 +379,7 @@ void ChunkManager::calcInitSplitsAndShards(OperationContext* txn,
                                            const set<ShardId>* initShardIds,
                                            vector<BSONObj>* splitPoints,
                                            vector<ShardId>* shardIds) const {
-    verify(_chunkMap.size() == 0);
+    verify(numChunks() == 0);
 
     Chunk c(this,
             _keyPattern.getKeyPattern().globalMin(),
@@ -445,40 +477,82 @@ Status ChunkManager::createFirstChunks(OperationContext* txn,
 }
 
 ChunkPtr ChunkManager::findIntersectingChunk(OperationContext* txn, const BSONObj& shardKey) const {
-    {
-        BSONObj chunkMin;
-        ChunkPtr chunk;
-        {
-            ChunkMap::const_iterator it = _chunkMap.upper_bound(shardKey);
-            if (it != _chunkMap.end()) {
-                chunkMin = it->first;
-                chunk = it->second;
-            }
-        }
+    const size_t i = _routingTable ? _routingTable->upperBound(shardKey) : 0;
+    return _chunkForKeyAt(txn, shardKey, i);
+}
 
-        if (chunk) {
-            if (chunk->containsKey(shardKey)) {
-                return chunk;
-            }
+void ChunkManager::findIntersectingChunks(OperationContext* txn,
+                                          const std::vector<BSONObj>& shardKeys,
+                                          std::vector<ChunkPtr>* chunks) const {
+    std::vector<size_t> positions(shardKeys.size(), 0);
+    if (_routingTable) {
+        _routingTable->upperBounds(shardKeys, &positions);
+    }
 
-            log() << chunkMin;
-            log() << *chunk;
-            log() << shardKey;
+    chunks->clear();
+    chunks->reserve(shardKeys.size());
+    for (size_t i = 0; i < shardKeys.size(); i++) {
+        chunks->push_back(_chunkForKeyAt(txn, shardKeys[i], positions[i]));
+    }
+}
 
-            reload(txn);
-            msgasserted(13141, "Chunk map pointed to incorrect chunk");
+ChunkPtr ChunkManager::_chunkForKeyAt(OperationContext* txn,
+                                      const BSONObj& shardKey,
+                                      size_t i) const {
+    if (_routingTable && i < _routingTable->size()) {
+        const ChunkPtr& chunk = _chunkAt(i);
+        if (chunk->containsKey(shardKey)) {
+            return chunk;
         }
+
+        log() << chunk->getMax();
+        log() << *chunk;
+        log() << shardKey;
+
+        reload(txn);
+        msgasserted(13141, "Chunk map pointed to incorrect chunk");
     }
 
     msgasserted(8070,
                 str::stream() << "couldn't find a chunk intersecting: " << shardKey
                               << " for ns: " << _ns << " at version: " << _version.toString()
-                              << ", number of chunks: " << _chunkMap.size());
+                              << ", number of chunks: " << numChunks());
 }
 
 void ChunkManager::getShardIdsForQuery(OperationContext* txn,
                                        const BSONObj& query,
                                        set<ShardId>* shardIds) const {
+    if (query.objsize() > kMaxCachedQuerySize) {
+        _targetQuery(txn, query, shardIds);
+        return;
+    }
+
+    const std::string cacheKey(query.objdata(), query.objsize());
+    {
+        stdx::lock_guard<stdx::mutex> lk(_queryTargetingCacheMutex);
+        auto it = _queryTargetingCache.find(cacheKey);
+        if (it != _queryTargetingCache.end()) {
+            shardIds->insert(it->second.begin(), it->second.end());
+            return;
+        }
+    }
+
+    // Target into a separate set, since the caller's one may already contain other shards
+    set<ShardId> targeted;
+    _targetQuery(txn, query, &targeted);
+    shardIds->insert(targeted.begin(), targeted.end());
+
+    stdx::lock_guard<stdx::mutex> lk(_queryTargetingCacheMutex);
+    if (_queryTargetingCache.size() >= kMaxCachedQueries) {
+        _queryTargetingCache.clear();
+    }
+
+    _queryTargetingCache.emplace(cacheKey, std::move(targeted));
+}
+
+void ChunkManager::_targetQuery(OperationContext* txn,
+                                const BSONObj& query,
+                                set<ShardId>* shardIds) const {
     auto statusWithCQ =
         CanonicalQuery::canonicalize(NamespaceString(_ns), query, ExtensionsCallbackNoop());
 
@@ -525,31 +599,19 @@ void ChunkManager::getShardIdsForQuery(OperationContext* txn,
     // returned.  For now, we satisfy that assumption by adding a shard with no matches rather
     // than return an empty set of shards.
     if (shardIds->empty()) {
-        massert(16068, "no chunk ranges available", !_chunkRanges.ranges().empty());
-        shardIds->insert(_chunkRanges.ranges().begin()->second->getShardId());
+        massert(16068, "no chunk ranges available", _routingTable && !_routingTable->empty());
+        shardIds->insert(_routingTable->shardIdAt(0));
     }
 }
 
 void ChunkManager::getShardIdsForRange(set<ShardId>& shardIds,
                                        const BSONObj& min,
                                        const BSONObj& max) const {
-    ChunkRangeMap::const_iterator it = _chunkRanges.upper_bound(min);
-    ChunkRangeMap::const_iterator end = _chunkRanges.upper_bound(max);
+    const bool found = _routingTable && _routingTable->getShardIdsForRange(min, max, &shardIds);
 
     massert(13507,
             str::stream() << "no chunks found between bounds " << min << " and " << max,
-            it != _chunkRanges.ranges().end());
-
-    if (end != _chunkRanges.ranges().end())
-        ++end;
-
-    for (; it != end; ++it) {
-        shardIds.insert(it->second->getShardId());
-
-        // once we know we need to visit all shards no need to keep looping
-        if (shardIds.size() == _shardIds.size())
-            break;
-    }
+            found);
 }
 
 void ChunkManager::getAllShardIds(set<ShardId>* all) const {
@@ -689,122 +751,74 @@ string ChunkManager::toString() const {
     StringBuilder sb;
     sb << "ChunkManager: " << _ns << " key:" << _keyPattern.toString() << '\n';
 
-    for (ChunkMap::const_iterator i = _chunkMap.begin(); i != _chunkMap.end(); ++i) {
-        sb << "\t" << i->second->toString() << '\n';
+    for (const auto& chunk : getChunks()) {
+        sb << "\t" << chunk->toString() << '\n';
     }
 
     return sb.str();
 }
 
 
-ChunkRange::ChunkRange(ChunkMap::const_iterator begin, const ChunkMap::const_iterator end)
-    : _manager(begin->second->getManager()),
-      _shardId(begin->second->getShardId()),
-      _min(begin->second->getMin()),
-      _max(boost::prior(end)->second->getMax()) {
-    invariant(begin != end);
+vector<ChunkPtr> ChunkManager::getChunks() const {
+    vector<ChunkPtr> chunks;
+    if (!_routingTable) {
+        return chunks;
+    }
 
-    DEV while (begin != end) {
-        dassert(begin->second->getManager() == _manager);
-        dassert(begin->second->getShardId() == _shardId);
-        ++begin;
+    chunks.reserve(_routingTable->size());
+    for (size_t leaf = 0; leaf < _routingTable->numLeaves(); leaf++) {
+        const auto leafChunks = _leafChunks(leaf);
+        chunks.insert(chunks.end(), leafChunks->begin(), leafChunks->end());
     }
-}
 
-ChunkRange::ChunkRange(const ChunkRange& min, const ChunkRange& max)
-    : _manager(min.getManager()),
-      _shardId(min.getShardId()),
-      _min(min.getMin()),
-      _max(max.getMax()) {
-    invariant(min.getShardId() == max.getShardId());
-    invariant(min.getManager() == max.getManager());
-    invariant(min.getMax() == max.getMin());
+    return chunks;
 }
 
-string ChunkRange::toString() const {
-    StringBuilder sb;
-    sb << "ChunkRange(min=" << _min << ", max=" << _max << ", shard=" << _shardId << ")";
+const ChunkPtr& ChunkManager::_chunkAt(size_t i) const {
+    const size_t leaf = _routingTable->leafFor(i);
 
-    return sb.str();
+    // The slot keeps the leaf's chunks alive for as long as this manager, so the reference stays
+    // valid after the local copy of the pointer goes away
+    return (*_leafChunks(leaf))[i - _routingTable->leafStart(leaf)];
 }
 
+shared_ptr<const vector<ChunkPtr>> ChunkManager::_leafChunks(size_t leaf) const {
+    auto chunks = std::atomic_load(&_chunkLeaves[leaf]);
+    if (chunks) {
+        return chunks;
+    }
 
-void ChunkRangeManager::assertValid() const {
-    if (_ranges.empty())
-        return;
-
-    try {
-        // No Nulls
-        for (ChunkRangeMap::const_iterator it = _ranges.begin(), end = _ranges.end(); it != end;
-             ++it) {
-            verify(it->second);
-        }
-
-        // Check endpoints
-        verify(allOfType(MinKey, _ranges.begin()->second->getMin()));
-        verify(allOfType(MaxKey, boost::prior(_ranges.end())->second->getMax()));
-
-        // Make sure there are no gaps or overlaps
-        for (ChunkRangeMap::const_iterator it = boost::next(_ranges.begin()), end = _ranges.end();
-             it != end;
-             ++it) {
-            ChunkRangeMap::const_iterator last = boost::prior(it);
-            verify(it->second->getMin() == last->second->getMax());
-        }
-
-        // Check Map keys
-        for (ChunkRangeMap::const_iterator it = _ranges.begin(), end = _ranges.end(); it != end;
-             ++it) {
-            verify(it->first == it->second->getMax());
-        }
-
-        // Make sure we match the original chunks
-        const ChunkMap chunks = _ranges.begin()->second->getManager()->_chunkMap;
-        for (ChunkMap::const_iterator i = chunks.begin(); i != chunks.end(); ++i) {
-            const ChunkPtr chunk = i->second;
-
-            ChunkRangeMap::const_iterator min = _ranges.upper_bound(chunk->getMin());
-            ChunkRangeMap::const_iterator max = _ranges.lower_bound(chunk->getMax());
-
-            verify(min != _ranges.end());
-            verify(max != _ranges.end());
-            verify(min == max);
-            verify(min->second->getShardId() == chunk->getShardId());
-            verify(min->second->containsKey(chunk->getMin()));
-            verify(min->second->containsKey(chunk->getMax()) ||
-                   (min->second->getMax() == chunk->getMax()));
-        }
-
-    } catch (...) {
-        error() << "\t invalid ChunkRangeMap! printing ranges:";
+    stdx::lock_guard<stdx::mutex> lk(_chunkLeavesMutex);
+    chunks = _chunkLeaves[leaf];
+    if (chunks) {
+        return chunks;
+    }
 
-        for (ChunkRangeMap::const_iterator it = _ranges.begin(), end = _ranges.end(); it != end;
-             ++it) {
-            log() << it->first << ": " << it->second->toString();
-        }
+    const size_t leafStart = _routingTable->leafStart(leaf);
+    const size_t leafEnd = leafStart + _routingTable->leafSize(leaf);
 
-        throw;
+    auto leafChunks = std::make_shared<vector<ChunkPtr>>();
+    leafChunks->reserve(leafEnd - leafStart);
+    for (size_t i = leafStart; i < leafEnd; i++) {
+        leafChunks->push_back(std::make_shared<Chunk>(this,
+                                                      _routingTable->minAt(i).getOwned(),
+                                                      _routingTable->maxAt(i).getOwned(),
+                                                      _routingTable->shardIdAt(i),
+                                                      _routingTable->lastmodAt(i),
+                                                      _routingTable->isJumboAt(i),
+                                                      _routingTable->bytesWrittenAt(i)));
     }
-}
 
-void ChunkRangeManager::reloadAll(const ChunkMap& chunks) {
-    _ranges.clear();
-    _insertRange(chunks.begin(), chunks.end());
-
-    DEV assertValid();
+    chunks = std::move(leafChunks);
+    std::atomic_store(&_chunkLeaves[leaf], chunks);
+    return chunks;
 }
 
-void ChunkRangeManager::_insertRange(ChunkMap::const_iterator begin,
-                                     const ChunkMap::const_iterator end) {
-    while (begin != end) {
-        ChunkMap::const_iterator first = begin;
-        ShardId shardId = first->second->getShardId();
-        while (begin != end && (begin->second->getShardId() == shardId))
-            ++begin;
+void ChunkManager::_setRoutingTable(shared_ptr<const ChunkRoutingTable> routingTable) {
+    _routingTable = std::move(routingTable);
 
-        shared_ptr<ChunkRange> cr(new ChunkRange(first, begin));
-        _ranges[cr->getMax()] = cr;
-    }
+    _chunkLeaves.clear();
+    _chunkLeaves.resize(_routingTable->numLeaves());
 }
 
 int ChunkManager::getCurrentDesiredChunkSize() const {
@@ -30,11 +30,14 @@
 
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "mongo/db/repl/optime.h"
 #include "mongo/s/chunk.h"
+#include "mongo/s/chunk_routing_table.h"
 #include "mongo/s/shard_key_pattern.h"
+#include "mongo/stdx/mutex.h"
 #include "mongo/util/concurrency/ticketholder.h"
 
 namespace mongo {
@@ -47,80 +50,6 @@ class OperationContext;
 
 typedef std::shared_ptr<ChunkManager> ChunkManagerPtr;
 
-// The key for the map is max for each Chunk or ChunkRange
-typedef std::map<BSONObj, std::shared_ptr<Chunk>, BSONObjCmp> ChunkMap;
-
-class ChunkRange {
-public:
-    ChunkRange(ChunkMap::const_iterator begin, const ChunkMap::const_iterator end);
-
-    // Merge min and max (must be adjacent ranges)
-    ChunkRange(const ChunkRange& min, const ChunkRange& max);
-
-    const ChunkManager* getManager() const {
-        return _manager;
-    }
-    ShardId getShardId() const {
-        return _shardId;
-    }
-
-    const BSONObj& getMin() const {
-        return _min;
-    }
-    const BSONObj& getMax() const {
-        return _max;
-    }
-
-    // clones of Chunk methods
-    // Returns true if this ChunkRange contains the given shard key, and false otherwise
-    //
-    // Note: this function takes an extracted *key*, not an original document
-    // (the point may be computed by, say, hashing a given field or projecting
-    //  to a subset of fields).
-    bool containsKey(const BSONObj& shardKey) const;
-
-    std::string toString() const;
-
-private:
-    const ChunkManager* _manager;
-    const ShardId _shardId;
-    const BSONObj _min;
-    const BSONObj _max;
-};
-
-typedef std::map<BSONObj, std::shared_ptr<ChunkRange>, BSONObjCmp> ChunkRangeMap;
-
-
-class ChunkRangeManager {
-public:
-    const ChunkRangeMap& ranges() const {
-        return _ranges;
-    }
-
-    void clear() {
-        _ranges.clear();
-    }
-
-    void reloadAll(const ChunkMap& chunks);
-
-    // Slow operation -- wrap with DEV
-    void assertValid() const;
-
-    ChunkRangeMap::const_iterator upper_bound(const BSONObj& o) const {
-        return _ranges.upper_bound(o);
-    }
-    ChunkRangeMap::const_iterator lower_bound(const BSONObj& o) const {
-        return _ranges.lower_bound(o);
-    }
-
-private:
-    // assumes nothing in this range exists in _ranges
-    void _insertRange(ChunkMap::const_iterator begin, const ChunkMap::const_iterator end);
-
-    ChunkRangeMap _ranges;
-};
-
-
 /* config.sharding
      { ns: 'alleyinsider.fs.chunks' ,
        key: { ts : 1 } ,
@@ -183,7 +112,7 @@ public:
     //
 
     int numChunks() const {
-        return _chunkMap.size();
+        return _routingTable ? _routingTable->size() : 0;
     }
 
     /**
@@ -196,6 +125,20 @@ public:
      */
     ChunkPtr findIntersectingChunk(OperationContext* txn, const BSONObj& shardKey) const;
 
+    /**
+     * Same as findIntersectingChunk, for a batch of shard keys. Sets (*chunks)[i] to the chunk
+     * which contains shardKeys[i]. Locating the keys together is cheaper than one at a time,
+     * because the routing table is only walked once for the whole batch.
+     */
+    void findIntersectingChunks(OperationContext* txn,
+                                const std::vector<BSONObj>& shardKeys,
+                                std::vector<ChunkPtr>* chunks) const;
+
+    /**
+     * Adds to 'shardIds' the shards which may contain documents matching 'query'. The result for
+     * small queries is cached, so repeatedly targeting the same query skips canonicalization and
+     * bounds generation.
+     */
     void getShardIdsForQuery(OperationContext* txn,
                              const BSONObj& query,
                              std::set<ShardId>* shardIds) const;
@@ -228,9 +171,11 @@ public:
     //   =>  { a: (0, 1), (2, 3), b: (0, 1), (2, 3) }
     static IndexBounds collapseQuerySolution(const QuerySolutionNode* node);
 
-    const ChunkMap& getChunkMap() const {
-        return _chunkMap;
-    }
+    /**
+     * Returns all the chunks in ascending order of their bounds. Builds the chunk objects of every
+     * leaf of the routing table which no lookup has needed yet.
+     */
+    std::vector<ChunkPtr> getChunks() const;
 
     /**
      * Returns true if, for this shard, the chunks are identical in both chunk managers
@@ -255,9 +200,12 @@ public:
     repl::OpTime getConfigOpTime() const;
 
 private:
-    // returns true if load was consistent
+    // returns true if load was consistent. Sets routingTable to the table of oldManager with the
+    // chunks which changed since its version applied, or to a new table if the load could not be
+    // based on oldManager, and adds the chunks which were applied to changes.
     bool _load(OperationContext* txn,
-               ChunkMap& chunks,
+               std::shared_ptr<const ChunkRoutingTable>* routingTable,
+               std::vector<ChunkRoutingTable::Change>* changes,
                std::set<ShardId>& shardIds,
                ShardVersionMap* shardVersions,
                const ChunkManager* oldManager);
@@ -273,8 +221,45 @@ private:
     // connection-level versions to the most up to date value.
     const unsigned long long _sequenceNumber;
 
-    ChunkMap _chunkMap;
-    ChunkRangeManager _chunkRanges;
+    /**
+     * Installs 'routingTable' as the chunks of this manager.
+     */
+    void _setRoutingTable(std::shared_ptr<const ChunkRoutingTable> routingTable);
+
+    /**
+     * Returns the chunk at position 'i' of the routing table after checking that it contains
+     * 'shardKey'. Asserts if 'i' is past the end of the table or the chunk is not the right one.
+     */
+    ChunkPtr _chunkForKeyAt(OperationContext* txn, const BSONObj& shardKey, size_t i) const;
+
+    /**
+     * Uncached implementation of getShardIdsForQuery.
+     */
+    void _targetQuery(OperationContext* txn,
+                      const BSONObj& query,
+                      std::set<ShardId>* shardIds) const;
+
+    // Immutable store of the chunks, used for all key and range targeting. Shares the leaves which
+    // were not affected by a refresh with the previous ChunkManager.
+    std::shared_ptr<const ChunkRoutingTable> _routingTable;
+
+    /**
+     * Returns the chunk at position 'i' of _routingTable.
+     */
+    const ChunkPtr& _chunkAt(size_t i) const;
+
+    /**
+     * Returns the chunk objects of the given leaf of _routingTable. They are built by the first
+     * lookup which lands in that leaf, so a refresh never has to create an object for every chunk.
+     */
+    std::shared_ptr<const std::vector<ChunkPtr>> _leafChunks(size_t leaf) const;
+
+    // Chunks of each leaf of _routingTable, in the same order, or null if no lookup has landed in
+    // that leaf yet. Chunk objects belong to the manager which created them, so unlike the leaves
+    // these cannot be taken over from the previous manager. Slots are filled at most once, under
+    // _chunkLeavesMutex, and are read with std::atomic_load.
+    mutable stdx::mutex _chunkLeavesMutex;
+    mutable std::vector<std::shared_ptr<const std::vector<ChunkPtr>>> _chunkLeaves;
 
     std::set<ShardId> _shardIds;
 
@@ -312,12 +297,17 @@ private:
 
     mutable SplitHeuristics _splitHeuristics;
 
+    // Shards targeted by recently seen queries, keyed by the raw bytes of the query. The chunks of
+    // a ChunkManager never change, so entries never become stale and the whole cache goes away
+    // with the ChunkManager on refresh.
+    mutable stdx::mutex _queryTargetingCacheMutex;
+    mutable std::unordered_map<std::string, std::set<ShardId>> _queryTargetingCache;
+
     //
     // End split heuristics
     //
 
     friend class Chunk;
-    friend class ChunkRangeManager;  // only needed for CRM::assertValid()
     static AtomicUInt32 NextSequenceNumber;
 
     friend class TestableChunkManager;
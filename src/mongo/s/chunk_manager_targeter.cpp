@@ -289,24 +289,7 @@ Status ChunkManagerTargeter::targetInsert(OperationContext* txn,
     BSONObj shardKey;
 
     if (_manager) {
-        //
-        // Sharded collections have the following requirements for targeting:
-        //
-        // Inserts must contain the exact shard key.
-        //
-
-        shardKey = _manager->getShardKeyPattern().extractShardKeyFromDoc(doc);
-
-        // Check shard key exists
-        if (shardKey.isEmpty()) {
-            return Status(ErrorCodes::ShardKeyNotFound,
-                          stream() << "document " << doc
-                                   << " does not contain shard key for pattern "
-                                   << _manager->getShardKeyPattern().toString());
-        }
-
-        // Check shard key size on insert
-        Status status = ShardKeyPattern::checkShardKeySize(shardKey);
+        Status status = extractInsertShardKey(doc, &shardKey);
         if (!status.isOK())
             return status;
     }
@@ -326,6 +309,88 @@ Status ChunkManagerTargeter::targetInsert(OperationContext* txn,
     }
 }
 
+void ChunkManagerTargeter::targetInserts(OperationContext* txn,
+                                         const vector<BSONObj>& docs,
+                                         vector<ShardEndpoint*>* endpoints,
+                                         vector<Status>* results) const {
+    if (!_manager) {
+        // Unsharded inserts all go to the primary, there is nothing to gain from batching
+        _insertSizeDeltas.clear();
+        NSTargeter::targetInserts(txn, docs, endpoints, results);
+        return;
+    }
+
+    endpoints->assign(docs.size(), NULL);
+    results->assign(docs.size(), Status::OK());
+    _insertSizeDeltas.assign(docs.size(), std::make_pair(BSONObj(), 0));
+
+    vector<BSONObj> shardKeys;
+    vector<size_t> docIndexes;
+    shardKeys.reserve(docs.size());
+    docIndexes.reserve(docs.size());
+
+    for (size_t i = 0; i < docs.size(); i++) {
+        BSONObj shardKey;
+        Status status = extractInsertShardKey(docs[i], &shardKey);
+        if (!status.isOK()) {
+            (*results)[i] = status;
+            continue;
+        }
+
+        shardKeys.push_back(shardKey);
+        docIndexes.push_back(i);
+    }
+
+    vector<ChunkPtr> chunks;
+    _manager->findIntersectingChunks(txn, shardKeys, &chunks);
+
+    for (size_t i = 0; i < chunks.size(); i++) {
+        const ChunkPtr& chunk = chunks[i];
+        const size_t docIndex = docIndexes[i];
+
+        // Same best effort autosplit accounting as targetShardKey, but only recorded by
+        // noteInsertBatched once the document is actually sent
+        _insertSizeDeltas[docIndex] = std::make_pair(chunk->getMin(), docs[docIndex].objsize());
+
+        (*endpoints)[docIndex] =
+            new ShardEndpoint(chunk->getShardId(), _manager->getVersion(chunk->getShardId()));
+    }
+}
+
+void ChunkManagerTargeter::noteInsertBatched(size_t i) const {
+    if (i >= _insertSizeDeltas.size()) {
+        return;
+    }
+
+    // Documents which went to an unsharded collection or could not be targeted have no chunk
+    const std::pair<BSONObj, int>& delta = _insertSizeDeltas[i];
+    if (!delta.first.isEmpty()) {
+        _stats->chunkSizeDelta[delta.first] += delta.second;
+    }
+}
+
+Status ChunkManagerTargeter::extractInsertShardKey(const BSONObj& doc, BSONObj* shardKey) const {
+    invariant(NULL != _manager);
+
+    //
+    // Sharded collections have the following requirements for targeting:
+    //
+    // Inserts must contain the exact shard key.
+    //
+
+    *shardKey = _manager->getShardKeyPattern().extractShardKeyFromDoc(doc);
+
+    // Check shard key exists
+    if (shardKey->isEmpty()) {
+        return Status(ErrorCodes::ShardKeyNotFound,
+                      stream() << "document " << doc << " does not contain shard key for pattern "
+                               << _manager->getShardKeyPattern().toString());
+    }
+
+    // Check shard key size on insert
+    return ShardKeyPattern::checkShardKeySize(*shardKey);
+}
+
 Status ChunkManagerTargeter::targetUpdate(OperationContext* txn,
                                           const BatchedUpdateDocument& updateDoc,
                                           vector<ShardEndpoint*>* endpoints) const {
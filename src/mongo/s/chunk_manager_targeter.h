@@ -29,6 +29,8 @@
 #pragma once
 
 #include <map>
+#include <utility>
+#include <vector>
 
 #include "mongo/bson/bsonobj.h"
 #include "mongo/db/namespace_string.h"
@@ -70,6 +72,15 @@ public:
     // Returns ShardKeyNotFound if document does not have a full shard key.
     Status targetInsert(OperationContext* txn, const BSONObj& doc, ShardEndpoint** endpoint) const;
 
+    // Locates the shard keys of all the documents in a single pass over the routing table.
+    void targetInserts(OperationContext* txn,
+                       const std::vector<BSONObj>& docs,
+                       std::vector<ShardEndpoint*>* endpoints,
+                       std::vector<Status>* results) const;
+
+    // Records the autosplit size delta of a document targeted by the last targetInserts call.
+    void noteInsertBatched(size_t i) const;
+
     // Returns ShardKeyNotFound if the update can't be targeted without a shard key.
     Status targetUpdate(OperationContext* txn,
                         const BatchedUpdateDocument& updateDoc,
@@ -127,6 +138,12 @@ private:
                      const BSONObj& doc,
                      std::vector<ShardEndpoint*>* endpoints) const;
 
+    /**
+     * Extracts the shard key of a document to be inserted into a sharded collection. Returns
+     * !OK if the document does not contain the full shard key or the key is too large.
+     */
+    Status extractInsertShardKey(const BSONObj& doc, BSONObj* shardKey) const;
+
     /**
      * Returns a vector of ShardEndpoints for a potentially multi-shard query.
      *
@@ -163,6 +180,10 @@ private:
 
     // Map of shard->remote shard version reported from stale errors
     ShardVersionMap _remoteShardVersions;
+
+    // Chunk min key and size of each document of the last targetInserts call, or an empty key if
+    // it was not targeted to a chunk. Applied to _stats by noteInsertBatched.
+    mutable std::vector<std::pair<BSONObj, int>> _insertSizeDeltas;
 };
 
 }  // namespace mongo
@@ -0,0 +1,619 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/s/chunk_routing_table.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/bson/ordering.h"
+#include "mongo/db/storage/key_string.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/debug_util.h"
+
+namespace mongo {
+
+namespace {
+
+// Shard key patterns are always ascending, so a single all-ascending ordering is used to encode
+// every key in the table.
+const Ordering kAllAscending = Ordering::make(BSONObj());
+
+/**
+ * KeyString encodes values only and requires the field names of the key to be empty, so they are
+ * stripped first.
+ */
+void encodeKey(const BSONObj& shardKey, KeyString* out) {
+    BSONObjBuilder stripped;
+    for (const auto& elem : shardKey) {
+        stripped.appendAs(elem, "");
+    }
+
+    out->resetToKey(stripped.done(), kAllAscending);
+}
+
+/**
+ * Same semantics as KeyString::compare, but operates on raw buffers.
+ */
+inline int compareEncoded(const char* lhs, size_t lhsSize, const char* rhs, size_t rhsSize) {
+    const int cmp = memcmp(lhs, rhs, std::min(lhsSize, rhsSize));
+    if (cmp) {
+        return cmp;
+    }
+
+    return (lhsSize > rhsSize) - (lhsSize < rhsSize);
+}
+
+/**
+ * A chunk change with its bounds encoded, along with the range of existing chunks [first, end) it
+ * replaces.
+ */
+struct EncodedChange {
+    const ChunkRoutingTable::Change* source;
+    std::string min;
+    std::string max;
+    uint16_t shardIndex;
+    size_t first;
+    size_t end;
+};
+
+int compareEncoded(const std::string& lhs, const std::string& rhs) {
+    return compareEncoded(lhs.data(), lhs.size(), rhs.data(), rhs.size());
+}
+
+}  // namespace
+
+
+/**
+ * Packs a stream of chunks into leaves of at most kMaxLeafSize chunks each.
+ */
+class ChunkRoutingTable::LeafAccumulator {
+public:
+    explicit LeafAccumulator(std::vector<std::shared_ptr<const Leaf>>* leaves) : _leaves(leaves) {}
+
+    /**
+     * Appends a new chunk, whose encoded max bound is 'key'.
+     */
+    void append(const char* key, size_t keySize, uint16_t shardIndex, const Change& chunk) {
+        Leaf* const leaf = _startChunk(key, keySize, shardIndex);
+        leaf->bounds.append(chunk.min.objdata(), chunk.min.objsize());
+        leaf->bounds.append(chunk.max.objdata(), chunk.max.objsize());
+        leaf->versions.push_back(chunk.lastmod.toLong());
+        leaf->jumbo.push_back(chunk.jumbo);
+        leaf->bytesWritten.push_back(chunk.bytesWritten);
+        _finishChunk();
+    }
+
+    /**
+     * Appends a copy of chunk 'i' of an existing leaf.
+     */
+    void append(const Leaf& from, size_t i) {
+        Leaf* const leaf =
+            _startChunk(from.maxKeys.keyData(i), from.maxKeys.keySize(i), from.shardIndexes[i]);
+        leaf->bounds.append(from.bounds.keyData(2 * i), from.bounds.keySize(2 * i));
+        leaf->bounds.append(from.bounds.keyData(2 * i + 1), from.bounds.keySize(2 * i + 1));
+        leaf->versions.push_back(from.versions[i]);
+        leaf->jumbo.push_back(from.jumbo[i]);
+        leaf->bytesWritten.push_back(from.bytesWritten[i]);
+        _finishChunk();
+    }
+
+    /**
+     * Closes the leaf being filled, if any. The next chunk appended starts a new leaf.
+     */
+    void flush() {
+        if (!_current) {
+            return;
+        }
+
+        Leaf* const leaf = _current.get();
+        const size_t size = leaf->size();
+
+        // Walk backwards so that each chunk can inherit the run end of its successor when both
+        // live on the same shard
+        leaf->runEnds.resize(size);
+        for (size_t i = size; i-- > 0;) {
+            if (i + 1 < size && leaf->shardIndexes[i] == leaf->shardIndexes[i + 1]) {
+                leaf->runEnds[i] = leaf->runEnds[i + 1];
+            } else {
+                leaf->runEnds[i] = static_cast<uint16_t>(i + 1);
+            }
+        }
+
+        leaf->maxKeys.bytes.shrink_to_fit();
+        leaf->maxKeys.offsets.shrink_to_fit();
+        leaf->bounds.bytes.shrink_to_fit();
+        leaf->bounds.offsets.shrink_to_fit();
+        leaf->shardIndexes.shrink_to_fit();
+        leaf->versions.shrink_to_fit();
+        leaf->jumbo.shrink_to_fit();
+        leaf->bytesWritten.shrink_to_fit();
+
+        _leaves->push_back(std::shared_ptr<const Leaf>(_current.release()));
+    }
+
+private:
+    /**
+     * Records the routing information of the next chunk and returns the leaf it goes into. The
+     * rest of the chunk must be recorded before calling _finishChunk.
+     */
+    Leaf* _startChunk(const char* key, size_t keySize, uint16_t shardIndex) {
+        if (kDebugBuild) {
+            dassert(compareEncoded(_lastKey.data(), _lastKey.size(), key, keySize) < 0 ||
+                    _lastKey.empty());
+            _lastKey.assign(key, keySize);
+        }
+
+        if (!_current) {
+            _current.reset(new Leaf());
+        }
+
+        _current->maxKeys.append(key, keySize);
+        _current->shardIndexes.push_back(shardIndex);
+
+        return _current.get();
+    }
+
+    void _finishChunk() {
+        if (_current->size() == kMaxLeafSize) {
+            flush();
+        }
+    }
+
+    std::vector<std::shared_ptr<const Leaf>>* const _leaves;
+    std::unique_ptr<Leaf> _current;
+
+    // Only maintained in debug builds, to check the ordering of the keys
+    std::string _lastKey;
+};
+
+
+void ChunkRoutingTable::KeyArray::append(const char* key, size_t keySize) {
+    invariant(bytes.size() + keySize <= std::numeric_limits<uint32_t>::max());
+    bytes.append(key, keySize);
+    offsets.push_back(static_cast<uint32_t>(bytes.size()));
+}
+
+size_t ChunkRoutingTable::KeyArray::upperBound(const char* key,
+                                               size_t keySize,
+                                               size_t from) const {
+    dassert(from <= size());
+    size_t n = size() - from;
+    if (n == 0) {
+        return from;
+    }
+
+    auto isLessOrEqual = [&](size_t i) {
+        return compareEncoded(keyData(i), this->keySize(i), key, keySize) <= 0;
+    };
+
+    // The loop runs a fixed number of iterations for a given array size and the comparison result
+    // only selects the next base, so the compiler can emit a conditional move instead of a
+    // data-dependent branch.
+    size_t base = from;
+    while (n > 1) {
+        const size_t half = n / 2;
+        base = isLessOrEqual(base + half) ? base + half : base;
+        n -= half;
+    }
+
+    return base + isLessOrEqual(base);
+}
+
+size_t ChunkRoutingTable::KeyArray::memoryUsageBytes() const {
+    return bytes.capacity() + offsets.capacity() * sizeof(uint32_t);
+}
+
+size_t ChunkRoutingTable::Leaf::memoryUsageBytes() const {
+    return sizeof(Leaf) + maxKeys.memoryUsageBytes() + bounds.memoryUsageBytes() +
+        (shardIndexes.capacity() + runEnds.capacity()) * sizeof(uint16_t) +
+        versions.capacity() * sizeof(unsigned long long) + jumbo.capacity() / 8 +
+        bytesWritten.capacity() * sizeof(long long);
+}
+
+
+ChunkRoutingTable::ChunkRoutingTable() : _leafStarts(1, 0), _numShards(0) {}
+
+size_t ChunkRoutingTable::upperBound(const BSONObj& shardKey) const {
+    KeyString encoded;
+    encodeKey(shardKey, &encoded);
+    return _upperBound(encoded.getBuffer(), encoded.getSize());
+}
+
+void ChunkRoutingTable::upperBounds(const std::vector<BSONObj>& shardKeys,
+                                    std::vector<size_t>* positions) const {
+    const size_t numKeys = shardKeys.size();
+    positions->resize(numKeys);
+
+    std::vector<std::string> encodedKeys(numKeys);
+    KeyString encoded;
+    for (size_t i = 0; i < numKeys; i++) {
+        encodeKey(shardKeys[i], &encoded);
+        encodedKeys[i].assign(encoded.getBuffer(), encoded.getSize());
+    }
+
+    std::vector<size_t> order(numKeys);
+    for (size_t i = 0; i < numKeys; i++) {
+        order[i] = i;
+    }
+
+    std::sort(order.begin(), order.end(), [&encodedKeys](size_t lhs, size_t rhs) {
+        return compareEncoded(encodedKeys[lhs], encodedKeys[rhs]) < 0;
+    });
+
+    // Visiting the keys in ascending order means that neither the leaf nor the position within the
+    // leaf can move backwards, so each search only needs to cover what is left of the table
+    size_t leafIndex = 0;
+    size_t leafPosition = 0;
+    for (const size_t i : order) {
+        const std::string& key = encodedKeys[i];
+
+        const size_t nextLeafIndex = _fenceKeys.upperBound(key.data(), key.size(), leafIndex);
+        if (nextLeafIndex == _leaves.size()) {
+            // All the remaining keys are past the end of the table as well
+            (*positions)[i] = size();
+            leafIndex = nextLeafIndex;
+            continue;
+        }
+
+        if (nextLeafIndex != leafIndex) {
+            leafIndex = nextLeafIndex;
+            leafPosition = 0;
+        }
+
+        leafPosition = _leaves[leafIndex]->maxKeys.upperBound(key.data(), key.size(), leafPosition);
+        (*positions)[i] = _leafStarts[leafIndex] + leafPosition;
+    }
+}
+
+size_t ChunkRoutingTable::_upperBound(const char* key, size_t keySize) const {
+    // The fence key of a leaf is the max bound of its last chunk, so the first leaf whose fence
+    // is greater than the key is the one which contains the chunk
+    const size_t leafIndex = _fenceKeys.upperBound(key, keySize);
+    if (leafIndex == _leaves.size()) {
+        return size();
+    }
+
+    return _leafStarts[leafIndex] + _leaves[leafIndex]->maxKeys.upperBound(key, keySize);
+}
+
+size_t ChunkRoutingTable::_leafFor(size_t i) const {
+    dassert(i < size());
+    return std::upper_bound(_leafStarts.begin(), _leafStarts.end(), i) - _leafStarts.begin() - 1;
+}
+
+const ShardId& ChunkRoutingTable::shardIdAt(size_t i) const {
+    const size_t leafIndex = _leafFor(i);
+    return _shardIds[_leaves[leafIndex]->shardIndexes[i - _leafStarts[leafIndex]]];
+}
+
+BSONObj ChunkRoutingTable::minAt(size_t i) const {
+    const size_t leafIndex = _leafFor(i);
+    return BSONObj(_leaves[leafIndex]->bounds.keyData(2 * (i - _leafStarts[leafIndex])));
+}
+
+BSONObj ChunkRoutingTable::maxAt(size_t i) const {
+    const size_t leafIndex = _leafFor(i);
+    return BSONObj(_leaves[leafIndex]->bounds.keyData(2 * (i - _leafStarts[leafIndex]) + 1));
+}
+
+ChunkVersion ChunkRoutingTable::lastmodAt(size_t i) const {
+    const size_t leafIndex = _leafFor(i);
+    const unsigned long long version = _leaves[leafIndex]->versions[i - _leafStarts[leafIndex]];
+    return ChunkVersion::fromDeprecatedLong(version, _epoch);
+}
+
+bool ChunkRoutingTable::isJumboAt(size_t i) const {
+    const size_t leafIndex = _leafFor(i);
+    return _leaves[leafIndex]->jumbo[i - _leafStarts[leafIndex]];
+}
+
+std::shared_ptr<long long> ChunkRoutingTable::bytesWrittenAt(size_t i) const {
+    const size_t leafIndex = _leafFor(i);
+    const auto& leaf = _leaves[leafIndex];
+
+    // The counter keeps its leaf alive, so it stays valid after the table goes away
+    return std::shared_ptr<long long>(leaf, &leaf->bytesWritten[i - _leafStarts[leafIndex]]);
+}
+
+size_t ChunkRoutingTable::nextShardBoundary(size_t i) const {
+    const size_t leafIndex = _leafFor(i);
+    const size_t leafStart = _leafStarts[leafIndex];
+    return leafStart + _leaves[leafIndex]->runEnds[i - leafStart];
+}
+
+bool ChunkRoutingTable::getShardIdsForRange(const BSONObj& min,
+                                            const BSONObj& max,
+                                            std::set<ShardId>* shardIds) const {
+    const size_t first = upperBound(min);
+    if (first == size()) {
+        return false;
+    }
+
+    // The chunk containing 'max' is included as well, since the interval is closed
+    const size_t last = std::min(upperBound(max), size() - 1);
+
+    size_t leafIndex = _leafFor(first);
+    size_t pos = first - _leafStarts[leafIndex];
+
+    while (_leafStarts[leafIndex] + pos <= last) {
+        const Leaf& leaf = *_leaves[leafIndex];
+        shardIds->insert(_shardIds[leaf.shardIndexes[pos]]);
+
+        // once we know we need to visit all shards no need to keep looping
+        if (shardIds->size() == _numShards) {
+            break;
+        }
+
+        pos = leaf.runEnds[pos];
+        if (pos == leaf.size()) {
+            if (++leafIndex == _leaves.size()) {
+                break;
+            }
+            pos = 0;
+        }
+    }
+
+    return true;
+}
+
+std::shared_ptr<const ChunkRoutingTable> ChunkRoutingTable::makeUpdated(
+    const std::vector<Change>& changes) const {
+    std::unique_ptr<ChunkRoutingTable> table(new ChunkRoutingTable());
+    table->_shardIds = _shardIds;
+    table->_shardChunkCounts = _shardChunkCounts;
+    table->_epoch = changes.empty() ? _epoch : changes.front().lastmod.epoch();
+
+    std::vector<EncodedChange> encodedChanges;
+    encodedChanges.reserve(changes.size());
+
+    KeyString encoded;
+    for (const auto& change : changes) {
+        EncodedChange encodedChange;
+        encodedChange.source = &change;
+
+        encodeKey(change.min, &encoded);
+        encodedChange.min.assign(encoded.getBuffer(), encoded.getSize());
+        encodeKey(change.max, &encoded);
+        encodedChange.max.assign(encoded.getBuffer(), encoded.getSize());
+        encodedChange.shardIndex = table->_internShardId(change.shardId);
+
+        encodedChanges.push_back(std::move(encodedChange));
+    }
+
+    std::sort(encodedChanges.begin(),
+              encodedChanges.end(),
+              [](const EncodedChange& lhs, const EncodedChange& rhs) {
+                  return compareEncoded(lhs.min, rhs.min) < 0;
+              });
+
+    for (size_t i = 0; i < encodedChanges.size(); i++) {
+        EncodedChange& change = encodedChanges[i];
+        if (compareEncoded(change.min, change.max) >= 0 ||
+            (i > 0 && compareEncoded(encodedChanges[i - 1].max, change.min) > 0)) {
+            return nullptr;
+        }
+
+        // Same rule as the config diff tracker uses: a change replaces all chunks whose max bound
+        // falls in (min, max]
+        change.first = _upperBound(change.min.data(), change.min.size());
+        change.end = _upperBound(change.max.data(), change.max.size());
+    }
+
+    LeafAccumulator accumulator(&table->_leaves);
+
+    auto appendChange = [&](const EncodedChange& change) {
+        accumulator.append(
+            change.max.data(), change.max.size(), change.shardIndex, *change.source);
+        table->_shardChunkCounts[change.shardIndex]++;
+    };
+
+    // Position 'size()' means after the last chunk, which is handled by the last leaf
+    auto leafForPosition = [this](size_t pos) {
+        return pos < size() ? _leafFor(pos) : _leaves.size() - 1;
+    };
+
+    size_t nextChange = 0;
+    size_t nextLeaf = 0;
+
+    while (nextChange < encodedChanges.size() && !_leaves.empty()) {
+        // Find the run of consecutive leaves touched by the next group of changes
+        const size_t runFirstChange = nextChange;
+        const size_t runFirstLeaf = leafForPosition(encodedChanges[nextChange].first);
+        size_t runLastLeaf = runFirstLeaf;
+
+        while (nextChange < encodedChanges.size()) {
+            const EncodedChange& change = encodedChanges[nextChange];
+            if (leafForPosition(change.first) > runLastLeaf) {
+                break;
+            }
+
+            const size_t lastTouched = change.end > change.first ? change.end - 1 : change.first;
+            runLastLeaf = std::max(runLastLeaf, leafForPosition(lastTouched));
+            nextChange++;
+        }
+
+        // Leaves before the run are shared as they are
+        for (; nextLeaf < runFirstLeaf; nextLeaf++) {
+            table->_leaves.push_back(_leaves[nextLeaf]);
+        }
+
+        // Rebuild the leaves of the run, merging the surviving chunks with the changes
+        size_t change = runFirstChange;
+        size_t pos = _leafStarts[runFirstLeaf];
+
+        for (; nextLeaf <= runLastLeaf; nextLeaf++) {
+            const Leaf& leaf = *_leaves[nextLeaf];
+            for (size_t i = 0; i < leaf.size(); i++, pos++) {
+                while (change < nextChange && encodedChanges[change].end <= pos) {
+                    appendChange(encodedChanges[change++]);
+                }
+
+                // Changes are sorted and do not overlap, so only the next pending one can cover
+                // this chunk
+                if (change < nextChange && encodedChanges[change].first <= pos) {
+                    table->_shardChunkCounts[leaf.shardIndexes[i]]--;
+                    continue;
+                }
+
+                accumulator.append(leaf, i);
+            }
+        }
+
+        while (change < nextChange) {
+            appendChange(encodedChanges[change++]);
+        }
+
+        accumulator.flush();
+    }
+
+    for (; nextLeaf < _leaves.size(); nextLeaf++) {
+        table->_leaves.push_back(_leaves[nextLeaf]);
+    }
+
+    // Changes applied to an empty table simply become its contents
+    while (nextChange < encodedChanges.size()) {
+        appendChange(encodedChanges[nextChange++]);
+    }
+    accumulator.flush();
+
+    table->_indexLeaves();
+
+    // Rebuilding runs of leaves can leave partially filled leaves behind. Once they make up a
+    // large fraction of the table, repack everything so lookups don't degrade.
+    const size_t minLeaves = (table->size() + kMaxLeafSize - 1) / kMaxLeafSize;
+    if (table->_leaves.size() > 2 * minLeaves + 1) {
+        std::vector<std::shared_ptr<const Leaf>> fragmented;
+        fragmented.swap(table->_leaves);
+
+        LeafAccumulator repacker(&table->_leaves);
+        for (const auto& leaf : fragmented) {
+            for (size_t i = 0; i < leaf->size(); i++) {
+                repacker.append(*leaf, i);
+            }
+        }
+        repacker.flush();
+
+        table->_indexLeaves();
+    }
+
+    return std::shared_ptr<const ChunkRoutingTable>(table.release());
+}
+
+size_t ChunkRoutingTable::numLeavesSharedWith(const ChunkRoutingTable& other) const {
+    std::set<const Leaf*> otherLeaves;
+    for (const auto& leaf : other._leaves) {
+        otherLeaves.insert(leaf.get());
+    }
+
+    return std::count_if(_leaves.begin(),
+                         _leaves.end(),
+                         [&](const std::shared_ptr<const Leaf>& leaf) {
+                             return otherLeaves.count(leaf.get()) > 0;
+                         });
+}
+
+size_t ChunkRoutingTable::memoryUsageBytes() const {
+    size_t bytes = sizeof(ChunkRoutingTable);
+    bytes += _leaves.capacity() * sizeof(std::shared_ptr<const Leaf>);
+    bytes += _leafStarts.capacity() * sizeof(size_t);
+    bytes += _fenceKeys.memoryUsageBytes();
+    bytes += _shardChunkCounts.capacity() * sizeof(uint32_t);
+    for (const auto& shardId : _shardIds) {
+        bytes += sizeof(ShardId) + shardId.capacity();
+    }
+    for (const auto& leaf : _leaves) {
+        bytes += leaf->memoryUsageBytes();
+    }
+
+    return bytes;
+}
+
+uint16_t ChunkRoutingTable::_internShardId(const ShardId& shardId) {
+    auto it = std::find(_shardIds.begin(), _shardIds.end(), shardId);
+    if (it == _shardIds.end()) {
+        invariant(_shardIds.size() < std::numeric_limits<uint16_t>::max());
+        it = _shardIds.insert(it, shardId);
+        _shardChunkCounts.push_back(0);
+    }
+
+    return static_cast<uint16_t>(std::distance(_shardIds.begin(), it));
+}
+
+void ChunkRoutingTable::_indexLeaves() {
+    _leafStarts.assign(1, 0);
+    _fenceKeys = KeyArray();
+
+    for (const auto& leaf : _leaves) {
+        invariant(leaf->size() > 0);
+        _leafStarts.push_back(_leafStarts.back() + leaf->size());
+
+        const size_t last = leaf->size() - 1;
+        _fenceKeys.append(leaf->maxKeys.keyData(last), leaf->maxKeys.keySize(last));
+    }
+
+    _numShards = std::count_if(_shardChunkCounts.begin(),
+                               _shardChunkCounts.end(),
+                               [](uint32_t count) { return count > 0; });
+}
+
+
+ChunkRoutingTable::Builder::Builder()
+    : _table(new ChunkRoutingTable()), _leaves(new LeafAccumulator(&_table->_leaves)) {}
+
+ChunkRoutingTable::Builder::~Builder() = default;
+
+void ChunkRoutingTable::Builder::append(const Change& chunk) {
+    invariant(_table);
+
+    KeyString encoded;
+    encodeKey(chunk.max, &encoded);
+
+    const uint16_t shardIndex = _table->_internShardId(chunk.shardId);
+    _table->_shardChunkCounts[shardIndex]++;
+
+    // All the chunks share the same epoch
+    _table->_epoch = chunk.lastmod.epoch();
+
+    _leaves->append(encoded.getBuffer(), encoded.getSize(), shardIndex, chunk);
+}
+
+std::shared_ptr<const ChunkRoutingTable> ChunkRoutingTable::Builder::done() {
+    invariant(_table);
+
+    _leaves->flush();
+    _table->_indexLeaves();
+
+    return std::shared_ptr<const ChunkRoutingTable>(_table.release());
+}
+
+}  // namespace mongo
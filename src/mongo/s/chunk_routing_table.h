@@ -0,0 +1,359 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/bson/oid.h"
+#include "mongo/s/chunk_version.h"
+#include "mongo/s/client/shard.h"
+
+namespace mongo {
+
+/**
+ * Immutable, persistent routing table for the chunks of one sharded collection.
+ *
+ * The max bound of every chunk is encoded as a KeyString and stored back to back in contiguous
+ * buffers, so locating the chunk which owns a shard key is a binary search over memcmp-comparable
+ * byte strings instead of a BSONObj comparison walk over a std::map. Shard ids are interned and
+ * referenced through a 16-bit index, and every chunk records where its run of chunks on the same
+ * shard ends, so range targeting can skip over whole runs.
+ *
+ * Chunks are grouped into fixed-capacity leaves, which are immutable and reference counted. A
+ * refreshed table is produced from an existing one through makeUpdated(), which rebuilds only the
+ * leaves touched by the changed chunks and shares all the others with the original. Applying K
+ * changes therefore costs O(K * (log N + kMaxLeafSize) + N / kMaxLeafSize) instead of O(N), and
+ * readers of the original table are unaffected, since nothing reachable from it is modified.
+ *
+ * Shard key patterns are always ascending (or hashed, which is stored as an ascending NumberLong),
+ * so all keys are encoded with an all-ascending ordering.
+ *
+ * Besides what is needed for routing, every chunk also records its raw BSON bounds, version and
+ * jumbo flag, so the table is the only copy of the chunks a ChunkManager keeps. All the chunks of
+ * a table must belong to the same collection epoch.
+ */
+class ChunkRoutingTable {
+    MONGO_DISALLOW_COPYING(ChunkRoutingTable);
+
+public:
+    class Builder;
+
+    /**
+     * A chunk which was created or modified since a table was built. It replaces every chunk of
+     * the table whose max bound falls in (min, max].
+     */
+    struct Change {
+        Change(BSONObj min,
+               BSONObj max,
+               ShardId shardId,
+               ChunkVersion lastmod = ChunkVersion(),
+               bool jumbo = false,
+               long long bytesWritten = 0)
+            : min(std::move(min)),
+              max(std::move(max)),
+              shardId(std::move(shardId)),
+              lastmod(std::move(lastmod)),
+              jumbo(jumbo),
+              bytesWritten(bytesWritten) {}
+
+        BSONObj min;
+        BSONObj max;
+        ShardId shardId;
+        ChunkVersion lastmod;
+        bool jumbo;
+
+        // Initial value of the chunk's bytes written counter, see bytesWrittenAt()
+        long long bytesWritten;
+    };
+
+    // Maximum number of chunks stored in a single leaf
+    static const size_t kMaxLeafSize = 128;
+
+    /**
+     * Number of chunks in the table.
+     */
+    size_t size() const {
+        return _leafStarts.back();
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    /**
+     * Number of distinct shards which own at least one chunk.
+     */
+    size_t numShards() const {
+        return _numShards;
+    }
+
+    /**
+     * Returns the index of the first chunk whose max bound is strictly greater than the given
+     * shard key, which is the chunk that would contain it, or size() if there is none.
+     */
+    size_t upperBound(const BSONObj& shardKey) const;
+
+    /**
+     * Same as upperBound(), for a batch of shard keys. Sets (*positions)[i] to the upper bound of
+     * shardKeys[i]. The keys are encoded and located in ascending order, so every search resumes
+     * where the previous one ended instead of starting again from the root of the table.
+     */
+    void upperBounds(const std::vector<BSONObj>& shardKeys, std::vector<size_t>* positions) const;
+
+    const ShardId& shardIdAt(size_t i) const;
+
+    /**
+     * Bounds of chunk 'i'. The returned objects point into the table and are only valid for as
+     * long as it is.
+     */
+    BSONObj minAt(size_t i) const;
+    BSONObj maxAt(size_t i) const;
+
+    ChunkVersion lastmodAt(size_t i) const;
+
+    bool isJumboAt(size_t i) const;
+
+    /**
+     * Returns the counter of bytes written to chunk 'i' since it was last considered for
+     * splitting. The counter is shared by every table which shares the leaf of the chunk, so the
+     * count survives refreshes which do not touch that chunk. It is the only part of a table which
+     * may be modified after it is built, and only as a heuristic, so accesses are not synchronized.
+     */
+    std::shared_ptr<long long> bytesWrittenAt(size_t i) const;
+
+    /**
+     * Epoch of the collection the chunks belong to.
+     */
+    const OID& epoch() const {
+        return _epoch;
+    }
+
+    /**
+     * Returns an index past 'i' such that all the chunks in [i, result) live on the same shard as
+     * chunk 'i'. Used to skip over runs of chunks on the same shard. A run which crosses a leaf
+     * boundary is reported in several pieces.
+     */
+    size_t nextShardBoundary(size_t i) const;
+
+    /**
+     * Adds to 'shardIds' the ids of all shards which own chunks intersecting the closed interval
+     * [min, max]. Returns false if no chunk has a max bound greater than 'min'. Stops early once
+     * every shard in the table has been added.
+     */
+    bool getShardIdsForRange(const BSONObj& min,
+                             const BSONObj& max,
+                             std::set<ShardId>* shardIds) const;
+
+    /**
+     * Returns a new table with the given changes applied, sharing all untouched leaves with this
+     * one. The changes need not be sorted, but must not overlap each other. Returns nullptr if
+     * they do, in which case the caller should build a new table from scratch.
+     */
+    std::shared_ptr<const ChunkRoutingTable> makeUpdated(const std::vector<Change>& changes) const;
+
+    /**
+     * Number of leaves of this table which are also referenced by 'other'.
+     */
+    size_t numLeavesSharedWith(const ChunkRoutingTable& other) const;
+
+    size_t numLeaves() const {
+        return _leaves.size();
+    }
+
+    /**
+     * Returns the index of the leaf which contains chunk 'i'. Lets callers keep per-leaf data
+     * alongside the table, such as the chunk objects at each position.
+     */
+    size_t leafFor(size_t i) const {
+        return _leafFor(i);
+    }
+
+    /**
+     * Position of the first chunk of the given leaf.
+     */
+    size_t leafStart(size_t leafIndex) const {
+        return _leafStarts[leafIndex];
+    }
+
+    size_t leafSize(size_t leafIndex) const {
+        return _leafStarts[leafIndex + 1] - _leafStarts[leafIndex];
+    }
+
+    /**
+     * Approximate number of bytes of memory used by this table, counting shared leaves in full.
+     */
+    size_t memoryUsageBytes() const;
+
+private:
+    /**
+     * Sequence of encoded keys stored back to back in a single buffer.
+     */
+    struct KeyArray {
+        KeyArray() : offsets(1, 0) {}
+
+        size_t size() const {
+            return offsets.size() - 1;
+        }
+
+        const char* keyData(size_t i) const {
+            return bytes.data() + offsets[i];
+        }
+
+        size_t keySize(size_t i) const {
+            return offsets[i + 1] - offsets[i];
+        }
+
+        void append(const char* key, size_t keySize);
+
+        /**
+         * Returns the number of keys which compare less than or equal to the given encoded key.
+         * Only the keys at positions 'from' and above are searched; the ones before are assumed to
+         * compare less than or equal.
+         */
+        size_t upperBound(const char* key, size_t keySize, size_t from = 0) const;
+
+        size_t memoryUsageBytes() const;
+
+        std::string bytes;
+
+        // offsets[i] is where key i starts in bytes. Has size() + 1 entries so that the end of the
+        // last key is also recorded.
+        std::vector<uint32_t> offsets;
+    };
+
+    /**
+     * Immutable group of up to kMaxLeafSize consecutive chunks.
+     */
+    struct Leaf {
+        size_t size() const {
+            return shardIndexes.size();
+        }
+
+        size_t memoryUsageBytes() const;
+
+        // Encoded max bounds of the chunks in ascending order
+        KeyArray maxKeys;
+
+        // Raw BSON bounds of the chunks, the min bound of chunk i at 2 * i and its max at 2 * i + 1
+        KeyArray bounds;
+
+        // Index into the table's _shardIds of the shard which owns each chunk
+        std::vector<uint16_t> shardIndexes;
+
+        // Position in this leaf of the first subsequent chunk living on a different shard
+        std::vector<uint16_t> runEnds;
+
+        // Version of each chunk, as returned by ChunkVersion::toLong
+        std::vector<unsigned long long> versions;
+
+        std::vector<bool> jumbo;
+
+        // See bytesWrittenAt(). Never resized once the leaf is built.
+        mutable std::vector<long long> bytesWritten;
+    };
+
+    class LeafAccumulator;
+
+    ChunkRoutingTable();
+
+    /**
+     * Returns the index of the leaf which contains chunk 'i'.
+     */
+    size_t _leafFor(size_t i) const;
+
+    /**
+     * Returns the index of the first chunk whose encoded max bound is strictly greater than the
+     * given encoded key.
+     */
+    size_t _upperBound(const char* key, size_t keySize) const;
+
+    /**
+     * Returns the index of the given shard in _shardIds, adding it if it is not there yet.
+     */
+    uint16_t _internShardId(const ShardId& shardId);
+
+    /**
+     * Rebuilds the leaf start positions and fence keys after _leaves has been modified.
+     */
+    void _indexLeaves();
+
+    std::vector<std::shared_ptr<const Leaf>> _leaves;
+
+    // _leafStarts[i] is the index of the first chunk of leaf i. Has _leaves.size() + 1 entries so
+    // that the total number of chunks is also recorded.
+    std::vector<size_t> _leafStarts;
+
+    // Encoded max bound of the last chunk of every leaf
+    KeyArray _fenceKeys;
+
+    // Distinct shard ids, in order of first appearance. May include shards which no longer own
+    // any chunks.
+    std::vector<ShardId> _shardIds;
+
+    // Number of chunks owned by each entry of _shardIds
+    std::vector<uint32_t> _shardChunkCounts;
+
+    // Number of entries of _shardChunkCounts which are not zero
+    size_t _numShards;
+
+    OID _epoch;
+};
+
+/**
+ * Accumulates chunks in ascending order of their bounds and produces an immutable routing table.
+ */
+class ChunkRoutingTable::Builder {
+    MONGO_DISALLOW_COPYING(Builder);
+
+public:
+    Builder();
+    ~Builder();
+
+    /**
+     * Appends the next chunk. Chunks must be appended in ascending order of their bounds.
+     */
+    void append(const Change& chunk);
+
+    /**
+     * Finalizes the table. The builder must not be used afterwards.
+     */
+    std::shared_ptr<const ChunkRoutingTable> done();
+
+private:
+    std::unique_ptr<ChunkRoutingTable> _table;
+    std::unique_ptr<LeafAccumulator> _leaves;
+};
+
+}  // namespace mongo
@@ -0,0 +1,411 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/s/chunk_routing_table.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+using std::set;
+using std::shared_ptr;
+
+/**
+ * Bounds of chunk 'i' of a table built by makeTable with 'size' chunks.
+ */
+BSONObj chunkMin(size_t i) {
+    return i == 0 ? BSON("a" << MINKEY) : BSON("a" << static_cast<int>((i - 1) * 10));
+}
+
+BSONObj chunkMax(size_t i, size_t size) {
+    return i + 1 == size ? BSON("a" << MAXKEY) : BSON("a" << static_cast<int>(i * 10));
+}
+
+/**
+ * Builds a table with chunks [MinKey, 0), [0, 10), [10, 20), ..., [90, MaxKey) placed on the
+ * shards named in 'shards', one per chunk.
+ */
+shared_ptr<const ChunkRoutingTable> makeTable(const std::vector<ShardId>& shards) {
+    ChunkRoutingTable::Builder builder;
+    for (size_t i = 0; i < shards.size(); i++) {
+        builder.append({chunkMin(i), chunkMax(i, shards.size()), shards[i]});
+    }
+
+    return builder.done();
+}
+
+/**
+ * Makes a table with 'size' chunks alternating between shards s0 and s1.
+ */
+shared_ptr<const ChunkRoutingTable> makeLargeTable(size_t size) {
+    std::vector<ShardId> shards;
+    for (size_t i = 0; i < size; i++) {
+        shards.push_back(i % 2 ? "s1" : "s0");
+    }
+
+    return makeTable(shards);
+}
+
+TEST(ChunkRoutingTable, Empty) {
+    auto table = makeTable({});
+    ASSERT(table->empty());
+    ASSERT_EQUALS(0U, table->upperBound(BSON("a" << 5)));
+
+    set<ShardId> shardIds;
+    ASSERT_FALSE(table->getShardIdsForRange(BSON("a" << MINKEY), BSON("a" << MAXKEY), &shardIds));
+    ASSERT(shardIds.empty());
+}
+
+TEST(ChunkRoutingTable, SingleChunk) {
+    auto table = makeTable({"s0"});
+    ASSERT_EQUALS(1U, table->size());
+    ASSERT_EQUALS(1U, table->numShards());
+    ASSERT_EQUALS(0U, table->upperBound(BSON("a" << MINKEY)));
+    ASSERT_EQUALS(0U, table->upperBound(BSON("a" << 12345)));
+    ASSERT_EQUALS(1U, table->upperBound(BSON("a" << MAXKEY)));
+}
+
+TEST(ChunkRoutingTable, UpperBoundMatchesChunkBoundaries) {
+    const std::vector<ShardId> shards{"s0", "s1", "s0", "s2", "s2", "s2", "s1", "s0", "s1", "s2"};
+    auto table = makeTable(shards);
+    ASSERT_EQUALS(shards.size(), table->size());
+    ASSERT_EQUALS(3U, table->numShards());
+
+    // A key equal to a chunk's max belongs to the next chunk
+    ASSERT_EQUALS(0U, table->upperBound(BSON("a" << -1)));
+    ASSERT_EQUALS(1U, table->upperBound(BSON("a" << 0)));
+    ASSERT_EQUALS(1U, table->upperBound(BSON("a" << 9)));
+    ASSERT_EQUALS(2U, table->upperBound(BSON("a" << 10)));
+    ASSERT_EQUALS(9U, table->upperBound(BSON("a" << 80)));
+    ASSERT_EQUALS(9U, table->upperBound(BSON("a" << 1000)));
+
+    // Numeric types compare by value, as they do for BSONObj
+    ASSERT_EQUALS(2U, table->upperBound(BSON("a" << 10.5)));
+    ASSERT_EQUALS(2U, table->upperBound(BSON("a" << 10LL)));
+
+    // Non-numeric types sort after numbers
+    ASSERT_EQUALS(9U, table->upperBound(BSON("a"
+                                             << "abc")));
+
+    for (size_t i = 0; i < shards.size(); i++) {
+        ASSERT_EQUALS(shards[i], table->shardIdAt(i));
+    }
+}
+
+TEST(ChunkRoutingTable, ShardBoundaries) {
+    auto table = makeTable({"s0", "s0", "s1", "s2", "s2", "s2", "s0"});
+    ASSERT_EQUALS(2U, table->nextShardBoundary(0));
+    ASSERT_EQUALS(2U, table->nextShardBoundary(1));
+    ASSERT_EQUALS(3U, table->nextShardBoundary(2));
+    ASSERT_EQUALS(6U, table->nextShardBoundary(3));
+    ASSERT_EQUALS(6U, table->nextShardBoundary(5));
+    ASSERT_EQUALS(7U, table->nextShardBoundary(6));
+}
+
+TEST(ChunkRoutingTable, ShardIdsForRange) {
+    auto table = makeTable({"s0", "s0", "s1", "s2", "s2", "s2", "s0"});
+
+    set<ShardId> shardIds;
+    ASSERT(table->getShardIdsForRange(BSON("a" << 1), BSON("a" << 5), &shardIds));
+    ASSERT(set<ShardId>({"s0"}) == shardIds);
+
+    // The chunk containing the upper bound is included
+    shardIds.clear();
+    ASSERT(table->getShardIdsForRange(BSON("a" << 1), BSON("a" << 10), &shardIds));
+    ASSERT(set<ShardId>({"s0", "s1"}) == shardIds);
+
+    shardIds.clear();
+    ASSERT(table->getShardIdsForRange(BSON("a" << 25), BSON("a" << 45), &shardIds));
+    ASSERT(set<ShardId>({"s2"}) == shardIds);
+
+    shardIds.clear();
+    ASSERT(table->getShardIdsForRange(BSON("a" << MINKEY), BSON("a" << MAXKEY), &shardIds));
+    ASSERT(set<ShardId>({"s0", "s1", "s2"}) == shardIds);
+}
+
+TEST(ChunkRoutingTable, CompoundKey) {
+    ChunkRoutingTable::Builder builder;
+    builder.append({BSON("a" << MINKEY << "b" << MINKEY), BSON("a" << 1 << "b" << 5), "s0"});
+    builder.append({BSON("a" << 1 << "b" << 5), BSON("a" << 2 << "b" << MINKEY), "s1"});
+    builder.append({BSON("a" << 2 << "b" << MINKEY), BSON("a" << MAXKEY << "b" << MAXKEY), "s2"});
+    auto table = builder.done();
+
+    ASSERT_EQUALS(0U, table->upperBound(BSON("a" << 1 << "b" << 4)));
+    ASSERT_EQUALS(1U, table->upperBound(BSON("a" << 1 << "b" << 5)));
+    ASSERT_EQUALS(1U, table->upperBound(BSON("a" << 1 << "b" << MAXKEY)));
+    ASSERT_EQUALS(2U, table->upperBound(BSON("a" << 2 << "b" << MINKEY)));
+    ASSERT_EQUALS(2U, table->upperBound(BSON("a" << 3 << "b" << 0)));
+}
+
+TEST(ChunkRoutingTable, BatchUpperBoundsMatchSingleLookups) {
+    const size_t size = 3 * ChunkRoutingTable::kMaxLeafSize + 5;
+    auto table = makeLargeTable(size);
+
+    // Unsorted keys with duplicates, keys equal to chunk bounds and keys past both ends
+    std::vector<BSONObj> keys;
+    for (int key = static_cast<int>(size * 10); key >= -20; key -= 7) {
+        keys.push_back(BSON("a" << key));
+        keys.push_back(BSON("a" << (key / 10) * 10));
+    }
+    keys.push_back(BSON("a" << MAXKEY));
+    keys.push_back(BSON("a" << MINKEY));
+    keys.push_back(BSON("a"
+                        << "abc"));
+
+    std::vector<size_t> positions;
+    table->upperBounds(keys, &positions);
+    ASSERT_EQUALS(keys.size(), positions.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        ASSERT_EQUALS(table->upperBound(keys[i]), positions[i]);
+    }
+
+    makeTable({})->upperBounds(keys, &positions);
+    ASSERT_EQUALS(keys.size(), positions.size());
+    for (size_t position : positions) {
+        ASSERT_EQUALS(0U, position);
+    }
+}
+
+TEST(ChunkRoutingTable, UpdateSplit) {
+    auto table = makeTable({"s0", "s0", "s1", "s2", "s2"});
+
+    // Split [20, 30) in two, moving the upper half to another shard
+    auto updated = table->makeUpdated({{BSON("a" << 20), BSON("a" << 25), "s2"},
+                                       {BSON("a" << 25), BSON("a" << 30), "s0"}});
+    ASSERT(updated);
+    ASSERT_EQUALS(6U, updated->size());
+    ASSERT_EQUALS(3U, updated->upperBound(BSON("a" << 22)));
+    ASSERT_EQUALS(ShardId("s2"), updated->shardIdAt(3));
+    ASSERT_EQUALS(4U, updated->upperBound(BSON("a" << 25)));
+    ASSERT_EQUALS(ShardId("s0"), updated->shardIdAt(4));
+    ASSERT_EQUALS(5U, updated->upperBound(BSON("a" << 30)));
+
+    // The original table is not modified
+    ASSERT_EQUALS(5U, table->size());
+    ASSERT_EQUALS(ShardId("s2"), table->shardIdAt(3));
+}
+
+TEST(ChunkRoutingTable, UpdateMerge) {
+    auto table = makeTable({"s0", "s1", "s1", "s1", "s0"});
+
+    // Merge [0, 10), [10, 20) and [20, 30)
+    auto updated = table->makeUpdated({{BSON("a" << 0), BSON("a" << 30), "s1"}});
+    ASSERT(updated);
+    ASSERT_EQUALS(3U, updated->size());
+    ASSERT_EQUALS(1U, updated->upperBound(BSON("a" << 0)));
+    ASSERT_EQUALS(1U, updated->upperBound(BSON("a" << 29)));
+    ASSERT_EQUALS(2U, updated->upperBound(BSON("a" << 30)));
+    ASSERT_EQUALS(2U, updated->nextShardBoundary(1));
+}
+
+TEST(ChunkRoutingTable, UpdateShards) {
+    auto table = makeTable({"s0", "s1", "s1"});
+    ASSERT_EQUALS(2U, table->numShards());
+
+    // Moving a chunk to a new shard adds it
+    auto updated = table->makeUpdated({{BSON("a" << 0), BSON("a" << 10), "s2"}});
+    ASSERT(updated);
+    ASSERT_EQUALS(3U, updated->numShards());
+
+    set<ShardId> shardIds;
+    ASSERT(updated->getShardIdsForRange(BSON("a" << 5), BSON("a" << 6), &shardIds));
+    ASSERT(set<ShardId>({"s2"}) == shardIds);
+
+    // Moving the last chunk off a shard removes it
+    updated = updated->makeUpdated({{BSON("a" << MINKEY), BSON("a" << 0), "s2"},
+                                    {BSON("a" << 10), BSON("a" << MAXKEY), "s2"}});
+    ASSERT(updated);
+    ASSERT_EQUALS(1U, updated->numShards());
+}
+
+TEST(ChunkRoutingTable, UpdateEmpty) {
+    auto table = makeTable({});
+
+    auto updated = table->makeUpdated({{BSON("a" << 0), BSON("a" << MAXKEY), "s1"},
+                                       {BSON("a" << MINKEY), BSON("a" << 0), "s0"}});
+    ASSERT(updated);
+    ASSERT_EQUALS(2U, updated->size());
+    ASSERT_EQUALS(ShardId("s0"), updated->shardIdAt(0));
+    ASSERT_EQUALS(ShardId("s1"), updated->shardIdAt(1));
+}
+
+TEST(ChunkRoutingTable, UpdateRejectsOverlappingChanges) {
+    auto table = makeTable({"s0", "s1", "s0"});
+    ASSERT_FALSE(table->makeUpdated({{BSON("a" << 0), BSON("a" << 10), "s1"},
+                                     {BSON("a" << 5), BSON("a" << MAXKEY), "s1"}}));
+    ASSERT_FALSE(table->makeUpdated({{BSON("a" << 10), BSON("a" << 0), "s1"}}));
+}
+
+TEST(ChunkRoutingTable, UpdateSharesUntouchedLeaves) {
+    const size_t size = 10 * ChunkRoutingTable::kMaxLeafSize;
+    auto table = makeLargeTable(size);
+    ASSERT_EQUALS(10U, table->numLeaves());
+
+    const size_t middle = size / 2;
+    auto updated = table->makeUpdated({{chunkMin(middle), chunkMax(middle, size), "s2"}});
+    ASSERT(updated);
+    ASSERT_EQUALS(size, updated->size());
+    ASSERT_EQUALS(ShardId("s2"), updated->shardIdAt(middle));
+    ASSERT_EQUALS(9U, updated->numLeavesSharedWith(*table));
+}
+
+TEST(ChunkRoutingTable, ChunkRecords) {
+    const OID epoch = OID::gen();
+
+    ChunkRoutingTable::Builder builder;
+    builder.append({BSON("a" << MINKEY), BSON("a" << 0), "s0", ChunkVersion(1, 0, epoch)});
+    builder.append(
+        {BSON("a" << 0), BSON("a" << MAXKEY), "s1", ChunkVersion(2, 3, epoch), true, 1234});
+    auto table = builder.done();
+
+    ASSERT_EQUALS(epoch, table->epoch());
+    ASSERT_EQUALS(BSON("a" << MINKEY), table->minAt(0));
+    ASSERT_EQUALS(BSON("a" << 0), table->maxAt(0));
+    ASSERT_EQUALS(BSON("a" << 0), table->minAt(1));
+    ASSERT_EQUALS(BSON("a" << MAXKEY), table->maxAt(1));
+    ASSERT(ChunkVersion(1, 0, epoch).equals(table->lastmodAt(0)));
+    ASSERT(ChunkVersion(2, 3, epoch).equals(table->lastmodAt(1)));
+    ASSERT_FALSE(table->isJumboAt(0));
+    ASSERT(table->isJumboAt(1));
+    ASSERT_EQUALS(0, *table->bytesWrittenAt(0));
+    ASSERT_EQUALS(1234, *table->bytesWrittenAt(1));
+}
+
+TEST(ChunkRoutingTable, UpdateKeepsBytesWritten) {
+    const size_t size = 3 * ChunkRoutingTable::kMaxLeafSize;
+    auto table = makeLargeTable(size);
+
+    // Count writes to a chunk of the first leaf and to a chunk of the second one
+    const size_t first = 5;
+    const size_t second = ChunkRoutingTable::kMaxLeafSize + 5;
+    *table->bytesWrittenAt(first) = 100;
+    *table->bytesWrittenAt(second) = 200;
+
+    // Split the chunk after 'second', which rebuilds the second leaf only
+    const BSONObj mid = BSON("a" << static_cast<int>(second * 10 + 5));
+    auto updated =
+        table->makeUpdated({{chunkMin(second + 1), mid, "s2", ChunkVersion(), false, 10},
+                            {mid, chunkMax(second + 1, size), "s2", ChunkVersion(), false, 20}});
+    ASSERT(updated);
+    ASSERT_EQUALS(10, *updated->bytesWrittenAt(second + 1));
+    ASSERT_EQUALS(20, *updated->bytesWrittenAt(second + 2));
+
+    // The first leaf is shared, so writes through either table are counted once
+    ASSERT_EQUALS(100, *updated->bytesWrittenAt(first));
+    *updated->bytesWrittenAt(first) += 50;
+    ASSERT_EQUALS(150, *table->bytesWrittenAt(first));
+
+    // The second leaf was rebuilt with a copy of the counts of the chunks it kept
+    ASSERT_EQUALS(200, *updated->bytesWrittenAt(second));
+    ASSERT_EQUALS(chunkMin(second), updated->minAt(second));
+    ASSERT_EQUALS(mid, updated->maxAt(second + 1));
+    ASSERT_EQUALS(mid, updated->minAt(second + 2));
+
+    // A counter keeps its leaf alive after the table goes away
+    auto counter = updated->bytesWrittenAt(first);
+    table.reset();
+    updated.reset();
+    ASSERT_EQUALS(150, *counter);
+}
+
+TEST(ChunkRoutingTable, LeafPositions) {
+    const size_t size = 3 * ChunkRoutingTable::kMaxLeafSize + 5;
+    auto table = makeLargeTable(size);
+    ASSERT_EQUALS(4U, table->numLeaves());
+
+    size_t total = 0;
+    for (size_t leaf = 0; leaf < table->numLeaves(); leaf++) {
+        ASSERT_EQUALS(total, table->leafStart(leaf));
+        for (size_t i = 0; i < table->leafSize(leaf); i++) {
+            ASSERT_EQUALS(leaf, table->leafFor(total + i));
+        }
+        total += table->leafSize(leaf);
+    }
+    ASSERT_EQUALS(size, total);
+}
+
+TEST(ChunkRoutingTable, UpdateMatchesRebuiltTable) {
+    const size_t size = 5 * ChunkRoutingTable::kMaxLeafSize + 17;
+    auto table = makeLargeTable(size);
+
+    // Split every 7th chunk in two, merge every 11th chunk with the next one and move the chunks
+    // around the leaf boundaries to another shard
+    std::vector<ChunkRoutingTable::Change> changes;
+    ChunkRoutingTable::Builder expectedBuilder;
+
+    for (size_t i = 0; i < size; i++) {
+        const ShardId original(i % 2 ? "s1" : "s0");
+
+        if (i % 11 == 0 && i + 1 < size) {
+            changes.emplace_back(chunkMin(i), chunkMax(i + 1, size), "s3");
+            expectedBuilder.append({chunkMin(i), chunkMax(i + 1, size), "s3"});
+            i++;
+        } else if (i % 7 == 0 && i > 0 && i + 1 < size) {
+            const BSONObj mid = BSON("a" << static_cast<int>((i - 1) * 10 + 5));
+            changes.emplace_back(chunkMin(i), mid, original);
+            changes.emplace_back(mid, chunkMax(i, size), "s2");
+            expectedBuilder.append({chunkMin(i), mid, original});
+            expectedBuilder.append({mid, chunkMax(i, size), "s2"});
+        } else if (i % ChunkRoutingTable::kMaxLeafSize <= 1) {
+            changes.emplace_back(chunkMin(i), chunkMax(i, size), "s2");
+            expectedBuilder.append({chunkMin(i), chunkMax(i, size), "s2"});
+        } else {
+            expectedBuilder.append({chunkMin(i), chunkMax(i, size), original});
+        }
+    }
+
+    auto expected = expectedBuilder.done();
+    auto updated = table->makeUpdated(changes);
+    ASSERT(updated);
+    ASSERT_EQUALS(expected->size(), updated->size());
+    ASSERT_EQUALS(expected->numShards(), updated->numShards());
+
+    for (size_t i = 0; i < expected->size(); i++) {
+        ASSERT_EQUALS(expected->shardIdAt(i), updated->shardIdAt(i));
+        ASSERT_EQUALS(expected->minAt(i), updated->minAt(i));
+        ASSERT_EQUALS(expected->maxAt(i), updated->maxAt(i));
+    }
+
+    for (int key = -5; key < static_cast<int>(size * 10); key += 5) {
+        ASSERT_EQUALS(expected->upperBound(BSON("a" << key)),
+                      updated->upperBound(BSON("a" << key)));
+    }
+
+    set<ShardId> expectedShardIds;
+    set<ShardId> updatedShardIds;
+    ASSERT(expected->getShardIdsForRange(BSON("a" << 300), BSON("a" << 2000), &expectedShardIds));
+    ASSERT(updated->getShardIdsForRange(BSON("a" << 300), BSON("a" << 2000), &updatedShardIds));
+    ASSERT(expectedShardIds == updatedShardIds);
+}
+
+}  // namespace
+}  // namespace mongo
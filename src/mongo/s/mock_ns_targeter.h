@@ -95,6 +95,29 @@ public:
         return Status::OK();
     }
 
+    /**
+     * Targets every document through targetInsert, remembering them for noteInsertBatched.
+     */
+    void targetInserts(OperationContext* txn,
+                       const std::vector<BSONObj>& docs,
+                       std::vector<ShardEndpoint*>* endpoints,
+                       std::vector<Status>* results) const {
+        _lastTargetedInserts = docs;
+        NSTargeter::targetInserts(txn, docs, endpoints, results);
+    }
+
+    void noteInsertBatched(size_t i) const {
+        ASSERT_LESS_THAN(i, _lastTargetedInserts.size());
+        _batchedInserts.push_back(_lastTargetedInserts[i]);
+    }
+
+    /**
+     * Documents reported through noteInsertBatched, in the order they were reported.
+     */
+    const std::vector<BSONObj>& getBatchedInserts() const {
+        return _batchedInserts;
+    }
+
     /**
      * Returns the first ShardEndpoint for the query from the mock ranges.  Only can handle
      * queries of the form { field : { $gte : <value>, $lt : <value> } }.
@@ -207,6 +230,10 @@ private:
 
     // Manually-stored ranges
     OwnedPointerVector<MockRange> _mockRanges;
+
+    // Documents of the last targetInserts call, and those reported through noteInsertBatched
+    mutable std::vector<BSONObj> _lastTargetedInserts;
+    mutable std::vector<BSONObj> _batchedInserts;
 };
 
 inline void assertEndpointsEqual(const ShardEndpoint& endpointA, const ShardEndpoint& endpointB) {
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "mongo/bson/bsonobj.h"
 #include "mongo/base/status.h"
@@ -86,6 +87,34 @@ public:
                                 const BSONObj& doc,
                                 ShardEndpoint** endpoint) const = 0;
 
+    /**
+     * Targets a batch of documents for insertion. Sets (*endpoints)[i] and (*results)[i] to what
+     * targetInsert would have produced for docs[i], so (*endpoints)[i] is NULL wherever
+     * (*results)[i] is not OK. The caller owns the returned endpoints.
+     *
+     * Implementations may locate the documents together more cheaply than one at a time. The
+     * default implementation just calls targetInsert for every document.
+     */
+    virtual void targetInserts(OperationContext* txn,
+                               const std::vector<BSONObj>& docs,
+                               std::vector<ShardEndpoint*>* endpoints,
+                               std::vector<Status>* results) const {
+        endpoints->assign(docs.size(), NULL);
+        results->clear();
+        results->reserve(docs.size());
+        for (size_t i = 0; i < docs.size(); i++) {
+            results->push_back(targetInsert(txn, docs[i], &(*endpoints)[i]));
+        }
+    }
+
+    /**
+     * Notes that docs[i] of the last targetInserts call was added to a write batch. An ordered
+     * batch may stop before it uses all the documents it targeted, and the rest are targeted again
+     * later, so implementations which keep per-document statistics should record them here rather
+     * than in targetInserts. Does nothing by default.
+     */
+    virtual void noteInsertBatched(size_t i) const {}
+
     /**
      * Returns a vector of ShardEndpoints for a potentially multi-shard update.
      *
@@ -36,11 +36,14 @@
 #include "mongo/db/query/cursor_response.h"
 #include "mongo/db/query/getmore_request.h"
 #include "mongo/db/query/killcursors_request.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/executor/remote_command_request.h"
 #include "mongo/executor/remote_command_response.h"
+#include "mongo/rpc/get_status_from_command_result.h"
 #include "mongo/rpc/metadata/server_selection_metadata.h"
 #include "mongo/s/client/shard_registry.h"
 #include "mongo/s/grid.h"
+#include "mongo/s/query/host_latency_tracker.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
 #include "mongo/util/scopeguard.h"
@@ -51,6 +54,130 @@ namespace {
 // Maximum number of retries for network and replication notMaster errors (per host).
 const int kMaxNumFailedHostRetryAttempts = 3;
 
+// Shortest time a request is given to complete before it is hedged, so that hosts which usually
+// reply within a millisecond do not get every request hedged.
+const Milliseconds kMinHedgeDelay(5);
+
+// Whether the command establishing a remote cursor for a read, which may be served by secondaries,
+// is also sent to a second host of the shard when the first one is slower to reply than usual.
+// Configurable with server parameter "enableHedgedReads".
+std::atomic<bool> enableHedgedReads(false);  // NOLINT
+
+ExportedServerParameter<bool, ServerParameterType::kStartupAndRuntime> enableHedgedReadsConfig(
+    ServerParameterSet::getGlobal(), "enableHedgedReads", &enableHedgedReads);
+
+// Percentile of the recent response times of a host past which a request to it gets hedged.
+// Configurable with server parameter "hedgedReadsLatencyPercentile".
+std::atomic<int> hedgedReadsLatencyPercentile(95);  // NOLINT
+
+class HedgedReadsLatencyPercentile
+    : public ExportedServerParameter<int, ServerParameterType::kStartupAndRuntime> {
+public:
+    HedgedReadsLatencyPercentile()
+        : ExportedServerParameter<int, ServerParameterType::kStartupAndRuntime>(
+              ServerParameterSet::getGlobal(),
+              "hedgedReadsLatencyPercentile",
+              &hedgedReadsLatencyPercentile) {}
+
+    virtual Status validate(const int& potentialNewValue) {
+        if (potentialNewValue < 50 || potentialNewValue > 100) {
+            return Status(ErrorCodes::BadValue,
+                          "hedgedReadsLatencyPercentile has to be >= 50 and <= 100");
+        }
+
+        return Status::OK();
+    }
+} hedgedReadsLatencyPercentileConfig;
+
+/**
+ * Returns how long the request establishing a cursor on 'host' may take before it is hedged, or
+ * boost::none if it should not be hedged.
+ */
+boost::optional<Milliseconds> getHedgeDelay(const ReadPreferenceSetting& readPref,
+                                            const HostAndPort& host) {
+    // Only the primary can serve a primary read, so there is no other host to hedge it to
+    if (!enableHedgedReads.load() || readPref.pref == ReadPreference::PrimaryOnly) {
+        return boost::none;
+    }
+
+    auto delay =
+        HostLatencyTracker::get()->getPercentile(host, hedgedReadsLatencyPercentile.load());
+    if (!delay) {
+        return boost::none;
+    }
+
+    return std::max(*delay, kMinHedgeDelay);
+}
+
+/**
+ * Records the response time of a request establishing a cursor, which is what hedging decisions
+ * are based on.
+ */
+void recordInitialResponseLatency(const executor::TaskExecutor::RemoteCommandCallbackArgs& cbData) {
+    if (enableHedgedReads.load() && cbData.response.isOK()) {
+        HostLatencyTracker::get()->recordLatency(cbData.request.target,
+                                                 cbData.response.getValue().elapsedMillis);
+    }
+}
+
+/**
+ * Returns the data of 'response' as an owned object. If it points into the message it was
+ * received in, and the message was received into a shared buffer, the object shares ownership of
+ * that buffer. Otherwise it gets its own copy.
+ */
+BSONObj getOwnedResponseData(const executor::RemoteCommandResponse& response) {
+    BSONObj data = response.data;
+    if (data.isOwned()) {
+        return data;
+    }
+
+    if (response.message) {
+        const SharedBuffer& buffer = response.message->sharedBuffer();
+        const char* const begin = buffer.get();
+        if (begin && data.objdata() >= begin &&
+            data.objdata() + data.objsize() <= begin + response.message->size()) {
+            return data.shareOwnershipWith(buffer);
+        }
+    }
+
+    return data.getOwned();
+}
+
+/**
+ * Returns the id of the cursor which the reply in 'cbData' opened, or 0 if it did not open one.
+ */
+CursorId getCursorIdOpenedBy(const executor::TaskExecutor::RemoteCommandCallbackArgs& cbData) {
+    if (!cbData.response.isOK()) {
+        return 0;
+    }
+
+    auto cursorResponse = CursorResponse::parseFromBSON(cbData.response.getValue().data);
+    if (!cursorResponse.isOK()) {
+        return 0;
+    }
+
+    return cursorResponse.getValue().getCursorId();
+}
+
+/**
+ * Kills the cursor which the reply in 'cbData' may have opened, if any. Used for the reply to the
+ * request of a hedged pair which was not used for the remote.
+ */
+void killCursorOpenedBy(const executor::TaskExecutor::RemoteCommandCallbackArgs& cbData,
+                        const NamespaceString& nss) {
+    const CursorId cursorId = getCursorIdOpenedBy(cbData);
+    if (!cursorId) {
+        return;
+    }
+
+    BSONObj cmdObj = KillCursorsRequest(nss, {cursorId}).toBSON();
+
+    executor::RemoteCommandRequest request(cbData.request.target, nss.db().toString(), cmdObj);
+
+    cbData.executor->scheduleRemoteCommand(
+        request, [](const executor::TaskExecutor::RemoteCommandCallbackArgs&) {});
+}
+
 }  // namespace
 
 AsyncResultsMerger::AsyncResultsMerger(executor::TaskExecutor* executor,
@@ -263,6 +390,7 @@ Status AsyncResultsMerger::askForNextBatch_inlock(size_t remoteIndex) {
     // a full sort as is the case for the OP_QUERY find then this optimization will prevent
     // switching to the full sort plan branch.
     BSONObj cmdObj;
+    boost::optional<Milliseconds> hedgeDelay;
 
     if (remote.cursorId) {
         auto adjustedBatchSize = _params.batchSize;
@@ -287,23 +415,117 @@ Status AsyncResultsMerger::askForNextBatch_inlock(size_t remoteIndex) {
 
         remote.fetchedCount = 0;
         cmdObj = *remote.initialCmdObj;
+
+        hedgeDelay = getHedgeDelay(*_params.readPreference, remote.getTargetHost());
+        if (hedgeDelay) {
+            remote.hedgeRelay = std::make_shared<HedgeRelay>(this, remoteIndex, _params.nsString);
+            remote.hedgeHost = boost::none;
+        }
     }
 
     executor::RemoteCommandRequest request(
         remote.getTargetHost(), _params.nsString.db().toString(), cmdObj, _metadataObj);
 
-    auto callbackStatus = _executor->scheduleRemoteCommand(
-        request,
-        stdx::bind(
-            &AsyncResultsMerger::handleBatchResponse, this, stdx::placeholders::_1, remoteIndex));
+    executor::TaskExecutor::RemoteCommandCallbackFn callback;
+    if (remote.hedgeRelay) {
+        callback = stdx::bind(
+            &AsyncResultsMerger::relayBatchResponse, remote.hedgeRelay, stdx::placeholders::_1);
+    } else {
+        callback = stdx::bind(
+            &AsyncResultsMerger::handleBatchResponse, this, stdx::placeholders::_1, remoteIndex);
+    }
+
+    auto callbackStatus = _executor->scheduleRemoteCommand(request, callback);
     if (!callbackStatus.isOK()) {
+        remote.hedgeRelay.reset();
         return callbackStatus.getStatus();
     }
 
     remote.cbHandle = callbackStatus.getValue();
+
+    if (hedgeDelay) {
+        scheduleHedgeTimer_inlock(remoteIndex, *hedgeDelay);
+    }
+
     return Status::OK();
 }
 
+void AsyncResultsMerger::scheduleHedgeTimer_inlock(size_t remoteIndex, Milliseconds delay) {
+    auto& remote = _remotes[remoteIndex];
+    invariant(remote.hedgeRelay);
+
+    auto timerStatus = _executor->scheduleWorkAt(
+        _executor->now() + delay,
+        stdx::bind(
+            &AsyncResultsMerger::relayHedgeTimer, remote.hedgeRelay, stdx::placeholders::_1));
+    if (!timerStatus.isOK()) {
+        LOG(1) << "Failed to schedule hedging of the request to " << remote.getTargetHost()
+               << causedBy(timerStatus.getStatus());
+        return;
+    }
+
+    remote.hedgeTimerHandle = timerStatus.getValue();
+}
+
+void AsyncResultsMerger::relayHedgeTimer(const std::shared_ptr<HedgeRelay>& relay,
+                                         const executor::TaskExecutor::CallbackArgs& cbData) {
+    stdx::lock_guard<stdx::mutex> lk(relay->mutex);
+    if (relay->arm) {
+        relay->arm->handleHedgeTimer(cbData, relay->remoteIndex);
+    }
+}
+
+void AsyncResultsMerger::handleHedgeTimer(const executor::TaskExecutor::CallbackArgs& cbData,
+                                          size_t remoteIndex) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+
+    auto& remote = _remotes[remoteIndex];
+    remote.hedgeTimerHandle = executor::TaskExecutor::CallbackHandle();
+
+    if (!cbData.status.isOK() || _lifecycleState != kAlive) {
+        return;
+    }
+
+    // The relay is still attached, so the initial request has not completed, and it is only ever
+    // hedged once.
+    invariant(remote.cbHandle.isValid());
+    invariant(!remote.hedgeCbHandle.isValid());
+
+    const auto shard = grid.shardRegistry()->getShardNoReload(*remote.shardId);
+    if (!shard) {
+        return;
+    }
+
+    auto hedgeHostStatus =
+        shard->getTargeter()->findAlternateHost(*_params.readPreference, remote.getTargetHost());
+    if (!hedgeHostStatus.isOK()) {
+        LOG(1) << "Not hedging the request to " << remote.getTargetHost()
+               << causedBy(hedgeHostStatus.getStatus());
+        return;
+    }
+
+    executor::RemoteCommandRequest request(hedgeHostStatus.getValue(),
+                                           _params.nsString.db().toString(),
+                                           *remote.initialCmdObj,
+                                           _metadataObj);
+
+    auto callbackStatus = _executor->scheduleRemoteCommand(
+        request,
+        stdx::bind(
+            &AsyncResultsMerger::relayBatchResponse, remote.hedgeRelay, stdx::placeholders::_1));
+    if (!callbackStatus.isOK()) {
+        LOG(1) << "Failed to hedge the request to " << remote.getTargetHost()
+               << causedBy(callbackStatus.getStatus());
+        return;
+    }
+
+    LOG(1) << "Hedging the request to " << remote.getTargetHost() << " with a request to "
+           << hedgeHostStatus.getValue();
+
+    remote.hedgeHost = std::move(hedgeHostStatus.getValue());
+    remote.hedgeCbHandle = callbackStatus.getValue();
+}
+
 StatusWith<executor::TaskExecutor::EventHandle> AsyncResultsMerger::nextEvent() {
     stdx::lock_guard<stdx::mutex> lk(_mutex);
 
@@ -327,7 +549,8 @@ StatusWith<executor::TaskExecutor::EventHandle> AsyncResultsMerger::nextEvent()
         // It is illegal to call this method if there is an error received from any shard.
         invariant(remote.status.isOK());
 
-        if (!remote.hasNext() && !remote.exhausted() && !remote.cbHandle.isValid()) {
+        if (!remote.hasNext() && !remote.exhausted() && !remote.cbHandle.isValid() &&
+            !remote.hedgeCbHandle.isValid()) {
             // If we already have established a cursor with this remote, and there is no outstanding
             // request for which we have a valid callback handle, then schedule work to retrieve the
             // next batch.
@@ -374,15 +597,107 @@ StatusWith<CursorResponse> AsyncResultsMerger::parseCursorResponse(const BSONObj
     return std::move(cursorResponse);
 }
 
+void AsyncResultsMerger::relayBatchResponse(
+    const std::shared_ptr<HedgeRelay>& relay,
+    const executor::TaskExecutor::RemoteCommandCallbackArgs& cbData) {
+    stdx::lock_guard<stdx::mutex> lk(relay->mutex);
+    if (relay->arm) {
+        relay->arm->handleBatchResponse(cbData, relay->remoteIndex);
+        return;
+    }
+
+    // The other request won, so the remote cursor lives elsewhere. Kill the one this request may
+    // have opened.
+    recordInitialResponseLatency(cbData);
+    killCursorOpenedBy(cbData, relay->nss);
+}
+
+bool AsyncResultsMerger::resolveHedge_inlock(
+    const executor::TaskExecutor::RemoteCommandCallbackArgs& cbData,
+    size_t remoteIndex,
+    bool* disposedOfReply) {
+    auto& remote = _remotes[remoteIndex];
+
+    const bool isHedge = remote.hedgeCbHandle.isValid() && cbData.myHandle == remote.hedgeCbHandle;
+    auto& handle = isHedge ? remote.hedgeCbHandle : remote.cbHandle;
+    auto& otherHandle = isHedge ? remote.cbHandle : remote.hedgeCbHandle;
+
+    handle = executor::TaskExecutor::CallbackHandle();
+
+    if (_lifecycleState != kAlive) {
+        // kill() cancelled the hedged request, but it only completes once the replies to both
+        // requests are back, so the relay stays attached until then. The first cursor opened
+        // becomes the remote's cursor, which the kill closes, and one opened by the other request
+        // is killed right away.
+        if (remote.cursorId) {
+            killCursorOpenedBy(cbData, _params.nsString);
+            *disposedOfReply = true;
+        } else if (isHedge && getCursorIdOpenedBy(cbData)) {
+            remote.promoteHedgeHost();
+        }
+
+        if (!otherHandle.isValid()) {
+            detachHedgeRelay_inlock(remoteIndex);
+        }
+
+        return true;
+    }
+
+    // A failure is only reported once the other request has failed too
+    if (otherHandle.isValid() &&
+        (!cbData.response.isOK() ||
+         !getStatusFromCommandResult(cbData.response.getValue().data).isOK())) {
+        return false;
+    }
+
+    // This reply is the one used for the remote. Drop the other request and detach the relay, so
+    // that its reply gets handled without the ARM. The caller holds the relay's mutex.
+    otherHandle = executor::TaskExecutor::CallbackHandle();
+    detachHedgeRelay_inlock(remoteIndex);
+
+    if (isHedge) {
+        remote.promoteHedgeHost();
+    }
+
+    return true;
+}
+
+void AsyncResultsMerger::detachHedgeRelay_inlock(size_t remoteIndex) {
+    auto& remote = _remotes[remoteIndex];
+
+    remote.hedgeRelay->arm = nullptr;
+    remote.hedgeRelay.reset();
+
+    if (remote.hedgeTimerHandle.isValid()) {
+        _executor->cancel(remote.hedgeTimerHandle);
+        remote.hedgeTimerHandle = executor::TaskExecutor::CallbackHandle();
+    }
+}
+
 void AsyncResultsMerger::handleBatchResponse(
     const executor::TaskExecutor::RemoteCommandCallbackArgs& cbData, size_t remoteIndex) {
     stdx::lock_guard<stdx::mutex> lk(_mutex);
 
     auto& remote = _remotes[remoteIndex];
 
-    // Clear the callback handle. This indicates that we are no longer waiting on a response from
-    // 'remote'.
-    remote.cbHandle = executor::TaskExecutor::CallbackHandle();
+    if (!remote.cursorId) {
+        recordInitialResponseLatency(cbData);
+    }
+
+    // Set if this reply belongs to the losing request of a hedged pair and was already dealt with
+    bool disposedOfReply = false;
+
+    if (remote.hedgeRelay) {
+        // Nothing changes for the remote if this reply is a failure and the other request of the
+        // hedged pair is still outstanding.
+        if (!resolveHedge_inlock(cbData, remoteIndex, &disposedOfReply)) {
+            return;
+        }
+    } else {
+        // Clear the callback handle. This indicates that we are no longer waiting on a response
+        // from 'remote'.
+        remote.cbHandle = executor::TaskExecutor::CallbackHandle();
+    }
 
     // If we're in the process of shutting down then there's no need to process the batch.
     if (_lifecycleState != kAlive) {
@@ -392,8 +707,9 @@ void AsyncResultsMerger::handleBatchResponse(
         signalCurrentEventIfReady_inlock();
 
         // Make a best effort to parse the response and retrieve the cursor id. We need the cursor
-        // id in order to issue a killCursors command against it.
-        if (cbData.response.isOK()) {
+        // id in order to issue a killCursors command against it. A reply which was disposed of
+        // does not hold the remote's cursor, and would overwrite the id of the one to kill.
+        if (cbData.response.isOK() && !disposedOfReply) {
             auto cursorResponse = parseCursorResponse(cbData.response.getValue().data, remote);
             if (cursorResponse.isOK()) {
                 remote.cursorId = cursorResponse.getValue().getCursorId();
@@ -422,9 +738,13 @@ void AsyncResultsMerger::handleBatchResponse(
     // Early return from this point on signal anyone waiting on an event, if ready() is true.
     ScopeGuard signaller = MakeGuard(&AsyncResultsMerger::signalCurrentEventIfReady_inlock, this);
 
+    // The response points into the network message. The buffered documents share ownership of
+    // the buffer the message was received into, so they are handed to the client reply without
+    // being copied until they get serialized into it.
     StatusWith<CursorResponse> cursorResponseStatus(
-        cbData.response.isOK() ? parseCursorResponse(cbData.response.getValue().data, remote)
-                               : cbData.response.getStatus());
+        cbData.response.isOK()
+            ? parseCursorResponse(getOwnedResponseData(cbData.response.getValue()), remote)
+            : cbData.response.getStatus());
 
     if (!cursorResponseStatus.isOK()) {
         // Notify the shard registry of the failure.
@@ -538,7 +858,7 @@ void AsyncResultsMerger::signalCurrentEventIfReady_inlock() {
 
 bool AsyncResultsMerger::haveOutstandingBatchRequests_inlock() {
     for (const auto& remote : _remotes) {
-        if (remote.cbHandle.isValid()) {
+        if (remote.cbHandle.isValid() || remote.hedgeCbHandle.isValid()) {
             return true;
         }
     }
@@ -552,6 +872,7 @@ void AsyncResultsMerger::scheduleKillCursors_inlock() {
 
     for (const auto& remote : _remotes) {
         invariant(!remote.cbHandle.isValid());
+        invariant(!remote.hedgeCbHandle.isValid());
 
         if (remote.status.isOK() && remote.cursorId && !remote.exhausted()) {
             BSONObj cmdObj = KillCursorsRequest(_params.nsString, {*remote.cursorId}).toBSON();
@@ -580,6 +901,20 @@ executor::TaskExecutor::EventHandle AsyncResultsMerger::kill() {
 
     _lifecycleState = kKillStarted;
 
+    // Only one reply of a hedged pair of requests is needed to learn the cursor to kill, so the
+    // hedged requests are cancelled. The kill still waits for their callbacks to run, as it does
+    // for the other outstanding requests.
+    for (auto& remote : _remotes) {
+        if (remote.hedgeCbHandle.isValid()) {
+            _executor->cancel(remote.hedgeCbHandle);
+        }
+
+        if (remote.hedgeTimerHandle.isValid()) {
+            _executor->cancel(remote.hedgeTimerHandle);
+            remote.hedgeTimerHandle = executor::TaskExecutor::CallbackHandle();
+        }
+    }
+
     // Make '_killCursorsScheduledEvent', which we will signal as soon as we have scheduled a
     // killCursors command to run on all the remote shards.
     auto statusWithEvent = _executor->makeEvent();
@@ -652,6 +987,13 @@ Status AsyncResultsMerger::RemoteCursorData::resolveShardIdToHostAndPort(
     return Status::OK();
 }
 
+void AsyncResultsMerger::RemoteCursorData::promoteHedgeHost() {
+    invariant(hedgeHost);
+    invariant(!cursorId);
+
+    _shardHostAndPort = *hedgeHost;
+}
+
 //
 // AsyncResultsMerger::MergingComparator
 //
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <memory>
 #include <queue>
 #include <vector>
 
@@ -66,6 +67,11 @@ class CursorResponse;
  *
  * On any error, the caller is responsible for shutting down the ARM using the kill() method.
  *
+ * When hedged reads are enabled and the read preference allows secondaries, the command which
+ * establishes a remote cursor is also sent to a second host of the shard if the first one has not
+ * replied within a high percentile of its recent response times. The first successful reply
+ * establishes the cursor, and the cursor opened by the other request is killed.
+ *
  * Does not throw exceptions.
  */
 class AsyncResultsMerger {
@@ -164,6 +170,8 @@ public:
     executor::TaskExecutor::EventHandle kill();
 
 private:
+    struct HedgeRelay;
+
     /**
      * We instantiate one of these per remote host. It contains the buffer of results we've
      * retrieved from the host but not yet returned, as well as the cursor id, and any error
@@ -207,6 +215,12 @@ private:
          */
         Status resolveShardIdToHostAndPort(const ReadPreferenceSetting& readPref);
 
+        /**
+         * Moves the remote cursor to 'hedgeHost', after the reply to the hedged request won over
+         * the one from the host selected by resolveShardIdToHostAndPort.
+         */
+        void promoteHedgeHost();
+
         // ShardId on which a cursor will be created.
         const boost::optional<ShardId> shardId;
 
@@ -234,6 +248,16 @@ private:
         // batchSize in getMore when mongod returned less docs than the requested batchSize.
         long long fetchedCount = 0;
 
+        // Set while the command establishing the cursor may be hedged. The replies to the
+        // original and the hedged requests, and the timer which sends the latter, go through it.
+        std::shared_ptr<HedgeRelay> hedgeRelay;
+
+        // Host and callback handle of the hedged request, once it has been sent.
+        boost::optional<HostAndPort> hedgeHost;
+        executor::TaskExecutor::CallbackHandle hedgeCbHandle;
+
+        executor::TaskExecutor::CallbackHandle hedgeTimerHandle;
+
     private:
         // For a cursor, which has shard id associated contains the exact host on which the remote
         // cursor resides.
@@ -253,6 +277,29 @@ private:
         const BSONObj& _sort;
     };
 
+    /**
+     * Forwards the replies to the requests establishing a hedged remote cursor, and the timer
+     * which sends the hedged request, to the ARM. Once either request has produced the reply used
+     * for the remote, the relay is detached, and the reply to the other request is handled without
+     * touching the ARM, which may have been destroyed by the time it arrives.
+     *
+     * The ARM is guaranteed to outlive an attached relay, because the relay is only attached while
+     * at least one of its requests is outstanding.
+     */
+    struct HedgeRelay {
+        HedgeRelay(AsyncResultsMerger* arm, size_t remoteIndex, NamespaceString nss)
+            : arm(arm), remoteIndex(remoteIndex), nss(std::move(nss)) {}
+
+        // Must be held when using 'arm', and is acquired before the ARM's own mutex
+        stdx::mutex mutex;
+
+        // Null once detached
+        AsyncResultsMerger* arm;
+
+        const size_t remoteIndex;
+        const NamespaceString nss;
+    };
+
     enum LifecycleState { kAlive, kKillStarted, kKillComplete };
 
     /**
@@ -261,6 +308,21 @@ private:
     static void handleKillCursorsResponse(
         const executor::TaskExecutor::RemoteCommandCallbackArgs& cbData);
 
+    /**
+     * Callback run for the reply to a request establishing a hedged remote cursor. Passes it on to
+     * handleBatchResponse() while the relay is attached. Otherwise, the other request already won,
+     * so only kills the cursor which this request may have opened.
+     */
+    static void relayBatchResponse(const std::shared_ptr<HedgeRelay>& relay,
+                                   const executor::TaskExecutor::RemoteCommandCallbackArgs& cbData);
+
+    /**
+     * Callback run when the initial request of a hedged remote cursor has been outstanding for too
+     * long. Passes it on to handleHedgeTimer() while the relay is attached.
+     */
+    static void relayHedgeTimer(const std::shared_ptr<HedgeRelay>& relay,
+                                const executor::TaskExecutor::CallbackArgs& cbData);
+
     /**
      * Parses the find or getMore command response object to a CursorResponse.
      *
@@ -279,6 +341,41 @@ private:
      */
     Status askForNextBatch_inlock(size_t remoteIndex);
 
+    /**
+     * Schedules the timer after which the request establishing the cursor of the remote at
+     * 'remoteIndex' is hedged, if it has not completed by then.
+     */
+    void scheduleHedgeTimer_inlock(size_t remoteIndex, Milliseconds delay);
+
+    /**
+     * Sends the command establishing the cursor of the remote at 'remoteIndex' to another host of
+     * its shard as well. Hedging is best effort, so failures are only logged.
+     */
+    void handleHedgeTimer(const executor::TaskExecutor::CallbackArgs& cbData, size_t remoteIndex);
+
+    /**
+     * Called by handleBatchResponse() for the replies to the requests establishing a hedged remote
+     * cursor. Returns true if the reply is the one to use for the remote, which is the first
+     * successful one, or the last one if both failed. In that case, detaches the relay, drops the
+     * other request and moves the remote to the host which replied. Returns false if the reply is
+     * a failure and the other request is still outstanding.
+     *
+     * Once the ARM is being killed, always returns true, and only detaches the relay when the
+     * replies to both requests are back, so that the kill waits for both of them. If the remote
+     * already has a cursor by then, the reply is the other request's: the cursor it may have opened
+     * is killed right away, and '*disposedOfReply' is set to true so that the reply is not used
+     * for the remote.
+     */
+    bool resolveHedge_inlock(const executor::TaskExecutor::RemoteCommandCallbackArgs& cbData,
+                             size_t remoteIndex,
+                             bool* disposedOfReply);
+
+    /**
+     * Detaches the relay of the remote at 'remoteIndex', so that it no longer passes anything on
+     * to the ARM, and cancels the timer which sends its hedged request.
+     */
+    void detachHedgeRelay_inlock(size_t remoteIndex);
+
     /**
      * Checks whether or not the remote cursors are all exhausted.
      */
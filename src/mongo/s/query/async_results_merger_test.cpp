@@ -39,12 +39,16 @@
 #include "mongo/executor/network_interface_mock.h"
 #include "mongo/executor/task_executor.h"
 #include "mongo/executor/thread_pool_task_executor_test_fixture.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/rpc/metadata/server_selection_metadata.h"
 #include "mongo/s/catalog/type_shard.h"
 #include "mongo/s/client/shard_registry.h"
+#include "mongo/s/query/host_latency_tracker.h"
 #include "mongo/s/sharding_test_fixture.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -253,6 +257,54 @@ TEST_F(AsyncResultsMergerTest, ClusterFind) {
     ASSERT(!unittest::assertGet(arm->nextReady()));
 }
 
+TEST_F(AsyncResultsMergerTest, DocumentsShareTheBufferOfTheReplyMessage) {
+    BSONObj findCmd = fromjson("{find: 'testcoll'}");
+    makeCursorFromFindCmd(findCmd, {kTestShardIds[0]});
+
+    auto readyEvent = unittest::assertGet(arm->nextEvent());
+
+    // Lay the reply out in a shared buffer the way the network interface receives it.
+    std::vector<BSONObj> batch = {fromjson("{_id: 1}"), fromjson("{_id: 2}")};
+    const BSONObj reply = CursorResponse(_nss, CursorId(0), batch)
+                              .toBSON(CursorResponse::ResponseType::InitialResponse);
+    const int messageLength = sizeof(MSGHEADER::Value) + reply.objsize();
+    SharedBuffer buffer = SharedBuffer::allocate(messageLength);
+    MsgData::View header(buffer.get());
+    header.setLen(messageLength);
+    header.setOperation(dbCommandReply);
+    memcpy(header.data(), reply.objdata(), reply.objsize());
+
+    const char* const messageStart = buffer.get();
+    const char* const messageEnd = messageStart + messageLength;
+
+    Message message;
+    message.setSharedData(std::move(buffer));
+
+    executor::NetworkInterfaceMock* net = network();
+    net->enterNetwork();
+    RemoteCommandResponse response(std::move(message),
+                                   BSONObj(messageStart + sizeof(MSGHEADER::Value)),
+                                   BSONObj(),
+                                   Milliseconds(0));
+    net->scheduleResponse(
+        net->getNextReadyRequest(), net->now(), executor::TaskExecutor::ResponseStatus(response));
+    net->runReadyNetworkOperations();
+    net->exitNetwork();
+    executor->waitForEvent(readyEvent);
+
+    // The documents point into the buffer of the message and share ownership of it.
+    for (const BSONObj& expected : batch) {
+        ASSERT_TRUE(arm->ready());
+        BSONObj doc = *unittest::assertGet(arm->nextReady());
+        ASSERT_TRUE(doc.isOwned());
+        ASSERT(doc.objdata() > messageStart && doc.objdata() < messageEnd);
+        ASSERT_EQ(expected, doc);
+    }
+
+    ASSERT_TRUE(arm->ready());
+    ASSERT(!unittest::assertGet(arm->nextReady()));
+}
+
 TEST_F(AsyncResultsMergerTest, ClusterFindAndGetMore) {
     BSONObj findCmd = fromjson("{find: 'testcoll', batchSize: 2}");
     makeCursorFromFindCmd(findCmd, kTestShardIds);
@@ -1367,6 +1419,335 @@ TEST_F(AsyncResultsMergerTest, GetMoreRequestWithoutAwaitDataCantHaveMaxTime) {
     executor->waitForEvent(killEvent);
 }
 
+/**
+ * Fixture for the tests of hedged reads, which enables them and makes the first shard look like
+ * it usually replies within 10ms, with FakeShard1HedgeHost as the other host to read from.
+ */
+class AsyncResultsMergerHedgingTest : public AsyncResultsMergerTest {
+public:
+    void setUp() override {
+        AsyncResultsMergerTest::setUp();
+
+        setHedgedReadsEnabled(true);
+
+        for (size_t i = 0; i < HostLatencyTracker::kMaxSamples; ++i) {
+            HostLatencyTracker::get()->recordLatency(kTestShardHosts[0], Milliseconds(10));
+        }
+
+        auto shard = shardRegistry()->getShardNoReload(kTestShardIds[0]);
+        RemoteCommandTargeterMock::get(shard->getTargeter())
+            ->setFindAlternateHostReturnValue(kHedgeHost);
+    }
+
+    void tearDown() override {
+        setHedgedReadsEnabled(false);
+
+        AsyncResultsMergerTest::tearDown();
+    }
+
+protected:
+    static void setHedgedReadsEnabled(bool enabled) {
+        auto param = ServerParameterSet::getGlobal()->getMap().find("enableHedgedReads");
+        ASSERT(param != ServerParameterSet::getGlobal()->getMap().end());
+        ASSERT_OK(param->second->setFromString(enabled ? "true" : "false"));
+    }
+
+    /**
+     * Takes the initial request from the network without replying to it, and lets enough time
+     * pass for it to be hedged.
+     */
+    NetworkInterfaceMock::NetworkOperationIterator stallInitialRequest() {
+        executor::NetworkInterfaceMock* net = network();
+        net->enterNetwork();
+        ASSERT_TRUE(net->hasReadyRequests());
+        auto noi = net->getNextReadyRequest();
+        ASSERT_EQ(kTestShardHosts[0], noi->getRequest().target);
+        net->runUntil(net->now() + Milliseconds(20));
+        net->exitNetwork();
+        return noi;
+    }
+
+    void scheduleResponse(NetworkInterfaceMock::NetworkOperationIterator noi,
+                          const CursorResponse& response) {
+        executor::NetworkInterfaceMock* net = network();
+        net->enterNetwork();
+        net->scheduleResponse(
+            noi,
+            net->now(),
+            RemoteCommandResponse(response.toBSON(CursorResponse::ResponseType::InitialResponse),
+                                  BSONObj(),
+                                  Milliseconds(0)));
+        net->runReadyNetworkOperations();
+        net->exitNetwork();
+    }
+
+    const HostAndPort kHedgeHost = HostAndPort("FakeShard1HedgeHost", 12345);
+    const ReadPreferenceSetting kSecondaryPreferred =
+        ReadPreferenceSetting(ReadPreference::SecondaryPreferred);
+};
+
+TEST_F(AsyncResultsMergerHedgingTest, HedgedRequestWinsAndOtherCursorIsKilled) {
+    BSONObj findCmd = fromjson("{find: 'testcoll'}");
+    makeCursorFromFindCmd(findCmd, {kTestShardIds[0]}, boost::none, kSecondaryPreferred);
+
+    auto readyEvent = unittest::assertGet(arm->nextEvent());
+    auto initialRequest = stallInitialRequest();
+    ASSERT_FALSE(arm->ready());
+
+    // The same command went to the other host
+    auto hedgedRequest = getFirstPendingRequest();
+    ASSERT_EQ(kHedgeHost, hedgedRequest.target);
+    ASSERT_EQ(findCmd, hedgedRequest.cmdObj);
+
+    std::vector<CursorResponse> responses;
+    std::vector<BSONObj> batch = {fromjson("{_id: 1}"), fromjson("{_id: 2}")};
+    responses.emplace_back(_nss, CursorId(123), batch);
+    scheduleNetworkResponses(std::move(responses), CursorResponse::ResponseType::InitialResponse);
+
+    executor->waitForEvent(readyEvent);
+    ASSERT_TRUE(arm->ready());
+    ASSERT_EQ(fromjson("{_id: 1}"), *unittest::assertGet(arm->nextReady()));
+    ASSERT_EQ(fromjson("{_id: 2}"), *unittest::assertGet(arm->nextReady()));
+    ASSERT_FALSE(arm->ready());
+
+    // The slow host replies late. The cursor it opened gets killed, and the next batch is
+    // requested from the host which won.
+    scheduleResponse(initialRequest, CursorResponse(_nss, CursorId(456), {fromjson("{_id: 3}")}));
+
+    BSONObj expectedKillCmdObj = BSON("killCursors"
+                                      << "testcoll"
+                                      << "cursors" << BSON_ARRAY(CursorId(456)));
+    auto killRequest = getFirstPendingRequest();
+    ASSERT_EQ(kTestShardHosts[0], killRequest.target);
+    ASSERT_EQ(expectedKillCmdObj, killRequest.cmdObj);
+    scheduleNetworkResponseObjs({BSON("ok" << 1)});
+
+    readyEvent = unittest::assertGet(arm->nextEvent());
+    auto getMoreRequest = getFirstPendingRequest();
+    ASSERT_EQ(kHedgeHost, getMoreRequest.target);
+    ASSERT_EQ(CursorId(123),
+              unittest::assertGet(GetMoreRequest::parseFromBSON("testdb", getMoreRequest.cmdObj))
+                  .cursorid);
+
+    responses.clear();
+    std::vector<BSONObj> batch2 = {fromjson("{_id: 3}")};
+    responses.emplace_back(_nss, CursorId(0), batch2);
+    scheduleNetworkResponses(std::move(responses),
+                             CursorResponse::ResponseType::SubsequentResponse);
+
+    executor->waitForEvent(readyEvent);
+    ASSERT_EQ(fromjson("{_id: 3}"), *unittest::assertGet(arm->nextReady()));
+    ASSERT_TRUE(arm->ready());
+    ASSERT(!unittest::assertGet(arm->nextReady()));
+    ASSERT_TRUE(arm->remotesExhausted());
+}
+
+TEST_F(AsyncResultsMergerHedgingTest, FailedHedgedRequestWaitsForInitialRequest) {
+    BSONObj findCmd = fromjson("{find: 'testcoll'}");
+    makeCursorFromFindCmd(findCmd, {kTestShardIds[0]}, boost::none, kSecondaryPreferred);
+
+    auto readyEvent = unittest::assertGet(arm->nextEvent());
+    auto initialRequest = stallInitialRequest();
+
+    ASSERT_EQ(kHedgeHost, getFirstPendingRequest().target);
+    scheduleErrorResponse({ErrorCodes::HostUnreachable, "host unreachable"});
+
+    // The failure is not reported while the initial request may still succeed
+    ASSERT_FALSE(arm->ready());
+
+    scheduleResponse(initialRequest, CursorResponse(_nss, CursorId(0), {fromjson("{_id: 1}")}));
+
+    executor->waitForEvent(readyEvent);
+    ASSERT_EQ(fromjson("{_id: 1}"), *unittest::assertGet(arm->nextReady()));
+    ASSERT_TRUE(arm->ready());
+    ASSERT(!unittest::assertGet(arm->nextReady()));
+    ASSERT_TRUE(arm->remotesExhausted());
+}
+
+TEST_F(AsyncResultsMergerHedgingTest, KillCancelsHedgedRequest) {
+    BSONObj findCmd = fromjson("{find: 'testcoll'}");
+    makeCursorFromFindCmd(findCmd, {kTestShardIds[0]}, boost::none, kSecondaryPreferred);
+
+    auto readyEvent = unittest::assertGet(arm->nextEvent());
+    auto initialRequest = stallInitialRequest();
+    ASSERT_EQ(kHedgeHost, getFirstPendingRequest().target);
+
+    auto killedEvent = arm->kill();
+
+    // The hedged request is cancelled, and the kill then waits for the initial request only
+    executor::NetworkInterfaceMock* net = network();
+    net->enterNetwork();
+    net->runReadyNetworkOperations();
+    ASSERT_FALSE(net->hasReadyRequests());
+    net->exitNetwork();
+
+    scheduleResponse(initialRequest, CursorResponse(_nss, CursorId(123), {fromjson("{_id: 1}")}));
+
+    BSONObj expectedKillCmdObj = BSON("killCursors"
+                                      << "testcoll"
+                                      << "cursors" << BSON_ARRAY(CursorId(123)));
+    auto killRequest = getFirstPendingRequest();
+    ASSERT_EQ(kTestShardHosts[0], killRequest.target);
+    ASSERT_EQ(expectedKillCmdObj, killRequest.cmdObj);
+
+    executor->waitForEvent(readyEvent);
+    executor->waitForEvent(killedEvent);
+}
+
+TEST_F(AsyncResultsMergerHedgingTest, KillWaitsForHedgedRequest) {
+    BSONObj findCmd = fromjson("{find: 'testcoll'}");
+    makeCursorFromFindCmd(findCmd, {kTestShardIds[0]}, boost::none, kSecondaryPreferred);
+
+    auto readyEvent = unittest::assertGet(arm->nextEvent());
+    auto initialRequest = stallInitialRequest();
+
+    // The hedged request is already in progress, so cancelling it has no effect
+    executor::NetworkInterfaceMock* net = network();
+    net->enterNetwork();
+    auto hedgedRequest = net->getNextReadyRequest();
+    ASSERT_EQ(kHedgeHost, hedgedRequest->getRequest().target);
+    net->exitNetwork();
+
+    auto killedEvent = arm->kill();
+
+    // The cursor opened by the initial request is not killed while the hedged request is still
+    // outstanding, as the kill is not complete until then
+    scheduleResponse(initialRequest, CursorResponse(_nss, CursorId(123), {fromjson("{_id: 1}")}));
+
+    net->enterNetwork();
+    ASSERT_FALSE(net->hasReadyRequests());
+    net->exitNetwork();
+
+    // Both cursors get killed once the hedged request opened one too
+    scheduleResponse(hedgedRequest, CursorResponse(_nss, CursorId(456), {fromjson("{_id: 1}")}));
+
+    net->enterNetwork();
+    ASSERT_TRUE(net->hasReadyRequests());
+    auto killHedgedRequest = net->getNextReadyRequest();
+    ASSERT_EQ(kHedgeHost, killHedgedRequest->getRequest().target);
+    ASSERT_EQ(BSON("killCursors"
+                   << "testcoll"
+                   << "cursors" << BSON_ARRAY(CursorId(456))),
+              killHedgedRequest->getRequest().cmdObj);
+    net->scheduleResponse(killHedgedRequest,
+                          net->now(),
+                          RemoteCommandResponse(BSON("ok" << 1), BSONObj(), Milliseconds(0)));
+    net->runReadyNetworkOperations();
+    net->exitNetwork();
+
+    auto killInitialRequest = getFirstPendingRequest();
+    ASSERT_EQ(kTestShardHosts[0], killInitialRequest.target);
+    ASSERT_EQ(BSON("killCursors"
+                   << "testcoll"
+                   << "cursors" << BSON_ARRAY(CursorId(123))),
+              killInitialRequest.cmdObj);
+
+    executor->waitForEvent(readyEvent);
+    executor->waitForEvent(killedEvent);
+}
+
+TEST_F(AsyncResultsMergerHedgingTest, KillAfterHedgedRequestWinsKillsBothCursors) {
+    BSONObj findCmd = fromjson("{find: 'testcoll'}");
+    makeCursorFromFindCmd(findCmd, {kTestShardIds[0]}, boost::none, kSecondaryPreferred);
+
+    auto readyEvent = unittest::assertGet(arm->nextEvent());
+    auto initialRequest = stallInitialRequest();
+
+    executor::NetworkInterfaceMock* net = network();
+    net->enterNetwork();
+    auto hedgedRequest = net->getNextReadyRequest();
+    ASSERT_EQ(kHedgeHost, hedgedRequest->getRequest().target);
+    net->exitNetwork();
+
+    auto killedEvent = arm->kill();
+
+    // The hedged request opens the remote's cursor first
+    scheduleResponse(hedgedRequest, CursorResponse(_nss, CursorId(456), {fromjson("{_id: 1}")}));
+
+    net->enterNetwork();
+    ASSERT_FALSE(net->hasReadyRequests());
+    net->exitNetwork();
+
+    // The cursor opened by the initial request is killed on its own host, and the remote's cursor
+    // on the host of the hedged request
+    scheduleResponse(initialRequest, CursorResponse(_nss, CursorId(123), {fromjson("{_id: 1}")}));
+
+    net->enterNetwork();
+    ASSERT_TRUE(net->hasReadyRequests());
+    auto killInitialRequest = net->getNextReadyRequest();
+    ASSERT_EQ(kTestShardHosts[0], killInitialRequest->getRequest().target);
+    ASSERT_EQ(BSON("killCursors"
+                   << "testcoll"
+                   << "cursors" << BSON_ARRAY(CursorId(123))),
+              killInitialRequest->getRequest().cmdObj);
+    net->scheduleResponse(killInitialRequest,
+                          net->now(),
+                          RemoteCommandResponse(BSON("ok" << 1), BSONObj(), Milliseconds(0)));
+    net->runReadyNetworkOperations();
+    net->exitNetwork();
+
+    auto killHedgedRequest = getFirstPendingRequest();
+    ASSERT_EQ(kHedgeHost, killHedgedRequest.target);
+    ASSERT_EQ(BSON("killCursors"
+                   << "testcoll"
+                   << "cursors" << BSON_ARRAY(CursorId(456))),
+              killHedgedRequest.cmdObj);
+
+    executor->waitForEvent(readyEvent);
+    executor->waitForEvent(killedEvent);
+}
+
+TEST_F(AsyncResultsMergerHedgingTest, KillIgnoresCursorIdOfLosingHedgedReply) {
+    BSONObj findCmd = fromjson("{find: 'testcoll'}");
+    makeCursorFromFindCmd(findCmd, {kTestShardIds[0]}, boost::none, kSecondaryPreferred);
+
+    auto readyEvent = unittest::assertGet(arm->nextEvent());
+    auto initialRequest = stallInitialRequest();
+
+    executor::NetworkInterfaceMock* net = network();
+    net->enterNetwork();
+    auto hedgedRequest = net->getNextReadyRequest();
+    ASSERT_EQ(kHedgeHost, hedgedRequest->getRequest().target);
+    net->exitNetwork();
+
+    auto killedEvent = arm->kill();
+
+    scheduleResponse(initialRequest, CursorResponse(_nss, CursorId(123), {fromjson("{_id: 1}")}));
+
+    // The hedged request returns all its results at once. Its cursor id of 0 must not replace the
+    // id of the remote's cursor, which still needs to be killed.
+    scheduleResponse(hedgedRequest, CursorResponse(_nss, CursorId(0), {fromjson("{_id: 1}")}));
+
+    auto killRequest = getFirstPendingRequest();
+    ASSERT_EQ(kTestShardHosts[0], killRequest.target);
+    ASSERT_EQ(BSON("killCursors"
+                   << "testcoll"
+                   << "cursors" << BSON_ARRAY(CursorId(123))),
+              killRequest.cmdObj);
+
+    executor->waitForEvent(readyEvent);
+    executor->waitForEvent(killedEvent);
+}
+
+TEST_F(AsyncResultsMergerHedgingTest, PrimaryReadsAreNotHedged) {
+    BSONObj findCmd = fromjson("{find: 'testcoll'}");
+    makeCursorFromFindCmd(findCmd, {kTestShardIds[0]});
+
+    auto readyEvent = unittest::assertGet(arm->nextEvent());
+    auto initialRequest = stallInitialRequest();
+
+    executor::NetworkInterfaceMock* net = network();
+    net->enterNetwork();
+    ASSERT_FALSE(net->hasReadyRequests());
+    net->exitNetwork();
+
+    scheduleResponse(initialRequest, CursorResponse(_nss, CursorId(0), {fromjson("{_id: 1}")}));
+
+    executor->waitForEvent(readyEvent);
+    ASSERT_EQ(fromjson("{_id: 1}"), *unittest::assertGet(arm->nextReady()));
+    ASSERT_TRUE(arm->remotesExhausted());
+}
+
 }  // namespace
 
 }  // namespace mongo
@@ -0,0 +1,87 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/s/query/host_latency_tracker.h"
+
+#include <algorithm>
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+const size_t HostLatencyTracker::kMaxSamples;
+const size_t HostLatencyTracker::kMinSamples;
+
+HostLatencyTracker* HostLatencyTracker::get() {
+    static HostLatencyTracker globalTracker;
+    return &globalTracker;
+}
+
+void HostLatencyTracker::recordLatency(const HostAndPort& host, Milliseconds latency) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+
+    auto& samples = _samples[host];
+    if (samples.latencies.size() < kMaxSamples) {
+        samples.latencies.push_back(latency);
+        return;
+    }
+
+    samples.latencies[samples.next] = latency;
+    samples.next = (samples.next + 1) % kMaxSamples;
+}
+
+boost::optional<Milliseconds> HostLatencyTracker::getPercentile(const HostAndPort& host,
+                                                                int percentile) const {
+    invariant(percentile >= 0 && percentile <= 100);
+
+    std::vector<Milliseconds> latencies;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+
+        auto it = _samples.find(host);
+        if (it == _samples.end() || it->second.latencies.size() < kMinSamples) {
+            return boost::none;
+        }
+
+        latencies = it->second.latencies;
+    }
+
+    // Nearest-rank percentile. The ring is small, so selecting over a copy is cheaper than keeping
+    // the samples ordered as they come in.
+    size_t rank = (latencies.size() * percentile + 99) / 100;
+    if (rank > 0) {
+        --rank;
+    }
+
+    std::nth_element(latencies.begin(), latencies.begin() + rank, latencies.end());
+    return latencies[rank];
+}
+
+}  // namespace mongo
@@ -0,0 +1,91 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <unordered_map>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/net/hostandport.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+/**
+ * Keeps the most recent response times observed for requests sent to each remote host, so that
+ * what counts as an unusually slow response can be judged per host.
+ *
+ * Thread-safe.
+ */
+class HostLatencyTracker {
+    MONGO_DISALLOW_COPYING(HostLatencyTracker);
+
+public:
+    // Number of most recent samples kept per host
+    static const size_t kMaxSamples = 128;
+
+    // Number of samples needed before a percentile is reported for a host
+    static const size_t kMinSamples = 16;
+
+    HostLatencyTracker() = default;
+
+    /**
+     * Returns the tracker shared by all the cursors of this process.
+     */
+    static HostLatencyTracker* get();
+
+    /**
+     * Records that a request to 'host' took 'latency' to complete. Once kMaxSamples have been
+     * recorded for the host, replaces its oldest sample.
+     */
+    void recordLatency(const HostAndPort& host, Milliseconds latency);
+
+    /**
+     * Returns the response time under which the given percentage of the recent requests to 'host'
+     * completed, or boost::none if fewer than kMinSamples requests to it have been recorded.
+     * 'percentile' must be in [0, 100].
+     */
+    boost::optional<Milliseconds> getPercentile(const HostAndPort& host, int percentile) const;
+
+private:
+    struct Samples {
+        std::vector<Milliseconds> latencies;
+
+        // Position in 'latencies' which the next sample overwrites, once it is full
+        size_t next = 0;
+    };
+
+    mutable stdx::mutex _mutex;
+
+    std::unordered_map<HostAndPort, Samples> _samples;
+};
+
+}  // namespace mongo
@@ -0,0 +1,99 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/s/query/host_latency_tracker.h"
+
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+
+namespace {
+
+const HostAndPort kHost("FakeHost", 12345);
+const HostAndPort kOtherHost("FakeOtherHost", 12345);
+
+TEST(HostLatencyTrackerTest, NoPercentileUntilEnoughSamples) {
+    HostLatencyTracker tracker;
+    ASSERT_FALSE(tracker.getPercentile(kHost, 50));
+
+    for (size_t i = 1; i < HostLatencyTracker::kMinSamples; ++i) {
+        tracker.recordLatency(kHost, Milliseconds(10));
+    }
+    ASSERT_FALSE(tracker.getPercentile(kHost, 50));
+
+    tracker.recordLatency(kHost, Milliseconds(10));
+    ASSERT_EQ(Milliseconds(10), *tracker.getPercentile(kHost, 50));
+}
+
+TEST(HostLatencyTrackerTest, PercentilesAreNearestRank) {
+    HostLatencyTracker tracker;
+    for (int i = 100; i >= 1; --i) {
+        tracker.recordLatency(kHost, Milliseconds(i));
+    }
+
+    ASSERT_EQ(Milliseconds(1), *tracker.getPercentile(kHost, 0));
+    ASSERT_EQ(Milliseconds(1), *tracker.getPercentile(kHost, 1));
+    ASSERT_EQ(Milliseconds(50), *tracker.getPercentile(kHost, 50));
+    ASSERT_EQ(Milliseconds(95), *tracker.getPercentile(kHost, 95));
+    ASSERT_EQ(Milliseconds(100), *tracker.getPercentile(kHost, 100));
+}
+
+TEST(HostLatencyTrackerTest, HostsAreTrackedSeparately) {
+    HostLatencyTracker tracker;
+    for (size_t i = 0; i < HostLatencyTracker::kMinSamples; ++i) {
+        tracker.recordLatency(kHost, Milliseconds(10));
+        tracker.recordLatency(kOtherHost, Milliseconds(200));
+    }
+
+    ASSERT_EQ(Milliseconds(10), *tracker.getPercentile(kHost, 99));
+    ASSERT_EQ(Milliseconds(200), *tracker.getPercentile(kOtherHost, 1));
+}
+
+TEST(HostLatencyTrackerTest, OldestSamplesAreReplaced) {
+    HostLatencyTracker tracker;
+    for (size_t i = 0; i < HostLatencyTracker::kMaxSamples; ++i) {
+        tracker.recordLatency(kHost, Milliseconds(1000));
+    }
+    ASSERT_EQ(Milliseconds(1000), *tracker.getPercentile(kHost, 1));
+
+    // Replace all but one of the slow samples
+    for (size_t i = 1; i < HostLatencyTracker::kMaxSamples; ++i) {
+        tracker.recordLatency(kHost, Milliseconds(5));
+    }
+    ASSERT_EQ(Milliseconds(5), *tracker.getPercentile(kHost, 99));
+    ASSERT_EQ(Milliseconds(1000), *tracker.getPercentile(kHost, 100));
+
+    tracker.recordLatency(kHost, Milliseconds(5));
+    ASSERT_EQ(Milliseconds(5), *tracker.getPercentile(kHost, 100));
+}
+
+}  // namespace
+
+}  // namespace mongo
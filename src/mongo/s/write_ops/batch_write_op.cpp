@@ -30,6 +30,8 @@
 
 #include "mongo/s/write_ops/batch_write_op.h"
 
+#include <algorithm>
+
 #include "mongo/base/error_codes.h"
 
 namespace mongo {
@@ -198,6 +200,95 @@ static bool wouldMakeBatchesTooBig(const vector<TargetedWrite*>& writes,
     return false;
 }
 
+// Ordered batches stop at the first write which goes to a different shard, so their inserts are
+// targeted ahead in windows which start small and double every time one is used up. Unordered
+// batches target all of their ready inserts at once.
+static const size_t kMinInsertTargetingWindow = 8;
+static const size_t kMaxInsertTargetingWindow = 1000;
+
+namespace {
+
+/**
+ * Targets the ready inserts of a batch ahead of time through NSTargeter::targetInserts, so the
+ * targeter can locate a whole window of documents in a single pass instead of one at a time.
+ */
+class InsertTargetingWindow {
+    MONGO_DISALLOW_COPYING(InsertTargetingWindow);
+
+public:
+    InsertTargetingWindow(WriteOp* writeOps, size_t numWriteOps, bool ordered)
+        : _writeOps(writeOps),
+          _numWriteOps(numWriteOps),
+          _windowSize(ordered ? kMinInsertTargetingWindow : kMaxInsertTargetingWindow),
+          _start(0),
+          _end(0) {}
+
+    /**
+     * Returns the targeting result of the ready insert at 'opIndex', and sets *endpoint to where
+     * it goes if it is OK. Ops must be requested in ascending order.
+     */
+    Status target(OperationContext* txn,
+                  const NSTargeter& targeter,
+                  size_t opIndex,
+                  const ShardEndpoint** endpoint) {
+        if (opIndex >= _end) {
+            _fill(txn, targeter, opIndex);
+        }
+
+        const int slot = _slots[opIndex - _start];
+        dassert(slot >= 0);
+
+        *endpoint = _endpoints.vector()[slot];
+        return _results[slot];
+    }
+
+    /**
+     * Tells the targeter that the insert at 'opIndex', which must have been targeted by the last
+     * call to target(), was added to a batch.
+     */
+    void noteBatched(const NSTargeter& targeter, size_t opIndex) {
+        dassert(opIndex >= _start && opIndex < _end);
+        targeter.noteInsertBatched(_slots[opIndex - _start]);
+    }
+
+private:
+    void _fill(OperationContext* txn, const NSTargeter& targeter, size_t start) {
+        _start = start;
+        _end = std::min(start + _windowSize, _numWriteOps);
+        _windowSize = std::min(_windowSize * 2, kMaxInsertTargetingWindow);
+
+        vector<BSONObj> docs;
+        _slots.assign(_end - _start, -1);
+        for (size_t i = _start; i < _end; i++) {
+            if (_writeOps[i].getWriteState() != WriteOpState_Ready)
+                continue;
+
+            _slots[i - _start] = docs.size();
+            docs.push_back(_writeOps[i].getWriteItem().getDocument());
+        }
+
+        _endpoints.clear();
+        targeter.targetInserts(txn, docs, &_endpoints.mutableVector(), &_results);
+    }
+
+    WriteOp* const _writeOps;
+    const size_t _numWriteOps;
+
+    // Number of ops covered by the next window
+    size_t _windowSize;
+
+    // Ops [_start, _end) are targeted, _slots maps each of them to its entry of _endpoints and
+    // _results, or to -1 if it was not ready
+    size_t _start;
+    size_t _end;
+    vector<int> _slots;
+
+    OwnedPointerVector<ShardEndpoint> _endpoints;
+    vector<Status> _results;
+};
+
+}  // namespace
+
 // Helper function to cancel all the write ops of targeted batches in a map
 static void cancelBatches(const WriteErrorDetail& why,
                           WriteOp* writeOps,
@@ -273,6 +364,12 @@ Status BatchWriteOp::targetBatch(OperationContext* txn,
     int numTargetErrors = 0;
 
     size_t numWriteOps = _clientRequest->sizeWriteOps();
+
+    // TODO: Remove the index targeting stuff once there is a command for it
+    const bool preTargetInserts =
+        _clientRequest->getBatchType() == BatchedCommandRequest::BatchType_Insert &&
+        !_clientRequest->isInsertIndexRequest();
+    InsertTargetingWindow insertWindow(_writeOps, numWriteOps, ordered);
     for (size_t i = 0; i < numWriteOps; ++i) {
         WriteOp& writeOp = _writeOps[i];
 
@@ -288,7 +385,16 @@ Status BatchWriteOp::targetBatch(OperationContext* txn,
         OwnedPointerVector<TargetedWrite> writesOwned;
         vector<TargetedWrite*>& writes = writesOwned.mutableVector();
 
-        Status targetStatus = writeOp.targetWrites(txn, targeter, &writes);
+        Status targetStatus = Status::OK();
+        if (preTargetInserts) {
+            const ShardEndpoint* endpoint = NULL;
+            targetStatus = insertWindow.target(txn, targeter, i, &endpoint);
+            if (targetStatus.isOK()) {
+                writeOp.targetInsertWrite(*endpoint, &writes);
+            }
+        } else {
+            targetStatus = writeOp.targetWrites(txn, targeter, &writes);
+        }
 
         if (!targetStatus.isOK()) {
             WriteErrorDetail targetError;
@@ -373,6 +479,10 @@ Status BatchWriteOp::targetBatch(OperationContext* txn,
         // Relinquish ownership of TargetedWrites, now the TargetedBatches own them
         writesOwned.mutableVector().clear();
 
+        if (preTargetInserts) {
+            insertWindow.noteBatched(targeter, i);
+        }
+
         //
         // Break if we're ordered and we have more than one endpoint - later writes cannot be
         // enforced as ordered across multiple shard endpoints.
@@ -523,6 +523,62 @@ TEST(WriteOpTests, MultiOpTwoShardsOrdered) {
     ASSERT_EQUALS(clientResponse.getN(), 2);
 }
 
+TEST(WriteOpTests, MultiOpAlternatingShardsOrderedNotesEachInsertOnce) {
+    //
+    // Ordered inserts which alternate between shards are targeted ahead in windows, but each
+    // batch only takes the inserts up to the first one for another shard. Every insert must be
+    // reported to the targeter as batched exactly once, even though most are targeted several
+    // times.
+    //
+
+    OperationContextNoop txn;
+    NamespaceString nss("foo.bar");
+    ShardEndpoint endpointA("shardA", ChunkVersion::IGNORED());
+    ShardEndpoint endpointB("shardB", ChunkVersion::IGNORED());
+    MockNSTargeter targeter;
+    initTargeterSplitRange(nss, endpointA, endpointB, &targeter);
+
+    const int numDocs = 20;
+    BatchedCommandRequest request(BatchedCommandRequest::BatchType_Insert);
+    request.setNS(nss);
+    request.setOrdered(true);
+    for (int i = 0; i < numDocs; i++) {
+        // Two inserts to shardA, then two to shardB, and so on
+        request.getInsertRequest()->addToDocuments(BSON("x" << ((i / 2) % 2 ? i + 1 : -(i + 1))));
+    }
+
+    BatchWriteOp batchOp;
+    batchOp.initClientRequest(&request);
+
+    BatchedCommandResponse response;
+    int numBatches = 0;
+    while (!batchOp.isFinished()) {
+        OwnedPointerVector<TargetedWriteBatch> targetedOwned;
+        vector<TargetedWriteBatch*>& targeted = targetedOwned.mutableVector();
+        Status status = batchOp.targetBatch(&txn, targeter, false, &targeted);
+        ASSERT(status.isOK());
+        ASSERT_EQUALS(targeted.size(), 1u);
+        ASSERT_EQUALS(targeted.front()->getWrites().size(), 2u);
+
+        buildResponse(2, &response);
+        batchOp.noteBatchResponse(*targeted.front(), response, NULL);
+        numBatches++;
+    }
+
+    ASSERT_EQUALS(numBatches, numDocs / 2);
+
+    const vector<BSONObj>& batched = targeter.getBatchedInserts();
+    ASSERT_EQUALS(batched.size(), static_cast<size_t>(numDocs));
+    for (int i = 0; i < numDocs; i++) {
+        ASSERT_EQUALS(batched[i], request.getInsertRequest()->getDocumentsAt(i));
+    }
+
+    BatchedCommandResponse clientResponse;
+    batchOp.buildClientResponse(&clientResponse);
+    ASSERT(clientResponse.getOk());
+    ASSERT_EQUALS(clientResponse.getN(), numDocs);
+}
+
 TEST(WriteOpTests, MultiOpTwoShardsUnordered) {
     //
     // Multi-op, multi-endpoint targeting test (unordered)
@@ -126,6 +126,13 @@ public:
                         const NSTargeter& targeter,
                         std::vector<TargetedWrite*>* targetedWrites);
 
+    /**
+     * Same as targetWrites, for an insert whose document has already been targeted to 'endpoint',
+     * for example through NSTargeter::targetInserts. Cannot be used for index inserts.
+     */
+    void targetInsertWrite(const ShardEndpoint& endpoint,
+                           std::vector<TargetedWrite*>* targetedWrites);
+
     /**
      * Returns the number of child writes that were last targeted.
      */
@@ -169,6 +176,12 @@ private:
      */
     void updateOpState();
 
+    /**
+     * Adds a pending child write to 'endpoint' and the TargetedWrite which sends it.
+     */
+    void addTargetedWrite(const ShardEndpoint& endpoint,
+                          std::vector<TargetedWrite*>* targetedWrites);
+
     // Owned elsewhere, reference to a batch with a write item
     const BatchItemRef _itemRef;
 
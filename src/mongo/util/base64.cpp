@@ -41,7 +41,10 @@ namespace base64 {
 
 Alphabet alphabet;
 
-void encode(stringstream& ss, const char* data, int size) {
+namespace {
+
+template <typename Stream>
+void encodeTo(Stream& ss, const char* data, int size) {
     for (int i = 0; i < size; i += 3) {
         int left = size - i;
         const unsigned char* start = (const unsigned char*)data + i;
@@ -79,6 +82,16 @@ void encode(stringstream& ss, const char* data, int size) {
     }
 }
 
+}  // namespace
+
+void encode(stringstream& ss, const char* data, int size) {
+    encodeTo(ss, data, size);
+}
+
+void encode(StringBuilder& sb, const char* data, int size) {
+    encodeTo(sb, data, size);
+}
+
 
 string encode(const char* data, int size) {
     stringstream ss;
@@ -30,6 +30,7 @@
 #pragma once
 
 
+#include "mongo/bson/util/builder.h"
 #include "mongo/util/assert_util.h"
 
 namespace mongo {
@@ -72,6 +73,7 @@ extern Alphabet alphabet;
 
 
 void encode(std::stringstream& ss, const char* data, int size);
+void encode(StringBuilder& sb, const char* data, int size);
 std::string encode(const char* data, int size);
 std::string encode(const std::string& s);
 
@@ -42,6 +42,7 @@
 #include "mongo/util/net/hostandport.h"
 #include "mongo/util/net/sock.h"
 #include "mongo/util/print.h"
+#include "mongo/util/shared_buffer.h"
 
 namespace mongo {
 
@@ -411,7 +412,11 @@ public:
 
     Message(void* data, bool freeIt) : _buf(reinterpret_cast<char*>(data)), _freeIt(freeIt) {}
 
-    Message(Message&& r) : _buf(r._buf), _data(std::move(r._data)), _freeIt(r._freeIt) {
+    Message(Message&& r)
+        : _buf(r._buf),
+          _data(std::move(r._data)),
+          _freeIt(r._freeIt),
+          _sharedBuf(std::move(r._sharedBuf)) {
         r._buf = nullptr;
         r._freeIt = false;
     }
@@ -494,6 +499,7 @@ public:
         _buf = r._buf;
         _data = std::move(r._data);
         _freeIt = r._freeIt;
+        _sharedBuf = std::move(r._sharedBuf);
 
         r._buf = nullptr;
         r._freeIt = false;
@@ -514,6 +520,7 @@ public:
         _buf = nullptr;
         _data.clear();
         _freeIt = false;
+        _sharedBuf = SharedBuffer();
     }
 
     // use to add a buffer
@@ -555,6 +562,24 @@ public:
         _setData(d.view2ptr(), true);
     }
 
+    /**
+     * Sets the single buffer of an empty message to 'buf', which must hold a full MsgData. Unlike
+     * with setData(), other objects can share ownership of the buffer through sharedBuffer(), so
+     * that data received into it can outlive the message without being copied.
+     */
+    void setSharedData(SharedBuffer buf) {
+        verify(empty());
+        _sharedBuf = std::move(buf);
+        _setData(_sharedBuf.get(), false);
+    }
+
+    /**
+     * The buffer set by setSharedData(), or a null buffer if the message was built otherwise.
+     */
+    const SharedBuffer& sharedBuffer() const {
+        return _sharedBuf;
+    }
+
     bool doIFreeIt() {
         return _freeIt;
     }
@@ -579,6 +604,8 @@ private:
     typedef std::vector<std::pair<char*, int>> MsgVec;
     MsgVec _data{};
     bool _freeIt{false};
+    // set if _buf is owned through a SharedBuffer
+    SharedBuffer _sharedBuf{};
 };
 
 
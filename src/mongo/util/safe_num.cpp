@@ -30,6 +30,7 @@
 #include "mongo/platform/basic.h"
 #undef MONGO_PCH_WHITELISTED  // for malloc/realloc/INFINITY pulled from bson
 
+#include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/bson/bsontypes.h"
 #include "mongo/util/safe_num.h"
 
@@ -60,6 +61,25 @@ SafeNum::SafeNum(const BSONElement& element) {
     }
 }
 
+void SafeNum::toBSON(StringData fieldName, BSONObjBuilder* bob) const {
+    switch (_type) {
+        case NumberInt:
+            bob->append(fieldName, _value.int32Val);
+            break;
+        case NumberLong:
+            bob->append(fieldName, _value.int64Val);
+            break;
+        case NumberDouble:
+            bob->append(fieldName, _value.doubleVal);
+            break;
+        case NumberDecimal:
+            bob->append(fieldName, Decimal128(_value.decimalVal));
+            break;
+        default:
+            invariant(false);
+    }
+}
+
 std::string SafeNum::debugString() const {
     ostringstream os;
     switch (_type) {
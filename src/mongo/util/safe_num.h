@@ -154,7 +154,11 @@ public:
     friend class mutablebson::Element;
     friend class mutablebson::Document;
 
-    // TODO: output to builder
+    /**
+     * Appends the value as a field named 'fieldName' to 'bob', with the BSON type of the
+     * number. It assumes 'this' is a valid SafeNum.
+     */
+    void toBSON(StringData fieldName, BSONObjBuilder* bob) const;
 
     //
     // accessors
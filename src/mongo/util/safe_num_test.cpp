@@ -81,6 +81,24 @@ TEST(Basics, BSONElementInitialization) {
     }
 }
 
+TEST(Basics, ToBSON) {
+    mongo::BSONObjBuilder bob;
+    SafeNum(1).toBSON("numberInt", &bob);
+    SafeNum(2LL).toBSON("numberLong", &bob);
+    SafeNum(0.5).toBSON("numberDouble", &bob);
+    const mongo::BSONObj o = bob.obj();
+
+    ASSERT_EQUALS(o["numberInt"].type(), mongo::NumberInt);
+    ASSERT_EQUALS(o["numberInt"].Int(), 1);
+    ASSERT_EQUALS(o["numberLong"].type(), mongo::NumberLong);
+    ASSERT_EQUALS(o["numberLong"].Long(), 2LL);
+    ASSERT_EQUALS(o["numberDouble"].type(), mongo::NumberDouble);
+    ASSERT_EQUALS(o["numberDouble"].Double(), 0.5);
+
+    const SafeNum roundTrip(o["numberLong"]);
+    ASSERT_TRUE(roundTrip.isIdentical(SafeNum(2LL)));
+}
+
 TEST(Comparison, EOO) {
     const SafeNum safeNumA;
     const SafeNum safeNumB;